@@ -5,6 +5,9 @@
 ;     mat_x_mat_d
 ;     vecarr_x_mat_f    Matrix and vector 4x4 multiplication
 ;     vecarr_x_mat_d
+;
+; Loads and stores are unaligned, which cost nothing extra on aligned data,
+; so callers are not required to align their matrices and vector arrays.
 
 specialized     equ         5                       ; Must match C enumeration
 
@@ -29,10 +32,10 @@ specialized     equ         5                       ; Must match C enumeration
 
                 align       16
 mat_x_mat_f     proc
-                movaps      xmm0,   [r8]            ; Load all the matrix rows
-                movaps      xmm1,   [r8 + 16]
-                movaps      xmm2,   [r8 + 32]
-                movaps      xmm3,   [r8 + 48]
+                movups      xmm0,   [r8]            ; Load all the matrix rows
+                movups      xmm1,   [r8 + 16]
+                movups      xmm2,   [r8 + 32]
+                movups      xmm3,   [r8 + 48]
 
                 xorps       xmm8,   xmm8            ; Zero destination vector
 
@@ -46,7 +49,7 @@ mat_x_mat_f     proc
                 vfmadd231ps xmm8,   xmm2,   xmm6
                 vfmadd231ps xmm8,   xmm3,   xmm7
 
-                movaps      [rcx],  xmm8            ; Store destination vector
+                movups      [rcx],  xmm8            ; Store destination vector
 
                 xorps       xmm8,   xmm8
                 vbroadcastss xmm4,  dword ptr [rdx + 16] ; 2nd element
@@ -57,7 +60,7 @@ mat_x_mat_f     proc
                 vfmadd231ps xmm8,   xmm1,   xmm5
                 vfmadd231ps xmm8,   xmm2,   xmm6
                 vfmadd231ps xmm8,   xmm3,   xmm7
-                movaps      [rcx + 16], xmm8
+                movups      [rcx + 16], xmm8
 
                 xorps       xmm8,   xmm8
                 vbroadcastss xmm4,  dword ptr [rdx + 32] ; 3rd element
@@ -68,7 +71,7 @@ mat_x_mat_f     proc
                 vfmadd231ps xmm8,   xmm1,   xmm5
                 vfmadd231ps xmm8,   xmm2,   xmm6
                 vfmadd231ps xmm8,   xmm3,   xmm7
-                movaps      [rcx + 32], xmm8
+                movups      [rcx + 32], xmm8
 
                 xorps       xmm8,   xmm8
                 vbroadcastss xmm4,  dword ptr [rdx + 48] ; 4th element
@@ -79,7 +82,7 @@ mat_x_mat_f     proc
                 vfmadd231ps xmm8,   xmm1,   xmm5
                 vfmadd231ps xmm8,   xmm2,   xmm6
                 vfmadd231ps xmm8,   xmm3,   xmm7
-                movaps      [rcx + 48], xmm8
+                movups      [rcx + 48], xmm8
 
                 mov         rax,    specialized
                 ret
@@ -98,10 +101,10 @@ mat_x_mat_f     endp
 
                 align       16
 mat_x_mat_d     proc
-                vmovapd     ymm0,   [r8]            ; Load all the matrix rows
-                vmovapd     ymm1,   [r8 + 32]
-                vmovapd     ymm2,   [r8 + 64]
-                vmovapd     ymm3,   [r8 + 96]
+                vmovupd     ymm0,   [r8]            ; Load all the matrix rows
+                vmovupd     ymm1,   [r8 + 32]
+                vmovupd     ymm2,   [r8 + 64]
+                vmovupd     ymm3,   [r8 + 96]
 
                 vxorpd      ymm8,   ymm8,   ymm8    ; Zero destination vector
 
@@ -115,7 +118,7 @@ mat_x_mat_d     proc
                 vfmadd231pd ymm8,   ymm2,   ymm6
                 vfmadd231pd ymm8,   ymm3,   ymm7
 
-                vmovapd     [rcx],  ymm8            ; Store destination vector
+                vmovupd     [rcx],  ymm8            ; Store destination vector
 
                 vxorpd      ymm8,   ymm8,   ymm8
                 vbroadcastsd ymm4,  qword ptr [rdx + 32] ; 2nd element
@@ -126,7 +129,7 @@ mat_x_mat_d     proc
                 vfmadd231pd ymm8,   ymm1,   ymm5
                 vfmadd231pd ymm8,   ymm2,   ymm6
                 vfmadd231pd ymm8,   ymm3,   ymm7
-                vmovapd     [rcx + 32], ymm8
+                vmovupd     [rcx + 32], ymm8
 
                 vxorpd      ymm8,   ymm8,   ymm8
                 vbroadcastsd ymm4,  qword ptr [rdx + 64] ; 3rd element
@@ -137,7 +140,7 @@ mat_x_mat_d     proc
                 vfmadd231pd ymm8,   ymm1,   ymm5
                 vfmadd231pd ymm8,   ymm2,   ymm6
                 vfmadd231pd ymm8,   ymm3,   ymm7
-                vmovapd     [rcx + 64], ymm8
+                vmovupd     [rcx + 64], ymm8
 
                 vxorpd      ymm8,   ymm8,   ymm8
                 vbroadcastsd ymm4,  qword ptr [rdx + 96] ; 4th element
@@ -148,7 +151,7 @@ mat_x_mat_d     proc
                 vfmadd231pd ymm8,   ymm1,   ymm5
                 vfmadd231pd ymm8,   ymm2,   ymm6
                 vfmadd231pd ymm8,   ymm3,   ymm7
-                vmovapd     [rcx + 96], ymm8
+                vmovupd     [rcx + 96], ymm8
 
                 mov         rax,    specialized
                 ret
@@ -173,10 +176,10 @@ mat_x_mat_d     endp
 vecarr_x_mat_f  proc
                 ; Single vector, 4 lane, implementation
 
-                movaps      xmm0,   [r8]            ; Load all the matrix rows
-                movaps      xmm1,   [r8 + 16]
-                movaps      xmm2,   [r8 + 32]
-                movaps      xmm3,   [r8 + 48]
+                movups      xmm0,   [r8]            ; Load all the matrix rows
+                movups      xmm1,   [r8 + 16]
+                movups      xmm2,   [r8 + 32]
+                movups      xmm3,   [r8 + 48]
 
 next:           xorps       xmm8,   xmm8            ; Zero destination vector
 
@@ -190,7 +193,7 @@ next:           xorps       xmm8,   xmm8            ; Zero destination vector
                 vfmadd231ps xmm8,   xmm2,   xmm6
                 vfmadd231ps xmm8,   xmm3,   xmm7
 
-                movaps      [rcx],  xmm8            ; Store destination vector
+                movups      [rcx],  xmm8            ; Store destination vector
 
                 add         rcx,    16              ; Update vector pointers
                 add         rdx,    16
@@ -208,14 +211,15 @@ vecarr_x_mat_f  endp
 vecarr_x_mat_f2 proc
                 ; Two vector, 8 lane, implementation
 
-                inc         r9                      ; Process vectors in pairs
-                shr         r9, 1
-
                 vbroadcastf128 ymm0, oword ptr [r8]      ; Load the matrix twice,
                 vbroadcastf128 ymm1, oword ptr [r8 + 16] ;   into upper and lower
                 vbroadcastf128 ymm2, oword ptr [r8 + 32] ;   halves of vector
                 vbroadcastf128 ymm3, oword ptr [r8 + 48]
 
+                mov         r10,    r9              ; Remember if count is odd
+                shr         r9,     1               ; Process vectors in pairs
+                jz          odd                     ; Branch if no pairs
+
 next:           vxorps      ymm12,  ymm12,  ymm12   ; Zero destination vector
 
                 vbroadcastss ymm4,  dword ptr [rdx]      ; Duplicate the nth element
@@ -236,7 +240,7 @@ next:           vxorps      ymm12,  ymm12,  ymm12   ; Zero destination vector
                 vfmadd231ps ymm12,  ymm2,   ymm6
                 vfmadd231ps ymm12,  ymm3,   ymm7
 
-                vmovaps     [rcx],  ymm12           ; Store destination vectors
+                vmovups     [rcx],  ymm12           ; Store destination vectors
 
                 add         rcx,    32              ; Update vector pointers
                 add         rdx,    32
@@ -244,7 +248,21 @@ next:           vxorps      ymm12,  ymm12,  ymm12   ; Zero destination vector
                 dec         r9                      ; Branch if more vectors
                 jnz         next                    ;   to process
 
-                mov         rax,    specialized + 1
+odd:            test        r10,    1               ; Branch if no odd vector,
+                jz          done                    ;   never write past the end
+
+                vxorps      xmm12,  xmm12,  xmm12   ; Single vector using the
+                vbroadcastss xmm4,  dword ptr [rdx]      ;   lower halves of the rows
+                vbroadcastss xmm5,  dword ptr [rdx +  4]
+                vbroadcastss xmm6,  dword ptr [rdx +  8]
+                vbroadcastss xmm7,  dword ptr [rdx + 12]
+                vfmadd231ps xmm12,  xmm0,   xmm4
+                vfmadd231ps xmm12,  xmm1,   xmm5
+                vfmadd231ps xmm12,  xmm2,   xmm6
+                vfmadd231ps xmm12,  xmm3,   xmm7
+                vmovups     [rcx],  xmm12
+
+done:           mov         rax,    specialized + 1
                 ret
 vecarr_x_mat_f2 endp
 
@@ -262,10 +280,10 @@ vecarr_x_mat_f2 endp
 
                 align       16
 vecarr_x_mat_d  proc
-                vmovapd     ymm0,   [r8]            ; Load all the matrix rows
-                vmovapd     ymm1,   [r8 + 32]
-                vmovapd     ymm2,   [r8 + 64]
-                vmovapd     ymm3,   [r8 + 96]
+                vmovupd     ymm0,   [r8]            ; Load all the matrix rows
+                vmovupd     ymm1,   [r8 + 32]
+                vmovupd     ymm2,   [r8 + 64]
+                vmovupd     ymm3,   [r8 + 96]
 
 next:           vxorpd      ymm8,   ymm8,   ymm8    ; Zero destination vector
 
@@ -279,7 +297,7 @@ next:           vxorpd      ymm8,   ymm8,   ymm8    ; Zero destination vector
                 vfmadd231pd ymm8,   ymm2,   ymm6
                 vfmadd231pd ymm8,   ymm3,   ymm7
 
-                vmovapd     [rcx],  ymm8            ; Store destination vector
+                vmovupd     [rcx],  ymm8            ; Store destination vector
 
                 add         rcx,    32              ; Update vector pointers
                 add         rdx,    32
@@ -5,6 +5,9 @@
 #     mat_x_mat_d
 #     vecarr_x_mat_f    Matrix and vector 4x4 multiplication
 #     vecarr_x_mat_d
+#
+# Loads and stores are unaligned, which cost nothing extra on aligned data,
+# so callers are not required to align their matrices and vector arrays.
 
                 .intel_syntax noprefix
 
@@ -38,10 +41,10 @@ specialized     =           5                       # Must match C enumeration
                 .balign     16
 mat_x_mat_f:
 _mat_x_mat_f:
-                movaps      xmm0,   [rdx]           # Load all the matrix rows
-                movaps      xmm1,   [rdx + 16]
-                movaps      xmm2,   [rdx + 32]
-                movaps      xmm3,   [rdx + 48]
+                movups      xmm0,   [rdx]           # Load all the matrix rows
+                movups      xmm1,   [rdx + 16]
+                movups      xmm2,   [rdx + 32]
+                movups      xmm3,   [rdx + 48]
 
                 xorps       xmm8,   xmm8            # Zero destination vector
 
@@ -55,7 +58,7 @@ _mat_x_mat_f:
                 vfmadd231ps xmm8,   xmm2,   xmm6
                 vfmadd231ps xmm8,   xmm3,   xmm7
 
-                movaps      [rdi],  xmm8            # Store destination vector
+                movups      [rdi],  xmm8            # Store destination vector
 
                 xorps       xmm8,   xmm8
                 vbroadcastss xmm4,  [rsi + 16]      # 2nd element
@@ -66,7 +69,7 @@ _mat_x_mat_f:
                 vfmadd231ps xmm8,   xmm1,   xmm5
                 vfmadd231ps xmm8,   xmm2,   xmm6
                 vfmadd231ps xmm8,   xmm3,   xmm7
-                movaps      [rdi + 16], xmm8
+                movups      [rdi + 16], xmm8
 
                 xorps       xmm8,   xmm8
                 vbroadcastss xmm4,  [rsi + 32]      # 3rd element
@@ -77,7 +80,7 @@ _mat_x_mat_f:
                 vfmadd231ps xmm8,   xmm1,   xmm5
                 vfmadd231ps xmm8,   xmm2,   xmm6
                 vfmadd231ps xmm8,   xmm3,   xmm7
-                movaps      [rdi + 32], xmm8
+                movups      [rdi + 32], xmm8
 
                 xorps       xmm8,   xmm8
                 vbroadcastss xmm4,  [rsi + 48]      # 4th element
@@ -88,7 +91,7 @@ _mat_x_mat_f:
                 vfmadd231ps xmm8,   xmm1,   xmm5
                 vfmadd231ps xmm8,   xmm2,   xmm6
                 vfmadd231ps xmm8,   xmm3,   xmm7
-                movaps      [rdi + 48], xmm8
+                movups      [rdi + 48], xmm8
 
                 mov         rax,    specialized
                 ret
@@ -107,10 +110,10 @@ _mat_x_mat_f:
                 .balign     16
 mat_x_mat_d:
 _mat_x_mat_d:
-                vmovapd     ymm0,   [rdx]           # Load all the matrix rows
-                vmovapd     ymm1,   [rdx + 32]
-                vmovapd     ymm2,   [rdx + 64]
-                vmovapd     ymm3,   [rdx + 96]
+                vmovupd     ymm0,   [rdx]           # Load all the matrix rows
+                vmovupd     ymm1,   [rdx + 32]
+                vmovupd     ymm2,   [rdx + 64]
+                vmovupd     ymm3,   [rdx + 96]
 
                 vxorpd      ymm8,   ymm8,   ymm8    # Zero destination vector
 
@@ -124,7 +127,7 @@ _mat_x_mat_d:
                 vfmadd231pd ymm8,   ymm2,   ymm6
                 vfmadd231pd ymm8,   ymm3,   ymm7
 
-                vmovapd     [rdi],  ymm8            # Store destination vector
+                vmovupd     [rdi],  ymm8            # Store destination vector
 
                 vxorpd      ymm8,   ymm8,   ymm8
                 vbroadcastsd ymm4,  [rsi + 32]      # 2nd element
@@ -135,7 +138,7 @@ _mat_x_mat_d:
                 vfmadd231pd ymm8,   ymm1,   ymm5
                 vfmadd231pd ymm8,   ymm2,   ymm6
                 vfmadd231pd ymm8,   ymm3,   ymm7
-                vmovapd     [rdi + 32], ymm8
+                vmovupd     [rdi + 32], ymm8
 
                 vxorpd      ymm8,   ymm8,   ymm8
                 vbroadcastsd ymm4,  [rsi + 64]      # 3rd element
@@ -146,7 +149,7 @@ _mat_x_mat_d:
                 vfmadd231pd ymm8,   ymm1,   ymm5
                 vfmadd231pd ymm8,   ymm2,   ymm6
                 vfmadd231pd ymm8,   ymm3,   ymm7
-                vmovapd     [rdi + 64], ymm8
+                vmovupd     [rdi + 64], ymm8
 
                 vxorpd      ymm8,   ymm8,   ymm8
                 vbroadcastsd ymm4,  [rsi + 96]      # 4th element
@@ -157,7 +160,7 @@ _mat_x_mat_d:
                 vfmadd231pd ymm8,   ymm1,   ymm5
                 vfmadd231pd ymm8,   ymm2,   ymm6
                 vfmadd231pd ymm8,   ymm3,   ymm7
-                vmovapd     [rdi + 96], ymm8
+                vmovupd     [rdi + 96], ymm8
 
                 mov         rax,    specialized
                 ret
@@ -182,10 +185,10 @@ vecarr_x_mat_f:
 _vecarr_x_mat_f:
                 # Single vector, 4 lane, implementation
 
-                movaps      xmm0,   [rdx]           # Load all the matrix rows
-                movaps      xmm1,   [rdx + 16]
-                movaps      xmm2,   [rdx + 32]
-                movaps      xmm3,   [rdx + 48]
+                movups      xmm0,   [rdx]           # Load all the matrix rows
+                movups      xmm1,   [rdx + 16]
+                movups      xmm2,   [rdx + 32]
+                movups      xmm3,   [rdx + 48]
 
 1:              xorps       xmm8,   xmm8            # Zero destination vector
 
@@ -199,7 +202,7 @@ _vecarr_x_mat_f:
                 vfmadd231ps xmm8,   xmm2,   xmm6
                 vfmadd231ps xmm8,   xmm3,   xmm7
 
-                movaps      [rdi],  xmm8            # Store destination vector
+                movups      [rdi],  xmm8            # Store destination vector
 
                 add         rdi,    16              # Update vector pointers
                 add         rsi,    16
@@ -217,14 +220,15 @@ vecarr_x_mat_f2:
 _vecarr_x_mat_f2:
                 # Two vector, 8 lane, implementation
 
-                inc         rcx                     # Process vectors in pairs
-                shr         rcx, 1
-
                 vbroadcastf128 ymm0, [rdx]          # Load the matrix twice,
                 vbroadcastf128 ymm1, [rdx + 16]     #   into upper and lower
                 vbroadcastf128 ymm2, [rdx + 32]     #   halves of vector
                 vbroadcastf128 ymm3, [rdx + 48]
 
+                mov         r8,     rcx             # Remember if count is odd
+                shr         rcx,    1               # Process vectors in pairs
+                jz          2f                      # Branch if no pairs
+
 1:              vxorps      ymm12,  ymm12,  ymm12   # Zero destination vector
 
                 vbroadcastss ymm4,  [rsi]           # Duplicate the nth element
@@ -245,7 +249,7 @@ _vecarr_x_mat_f2:
                 vfmadd231ps ymm12,  ymm2,   ymm6
                 vfmadd231ps ymm12,  ymm3,   ymm7
 
-                vmovaps     [rdi],  ymm12           # Store destination vectors
+                vmovups     [rdi],  ymm12           # Store destination vectors
 
                 add         rdi,    32              # Update vector pointers
                 add         rsi,    32
@@ -253,7 +257,21 @@ _vecarr_x_mat_f2:
                 dec         rcx                     # Branch if more vectors
                 jnz         1b                      #   to process
 
-                mov         rax,    specialized + 1
+2:              test        r8,     1               # Branch if no odd vector,
+                jz          3f                      #   never write past the end
+
+                vxorps      xmm12,  xmm12,  xmm12   # Single vector using the
+                vbroadcastss xmm4,  [rsi]           #   lower halves of the rows
+                vbroadcastss xmm5,  [rsi +  4]
+                vbroadcastss xmm6,  [rsi +  8]
+                vbroadcastss xmm7,  [rsi + 12]
+                vfmadd231ps xmm12,  xmm0,   xmm4
+                vfmadd231ps xmm12,  xmm1,   xmm5
+                vfmadd231ps xmm12,  xmm2,   xmm6
+                vfmadd231ps xmm12,  xmm3,   xmm7
+                vmovups     [rdi],  xmm12
+
+3:              mov         rax,    specialized + 1
                 ret
 
 
@@ -271,10 +289,10 @@ _vecarr_x_mat_f2:
                 .balign     16
 vecarr_x_mat_d:
 _vecarr_x_mat_d:
-                vmovapd     ymm0,   [rdx]           # Load all the matrix rows
-                vmovapd     ymm1,   [rdx + 32]
-                vmovapd     ymm2,   [rdx + 64]
-                vmovapd     ymm3,   [rdx + 96]
+                vmovupd     ymm0,   [rdx]           # Load all the matrix rows
+                vmovupd     ymm1,   [rdx + 32]
+                vmovupd     ymm2,   [rdx + 64]
+                vmovupd     ymm3,   [rdx + 96]
 
 1:              vxorpd      ymm8,   ymm8,   ymm8    # Zero destination vector
 
@@ -288,7 +306,7 @@ _vecarr_x_mat_d:
                 vfmadd231pd ymm8,   ymm2,   ymm6
                 vfmadd231pd ymm8,   ymm3,   ymm7
 
-                vmovapd     [rdi],  ymm8            # Store destination vector
+                vmovupd     [rdi],  ymm8            # Store destination vector
 
                 add         rdi,    32              # Update vector pointers
                 add         rsi,    32
@@ -1,24 +1,24 @@
 //  main.cpp
-//  Assuming C++17
+//  Assuming C++20
 //
 //  Intel Mac:
-//      clang++ -std=c++17 -march=haswell -O3 main.cpp cpuinfo.c
-//      clang++ -std=c++17 -march=haswell -O3 -DASM main.cpp cpuinfo.c avx.s
+//      clang++ -std=c++20 -march=haswell -O3 main.cpp cpuinfo.c
+//      clang++ -std=c++20 -march=haswell -O3 -DASM main.cpp cpuinfo.c avx.s
 //  ARM Mac:
-//      clang++ -std=c++17 -march=armv8-a -O3 main.cpp cpuinfo.c
-//      clang++ -std=c++17 -march=armv8-a -O3 -DASM main.cpp cpuinfo.c neon.s
+//      clang++ -std=c++20 -march=armv8-a -O3 main.cpp cpuinfo.c
+//      clang++ -std=c++20 -march=armv8-a -O3 -DASM main.cpp cpuinfo.c neon.s
 //  Intel Linux:
-//      g++ -std=c++17 -march=haswell -O3 main.cpp cpuinfo.c
+//      g++ -std=c++20 -march=haswell -O3 main.cpp cpuinfo.c
 //      as -o avx.o --defsym IsLinux=1 avx.s
-//      g++ -std=c++17 -march=haswell -O3 -DIsLinux -DASM main.cpp cpuinfo.c avx.o
+//      g++ -std=c++20 -march=haswell -O3 -DIsLinux -DASM main.cpp cpuinfo.c avx.o
 //  Raspberry Pi
-//      g++ -std=c++17 -march=armv8-a -O3 main.cpp cpuinfo.cpp
-//      g++ -std=c++17 -march=armv8-a -O3 -DASM main.cpp cpuinfo.cpp neon.s
-//      g++ -std=c++17 -march=armv7-a -mfpu=neon-vfpv3 -O3 main.cpp cpuinfo.c
+//      g++ -std=c++20 -march=armv8-a -O3 main.cpp cpuinfo.cpp
+//      g++ -std=c++20 -march=armv8-a -O3 -DASM main.cpp cpuinfo.cpp neon.s
+//      g++ -std=c++20 -march=armv7-a -mfpu=neon-vfpv3 -O3 main.cpp cpuinfo.c
 //  Windows:
-//      cl /std:c++17 /arch:AVX2 /O2 /EHsc main.cpp cpuinfo.cpp
+//      cl /std:c++20 /arch:AVX2 /O2 /EHsc main.cpp cpuinfo.cpp
 //      ml64 /c /Feavx avx.asm
-//      cl /std:c++17 /arch:AVX2 /O2 /EHsc /DASM main.cpp cpuinfo.cpp avx.obj
+//      cl /std:c++20 /arch:AVX2 /O2 /EHsc /DASM main.cpp cpuinfo.cpp avx.obj
 //
 //  To enable unrolled template specializations add:
 //      -DUNROLL
@@ -39,6 +39,7 @@
 #include <iomanip>
 #include <fstream>
 #include <locale>
+#include <string>
 
 #include "timer.h"
 #include "cpuinfo.h"
@@ -81,7 +82,8 @@ void compare_vec(vec<T, N>  *dvecarr,
                  T          evec0[N],
                  T          evec1[N],
                  int        elements,
-                 const char *msg) {
+                 const char *msg,
+                 bool       guard = false) {
     auto valid = true;
     
     for (int i = 0; i < elements; ++i) {
@@ -101,6 +103,13 @@ void compare_vec(vec<T, N>  *dvecarr,
 #endif
         }
     }
+    
+    // Zero'd vector following the array must not have been written
+    if (guard) {
+        for (int j = 0; j < N; ++j) {
+            valid = valid && (dvecarr[elements].v[j] == T(0));
+        }
+    }
 
     // Overall results
     cout << msg << (valid ? passed : failed) << endl;
@@ -133,6 +142,288 @@ void compare_mat(mat<T, MAJ, MIN> &dmat,
 
 
 
+template <typename T, size_t MAJ, size_t MIN>
+void compare_matarr(mat<T, MAJ, MIN> *dmatarr,
+                    T                emat[MAJ * MIN],
+                    int              elements,
+                    const char       *msg) {
+    auto valid = true;
+    
+    for (int e = 0; e < elements; ++e) {
+        for (int i = 0; i < MAJ; ++i) {
+            for (int j = 0; j < MIN; ++j) {
+                auto k = i * MIN + j;
+                
+                valid = valid && (dmatarr[e].m[i][j] == emat[k]);
+                
+#ifdef DUMP
+                if (dmatarr[e].m[i][j] != emat[k]) {
+                    cout << " matarr[" << e << "][" << i << "][" << j << "] "
+                         << dmatarr[e].m[i][j]
+                         << " != expected[" << k << "] " << emat[k] << endl;
+                }
+#endif
+            }
+        }
+    }
+
+    // Overall results
+    cout << msg << (valid ? passed : failed) << endl;
+}
+
+
+
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+void compare_product(const char *msg) {
+    mat<T, MAJ, K>   a;
+    mat<T, K,   MIN> b;
+    mat<T, MAJ, MIN> dmat;
+    vec<T, MAJ>      v[3];
+    vec<T, K>        dvec[3];
+    auto             valid = true;
+
+    // Small integers, products and sums are exact
+    set_matrix(a, [] (int i, int k) -> T { return T(i * K + k + 1); });
+    set_matrix(b, [] (int k, int j) -> T { return T(k - j); });
+    for (int e = 0; e < 3; ++e) {
+        set_vector(v[e], [e] (int i) -> T { return T(e + i); });
+    }
+
+    mat_x_mat(dmat, a, b);
+    vecarr_x_mat(dvec, v, a, 2);
+    vec_x_mat(dvec[2], v[2], a);
+
+    for (int i = 0; i < MAJ; ++i) {
+        for (int j = 0; j < MIN; ++j) {
+            T sum = 0;
+
+            for (int k = 0; k < K; ++k) {
+                sum += T(i * K + k + 1) * T(k - j);
+            }
+            valid = valid && (dmat.m[i][j] == sum);
+        }
+    }
+
+    for (int e = 0; e < 3; ++e) {
+        for (int k = 0; k < K; ++k) {
+            T sum = 0;
+
+            for (int i = 0; i < MAJ; ++i) {
+                sum += T(e + i) * T(i * K + k + 1);
+            }
+            valid = valid && (dvec[e].v[k] == sum);
+        }
+    }
+
+    // Overall results
+    cout << msg << (valid ? passed : failed) << endl;
+}
+
+
+
+template <typename T>
+void compare_blocked(const char *msg, size_t maj, size_t min, size_t k, unsigned threads) {
+    std::vector<T> a(maj * k), b(k * min), dest(maj * min, T(-1));
+    auto           valid = true;
+
+    // Small integers, products and sums are exact
+    for (size_t i = 0; i < maj * k; ++i) {
+        a[i] = T(int(i % 7) - 3);
+    }
+    for (size_t i = 0; i < k * min; ++i) {
+        b[i] = T(int(i % 5) - 2);
+    }
+
+    mat_x_mat_blocked(dest.data(), a.data(), b.data(), maj, min, k, threads);
+
+    for (size_t i = 0; i < maj; ++i) {
+        for (size_t j = 0; j < min; ++j) {
+            T sum = 0;
+
+            for (size_t p = 0; p < k; ++p) {
+                sum += a[i * k + p] * b[p * min + j];
+            }
+            valid = valid && (dest[i * min + j] == sum);
+        }
+    }
+
+    // Overall results
+    cout << msg << (valid ? passed : failed) << endl;
+}
+
+template <typename T, typename L>
+void compare_layout(const char *msg) {
+    mat<T, 37, 45>        a;
+    mat<T, 45, 29>        b;
+    mat<T, 37, 29>        dmat, dcheck;
+    mat<T, 45, 37>        tmat;
+    cmat<T, 45, 37>       ca, cb;
+    lmat<T, 37, 45, L>    la, lc;
+    lmat<T, 45, 29, L>    lb;
+    lmat<T, 37, 29, L>    ld;
+    lmat<T, 45, 37, L>    lt;
+    auto                  valid = true;
+
+    // Small integers, products and sums are exact
+    set_matrix(a, [] (int i, int j) -> T { return T((i * 3 + j) % 7 - 3); });
+    set_matrix(b, [] (int i, int j) -> T { return T((i + j * 5) % 9 - 4); });
+
+    mat_to_lmat(la, a);
+    mat_to_lmat(lb, b);
+    mat_x_mat(ld, la, lb);
+    lmat_to_mat(dmat, ld);
+    mat_x_mat(dcheck, a, b);
+    valid = valid && std::memcmp(dmat.m, dcheck.m, sizeof(dmat.m)) == 0;
+
+    // Transpose a tile at a time
+    transpose(lt, la);
+    lmat_to_mat(tmat, lt);
+    for (int i = 0; i < 45; ++i) {
+        for (int j = 0; j < 37; ++j) {
+            valid = valid && tmat.m[i][j] == a.m[j][i];
+        }
+    }
+
+    // Column major conversion holds the same matrix
+    transpose(ca, a);
+    cmat_to_lmat(lc, ca);
+    lmat_to_cmat(cb, lc);
+    valid = valid && std::memcmp(la.m, lc.m, sizeof(la.m)) == 0
+                  && std::memcmp(ca.m, cb.m, sizeof(ca.m)) == 0;
+
+    // Overall results
+    cout << msg << (valid ? passed : failed) << endl;
+}
+
+// Change of basis and units known at compile time, metres to centimetres,
+// y up to z up, then a translation. Small integers keep the SIMD and
+// constant evaluated results identical.
+template <typename T>
+constexpr mat<T, 4, 4> fixed_transform(bool turn) {
+    mat<T, 4, 4> units{}, basis{}, move{}, temp{}, dest{};
+
+    diagonal(units, T(100));
+    units.m[3][3] = T(1);
+    set_matrix(basis, [] (int i, int j) -> T {
+        return (i == j && (i == 0 || i == 3)) ? T(1)  :
+               (i == 1 && j == 2)             ? T(1)  :
+               (i == 2 && j == 1)             ? T(-1) : T(0);
+    });
+    diagonal(move, T(1));
+    move.set({ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 2, -3, 5, 1 });
+
+    mat_x_mat(temp, units, basis);
+    mat_x_mat(dest, temp,  move);
+
+    if (turn) {
+        transpose(temp, dest);
+        return temp;
+    }
+
+    return dest;
+}
+
+template <typename T>
+constexpr vec<T, 4> fixed_point() {
+    auto      m = fixed_transform<T>(false);
+    vec<T, 4> v = {{ 1, 2, 3, 1 }}, dest{};
+
+    vec_x_mat(dest, v, m);
+
+    return dest;
+}
+
+template <typename T, size_t N>
+constexpr mat<T, N, N> fixed_product() {
+    mat<T, N, N> a{}, b{}, dest{};
+
+    set_matrix(a, [] (int i, int j) -> T { return T(i * N + j + 1); });
+    set_matrix(b, [] (int i, int j) -> T { return T(i - j); });
+    mat_x_mat(dest, a, b);
+
+    return dest;
+}
+
+// The same functions at run time take the specializations
+template <typename T, size_t N>
+bool compare_fixed() {
+    constexpr auto fixed = fixed_product<T, N>();
+    auto           run   = fixed_product<T, N>();
+
+    return std::memcmp(fixed.m, run.m, sizeof(run.m)) == 0;
+}
+
+template <typename T>
+void compare_constexpr(const char *msg) {
+    constexpr auto fixed  = fixed_transform<T>(false);
+    constexpr auto turned = fixed_transform<T>(true);
+    constexpr auto point  = fixed_point<T>();
+    auto           rfixed = fixed_transform<T>(false);
+    auto           rturn  = fixed_transform<T>(true);
+    auto           rpoint = fixed_point<T>();
+    auto           valid  = true;
+
+    static_assert(fixed.m[1][2]  == T(100) && fixed.m[2][1] == T(-100)
+               && fixed.m[3][0]  == T(2)   && fixed.m[3][1] == T(-3));
+    static_assert(turned.m[0][3] == T(2)   && turned.m[2][3] == T(5));
+    static_assert(point.v[0] == T(102) && point.v[1] == T(-303)
+               && point.v[2] == T(205) && point.v[3] == T(1));
+
+    valid =    std::memcmp(fixed.m, rfixed.m, sizeof(fixed.m)) == 0
+            && std::memcmp(turned.m, rturn.m, sizeof(turned.m)) == 0
+            && std::memcmp(point.v, rpoint.v, sizeof(point.v)) == 0
+            && compare_fixed<T, 2>()
+            && compare_fixed<T, 3>()
+            && compare_fixed<T, 4>()
+            && compare_fixed<T, 8>()
+            && compare_fixed<T, 16>()
+            && compare_fixed<T, 32>();
+
+    // Overall results
+    cout << msg << (valid ? passed : failed) << endl;
+}
+
+// Reference product for timing the blocked version
+template <typename T>
+void naive_x_mat(T *dest, T *a, T *b, size_t maj, size_t min, size_t k) {
+    for (size_t i = 0; i < maj; ++i) {
+        for (size_t j = 0; j < min; ++j) {
+            T sum = 0;
+
+            for (size_t p = 0; p < k; ++p) {
+                sum += a[i * k + p] * b[p * min + j];
+            }
+            dest[i * min + j] = sum;
+        }
+    }
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Aligned memory for arrays
+
+void *alloc_aligned(size_t size) {
+    // Round up to a multiple of the alignment as required by aligned_alloc
+    size = (size + alignment - 1) & ~size_t(alignment - 1);
+
+#if defined(__x86_64__) || defined(_M_X64)      // 64-bit Intel
+    return _mm_malloc(size, alignment);
+#else
+    return std::aligned_alloc(alignment, size);
+#endif
+}
+
+void free_aligned(void *p) {
+#if defined(__x86_64__) || defined(_M_X64)      // 64-bit Intel
+    _mm_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+
+
 // -----------------------------------------------------------------------------
 
 int main(void) {
@@ -146,6 +437,14 @@ int main(void) {
         cout << "CPU is not x86-64 4th gen compatible" << endl;
         exit(1);
     }
+
+#if defined(__AVX512F__)
+    // Compiler was allowed to generate AVX-512 code
+    if (! cpu_has_avx512_f_cd()) {
+        cout << "CPU does not support AVX-512" << endl;
+        exit(1);
+    }
+#endif
 #endif
 
     char buffer[2048];
@@ -582,154 +881,2793 @@ int main(void) {
     
     
     // -------------------------------------------------------------------------
-    // Additional tests
+    // Test the matrix array multiplications.
+    // Every matrix in an array is the same as the single matrix it replaces.
 
-    // Source and expected deta
-    int tmat32[]  = {  1,  2,  3,  4,  5,  6 };
-    int tmat23[]  = {  7,  8,  9, 10, 11, 12 };
-    int tmat33a[] = {  1,  2,  3,  4,  5,  6,  7,  8,  9 };
-    int tmat33b[] = { 10, 11, 12, 13, 14, 15, 16, 17, 18 };
-    int emat33[]  = { 27, 30, 33, 61, 68, 75, 95, 106, 117 };       // TI-84+
-    int emat22[]  = { 76, 100, 103, 136 };                          // TI-84+
-    int emat33c[] = { 84, 90, 96, 201, 216, 231, 318, 342, 366 };   // TI-84+
+    auto bytesmatf = elements * sizeof(rmat<float,  4, 4>);
+    auto bytesmatd = elements * sizeof(rmat<double, 4, 4>);
+    
+    auto *drmatarrf  = (rmat<float,  4, 4> *) alloc_aligned(bytesmatf);
+    auto *srmatarraf = (rmat<float,  4, 4> *) alloc_aligned(bytesmatf);
+    auto *srmatarrbf = (rmat<float,  4, 4> *) alloc_aligned(bytesmatf);
+    auto *drmatarrd  = (rmat<double, 4, 4> *) alloc_aligned(bytesmatd);
+    auto *srmatarrad = (rmat<double, 4, 4> *) alloc_aligned(bytesmatd);
+    auto *srmatarrbd = (rmat<double, 4, 4> *) alloc_aligned(bytesmatd);
 
-    // Source and destination matrices
-    rmat<int, 3, 2> srmat32;
-    rmat<int, 2, 3> srmat23;
-    rmat<int, 3, 3> srmat33a;
-    rmat<int, 3, 3> srmat33b;
-    cmat<int, 3, 2> scmat32;
-    cmat<int, 2, 3> scmat23;
-    cmat<int, 3, 3> scmat33a;
-    cmat<int, 3, 3> scmat33b;
-    rmat<int, 3, 3> drmat33;
-    rmat<int, 2, 2> drmat22;
-    rmat<int, 3, 3> drmat33c;
-    cmat<int, 3, 3> dcmat33;
-    cmat<int, 2, 2> dcmat22;
-    cmat<int, 3, 3> dcmat33c;
+    if (   drmatarrf  == nullptr
+        || srmatarraf == nullptr
+        || srmatarrbf == nullptr
+        || drmatarrd  == nullptr
+        || srmatarrad == nullptr
+        || srmatarrbd == nullptr) {
+        cout << "Failed to allocate memory for matrix arrays" << endl;
+        exit(1);
+    }
 
-    // Initialize source matrices with test data.
-    // Yes, data is supposed to be the same for
-    // row and column major order.
-    // Only the interpretation of the data differs.
-    // Whether consecutive values are interpreted
-    // as rows or interpreted as columns.
-    //
-    // Test linear arrays:  [ a b c d e f ]
-    //                      [ g h i j k l ]
-    //
-    // Row major order 3x2: [ [ a b ]
-    //                        [ c d ]
-    //                        [ e f ] ]
-    //                 2x3: [ [ a b c ]
-    //                        [ d e f ] ]
-    //
-    // Col major order 3x2:  [ [ a   [ c   [ e
-    //                           b ]   d ]   f ] ]
-    //                 2x3:  [ [ a   [ d
-    //                           b     e
-    //                           c ]   f ] ]
-    //
-    // Row major order mul:   C = A * B
-    //                        [ a b   * [ g h i
-    //                          c d       j k l ]
-    //                          e f ]
-    //                      [ ag+bj ah+bk ai+bl
-    //                        cg+dj ch+dk ci+dl
-    //                        eg+fj eh+fk ei+fl ]
-    //
-    // Expected inear array: [ ag+bj ah+bk ai+bl cg+dj ch+dk ci+dl eg+fj eh+fk ei+fl ]
-    //
-    // Col major order mul: T(C) = T(B) * (T(A)
-    //                      [ g j   * [ a c e
-    //                        h k       b d f ]
-    //                        i l ]
-    //                      [ ga+jb gc+jd ge+jf
-    //                        ha+kb hc+kd he+kf
-    //                        ia+lb ic+ld ie+lf ]
-    //
-    // Expected linear array: [ ga+jb ha+kb ia+lb gc+jd hc+kd ic+ld ge+jf he+kf ie+lf ]
-    //
-    // Note the linear arrays match
+    for (int i = 0; i < elements; ++i) {
+        srmatarraf[i] = srmataf;
+        srmatarrbf[i] = srmatbf;
+        srmatarrad[i] = srmatad;
+        srmatarrbd[i] = srmatbd;
+    }
     
-    // Initialize source matrices
-    srmat32.set  (tmat32);
-    srmat23.set  (tmat23);
-    srmat33a.set (tmat33a);
-    srmat33b.set (tmat33b);
-    scmat32.set  (tmat32);
-    scmat23.set  (tmat23);
-    scmat33a.set (tmat33a);
-    scmat33b.set (tmat33b);
+    // Column major order, same memory layout
+    auto *dcmatarrf  = (cmat<float,  4, 4> *) drmatarrf;
+    auto *scmatarraf = (cmat<float,  4, 4> *) srmatarraf;
+    auto *scmatarrbf = (cmat<float,  4, 4> *) srmatarrbf;
+    auto *dcmatarrd  = (cmat<double, 4, 4> *) drmatarrd;
+    auto *scmatarrad = (cmat<double, 4, 4> *) srmatarrad;
+    auto *scmatarrbd = (cmat<double, 4, 4> *) srmatarrbd;
 
-    // Zero destination matrices
-    memset(&drmat33,  0, sizeof(drmat33));
-    memset(&drmat22,  0, sizeof(drmat22));
-    memset(&drmat33c, 0, sizeof(drmat33c));
-    memset(&dcmat33,  0, sizeof(dcmat33));
-    memset(&dcmat22,  0, sizeof(dcmat22));
-    memset(&dcmat33c, 0, sizeof(dcmat33c));
+    memset(drmatarrf, 0, bytesmatf);
+    memset(drmatarrd, 0, bytesmatd);
+    rmatarr_x_rmat(drmatarrf, srmatarraf, srmatbf, elements);
+    rmatarr_x_rmat(drmatarrd, srmatarrad, srmatbd, elements);
+    compare_matarr<float,  4, 4>(drmatarrf, ematf, elements,
+                                 "mat[] 4x4 * matb  4x4 float  test ");
+    compare_matarr<double, 4, 4>(drmatarrd, ematd, elements,
+                                 "mat[] 4x4 * matb  4x4 double test ");
 
-    // Perform the row and column major order multiplications
-    rmata_x_rmatb(drmat33,  srmat32,  srmat23);
-    rmata_x_rmatb(drmat22,  srmat23,  srmat32);
-    rmata_x_rmatb(drmat33c, srmat33a, srmat33b);
-    cmatb_x_cmata(dcmat33,  scmat23,  scmat32);
-    cmatb_x_cmata(dcmat22,  scmat32,  scmat23);
-    cmatb_x_cmata(dcmat33c, scmat33b, scmat33a);
+    memset(drmatarrf, 0, bytesmatf);
+    memset(drmatarrd, 0, bytesmatd);
+    rmat_x_rmatarr(drmatarrf, srmataf, srmatarrbf, elements);
+    rmat_x_rmatarr(drmatarrd, srmatad, srmatarrbd, elements);
+    compare_matarr<float,  4, 4>(drmatarrf, ematf, elements,
+                                 "mata  4x4 * mat[] 4x4 float  test ");
+    compare_matarr<double, 4, 4>(drmatarrd, ematd, elements,
+                                 "mata  4x4 * mat[] 4x4 double test ");
+
+    memset(dcmatarrf, 0, bytesmatf);
+    memset(dcmatarrd, 0, bytesmatd);
+    cmat_x_cmatarr(dcmatarrf, scmatbf, scmatarraf, elements);
+    cmat_x_cmatarr(dcmatarrd, scmatbd, scmatarrad, elements);
+    compare_matarr<float,  4, 4>(dcmatarrf, ematf, elements,
+                                 "matb  4x4 * mat[] 4x4 float  test ");
+    compare_matarr<double, 4, 4>(dcmatarrd, ematd, elements,
+                                 "matb  4x4 * mat[] 4x4 double test ");
+
+    memset(dcmatarrf, 0, bytesmatf);
+    memset(dcmatarrd, 0, bytesmatd);
+    cmatarr_x_cmat(dcmatarrf, scmatarrbf, scmataf, elements);
+    cmatarr_x_cmat(dcmatarrd, scmatarrbd, scmatad, elements);
+    compare_matarr<float,  4, 4>(dcmatarrf, ematf, elements,
+                                 "mat[] 4x4 * mata  4x4 float  test ");
+    compare_matarr<double, 4, 4>(dcmatarrd, ematd, elements,
+                                 "mat[] 4x4 * mata  4x4 double test ");
+
+    memset(drmatarrf, 0, bytesmatf);
+    memset(drmatarrd, 0, bytesmatd);
+    matarr_x_matarr(drmatarrf, srmatarraf, srmatarrbf, elements);
+    matarr_x_matarr(drmatarrd, srmatarrad, srmatarrbd, elements);
+    compare_matarr<float,  4, 4>(drmatarrf, ematf, elements,
+                                 "mat[] 4x4 * mat[] 4x4 float  test ");
+    compare_matarr<double, 4, 4>(drmatarrd, ematd, elements,
+                                 "mat[] 4x4 * mat[] 4x4 double test ");
+
+    // Lane interleaved copies of the arrays
+    auto blocksf   = soa_blocks<float,  4, 4>(elements);
+    auto blocksd   = soa_blocks<double, 4, 4>(elements);
+    auto bytessoaf = blocksf * sizeof(matsoa<float,  4, 4>);
+    auto bytessoad = blocksd * sizeof(matsoa<double, 4, 4>);
+
+    auto *dsoaf  = (matsoa<float,  4, 4> *) alloc_aligned(bytessoaf);
+    auto *ssoaaf = (matsoa<float,  4, 4> *) alloc_aligned(bytessoaf);
+    auto *ssoabf = (matsoa<float,  4, 4> *) alloc_aligned(bytessoaf);
+    auto *dsoad  = (matsoa<double, 4, 4> *) alloc_aligned(bytessoad);
+    auto *ssoaad = (matsoa<double, 4, 4> *) alloc_aligned(bytessoad);
+    auto *ssoabd = (matsoa<double, 4, 4> *) alloc_aligned(bytessoad);
+
+    if (   dsoaf  == nullptr
+        || ssoaaf == nullptr
+        || ssoabf == nullptr
+        || dsoad  == nullptr
+        || ssoaad == nullptr
+        || ssoabd == nullptr) {
+        cout << "Failed to allocate memory for lane interleaved arrays" << endl;
+        exit(1);
+    }
+
+    matarr_to_soa(ssoaaf, srmatarraf, elements);
+    matarr_to_soa(ssoabf, srmatarrbf, elements);
+    matarr_to_soa(ssoaad, srmatarrad, elements);
+    matarr_to_soa(ssoabd, srmatarrbd, elements);
+
+    memset(drmatarrf, 0, bytesmatf);
+    memset(drmatarrd, 0, bytesmatd);
+    matsoa_x_matsoa(dsoaf, ssoaaf, ssoabf, blocksf);
+    matsoa_x_matsoa(dsoad, ssoaad, ssoabd, blocksd);
+    soa_to_matarr(drmatarrf, dsoaf, elements);
+    soa_to_matarr(drmatarrd, dsoad, elements);
+    compare_matarr<float,  4, 4>(drmatarrf, ematf, elements,
+                                 "soa   4x4 * soa   4x4 float  test ");
+    compare_matarr<double, 4, 4>(drmatarrd, ematd, elements,
+                                 "soa   4x4 * soa   4x4 double test ");
 
-    // Compare actual and expected results
-    compare_mat<int, 3, 3>(drmat33,  emat33,  "mata  3x2 * matb  2x3 int    test ");
-    compare_mat<int, 2, 2>(drmat22,  emat22,  "mata  2x3 * matb  3x2 int    test ");
-    compare_mat<int, 3, 3>(drmat33c, emat33c, "mata  3x3 * matb  3x3 int    test ");
-    compare_mat<int, 3, 3>(dcmat33,  emat33,  "matb  2x3 * mata  3x2 int    test ");
-    compare_mat<int, 2, 2>(dcmat22,  emat22,  "matb  3x2 * mata  2x3 int    test ");
-    compare_mat<int, 3, 3>(dcmat33c, emat33c, "matb  3x3 * mata  3x3 int    test ");
 
-    
     
     // -------------------------------------------------------------------------
-    // Time the multiplcations
+    // Test the inverses and determinants.
+    // Test data chosen so all the intermediate results are exact.
 
-    volatile auto specf = other;
-    timer<int, std::milli> timer;
-    for (int i = 0; i < iterations; ++i) {
-        specf = rmata_x_rmatb(drmatf, srmataf, srmatbf);
-    }
-    auto millif = timer.elapsed();
+    float  tinvf[]   = {  2,  2, -1,  1,  2, -2,  3, -1,
+                         -1,  2, -3,  3, -1, -1,  1, -2 };
+    float  einvf[]   = { -1,   -2,   -3, -4, 2.5, 3.5, 5, 7,
+                         2.5, 4.5,  6,  8, 0.5, 1.5, 2, 2 };
+    float  trigidf[] = {  0,  1,  0,  0, -1,  0,  0,  0,
+                          0,  0,  1,  0,  3,  4,  5,  1 };
+    float  erigidf[] = {  0, -1,  0,  0,  1,  0,  0,  0,
+                          0,  0,  1,  0, -4,  3, -5,  1 };
+    double tinvd[16], einvd[16], trigidd[16], erigidd[16];
+    float  detf[2];
+    double detd[2];
 
-    volatile auto specd = other;
-    timer.start();
-    for (int i = 0; i < iterations; ++i) {
-        specd = rmata_x_rmatb(drmatd, srmatad, srmatbd);
+    for (int i = 0; i < 16; ++i) {
+        tinvd[i]   = tinvf[i];
+        einvd[i]   = einvf[i];
+        trigidd[i] = trigidf[i];
+        erigidd[i] = erigidf[i];
     }
-    auto millid = timer.elapsed();
 
-    cout.imbue(std::locale(""));
-    cout << "iterations          " << iterations            << endl
-         << "vec array elements  " << elements              << endl
-         << "                 float                 double" << endl
-         << "mata x matb " << setw(width) << millif         << " ms "
-                           << get_string(specf)             << " "
-                           << setw(width) << millid         << " ms "
-                           << get_string(specd)             << endl;
+    rmat<float,  4, 4> sinvf[2], dinvf[2], srigidf;
+    rmat<double, 4, 4> sinvd[2], dinvd[2], srigidd;
 
-    specf = other;
+    sinvf[0].set (tinvf);
+    sinvf[1].set (tinvf);
+    sinvd[0].set (tinvd);
+    sinvd[1].set (tinvd);
+    srigidf.set  (trigidf);
+    srigidd.set  (trigidd);
+
+    detf[0] = detf[1] = 0;
+    detd[0] = detd[1] = 0;
+    determinant(detf[0], sinvf[0]);
+    determinant(detd[0], sinvd[0]);
+    cout << "det   4x4             float  test " << (detf[0] == 2 ? passed : failed) << endl;
+    cout << "det   4x4             double test " << (detd[0] == 2 ? passed : failed) << endl;
+
+    memset(dinvf, 0, sizeof(dinvf));
+    memset(dinvd, 0, sizeof(dinvd));
+    inverse(dinvf[0], sinvf[0]);
+    inverse(dinvd[0], sinvd[0]);
+    compare_mat<float,  4, 4>(dinvf[0], einvf, "inv   4x4             float  test ");
+    compare_mat<double, 4, 4>(dinvd[0], einvd, "inv   4x4             double test ");
+
+    memset(dinvf, 0, sizeof(dinvf));
+    memset(dinvd, 0, sizeof(dinvd));
+    rigid_inverse(dinvf[0], srigidf);
+    rigid_inverse(dinvd[0], srigidd);
+    compare_mat<float,  4, 4>(dinvf[0], erigidf, "rigid 4x4 inverse     float  test ");
+    compare_mat<double, 4, 4>(dinvd[0], erigidd, "rigid 4x4 inverse     double test ");
+
+    memset(dinvf, 0, sizeof(dinvf));
+    memset(dinvd, 0, sizeof(dinvd));
+    matarr_determinant(detf, sinvf, 2);
+    matarr_determinant(detd, sinvd, 2);
+    matarr_inverse(dinvf, sinvf, 2);
+    matarr_inverse(dinvd, sinvd, 2);
+    cout << "det[] 4x4             float  test "
+         << (detf[0] == 2 && detf[1] == 2 ? passed : failed) << endl;
+    cout << "det[] 4x4             double test "
+         << (detd[0] == 2 && detd[1] == 2 ? passed : failed) << endl;
+    compare_matarr<float,  4, 4>(dinvf, einvf, 2, "inv[] 4x4             float  test ");
+    compare_matarr<double, 4, 4>(dinvd, einvd, 2, "inv[] 4x4             double test ");
+
+
+    
+    // -------------------------------------------------------------------------
+    // Test the transposes and conversions between row and column major order
+
+    float  etransf[16];
+    double etransd[16];
+
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            etransf[j * 4 + i] = srmataf.m[i][j];
+            etransd[j * 4 + i] = srmatad.m[i][j];
+        }
+    }
+
+    rmat<float,  4, 4> dtransf, rtransf;
+    rmat<double, 4, 4> dtransd, rtransd;
+    cmat<float,  4, 4> ctransf;
+    cmat<double, 4, 4> ctransd;
+
+    memset(&dtransf, 0, sizeof(dtransf));
+    memset(&dtransd, 0, sizeof(dtransd));
+    transpose(dtransf, srmataf);
+    transpose(dtransd, srmatad);
+    compare_mat<float,  4, 4>(dtransf, etransf, "trans 4x4             float  test ");
+    compare_mat<double, 4, 4>(dtransd, etransd, "trans 4x4             double test ");
+
+    // Round trip through column major order
+    memset(&rtransf, 0, sizeof(rtransf));
+    memset(&rtransd, 0, sizeof(rtransd));
+    rmat_to_cmat(ctransf, srmataf);
+    rmat_to_cmat(ctransd, srmatad);
+    cmat_to_rmat(rtransf, ctransf);
+    cmat_to_rmat(rtransd, ctransd);
+    compare_mat<float,  4, 4>(ctransf, etransf, "rmat  4x4 to cmat     float  test ");
+    compare_mat<double, 4, 4>(ctransd, etransd, "rmat  4x4 to cmat     double test ");
+    compare_mat<float,  4, 4>(rtransf, srmataf.m[0], "cmat  4x4 to rmat     float  test ");
+    compare_mat<double, 4, 4>(rtransd, srmatad.m[0], "cmat  4x4 to rmat     double test ");
+
+    // Odd number of matrices in the array
+    int oddmat = (elements - 1) | 1;
+    memset(dcmatarrf, 0, bytesmatf);
+    memset(dcmatarrd, 0, bytesmatd);
+    rmatarr_to_cmatarr(dcmatarrf, srmatarraf, oddmat);
+    rmatarr_to_cmatarr(dcmatarrd, srmatarrad, oddmat);
+    compare_matarr<float,  4, 4>(dcmatarrf, etransf, oddmat,
+                                 "rmat[] 4x4 to cmat[]  float  test ");
+    compare_matarr<double, 4, 4>(dcmatarrd, etransd, oddmat,
+                                 "rmat[] 4x4 to cmat[]  double test ");
+
+
+    
+    // -------------------------------------------------------------------------
+    // Test the normal transformations.
+    // Rotation with a non-uniform scale, the normal matrix is exact.
+
+    float  tnormf[]  = {  0,  2,  0,  0, -1,  0,  0,  0,
+                          0,  0,  4,  0,  5,  6,  7,  1 };
+    double tnormd[16];
+    float  enormf[]  = { -2, 0.5, 0.75, 0 };
+    double enormd[]  = { -2, 0.5, 0.75, 0 };
+    float  enorm3f[] = { -2, 0.5, 0.75 };
+    double enorm3d[] = { -2, 0.5, 0.75 };
+    double length    = std::sqrt(4.8125);
+
+    for (int i = 0; i < 16; ++i) {
+        tnormd[i] = tnormf[i];
+    }
+
+    rmat<float,  4, 4> snormmatf;
+    rmat<double, 4, 4> snormmatd;
+    rvec<float,  4>    snormf[3], dnormf[3];
+    rvec<double, 4>    snormd[3], dnormd[3];
+    rvec<float,  3>    snorm3f[3], dnorm3f[3];
+    rvec<double, 3>    snorm3d[3], dnorm3d[3];
+
+    snormmatf.set(tnormf);
+    snormmatd.set(tnormd);
+
+    for (int i = 0; i < 3; ++i) {
+        snormf[i].set({ 1, 2, 3, 1 });
+        snormd[i].set({ 1, 2, 3, 1 });
+        snorm3f[i].set({ 1, 2, 3 });
+        snorm3d[i].set({ 1, 2, 3 });
+    }
+
+    memset(dnormf, 0, sizeof(dnormf));
+    memset(dnormd, 0, sizeof(dnormd));
+    memset(dnorm3f, 0, sizeof(dnorm3f));
+    memset(dnorm3d, 0, sizeof(dnorm3d));
+    rnormarr_x_rmat(dnormf,  snormf,  snormmatf, 3);
+    rnormarr_x_rmat(dnormd,  snormd,  snormmatd, 3);
+    rnormarr_x_rmat(dnorm3f, snorm3f, snormmatf, 3);
+    rnormarr_x_rmat(dnorm3d, snorm3d, snormmatd, 3);
+    compare_vec<float,  4>(dnormf,  enormf,  enormf,  3, "norm[] 1x4 * mat 4x4  float  test ");
+    compare_vec<double, 4>(dnormd,  enormd,  enormd,  3, "norm[] 1x4 * mat 4x4  double test ");
+    compare_vec<float,  3>(dnorm3f, enorm3f, enorm3f, 3, "norm[] 1x3 * mat 4x4  float  test ");
+    compare_vec<double, 3>(dnorm3d, enorm3d, enorm3d, 3, "norm[] 1x3 * mat 4x4  double test ");
+
+    // Normalized in the same pass, float uses an approximate reciprocal square root
+    rnormarr_x_rmat(dnormf,  snormf,  snormmatf, 3, true);
+    rnormarr_x_rmat(dnormd,  snormd,  snormmatd, 3, true);
+    rnormarr_x_rmat(dnorm3f, snorm3f, snormmatf, 3, true);
+    rnormarr_x_rmat(dnorm3d, snorm3d, snormmatd, 3, true);
+
+    auto validf = true;
+    auto validd = true;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            validf = validf && std::abs(dnormf[i].v[j]  - enormd[j] / length) < 1e-6;
+            validf = validf && std::abs(dnorm3f[i].v[j] - enormd[j] / length) < 1e-6;
+            validd = validd && std::abs(dnormd[i].v[j]  - enormd[j] / length) < 1e-15;
+            validd = validd && std::abs(dnorm3d[i].v[j] - enormd[j] / length) < 1e-15;
+        }
+        validf = validf && dnormf[i].v[3] == 0;
+        validd = validd && dnormd[i].v[3] == 0;
+    }
+    cout << "norm[] normalized     float  test " << (validf ? passed : failed) << endl;
+    cout << "norm[] normalized     double test " << (validd ? passed : failed) << endl;
+
+
+    
+    // -------------------------------------------------------------------------
+    // Test the fused projection, perspective divide and viewport.
+    // Odd numbered vectors are behind the viewer, w <= 0.
+    // An odd number of vectors verifies nothing is written past the end.
+
+    float  tprojf[]   = { 1, 0,  0, 0, 0, 1, 0, 0,
+                          0, 0,  1, 1, 0, 0, -1, 0 };
+    double tprojd[16];
+    float  eproj0f[]  = { 400, 360, 0.9375,  0.125 };
+    float  eproj1f[]  = { 160, 120, 1.25,   -0.5   };
+    double eproj0d[]  = { 400, 360, 0.9375,  0.125 };
+    double eproj1d[]  = { 160, 120, 1.25,   -0.5   };
+
+    for (int i = 0; i < 16; ++i) {
+        tprojd[i] = tprojf[i];
+    }
+
+    rmat<float,  4, 4> sprojmatf;
+    rmat<double, 4, 4> sprojmatd;
+    vec<float,   4>    scalef, offsetf;
+    vec<double,  4>    scaled, offsetd;
+    rvec<float,  4>    sprojf[8], dprojf[8];
+    rvec<double, 4>    sprojd[8], dprojd[8];
+    unsigned char      clipf[8], clipd[8];
+
+    sprojmatf.set (tprojf);
+    sprojmatd.set (tprojd);
+    scalef.set    ({ 320, 240, 0.5, 1 });
+    scaled.set    ({ 320, 240, 0.5, 1 });
+    offsetf.set   ({ 320, 240, 0.5, 0 });
+    offsetd.set   ({ 320, 240, 0.5, 0 });
+
+    for (int i = 0; i < 8; ++i) {
+        if (i & 1) {
+            sprojf[i].set({ 1, 1, -2, 1 });
+            sprojd[i].set({ 1, 1, -2, 1 });
+        } else {
+            sprojf[i].set({ 2, 4,  8, 1 });
+            sprojd[i].set({ 2, 4,  8, 1 });
+        }
+    }
+
+    memset(dprojf, 0, sizeof(dprojf));
+    memset(dprojd, 0, sizeof(dprojd));
+    memset(clipf,  0, sizeof(clipf));
+    memset(clipd,  0, sizeof(clipd));
+    rprojarr_x_rmat(dprojf, sprojf, sprojmatf, scalef, offsetf, 7, false, clipf);
+    rprojarr_x_rmat(dprojd, sprojd, sprojmatd, scaled, offsetd, 7, false, clipd);
+    compare_vec<float,  4>(dprojf, eproj0f, eproj1f, 7,
+                           "proj[] 1x4 * mat 4x4  float  test ", true);
+    compare_vec<double, 4>(dprojd, eproj0d, eproj1d, 7,
+                           "proj[] 1x4 * mat 4x4  double test ", true);
+
+    validf = true;
+    validd = true;
+    for (int i = 0; i < 8; ++i) {
+        validf = validf && clipf[i] == (i < 7 && (i & 1));
+        validd = validd && clipd[i] == (i < 7 && (i & 1));
+    }
+    cout << "proj[] clip flags     float  test " << (validf ? passed : failed) << endl;
+    cout << "proj[] clip flags     double test " << (validd ? passed : failed) << endl;
+
+    // Reciprocal approximation, compare within a relative tolerance
+    rprojarr_x_rmat(dprojf, sprojf, sprojmatf, scalef, offsetf, 7, true);
+    rprojarr_x_rmat(dprojd, sprojd, sprojmatd, scaled, offsetd, 7, true);
+
+    validf = true;
+    validd = true;
+    for (int i = 0; i < 7; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            double expected = (i & 1) ? eproj1d[j] : eproj0d[j];
+            validf = validf && std::abs(dprojf[i].v[j] - expected) <= 1e-5  * std::abs(expected);
+            validd = validd && std::abs(dprojd[i].v[j] - expected) <= 1e-12 * std::abs(expected);
+        }
+    }
+    cout << "proj[] approximate    float  test " << (validf ? passed : failed) << endl;
+    cout << "proj[] approximate    double test " << (validd ? passed : failed) << endl;
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test the quaternion conversions and rotations.
+    // [ 0.5, 0.5, -0.5, 0.5 ] rotates [ x, y, z ] to [ y, -z, -x ].
+    // An odd number of vectors verifies nothing is written past the end.
+
+    float  equatf[]  = { 0, 0, -1, 0, 1, 0, 0, 0, 0, -1, 0, 0, 0, 0, 0, 1 };
+    double equatd[]  = { 0, 0, -1, 0, 1, 0, 0, 0, 0, -1, 0, 0, 0, 0, 0, 1 };
+    float  equat0f[] = { 2, -3, -1, 1 };
+    float  equat1f[] = { 5, -6, -4, 0 };
+    double equat0d[] = { 2, -3, -1, 1 };
+    double equat1d[] = { 5, -6, -4, 0 };
+
+    auto *squatarrf = (quat<float>  *) alloc_aligned(elements * sizeof(quat<float>));
+    auto *squatarrd = (quat<double> *) alloc_aligned(elements * sizeof(quat<double>));
+
+    if (squatarrf == nullptr || squatarrd == nullptr) {
+        cout << "Failed to allocate memory for quaternion arrays" << endl;
+        exit(1);
+    }
+
+    quat<float>     squatf;
+    quat<double>    squatd;
+    rvec<float,  4> squatvecf[8], dquatvecf[8];
+    rvec<double, 4> squatvecd[8], dquatvecd[8];
+    rvec<float,  3> squatvec3f[8], dquatvec3f[8];
+    rvec<double, 3> squatvec3d[8], dquatvec3d[8];
+
+    squatf.set({ 0.5, 0.5, -0.5, 0.5 });
+    squatd.set({ 0.5, 0.5, -0.5, 0.5 });
+
+    for (int i = 0; i < elements; ++i) {
+        squatarrf[i] = squatf;
+        squatarrd[i] = squatd;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        if (i & 1) {
+            squatvecf[i].set ({ 4, 5, 6, 0 });
+            squatvecd[i].set ({ 4, 5, 6, 0 });
+            squatvec3f[i].set({ 4, 5, 6 });
+            squatvec3d[i].set({ 4, 5, 6 });
+        } else {
+            squatvecf[i].set ({ 1, 2, 3, 1 });
+            squatvecd[i].set ({ 1, 2, 3, 1 });
+            squatvec3f[i].set({ 1, 2, 3 });
+            squatvec3d[i].set({ 1, 2, 3 });
+        }
+    }
+
+    memset(drmatarrf, 0, bytesmatf);
+    memset(drmatarrd, 0, bytesmatd);
+    quatarr_to_rmatarr(drmatarrf, squatarrf, elements);
+    quatarr_to_rmatarr(drmatarrd, squatarrd, elements);
+    compare_matarr<float,  4, 4>(drmatarrf, equatf, elements,
+                                 "quat[] to rmat[] 4x4  float  test ");
+    compare_matarr<double, 4, 4>(drmatarrd, equatd, elements,
+                                 "quat[] to rmat[] 4x4  double test ");
+
+    memset(dquatvecf,  0, sizeof(dquatvecf));
+    memset(dquatvecd,  0, sizeof(dquatvecd));
+    memset(dquatvec3f, 0, sizeof(dquatvec3f));
+    memset(dquatvec3d, 0, sizeof(dquatvec3d));
+    rvecarr_x_quat(dquatvecf,  squatvecf,  squatf, 7);
+    rvecarr_x_quat(dquatvecd,  squatvecd,  squatd, 7);
+    rvecarr_x_quat(dquatvec3f, squatvec3f, squatf, 7);
+    rvecarr_x_quat(dquatvec3d, squatvec3d, squatd, 7);
+    compare_vec<float,  4>(dquatvecf,  equat0f, equat1f, 7,
+                           "vec[] 1x4 * quat      float  test ", true);
+    compare_vec<double, 4>(dquatvecd,  equat0d, equat1d, 7,
+                           "vec[] 1x4 * quat      double test ", true);
+    compare_vec<float,  3>(dquatvec3f, equat0f, equat1f, 7,
+                           "vec[] 1x3 * quat      float  test ", true);
+    compare_vec<double, 3>(dquatvec3d, equat0d, equat1d, 7,
+                           "vec[] 1x3 * quat      double test ", true);
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test composing and decomposing translation, rotation and scale.
+    // Translation [ 1, 2, 3 ], the rotation above, scale [ 2, 4, 8 ].
+
+    float  etrsf[] = { 0, 0, -2, 0, 4, 0, 0, 0, 0, -8, 0, 0, 1, 2, 3, 1 };
+    double etrsd[] = { 0, 0, -2, 0, 4, 0, 0, 0, 0, -8, 0, 0, 1, 2, 3, 1 };
+
+    auto bytestrsf = elements * sizeof(rvec<float,  4>);
+    auto bytestrsd = elements * sizeof(rvec<double, 4>);
+
+    auto *strsarrf = (rvec<float,  4> *) alloc_aligned(bytestrsf);
+    auto *ssclarrf = (rvec<float,  4> *) alloc_aligned(bytestrsf);
+    auto *dtrsarrf = (rvec<float,  4> *) alloc_aligned(bytestrsf);
+    auto *dsclarrf = (rvec<float,  4> *) alloc_aligned(bytestrsf);
+    auto *dquatarrf = (quat<float>    *) alloc_aligned(elements * sizeof(quat<float>));
+    auto *strsarrd = (rvec<double, 4> *) alloc_aligned(bytestrsd);
+    auto *ssclarrd = (rvec<double, 4> *) alloc_aligned(bytestrsd);
+    auto *dtrsarrd = (rvec<double, 4> *) alloc_aligned(bytestrsd);
+    auto *dsclarrd = (rvec<double, 4> *) alloc_aligned(bytestrsd);
+    auto *dquatarrd = (quat<double>   *) alloc_aligned(elements * sizeof(quat<double>));
+
+    if (   strsarrf  == nullptr
+        || ssclarrf  == nullptr
+        || dtrsarrf  == nullptr
+        || dsclarrf  == nullptr
+        || dquatarrf == nullptr
+        || strsarrd  == nullptr
+        || ssclarrd  == nullptr
+        || dtrsarrd  == nullptr
+        || dsclarrd  == nullptr
+        || dquatarrd == nullptr) {
+        cout << "Failed to allocate memory for transform arrays" << endl;
+        exit(1);
+    }
+
+    for (int i = 0; i < elements; ++i) {
+        strsarrf[i].set({ 1, 2, 3, 0 });
+        ssclarrf[i].set({ 2, 4, 8, 0 });
+        strsarrd[i].set({ 1, 2, 3, 0 });
+        ssclarrd[i].set({ 2, 4, 8, 0 });
+    }
+
+    memset(drmatarrf, 0, bytesmatf);
+    memset(drmatarrd, 0, bytesmatd);
+    trsarr_to_rmatarr(drmatarrf, strsarrf, squatarrf, ssclarrf, elements);
+    trsarr_to_rmatarr(drmatarrd, strsarrd, squatarrd, ssclarrd, elements);
+    compare_matarr<float,  4, 4>(drmatarrf, etrsf, elements,
+                                 "trs[] to rmat[] 4x4   float  test ");
+    compare_matarr<double, 4, 4>(drmatarrd, etrsd, elements,
+                                 "trs[] to rmat[] 4x4   double test ");
+
+    // Decompose the composed matrices back, the 4th elements are 1
+    rmatarr_to_trsarr(dtrsarrf, dquatarrf, dsclarrf, drmatarrf, elements);
+    rmatarr_to_trsarr(dtrsarrd, dquatarrd, dsclarrd, drmatarrd, elements);
+
+    validf = true;
+    validd = true;
+    for (int i = 0; i < elements; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            validf = validf && dtrsarrf[i].v[j]  == (j < 3 ? strsarrf[i].v[j] : 1)
+                            && dsclarrf[i].v[j]  == (j < 3 ? ssclarrf[i].v[j] : 1)
+                            && dquatarrf[i].v[j] == squatf.v[j];
+            validd = validd && dtrsarrd[i].v[j]  == (j < 3 ? strsarrd[i].v[j] : 1)
+                            && dsclarrd[i].v[j]  == (j < 3 ? ssclarrd[i].v[j] : 1)
+                            && dquatarrd[i].v[j] == squatd.v[j];
+        }
+    }
+    cout << "rmat[] 4x4 to trs[]   float  test " << (validf ? passed : failed) << endl;
+    cout << "rmat[] 4x4 to trs[]   double test " << (validd ? passed : failed) << endl;
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test the hierarchy update, a 4-ary tree with 2 roots and its nodes
+    // scattered through the arrays. Local matrices are translations and
+    // quarter turns, so the world matrices are exact.
+
+    std::vector<long> parent(elements);
+
+    for (int i = 0; i < elements; ++i) {
+        parent[(i * 7) % elements] = (i < 2) ? -1 : ((i - 1) / 4 * 7) % elements;
+    }
+
+    hierarchy tree;
+    bool      built = build_hierarchy(tree, parent.data(), elements);
+
+    auto *hlocalf = (rmat<float,  4, 4> *) alloc_aligned(bytesmatf);
+    auto *hreff   = (rmat<float,  4, 4> *) alloc_aligned(bytesmatf);
+    auto *hlocald = (rmat<double, 4, 4> *) alloc_aligned(bytesmatd);
+    auto *hrefd   = (rmat<double, 4, 4> *) alloc_aligned(bytesmatd);
+
+    if (   hlocalf == nullptr
+        || hreff   == nullptr
+        || hlocald == nullptr
+        || hrefd   == nullptr) {
+        cout << "Failed to allocate memory for hierarchy arrays" << endl;
+        exit(1);
+    }
+
+    for (int i = 0; i < elements; ++i) {
+        if (i & 1) {
+            hlocalf[i].set({ 0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 1, float(i % 3), 0, 1 });
+            hlocald[i].set({ 0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 1, double(i % 3), 0, 1 });
+        } else {
+            hlocalf[i].set({ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 1, float(i % 5), 1 });
+            hlocald[i].set({ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 1, double(i % 5), 1 });
+        }
+    }
+
+    // Reference walks up to the root one node at a time
+    for (int i = 0; i < elements; ++i) {
+        hreff[i] = hlocalf[i];
+        hrefd[i] = hlocald[i];
+
+        for (long p = parent[i]; p >= 0; p = parent[p]) {
+            rmat<float,  4, 4> tf = hreff[i];
+            rmat<double, 4, 4> td = hrefd[i];
+
+            rmata_x_rmatb(hreff[i], tf, hlocalf[p]);
+            rmata_x_rmatb(hrefd[i], td, hlocald[p]);
+        }
+    }
+
+    for (int threads = 1; threads <= 4; threads += 3) {
+        memset(drmatarrf, 0, bytesmatf);
+        memset(drmatarrd, 0, bytesmatd);
+        update_rhierarchy(drmatarrf, hlocalf, tree, threads);
+        update_rhierarchy(drmatarrd, hlocald, tree, threads);
+
+        validf = built && tree.levels() == 5;
+        validd = built && tree.levels() == 5;
+        for (int i = 0; i < elements; ++i) {
+            validf = validf && memcmp(&drmatarrf[i], &hreff[i], sizeof(hreff[i])) == 0;
+            validd = validd && memcmp(&drmatarrd[i], &hrefd[i], sizeof(hrefd[i])) == 0;
+        }
+        cout << (threads == 1 ? "hierarchy 4x4         float  test "
+                              : "hierarchy 4 threads   float  test ")
+             << (validf ? passed : failed) << endl;
+        cout << (threads == 1 ? "hierarchy 4x4         double test "
+                              : "hierarchy 4 threads   double test ")
+             << (validd ? passed : failed) << endl;
+    }
+
+    // A wide level split across more threads than it has full chunks,
+    // 4481 children make a last chunk shorter than the others
+    const int                       wide = 4482;
+    std::vector<long>               wparent(wide, 0);
+    std::vector<rmat<float,  4, 4>> wlocalf(wide), wworldf(wide);
+    std::vector<rmat<double, 4, 4>> wlocald(wide), wworldd(wide);
+    hierarchy                       wtree;
+
+    wparent[0] = -1;
+    built = build_hierarchy(wtree, wparent.data(), wide);
+
+    for (int i = 0; i < wide; ++i) {
+        wlocalf[i] = hlocalf[i % elements];
+        wlocald[i] = hlocald[i % elements];
+    }
+
+    update_rhierarchy(wworldf.data(), wlocalf.data(), wtree, 70);
+    update_rhierarchy(wworldd.data(), wlocald.data(), wtree, 70);
+
+    validf = built && wtree.levels() == 2;
+    validd = built && wtree.levels() == 2;
+    for (int i = 1; i < wide; ++i) {
+        rmat<float,  4, 4> ef;
+        rmat<double, 4, 4> ed;
+
+        rmata_x_rmatb(ef, wlocalf[i], wlocalf[0]);
+        rmata_x_rmatb(ed, wlocald[i], wlocald[0]);
+        validf = validf && memcmp(&wworldf[i], &ef, sizeof(ef)) == 0;
+        validd = validd && memcmp(&wworldd[i], &ed, sizeof(ed)) == 0;
+    }
+    cout << "hierarchy 70 threads  float  test " << (validf ? passed : failed) << endl;
+    cout << "hierarchy 70 threads  double test " << (validd ? passed : failed) << endl;
+
+    // Parents that form a cycle are rejected
+    parent[0] = 1;
+    parent[1] = 0;
+    hierarchy cycle;
+    cout << "hierarchy cycle              test "
+         << (build_hierarchy(cycle, parent.data(), elements) ? failed : passed) << endl;
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test linear blend skinning with a palette of 64 bones.
+    // Bone k scales by k + 1 and translates by [ k, 2k, 4k ].
+    // Even numbered vertices blend 4 bones, odd numbered vertices use one.
+
+    const int bones = 64;
+
+    float  eskin0f[]  = { 5, 10, 17, 1 };
+    float  eskin1f[]  = { 3,  6, 10, 1 };
+    float  enskin0f[] = { 0,  0,  3, 0 };
+    float  enskin1f[] = { 0,  2,  0, 0 };
+    double eskin0d[]  = { 5, 10, 17, 1 };
+    double eskin1d[]  = { 3,  6, 10, 1 };
+    double enskin0d[] = { 0,  0,  3, 0 };
+    double enskin1d[] = { 0,  2,  0, 0 };
+
+    auto *spalf    = (rmat<float,  4, 4> *) alloc_aligned(bones    * sizeof(rmat<float,  4, 4>));
+    auto *spald    = (rmat<double, 4, 4> *) alloc_aligned(bones    * sizeof(rmat<double, 4, 4>));
+    auto *sbonearr = (vec<unsigned, 4>   *) alloc_aligned(elements * sizeof(vec<unsigned, 4>));
+    auto *swgtarrf = (vec<float,    4>   *) alloc_aligned(elements * sizeof(vec<float,    4>));
+    auto *swgtarrd = (vec<double,   4>   *) alloc_aligned(elements * sizeof(vec<double,   4>));
+    auto *dnrmarrf = (rvec<float,   4>   *) alloc_aligned(elements * sizeof(rvec<float,   4>));
+    auto *dnrmarrd = (rvec<double,  4>   *) alloc_aligned(elements * sizeof(rvec<double,  4>));
+
+    if (   spalf    == nullptr
+        || spald    == nullptr
+        || sbonearr == nullptr
+        || swgtarrf == nullptr
+        || swgtarrd == nullptr
+        || dnrmarrf == nullptr
+        || dnrmarrd == nullptr) {
+        cout << "Failed to allocate memory for skinning arrays" << endl;
+        exit(1);
+    }
+
+    for (int k = 0; k < bones; ++k) {
+        float  sf = float(k + 1);
+        double sd = double(k + 1);
+
+        spalf[k].set({ sf, 0, 0, 0, 0, sf, 0, 0, 0, 0, sf, 0,
+                       float(k),  float(2 * k),  float(4 * k),  1 });
+        spald[k].set({ sd, 0, 0, 0, 0, sd, 0, 0, 0, 0, sd, 0,
+                       double(k), double(2 * k), double(4 * k), 1 });
+    }
+
+    rvec<float,  4> sskinf[8], dskinf[8], snskinf[8], dnskinf[8];
+    rvec<double, 4> sskind[8], dskind[8], snskind[8], dnskind[8];
+    vec<unsigned, 4> sbone[8];
+    vec<float,    4> swgtf[8];
+    vec<double,   4> swgtd[8];
+
+    for (int i = 0; i < 8; ++i) {
+        sskinf[i].set({ 1, 2, 3, 1 });
+        sskind[i].set({ 1, 2, 3, 1 });
+
+        if (i & 1) {
+            snskinf[i].set({ 0, 1, 0, 0 });
+            snskind[i].set({ 0, 1, 0, 0 });
+            sbone[i].set  ({ 1, 1, 1, 1 });
+            swgtf[i].set  ({ 1, 0, 0, 0 });
+            swgtd[i].set  ({ 1, 0, 0, 0 });
+        } else {
+            snskinf[i].set({ 0, 0, 1, 0 });
+            snskind[i].set({ 0, 0, 1, 0 });
+            sbone[i].set  ({ 3, 1, 0, 2 });
+            swgtf[i].set  ({ 0.5, 0.25, 0.125, 0.125 });
+            swgtd[i].set  ({ 0.5, 0.25, 0.125, 0.125 });
+        }
+    }
+
+    memset(dskinf,  0, sizeof(dskinf));
+    memset(dskind,  0, sizeof(dskind));
+    memset(dnskinf, 0, sizeof(dnskinf));
+    memset(dnskind, 0, sizeof(dnskind));
+    rskinarr_x_rmatarr(dskinf, sskinf, spalf, sbone, swgtf, 7, dnskinf, snskinf);
+    rskinarr_x_rmatarr(dskind, sskind, spald, sbone, swgtd, 7, dnskind, snskind);
+    compare_vec<float,  4>(dskinf,  eskin0f,  eskin1f,  7,
+                           "skin[] 1x4 * mat[]    float  test ", true);
+    compare_vec<double, 4>(dskind,  eskin0d,  eskin1d,  7,
+                           "skin[] 1x4 * mat[]    double test ", true);
+    compare_vec<float,  4>(dnskinf, enskin0f, enskin1f, 7,
+                           "skin[] normals        float  test ", true);
+    compare_vec<double, 4>(dnskind, enskin0d, enskin1d, 7,
+                           "skin[] normals        double test ", true);
+
+    // Vertices spread over the whole palette for timing, weights sum to 1
+    for (int i = 0; i < elements; ++i) {
+        sbonearr[i].set({ unsigned(i % bones),        unsigned((i * 7) % bones),
+                          unsigned((i * 13) % bones), unsigned((i * 29) % bones) });
+        swgtarrf[i].set({ 0.5, 0.25, 0.125, 0.125 });
+        swgtarrd[i].set({ 0.5, 0.25, 0.125, 0.125 });
+    }
+
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test instanced vectors that select their matrix from the bone palette.
+    // Even numbered vectors use bone 3, odd numbered vectors use bone 5.
+    // The run pre-pass must produce exactly what the indexed path produces.
+
+    float  eidx0f[] = {  7, 14, 24, 1 };
+    float  eidx1f[] = { 11, 22, 38, 1 };
+    double eidx0d[] = {  7, 14, 24, 1 };
+    double eidx1d[] = { 11, 22, 38, 1 };
+
+    auto *sidxarr = (unsigned *) alloc_aligned(elements * sizeof(unsigned));
+    auto *sidxrun = (unsigned *) alloc_aligned(elements * sizeof(unsigned));
+    std::vector<index_run> runs;
+
+    if (   sidxarr == nullptr
+        || sidxrun == nullptr) {
+        cout << "Failed to allocate memory for index arrays" << endl;
+        exit(1);
+    }
+
+    unsigned sidx[8] = { 3, 5, 3, 5, 3, 5, 3, 5 };
+
+    memset(dskinf, 0, sizeof(dskinf));
+    memset(dskind, 0, sizeof(dskind));
+    rvecarr_x_rmatarr_indexed(dskinf, sskinf, spalf, sidx, 7);
+    rvecarr_x_rmatarr_indexed(dskind, sskind, spald, sidx, 7);
+    compare_vec<float,  4>(dskinf, eidx0f, eidx1f, 7,
+                           "vec[] 1x4 * mat[idx]  float  test ", true);
+    compare_vec<double, 4>(dskind, eidx0d, eidx1d, 7,
+                           "vec[] 1x4 * mat[idx]  double test ", true);
+
+    // Scattered indices for timing, and instances drawn in runs of 25 with
+    // a scattered tail to exercise both kinds of entries of the pre-pass
+    for (int i = 0; i < elements; ++i) {
+        sidxarr[i] = unsigned((i * 7) % bones);
+        sidxrun[i] = unsigned(i < elements - 100 ? (i / 25) % bones : (i * 7) % bones);
+    }
+
+    build_index_runs(runs, sidxrun, elements);
+    rvecarr_x_rmatarr_indexed(drvecarrf, srvecarrf, spalf, sidxrun, elements);
+    rvecarr_x_rmatarr_runs   (dnrmarrf,  srvecarrf, spalf, sidxrun, runs);
+    rvecarr_x_rmatarr_indexed(drvecarrd, srvecarrd, spald, sidxrun, elements);
+    rvecarr_x_rmatarr_runs   (dnrmarrd,  srvecarrd, spald, sidxrun, runs);
+    validf = memcmp(drvecarrf, dnrmarrf, elements * sizeof(rvec<float,  4>)) == 0;
+    validd = memcmp(drvecarrd, dnrmarrd, elements * sizeof(rvec<double, 4>)) == 0;
+    cout << "vec[] 1x4 * mat[run]  float  test " << (validf ? passed : failed) << endl;
+    cout << "vec[] 1x4 * mat[run]  double test " << (validd ? passed : failed) << endl;
+
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test bounding boxes culled by the planes of a 20 unit cube.
+    // The planes come from an orthographic projection scaled by 1/10.
+    // The transform rotates 90 degrees, scales by 2 and moves 1 along x.
+    // Box i is centered at [ i - 4, 0, 0 ], only boxes 0 to 9 of 12 are
+    // inside and the zero'd lanes after the last box must stay clear.
+
+    const int  nbox     = 12;
+    unsigned   evisf[]  = { 0x3ff };
+    unsigned   evisd[]  = { 0xff, 0x3 };
+    float      eboxf[]  = { 1, -2, 0, 4, 1, 0.5 };
+    double     eboxd[]  = { 1, -2, 0, 4, 1, 0.5 };
+    rmat<float,  4, 4> sorthof, sboxmf;
+    rmat<double, 4, 4> sorthod, sboxmd;
+    rvec<float,  4>    splanef[6], sboxcf[nbox], sboxef[nbox];
+    rvec<double, 4>    splaned[6], sboxcd[nbox], sboxed[nbox];
+    aabbsoa<float>     saabbf[1], daabbf[1];
+    aabbsoa<double>    saabbd[2], daabbd[2];
+    unsigned           dvisf[1], dvisd[2];
+
+    sorthof.set({ 0.1f, 0, 0, 0, 0, 0.1f, 0, 0, 0, 0, 0.1f, 0, 0, 0, 0, 1 });
+    sorthod.set({ 0.1,  0, 0, 0, 0, 0.1,  0, 0, 0, 0, 0.1,  0, 0, 0, 0, 1 });
+    sboxmf.set({ 0, 2, 0, 0, -2, 0, 0, 0, 0, 0, 2, 0, 1, 0, 0, 1 });
+    sboxmd.set({ 0, 2, 0, 0, -2, 0, 0, 0, 0, 0, 2, 0, 1, 0, 0, 1 });
+    frustum_planes<float> (splanef, sorthof);
+    frustum_planes<double>(splaned, sorthod);
+
+    for (int i = 0; i < nbox; ++i) {
+        sboxcf[i].set({ float(i - 4),  0, 0, 1 });
+        sboxcd[i].set({ double(i - 4), 0, 0, 1 });
+        sboxef[i].set({ 0.5, 2, 0.25, 0 });
+        sboxed[i].set({ 0.5, 2, 0.25, 0 });
+    }
+
+    aabbarr_to_soa<float> (saabbf, sboxcf, sboxef, nbox);
+    aabbarr_to_soa<double>(saabbd, sboxcd, sboxed, nbox);
+    raabbsoa_x_rmat<float> (daabbf, dvisf, saabbf, sboxmf, splanef, 6, nbox);
+    raabbsoa_x_rmat<double>(daabbd, dvisd, saabbd, sboxmd, splaned, 6, nbox);
+    soa_to_aabbarr<float> (sboxcf, sboxef, daabbf, nbox);
+    soa_to_aabbarr<double>(sboxcd, sboxed, daabbd, nbox);
+
+    validf = dvisf[0] == evisf[0];
+    validd = dvisd[0] == evisd[0] && dvisd[1] == evisd[1];
+    for (int j = 0; j < 3; ++j) {
+        validf = validf && sboxcf[3].v[j] == eboxf[j] && sboxef[3].v[j] == eboxf[j + 3];
+        validd = validd && sboxcd[3].v[j] == eboxd[j] && sboxed[3].v[j] == eboxd[j + 3];
+    }
+    cout << "aabb  soa   * mat 4x4 float  test " << (validf ? passed : failed) << endl;
+    cout << "aabb  soa   * mat 4x4 double test " << (validd ? passed : failed) << endl;
+
+    // Boxes along y after the transform, about a quarter inside the planes
+    size_t aabbsf    = aabb_blocks<float> (elements);
+    size_t aabbsd    = aabb_blocks<double>(elements);
+    auto   *saabbarf = (aabbsoa<float>  *) alloc_aligned(aabbsf * sizeof(aabbsoa<float>));
+    auto   *daabbarf = (aabbsoa<float>  *) alloc_aligned(aabbsf * sizeof(aabbsoa<float>));
+    auto   *saabbard = (aabbsoa<double> *) alloc_aligned(aabbsd * sizeof(aabbsoa<double>));
+    auto   *daabbard = (aabbsoa<double> *) alloc_aligned(aabbsd * sizeof(aabbsoa<double>));
+    auto   *dvisarr  = (unsigned        *) alloc_aligned(aabbsd * sizeof(unsigned));
+
+    if (   saabbarf == nullptr
+        || daabbarf == nullptr
+        || saabbard == nullptr
+        || daabbard == nullptr
+        || dvisarr  == nullptr) {
+        cout << "Failed to allocate memory for bounding box arrays" << endl;
+        exit(1);
+    }
+
+    for (int i = 0; i < elements; ++i) {
+        saabbarf[i / aabbsoa<float>::lanes].c[0][i % aabbsoa<float>::lanes]  = float(i % 41 - 20);
+        saabbard[i / aabbsoa<double>::lanes].c[0][i % aabbsoa<double>::lanes] = double(i % 41 - 20);
+        for (int j = 1; j < 3; ++j) {
+            saabbarf[i / aabbsoa<float>::lanes].c[j][i % aabbsoa<float>::lanes]  = float(j);
+            saabbard[i / aabbsoa<double>::lanes].c[j][i % aabbsoa<double>::lanes] = double(j);
+        }
+        for (int j = 0; j < 3; ++j) {
+            saabbarf[i / aabbsoa<float>::lanes].e[j][i % aabbsoa<float>::lanes]  = 0.5f;
+            saabbard[i / aabbsoa<double>::lanes].e[j][i % aabbsoa<double>::lanes] = 0.5;
+        }
+    }
+
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test transforms that keep the bounds and sum of the results.
+    // Vector i is [ i, -i, 2i, 1 ], bone 2 scales by 3 and moves [ 2, 4, 8 ].
+    // The bounds only pass must match the pass that writes the results.
+
+    float  elof[]  = {  2, -14,   8, 1 };
+    float  ehif[]  = { 20,   4,  44, 1 };
+    float  esumf[] = { 77, -35, 182, 7 };
+    double elod[]  = {  2, -14,   8, 1 };
+    double ehid[]  = { 20,   4,  44, 1 };
+    double esumd[] = { 77, -35, 182, 7 };
+    rvec<float,  4> sbndf[7], dbndf[7];
+    rvec<double, 4> sbndd[7], dbndd[7];
+    vec<float,   4> dlof, dhif, dsumf, dlo2f, dhi2f;
+    vec<double,  4> dlod, dhid, dsumd, dlo2d, dhi2d;
+
+    for (int i = 0; i < 7; ++i) {
+        sbndf[i].set({ float(i),  float(-i),  float(2 * i),  1 });
+        sbndd[i].set({ double(i), double(-i), double(2 * i), 1 });
+    }
+
+    rvecarr_x_rmat_bounds<float,  4>(dbndf,   dlof,  dhif,  sbndf, spalf[2], 7, &dsumf);
+    rvecarr_x_rmat_bounds<double, 4>(dbndd,   dlod,  dhid,  sbndd, spald[2], 7, &dsumd);
+    rvecarr_x_rmat_bounds<float,  4>(nullptr, dlo2f, dhi2f, sbndf, spalf[2], 7);
+    rvecarr_x_rmat_bounds<double, 4>(nullptr, dlo2d, dhi2d, sbndd, spald[2], 7);
+
+    validf = dbndf[6].v[0] == 20 && dbndf[6].v[1] == -14 && dbndf[6].v[2] == 44;
+    validd = dbndd[6].v[0] == 20 && dbndd[6].v[1] == -14 && dbndd[6].v[2] == 44;
+    for (int j = 0; j < 4; ++j) {
+        validf = validf && dlof.v[j] == elof[j] && dhif.v[j] == ehif[j] && dsumf.v[j] == esumf[j]
+                        && dlo2f.v[j] == elof[j] && dhi2f.v[j] == ehif[j];
+        validd = validd && dlod.v[j] == elod[j] && dhid.v[j] == ehid[j] && dsumd.v[j] == esumd[j]
+                        && dlo2d.v[j] == elod[j] && dhi2d.v[j] == ehid[j];
+    }
+    cout << "vec[] 1x4 * mat bnds  float  test " << (validf ? passed : failed) << endl;
+    cout << "vec[] 1x4 * mat bnds  double test " << (validd ? passed : failed) << endl;
+
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test transforms that keep only the vectors passing a test.
+    // Vector i is [ i - 3, 0, 0, 1 ]. Bone 1 doubles and moves [ 1, 2, 4 ],
+    // giving x of -5 to 7 by 2, bone 0 leaves the vectors as they are.
+    // Each test keeps a run of the vectors, in order.
+
+    float  ecmpf[3][4] = { { -3, -1, 1, 3 }, { 3, 5, 7 }, { -1, 0, 1 } };
+    double ecmpd[3][4] = { { -3, -1, 1, 3 }, { 3, 5, 7 }, { -1, 0, 1 } };
+    size_t ecount[3]   = { 4, 3, 3 };
+    size_t dcountf, dcountd;
+    rvec<float,  4> scmpf[7], dcmpf[7], sbox0f, sbox1f;
+    rvec<double, 4> scmpd[7], dcmpd[7], sbox0d, sbox1d;
+    condition       stests[3] = { inside_box, above_plane, inside_clip };
+
+    for (int i = 0; i < 7; ++i) {
+        scmpf[i].set({ float(i - 3),  0, 0, 1 });
+        scmpd[i].set({ double(i - 3), 0, 0, 1 });
+    }
+
+    validf = validd = true;
+    for (int t = 0; t < 3; ++t) {
+        if (stests[t] == inside_box) {
+            sbox0f.set({ -3, 0, 0, 0 });
+            sbox0d.set({ -3, 0, 0, 0 });
+            sbox1f.set({  3, 4, 8, 0 });
+            sbox1d.set({  3, 4, 8, 0 });
+        } else {
+            sbox0f.set({ 1, 0, 0, -2 });                   // x >= 2
+            sbox0d.set({ 1, 0, 0, -2 });
+        }
+
+        int bone = stests[t] == inside_clip ? 0 : 1;
+
+        rvecarr_x_rmat_compact<float> (dcmpf, dcountf, scmpf, spalf[bone], 7, stests[t], sbox0f, sbox1f);
+        rvecarr_x_rmat_compact<double>(dcmpd, dcountd, scmpd, spald[bone], 7, stests[t], sbox0d, sbox1d);
+
+        validf = validf && dcountf == ecount[t];
+        validd = validd && dcountd == ecount[t];
+        for (size_t i = 0; i < ecount[t]; ++i) {
+            validf = validf && dcmpf[i].v[0] == ecmpf[t][i] && dcmpf[i].v[3] == 1;
+            validd = validd && dcmpd[i].v[0] == ecmpd[t][i] && dcmpd[i].v[3] == 1;
+        }
+    }
+    cout << "vec[] 1x4 * mat cmpct float  test " << (validf ? passed : failed) << endl;
+    cout << "vec[] 1x4 * mat cmpct double test " << (validd ? passed : failed) << endl;
+
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test dot and cross products, lengths and normalization of vector arrays
+    // and of lane interleaved blocks. Vector a[i] is [ 2, 3, 6, 0 ] * (i + 1)
+    // and b[i] is [ 0, 0, 1, 0 ], 11 vectors leave a partial last group.
+
+    const int       nops = 11;
+    rvec<float,  4> sopaf[nops], sopbf[nops], dopf[nops];
+    rvec<double, 4> sopad[nops], sopbd[nops], dopd[nops];
+    vec<float,   3> sop3af[nops], sop3bf[nops], dop3f[nops];
+    vec<double,  3> sop3ad[nops], sop3bd[nops], dop3d[nops];
+    vecsoa<float,  3> svsoaaf[1], svsoabf[1], dvsoaf[1];
+    vecsoa<double, 3> svsoaad[2], svsoabd[2], dvsoad[2];
+    float           ddotf[16], dlenf[16];
+    double          ddotd[16], dlend[16];
+    float           enrmf[] = { 2 / 7.0f, 3 / 7.0f, 6 / 7.0f };
+    double          enrmd[] = { 2 / 7.0,  3 / 7.0,  6 / 7.0  };
+
+    for (int i = 0; i < nops; ++i) {
+        float  sf = float(i + 1);
+        double sd = double(i + 1);
+
+        sopaf[i].set ({ 2 * sf, 3 * sf, 6 * sf, 0 });
+        sopad[i].set ({ 2 * sd, 3 * sd, 6 * sd, 0 });
+        sopbf[i].set ({ 0, 0, 1, 0 });
+        sopbd[i].set ({ 0, 0, 1, 0 });
+        sop3af[i].set({ 2 * sf, 3 * sf, 6 * sf });
+        sop3ad[i].set({ 2 * sd, 3 * sd, 6 * sd });
+        sop3bf[i].set({ 0, 0, 1 });
+        sop3bd[i].set({ 0, 0, 1 });
+    }
+
+    // Vector arrays, the cross product of a[i] and b[i] is [ 3, -2, 0, 0 ] * (i + 1)
+    vecarr_dot<float,  4>(ddotf, sopaf, sopbf, nops);
+    vecarr_dot<double, 4>(ddotd, sopad, sopbd, nops);
+    vecarr_length<float,  4>(dlenf, sopaf, nops);
+    vecarr_length<double, 4>(dlend, sopad, nops);
+    vecarr_cross<float,  4>(dopf, sopaf, sopbf, nops);
+    vecarr_cross<double, 4>(dopd, sopad, sopbd, nops);
+
+    validf = validd = true;
+    for (int i = 0; i < nops; ++i) {
+        validf = validf && ddotf[i] == 6 * (i + 1) && dlenf[i] == 7 * (i + 1)
+                        && dopf[i].v[0] == 3 * (i + 1) && dopf[i].v[1] == -2 * (i + 1)
+                        && dopf[i].v[2] == 0 && dopf[i].v[3] == 0;
+        validd = validd && ddotd[i] == 6 * (i + 1) && dlend[i] == 7 * (i + 1)
+                        && dopd[i].v[0] == 3 * (i + 1) && dopd[i].v[1] == -2 * (i + 1)
+                        && dopd[i].v[2] == 0 && dopd[i].v[3] == 0;
+    }
+
+    for (int approx = 0; approx < 2; ++approx) {
+        vecarr_normalize<float,  4>(dopf, sopaf, nops, approx);
+        vecarr_normalize<double, 4>(dopd, sopad, nops, approx);
+
+        for (int i = 0; i < nops; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                validf = validf && std::abs(dopf[i].v[j] - enrmf[j]) < 1e-5;
+                validd = validd && std::abs(dopd[i].v[j] - enrmd[j]) < 1e-12;
+            }
+            validf = validf && dopf[i].v[3] == 0;
+            validd = validd && dopd[i].v[3] == 0;
+        }
+    }
+    cout << "vec[] 1x4 dot/x/len   float  test " << (validf ? passed : failed) << endl;
+    cout << "vec[] 1x4 dot/x/len   double test " << (validd ? passed : failed) << endl;
+
+    // Blocks of 3 element vectors
+    vecarr_to_soa<float,  3>(svsoaaf, sop3af, nops);
+    vecarr_to_soa<float,  3>(svsoabf, sop3bf, nops);
+    vecarr_to_soa<double, 3>(svsoaad, sop3ad, nops);
+    vecarr_to_soa<double, 3>(svsoabd, sop3bd, nops);
+    vecsoa_dot<float,  3>(ddotf, svsoaaf, svsoabf, 1);
+    vecsoa_dot<double, 3>(ddotd, svsoaad, svsoabd, 2);
+    vecsoa_length<float,  3>(dlenf, svsoaaf, 1);
+    vecsoa_length<double, 3>(dlend, svsoaad, 2);
+    vecsoa_cross<float,  3>(dvsoaf, svsoaaf, svsoabf, 1);
+    vecsoa_cross<double, 3>(dvsoad, svsoaad, svsoabd, 2);
+    soa_to_vecarr<float,  3>(dop3f, dvsoaf, nops);
+    soa_to_vecarr<double, 3>(dop3d, dvsoad, nops);
+
+    validf = validd = true;
+    for (int i = 0; i < nops; ++i) {
+        validf = validf && ddotf[i] == 6 * (i + 1) && dlenf[i] == 7 * (i + 1)
+                        && dop3f[i].v[0] == 3 * (i + 1) && dop3f[i].v[1] == -2 * (i + 1)
+                        && dop3f[i].v[2] == 0;
+        validd = validd && ddotd[i] == 6 * (i + 1) && dlend[i] == 7 * (i + 1)
+                        && dop3d[i].v[0] == 3 * (i + 1) && dop3d[i].v[1] == -2 * (i + 1)
+                        && dop3d[i].v[2] == 0;
+    }
+
+    for (int approx = 0; approx < 2; ++approx) {
+        vecsoa_normalize<float,  3>(dvsoaf, svsoaaf, 1, approx);
+        vecsoa_normalize<double, 3>(dvsoad, svsoaad, 2, approx);
+        soa_to_vecarr<float,  3>(dop3f, dvsoaf, nops);
+        soa_to_vecarr<double, 3>(dop3d, dvsoad, nops);
+
+        for (int i = 0; i < nops; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                validf = validf && std::abs(dop3f[i].v[j] - enrmf[j]) < 1e-5;
+                validd = validd && std::abs(dop3d[i].v[j] - enrmd[j]) < 1e-12;
+            }
+        }
+    }
+    cout << "vec   soa dot/x/len   float  test " << (validf ? passed : failed) << endl;
+    cout << "vec   soa dot/x/len   double test " << (validd ? passed : failed) << endl;
+
+    // Blocks of the timing vectors, without the 4th element
+    size_t vblocksf = vec_blocks<float,  3>(elements);
+    size_t vblocksd = vec_blocks<double, 3>(elements);
+    auto   *ssoaarf = (vecsoa<float,  3> *) alloc_aligned(vblocksf * sizeof(vecsoa<float,  3>));
+    auto   *dsoaarf = (vecsoa<float,  3> *) alloc_aligned(vblocksf * sizeof(vecsoa<float,  3>));
+    auto   *ssoaard = (vecsoa<double, 3> *) alloc_aligned(vblocksd * sizeof(vecsoa<double, 3>));
+    auto   *dsoaard = (vecsoa<double, 3> *) alloc_aligned(vblocksd * sizeof(vecsoa<double, 3>));
+    auto   *dscalf  = (float  *) alloc_aligned(vblocksf * vecsoa<float,  3>::lanes * sizeof(float));
+    auto   *dscald  = (double *) alloc_aligned(vblocksd * vecsoa<double, 3>::lanes * sizeof(double));
+
+    if (   ssoaarf == nullptr
+        || dsoaarf == nullptr
+        || ssoaard == nullptr
+        || dsoaard == nullptr
+        || dscalf  == nullptr
+        || dscald  == nullptr) {
+        cout << "Failed to allocate memory for vector operation arrays" << endl;
+        exit(1);
+    }
+
+    for (int i = 0; i < elements; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            ssoaarf[i / vecsoa<float,  3>::lanes].v[j][i % vecsoa<float,  3>::lanes] = srvecarrf[i].v[j];
+            ssoaard[i / vecsoa<double, 3>::lanes].v[j][i % vecsoa<double, 3>::lanes] = srvecarrd[i].v[j];
+        }
+    }
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test interpolation. Vector a[i] is [ i, 2i, 3i, 1 ] and b[i] is
+    // [ i + 4, 2i + 8, 3i - 4, 1 ], so a quarter of the way is
+    // [ i + 1, 2i + 2, 3i - 1, 1 ]. Quaternion a[i] is the identity and b[i]
+    // rotates about z by (i + 1) / 4 radians, odd b[i] are negated to take
+    // the shorter path. Channel c of the keyframes has c % 3 + 1 keys at
+    // times 0, 1 and 2, key k of a vector channel is [ k, 2k, 3k, 1 ] * (c + 1)
+    // and of a quaternion channel rotates about z by k / 2 radians.
+
+    const int       nkeys = nops * 3;
+    const float     tlerpf = 0.25f, tslerpf = 0.3f;
+    const double    tlerpd = 0.25,  tslerpd = 0.3;
+    rvec<float,  4> lerpaf[nops], lerpbf[nops], dlerpf[nops], keyvf[nkeys];
+    rvec<double, 4> lerpad[nops], lerpbd[nops], dlerpd[nops], keyvd[nkeys];
+    quat<float>     qlerpaf[nops], qlerpbf[nops], dqlerpf[nops], keyqf[nkeys];
+    quat<double>    qlerpad[nops], qlerpbd[nops], dqlerpd[nops], keyqd[nkeys];
+    rmat<float,  4, 4> mlerpf[3];
+    rmat<double, 4, 4> mlerpd[3];
+    float           keytimef[nkeys];
+    double          keytimed[nkeys];
+    size_t          keyfirst[nops + 1], keycursor[nops];
+    double          sampletimes[] = { -0.5, 0.25, 1.5, 3, 1.75, 0.75 };
+
+    for (int i = 0; i < nops; ++i) {
+        double half = (i + 1) / 8.0;
+        double sign = (i & 1) ? -1 : 1;
+
+        lerpaf[i].set({ float(i), float(2 * i), float(3 * i), 1 });
+        lerpad[i].set({ double(i), double(2 * i), double(3 * i), 1 });
+        lerpbf[i].set({ float(i + 4), float(2 * i + 8), float(3 * i - 4), 1 });
+        lerpbd[i].set({ double(i + 4), double(2 * i + 8), double(3 * i - 4), 1 });
+        qlerpaf[i].set({ 0, 0, 0, 1 });
+        qlerpad[i].set({ 0, 0, 0, 1 });
+        qlerpbf[i].set({ 0, 0, float(sign * std::sin(half)), float(sign * std::cos(half)) });
+        qlerpbd[i].set({ 0, 0, sign * std::sin(half), sign * std::cos(half) });
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        set_matrix(mlerpf[i], [i] (int r, int c) -> float  { return float (i * 16 + r * 4 + c); });
+        set_matrix(mlerpd[i], [i] (int r, int c) -> double { return double(i * 16 + r * 4 + c); });
+    }
+
+    vecarr_lerp<float,  4>(dlerpf, lerpaf, lerpbf, tlerpf, nops);
+    vecarr_lerp<double, 4>(dlerpd, lerpad, lerpbd, tlerpd, nops);
+
+    validf = validd = true;
+    for (int i = 0; i < nops; ++i) {
+        validf = validf && dlerpf[i].v[0] == i + 1 && dlerpf[i].v[1] == 2 * i + 2
+                        && dlerpf[i].v[2] == 3 * i - 1 && dlerpf[i].v[3] == 1;
+        validd = validd && dlerpd[i].v[0] == i + 1 && dlerpd[i].v[1] == 2 * i + 2
+                        && dlerpd[i].v[2] == 3 * i - 1 && dlerpd[i].v[3] == 1;
+    }
+
+    // Matrices i and i + 1 differ by 16 in every element
+    matarr_lerp<float,  4, 4>(mlerpf, mlerpf, mlerpf + 1, tlerpf, 2);
+    matarr_lerp<double, 4, 4>(mlerpd, mlerpd, mlerpd + 1, tlerpd, 2);
+
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 16; ++j) {
+            validf = validf && mlerpf[i].m[j / 4][j % 4] == i * 16 + j + 4;
+            validd = validd && mlerpd[i].m[j / 4][j % 4] == i * 16 + j + 4;
+        }
+    }
+    cout << "vec[] mat[] lerp      float  test " << (validf ? passed : failed) << endl;
+    cout << "vec[] mat[] lerp      double test " << (validd ? passed : failed) << endl;
+
+    // nlerp of the identity and a rotation by angle is
+    // [ 0, 0, t sin(angle / 2), 1 - t + t cos(angle / 2) ] normalized,
+    // slerp is a rotation by t * angle
+    quatarr_nlerp<float>(dqlerpf, qlerpaf, qlerpbf, tslerpf, nops);
+    quatarr_nlerp<double>(dqlerpd, qlerpad, qlerpbd, tslerpd, nops);
+
+    validf = validd = true;
+    for (int i = 0; i < nops; ++i) {
+        double half = (i + 1) / 8.0;
+        double z    = tslerpd * std::sin(half);
+        double w    = 1 - tslerpd + tslerpd * std::cos(half);
+        double len  = std::sqrt(z * z + w * w);
+
+        validf = validf && dqlerpf[i].v[0] == 0 && dqlerpf[i].v[1] == 0
+                        && std::abs(dqlerpf[i].v[2] - z / len) < 1e-6
+                        && std::abs(dqlerpf[i].v[3] - w / len) < 1e-6;
+        validd = validd && dqlerpd[i].v[0] == 0 && dqlerpd[i].v[1] == 0
+                        && std::abs(dqlerpd[i].v[2] - z / len) < 1e-12
+                        && std::abs(dqlerpd[i].v[3] - w / len) < 1e-12;
+    }
+
+    quatarr_slerp<float>(dqlerpf, qlerpaf, qlerpbf, tslerpf, nops);
+    quatarr_slerp<double>(dqlerpd, qlerpad, qlerpbd, tslerpd, nops);
+
+    for (int i = 0; i < nops; ++i) {
+        double half = tslerpd * (i + 1) / 8.0;
+
+        validf = validf && dqlerpf[i].v[0] == 0 && dqlerpf[i].v[1] == 0
+                        && std::abs(dqlerpf[i].v[2] - std::sin(half)) < 5e-5
+                        && std::abs(dqlerpf[i].v[3] - std::cos(half)) < 5e-5;
+        validd = validd && dqlerpd[i].v[0] == 0 && dqlerpd[i].v[1] == 0
+                        && std::abs(dqlerpd[i].v[2] - std::sin(half)) < 5e-5
+                        && std::abs(dqlerpd[i].v[3] - std::cos(half)) < 5e-5;
+    }
+    cout << "quat[] nlerp slerp    float  test " << (validf ? passed : failed) << endl;
+    cout << "quat[] nlerp slerp    double test " << (validd ? passed : failed) << endl;
+
+    keyfirst[0] = 0;
+    for (int c = 0; c < nops; ++c) {
+        keyfirst[c + 1] = keyfirst[c] + c % 3 + 1;
+
+        for (int k = 0; k <= c % 3; ++k) {
+            size_t key = keyfirst[c] + k;
+
+            keytimef[key] = float(k);
+            keytimed[key] = double(k);
+            keyvf[key].set({ float(k * (c + 1)), float(2 * k * (c + 1)), float(3 * k * (c + 1)), 1 });
+            keyvd[key].set({ double(k * (c + 1)), double(2 * k * (c + 1)), double(3 * k * (c + 1)), 1 });
+            keyqf[key].set({ 0, 0, float(std::sin(k / 4.0)), float(std::cos(k / 4.0)) });
+            keyqd[key].set({ 0, 0, std::sin(k / 4.0), std::cos(k / 4.0) });
+        }
+    }
+
+    // Sample with and without cursors, times move forward and back
+    validf = validd = true;
+    for (int pass = 0; pass < 2; ++pass) {
+        size_t *cursor = pass ? keycursor : nullptr;
+
+        memset(keycursor, 0, sizeof(keycursor));
+        for (double time : sampletimes) {
+            vecarr_sample<float,  4>(dlerpf, keyvf, keytimef, keyfirst, nops, float(time), cursor);
+            vecarr_sample<double, 4>(dlerpd, keyvd, keytimed, keyfirst, nops, time, cursor);
+            quatarr_sample<float>(dqlerpf, keyqf, keytimef, keyfirst, nops, float(time), cursor);
+            quatarr_sample<double>(dqlerpd, keyqd, keytimed, keyfirst, nops, time, cursor);
+
+            for (int c = 0; c < nops; ++c) {
+                double u = std::min(std::max(time, 0.0), double(c % 3));
+                double k = std::floor(u);
+                double t = u - k;
+                double z = (1 - t) * std::sin(k / 4) + t * std::sin((k + 1) / 4);
+                double w = (1 - t) * std::cos(k / 4) + t * std::cos((k + 1) / 4);
+                double s = 1 / std::sqrt(z * z + w * w);
+
+                for (int j = 0; j < 3; ++j) {
+                    validf = validf && std::abs(dlerpf[c].v[j] - u * (j + 1) * (c + 1)) < 1e-5;
+                    validd = validd && std::abs(dlerpd[c].v[j] - u * (j + 1) * (c + 1)) < 1e-12;
+                }
+                validf = validf && dlerpf[c].v[3] == 1
+                                && std::abs(dqlerpf[c].v[2] - z * s) < 1e-6
+                                && std::abs(dqlerpf[c].v[3] - w * s) < 1e-6;
+                validd = validd && dlerpd[c].v[3] == 1
+                                && std::abs(dqlerpd[c].v[2] - z * s) < 1e-12
+                                && std::abs(dqlerpd[c].v[3] - w * s) < 1e-12;
+            }
+        }
+    }
+    cout << "vec[] quat[] sample   float  test " << (validf ? passed : failed) << endl;
+    cout << "vec[] quat[] sample   double test " << (validd ? passed : failed) << endl;
+
+    // Keyframes for timing, 4 keys for each channel
+    size_t kchannels = elements / 4;
+    auto   *ktimef   = (float  *) alloc_aligned(elements * sizeof(float));
+    auto   *ktimed   = (double *) alloc_aligned(elements * sizeof(double));
+    auto   *kfirst   = (size_t *) alloc_aligned((kchannels + 1) * sizeof(size_t));
+    auto   *kcursor  = (size_t *) alloc_aligned(kchannels * sizeof(size_t));
+
+    if (   ktimef  == nullptr
+        || ktimed  == nullptr
+        || kfirst  == nullptr
+        || kcursor == nullptr) {
+        cout << "Failed to allocate memory for keyframe arrays" << endl;
+        exit(1);
+    }
+
+    for (int i = 0; i < elements; ++i) {
+        ktimef[i] = float (i % 4);
+        ktimed[i] = double(i % 4);
+    }
+    for (size_t c = 0; c <= kchannels; ++c) {
+        kfirst[c] = c * 4;
+    }
+    memset(kcursor, 0, kchannels * sizeof(size_t));
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Elementwise operations on 11 vectors cover the vector loops and the
+    // scalar tails. Element x of a is x or -x, of b is 20 - x.
+
+    vec<float,  4>    eaf[nops], ebf[nops], edf[nops];
+    vec<double, 4>    ead[nops], ebd[nops], edd[nops];
+    vec<float,  3>    e3f[nops];
+    vec<double, 3>    e3d[nops];
+    mat<float,  4, 4> emf[2];
+    mat<double, 4, 4> emd[2];
+
+    for (int x = 0; x < nops * 4; ++x) {
+        eaf[x / 4].v[x % 4] = float (x % 2 ? -x : x);
+        ebf[x / 4].v[x % 4] = float (20 - x);
+        ead[x / 4].v[x % 4] = double(x % 2 ? -x : x);
+        ebd[x / 4].v[x % 4] = double(20 - x);
+    }
+
+    auto check_elementwise = [&] (double (*expect)(double, double)) {
+        for (int x = 0; x < nops * 4; ++x) {
+            double a = x % 2 ? -x : x;
+            double b = 20 - x;
+
+            validf = validf && edf[x / 4].v[x % 4] == float(expect(a, b));
+            validd = validd && edd[x / 4].v[x % 4] == expect(a, b);
+        }
+    };
+
+    validf = validd = true;
+    vecarr_add<float,  4>(edf, eaf, ebf, nops);
+    vecarr_add<double, 4>(edd, ead, ebd, nops);
+    check_elementwise([] (double a, double b) { return a + b; });
+    vecarr_sub<float,  4>(edf, eaf, ebf, nops);
+    vecarr_sub<double, 4>(edd, ead, ebd, nops);
+    check_elementwise([] (double a, double b) { return a - b; });
+    vecarr_add_scalar<float,  4>(edf, eaf, 0.5f, nops);
+    vecarr_add_scalar<double, 4>(edd, ead, 0.5,  nops);
+    check_elementwise([] (double a, double)   { return a + 0.5; });
+    vecarr_scale<float,  4>(edf, eaf, 3.0f, nops);
+    vecarr_scale<double, 4>(edd, ead, 3.0,  nops);
+    check_elementwise([] (double a, double)   { return a * 3; });
+    vecarr_axpy<float,  4>(edf, eaf, ebf, 2.0f, nops);
+    vecarr_axpy<double, 4>(edd, ead, ebd, 2.0,  nops);
+    check_elementwise([] (double a, double b) { return 2 * a + b; });
+    vecarr_blend<float,  4>(edf, eaf, ebf, 0.25f, 0.75f, nops);
+    vecarr_blend<double, 4>(edd, ead, ebd, 0.25,  0.75,  nops);
+    check_elementwise([] (double a, double b) { return 0.25 * a + 0.75 * b; });
+    vecarr_abs<float,  4>(edf, eaf, nops);
+    vecarr_abs<double, 4>(edd, ead, nops);
+    check_elementwise([] (double a, double)   { return std::abs(a); });
+    vecarr_min<float,  4>(edf, eaf, ebf, nops);
+    vecarr_min<double, 4>(edd, ead, ebd, nops);
+    check_elementwise([] (double a, double b) { return std::min(a, b); });
+    vecarr_max<float,  4>(edf, eaf, ebf, nops);
+    vecarr_max<double, 4>(edd, ead, ebd, nops);
+    check_elementwise([] (double a, double b) { return std::max(a, b); });
+
+    // In place, destination is the first source
+    memcpy(edf, eaf, sizeof(edf));
+    memcpy(edd, ead, sizeof(edd));
+    vecarr_sub<float,  4>(edf, edf, ebf, nops);
+    vecarr_sub<double, 4>(edd, edd, ebd, nops);
+    check_elementwise([] (double a, double b) { return a - b; });
+    cout << "vec[] elementwise     float  test " << (validf ? passed : failed) << endl;
+    cout << "vec[] elementwise     double test " << (validd ? passed : failed) << endl;
+
+    // 3 element vectors are processed with their padding
+    memset(e3f, 0, sizeof(e3f));
+    memset(e3d, 0, sizeof(e3d));
+    for (int i = 0; i < nops; ++i) {
+        e3f[i].set({ float (i), float (-i), float (2 * i) });
+        e3d[i].set({ double(i), double(-i), double(2 * i) });
+    }
+    vecarr_scale<float,  3>(e3f, e3f, -2.0f, nops);
+    vecarr_scale<double, 3>(e3d, e3d, -2.0,  nops);
+    vecarr_add_scalar<float,  3>(e3f, e3f, 1.0f, nops);
+    vecarr_add_scalar<double, 3>(e3d, e3d, 1.0,  nops);
+
+    validf = validd = true;
+    for (int i = 0; i < nops; ++i) {
+        validf = validf && e3f[i].v[0] == 1 - 2 * i && e3f[i].v[1] == 1 + 2 * i && e3f[i].v[2] == 1 - 4 * i;
+        validd = validd && e3d[i].v[0] == 1 - 2 * i && e3d[i].v[1] == 1 + 2 * i && e3d[i].v[2] == 1 - 4 * i;
+    }
+
+    // 2 matrices, y += alpha * x in place
+    for (int i = 0; i < 2; ++i) {
+        set_matrix(emf[i], [i] (int r, int c) -> float  { return float (i * 16 + r * 4 + c); });
+        set_matrix(emd[i], [i] (int r, int c) -> double { return double(i * 16 + r * 4 + c); });
+    }
+    matarr_axpy<float,  4, 4>(emf, emf, emf, 0.5f, 2);
+    matarr_axpy<double, 4, 4>(emd, emd, emd, 0.5,  2);
+
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 16; ++j) {
+            validf = validf && emf[i].m[j / 4][j % 4] == 1.5f * (i * 16 + j);
+            validd = validd && emd[i].m[j / 4][j % 4] == 1.5  * (i * 16 + j);
+        }
+    }
+    cout << "vec3[] mat[] elemwise float  test " << (validf ? passed : failed) << endl;
+    cout << "vec3[] mat[] elemwise double test " << (validd ? passed : failed) << endl;
+    
+    
+    // -------------------------------------------------------------------------
+    // Structured matrices of each form, built with the set_ functions or
+    // classified, are multiplied with the cheapest kernels and compared to
+    // the general products.
+
+    smat<float>       formf[5], prodf;
+    smat<double>      formd[5], prodd;
+    mat<float,  4, 4> reff;
+    mat<double, 4, 4> refd;
+    vec<float,  4>    sclf = {{ 2, -1, 0.5f, 0 }}, trnf = {{ 1, 2, -3, 0 }};
+    vec<double, 4>    scld = {{ 2, -1, 0.5,  0 }}, trnd = {{ 1, 2, -3, 0 }};
+    specialized       forms[4] = { ident, translate, scale, affine };
+
+    set_identity(formf[0]);
+    set_identity(formd[0]);
+    set_translation(formf[1], trnf);
+    set_translation(formd[1], trnd);
+    set_scale(formf[2], sclf, trnf);
+    set_scale(formd[2], scld, trnd);
+
+    // Affine has a last column of [ 0 0 0 1 ], general does not
+    set_matrix(formf[3], [] (int r, int c) -> float  { return c == 3 ? float (r == 3) : float (r * 4 + c + 1) / 8; });
+    set_matrix(formd[3], [] (int r, int c) -> double { return c == 3 ? double(r == 3) : double(r * 4 + c + 1) / 8; });
+    set_matrix(formf[4], [] (int r, int c) -> float  { return float (r * 4 + c + 1) / 8; });
+    set_matrix(formd[4], [] (int r, int c) -> double { return double(r * 4 + c + 1) / 8; });
+
+    validf = validd = true;
+    for (int i = 0; i < 5; ++i) {
+        structure built = (i < 3) ? formf[i].form : structure(i);
+
+        classify(formf[i]);
+        classify(formd[i]);
+        validf = validf && formf[i].form == built && formf[i].form == structure(i);
+        validd = validd && formd[i].form == built && formd[i].form == structure(i);
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            int         form = (i == 0 || j == 0) ? 0 : std::max(i, j);
+            specialized spec = smat_x_smat(prodf, formf[i], formf[j]);
+
+            mat_x_mat(reff, formf[i], formf[j]);
+            validf = validf && prodf.form == structure(std::max(i, j)) && (form == 4 || spec == forms[form]);
+            spec   = smat_x_smat(prodd, formd[i], formd[j]);
+            mat_x_mat(refd, formd[i], formd[j]);
+            validd = validd && prodd.form == structure(std::max(i, j)) && (form == 4 || spec == forms[form]);
+
+            for (int k = 0; k < 16; ++k) {
+                validf = validf && std::abs(prodf.m[k / 4][k % 4] - reff.m[k / 4][k % 4]) < 1e-5;
+                validd = validd && std::abs(prodd.m[k / 4][k % 4] - refd.m[k / 4][k % 4]) < 1e-12;
+            }
+        }
+    }
+    cout << "smat x smat structure float  test " << (validf ? passed : failed) << endl;
+    cout << "smat x smat structure double test " << (validd ? passed : failed) << endl;
+
+    // Points, directions and w of 2 in an odd count of vectors
+    validf = validd = true;
+    for (int i = 0; i < 5; ++i) {
+        for (int e = 0; e < nops; ++e) {
+            eaf[e].set({ float (e), float (1 - e), float (e) / 4, float (e % 3) });
+            ead[e].set({ double(e), double(1 - e), double(e) / 4, double(e % 3) });
+        }
+
+        specialized spec = vecarr_x_smat(edf, eaf, formf[i], nops);
+
+        validf = validf && (i >= 3 || spec == forms[i]);
+        spec   = vecarr_x_smat(edd, ead, formd[i], nops);
+        validd = validd && (i >= 3 || spec == forms[i]);
+
+        // General products, then in place where allowed
+        vecarr_x_mat(ebf, eaf, (mat<float,  4, 4> &) formf[i], nops);
+        vecarr_x_mat(ebd, ead, (mat<double, 4, 4> &) formd[i], nops);
+        if (i < 3) {
+            vecarr_x_smat(eaf, eaf, formf[i], nops);
+            vecarr_x_smat(ead, ead, formd[i], nops);
+        } else {
+            memcpy(eaf, edf, sizeof(eaf));
+            memcpy(ead, edd, sizeof(ead));
+        }
+
+        for (int x = 0; x < nops * 4; ++x) {
+            validf = validf && std::abs(edf[x / 4].v[x % 4] - ebf[x / 4].v[x % 4]) < 1e-5
+                            && std::abs(eaf[x / 4].v[x % 4] - ebf[x / 4].v[x % 4]) < 1e-5;
+            validd = validd && std::abs(edd[x / 4].v[x % 4] - ebd[x / 4].v[x % 4]) < 1e-12
+                            && std::abs(ead[x / 4].v[x % 4] - ebd[x / 4].v[x % 4]) < 1e-12;
+        }
+    }
+    cout << "vec[] x smat struct   float  test " << (validf ? passed : failed) << endl;
+    cout << "vec[] x smat struct   double test " << (validd ? passed : failed) << endl;
+    
+    
+    // -------------------------------------------------------------------------
+    // Rectangular and larger products, with vectors, unrolled at compile time
+    // in UNROLL builds
+
+    compare_product<float,  3, 3, 4>("mat 3x4 * mat 4x3     float  test ");
+    compare_product<double, 3, 3, 4>("mat 3x4 * mat 4x3     double test ");
+    compare_product<float,  4, 4, 3>("mat 4x3 * mat 3x4     float  test ");
+    compare_product<double, 4, 4, 3>("mat 4x3 * mat 3x4     double test ");
+    compare_product<float,  5, 6, 7>("mat 5x7 * mat 7x6     float  test ");
+    compare_product<double, 5, 6, 7>("mat 5x7 * mat 7x6     double test ");
+    compare_product<float,  8, 8, 8>("mat 8x8 * mat 8x8     float  test ");
+    compare_product<double, 8, 8, 8>("mat 8x8 * mat 8x8     double test ");
+    compare_product<float,  16, 16, 16>("mat 16x16 * mat 16x16 float  test ");
+    compare_product<double, 16, 16, 16>("mat 16x16 * mat 16x16 double test ");
+    compare_product<float,  64, 64, 64>("mat 64x64 * mat 64x64 float  test ");
+    compare_product<double, 64, 64, 64>("mat 64x64 * mat 64x64 double test ");
+    compare_blocked<float> ("blocked 37x300x45     float  test ", 37, 45, 300, 1);
+    compare_blocked<double>("blocked 37x300x45     double test ", 37, 45, 300, 1);
+    compare_blocked<float> ("blocked 4 threads     float  test ", 517, 4099, 263, 4);
+    compare_blocked<double>("blocked 4 threads     double test ", 517, 2063, 263, 4);
+    compare_layout<float,  tiled<16>> ("tiled 16 layout       float  test ");
+    compare_layout<double, tiled<8>>  ("tiled 8 layout        double test ");
+    compare_layout<float,  morton<8>> ("morton 8 layout       float  test ");
+    compare_layout<double, morton<1>> ("morton 1 layout       double test ");
+    compare_constexpr<float> ("constexpr transforms  float  test ");
+    compare_constexpr<double>("constexpr transforms  double test ");
+
+    // Matrices for timing the unrolled products
+    mat<float,  8, 8> m88af, m88bf, m88df;
+    mat<double, 8, 8> m88ad, m88bd, m88dd;
+    mat<float,  4, 3> m43f;
+    mat<double, 4, 3> m43d;
+    mat<float,  3, 4> m34f;
+    mat<double, 3, 4> m34d;
+    mat<float,  4, 4> m44f;
+    mat<double, 4, 4> m44d;
+
+    set_matrix(m88af, [] (int r, int c) -> float  { return float (r + c) / 8; });
+    set_matrix(m88bf, [] (int r, int c) -> float  { return float (r - c) / 8; });
+    set_matrix(m88ad, [] (int r, int c) -> double { return double(r + c) / 8; });
+    set_matrix(m88bd, [] (int r, int c) -> double { return double(r - c) / 8; });
+    set_matrix(m43f,  [] (int r, int c) -> float  { return float (r + c) / 4; });
+    set_matrix(m43d,  [] (int r, int c) -> double { return double(r + c) / 4; });
+    set_matrix(m34f,  [] (int r, int c) -> float  { return float (r - c) / 4; });
+    set_matrix(m34d,  [] (int r, int c) -> double { return double(r - c) / 4; });
+
+    mat<float,  16, 16> m1616af, m1616bf, m1616df;
+    mat<double, 16, 16> m1616ad, m1616bd, m1616dd;
+
+    set_matrix(m1616af, [] (int r, int c) -> float  { return float (r + c) / 16; });
+    set_matrix(m1616bf, [] (int r, int c) -> float  { return float (r - c) / 16; });
+    set_matrix(m1616ad, [] (int r, int c) -> double { return double(r + c) / 16; });
+    set_matrix(m1616bd, [] (int r, int c) -> double { return double(r - c) / 16; });
+    
+    
+    // -------------------------------------------------------------------------
+    // Additional tests
+
+    // Source and expected deta
+    int tmat32[]  = {  1,  2,  3,  4,  5,  6 };
+    int tmat23[]  = {  7,  8,  9, 10, 11, 12 };
+    int tmat33a[] = {  1,  2,  3,  4,  5,  6,  7,  8,  9 };
+    int tmat33b[] = { 10, 11, 12, 13, 14, 15, 16, 17, 18 };
+    int emat33[]  = { 27, 30, 33, 61, 68, 75, 95, 106, 117 };       // TI-84+
+    int emat22[]  = { 76, 100, 103, 136 };                          // TI-84+
+    int emat33c[] = { 84, 90, 96, 201, 216, 231, 318, 342, 366 };   // TI-84+
+
+    // Source and destination matrices
+    rmat<int, 3, 2> srmat32;
+    rmat<int, 2, 3> srmat23;
+    rmat<int, 3, 3> srmat33a;
+    rmat<int, 3, 3> srmat33b;
+    cmat<int, 3, 2> scmat32;
+    cmat<int, 2, 3> scmat23;
+    cmat<int, 3, 3> scmat33a;
+    cmat<int, 3, 3> scmat33b;
+    rmat<int, 3, 3> drmat33;
+    rmat<int, 2, 2> drmat22;
+    rmat<int, 3, 3> drmat33c;
+    cmat<int, 3, 3> dcmat33;
+    cmat<int, 2, 2> dcmat22;
+    cmat<int, 3, 3> dcmat33c;
+
+    // Initialize source matrices with test data.
+    // Yes, data is supposed to be the same for
+    // row and column major order.
+    // Only the interpretation of the data differs.
+    // Whether consecutive values are interpreted
+    // as rows or interpreted as columns.
+    //
+    // Test linear arrays:  [ a b c d e f ]
+    //                      [ g h i j k l ]
+    //
+    // Row major order 3x2: [ [ a b ]
+    //                        [ c d ]
+    //                        [ e f ] ]
+    //                 2x3: [ [ a b c ]
+    //                        [ d e f ] ]
+    //
+    // Col major order 3x2:  [ [ a   [ c   [ e
+    //                           b ]   d ]   f ] ]
+    //                 2x3:  [ [ a   [ d
+    //                           b     e
+    //                           c ]   f ] ]
+    //
+    // Row major order mul:   C = A * B
+    //                        [ a b   * [ g h i
+    //                          c d       j k l ]
+    //                          e f ]
+    //                      [ ag+bj ah+bk ai+bl
+    //                        cg+dj ch+dk ci+dl
+    //                        eg+fj eh+fk ei+fl ]
+    //
+    // Expected inear array: [ ag+bj ah+bk ai+bl cg+dj ch+dk ci+dl eg+fj eh+fk ei+fl ]
+    //
+    // Col major order mul: T(C) = T(B) * (T(A)
+    //                      [ g j   * [ a c e
+    //                        h k       b d f ]
+    //                        i l ]
+    //                      [ ga+jb gc+jd ge+jf
+    //                        ha+kb hc+kd he+kf
+    //                        ia+lb ic+ld ie+lf ]
+    //
+    // Expected linear array: [ ga+jb ha+kb ia+lb gc+jd hc+kd ic+ld ge+jf he+kf ie+lf ]
+    //
+    // Note the linear arrays match
+    
+    // Initialize source matrices
+    srmat32.set  (tmat32);
+    srmat23.set  (tmat23);
+    srmat33a.set (tmat33a);
+    srmat33b.set (tmat33b);
+    scmat32.set  (tmat32);
+    scmat23.set  (tmat23);
+    scmat33a.set (tmat33a);
+    scmat33b.set (tmat33b);
+
+    // Zero destination matrices
+    memset(&drmat33,  0, sizeof(drmat33));
+    memset(&drmat22,  0, sizeof(drmat22));
+    memset(&drmat33c, 0, sizeof(drmat33c));
+    memset(&dcmat33,  0, sizeof(dcmat33));
+    memset(&dcmat22,  0, sizeof(dcmat22));
+    memset(&dcmat33c, 0, sizeof(dcmat33c));
+
+    // Perform the row and column major order multiplications
+    rmata_x_rmatb(drmat33,  srmat32,  srmat23);
+    rmata_x_rmatb(drmat22,  srmat23,  srmat32);
+    rmata_x_rmatb(drmat33c, srmat33a, srmat33b);
+    cmatb_x_cmata(dcmat33,  scmat23,  scmat32);
+    cmatb_x_cmata(dcmat22,  scmat32,  scmat23);
+    cmatb_x_cmata(dcmat33c, scmat33b, scmat33a);
+
+    // Compare actual and expected results
+    compare_mat<int, 3, 3>(drmat33,  emat33,  "mata  3x2 * matb  2x3 int    test ");
+    compare_mat<int, 2, 2>(drmat22,  emat22,  "mata  2x3 * matb  3x2 int    test ");
+    compare_mat<int, 3, 3>(drmat33c, emat33c, "mata  3x3 * matb  3x3 int    test ");
+    compare_mat<int, 3, 3>(dcmat33,  emat33,  "matb  2x3 * mata  3x2 int    test ");
+    compare_mat<int, 2, 2>(dcmat22,  emat22,  "matb  3x2 * mata  2x3 int    test ");
+    compare_mat<int, 3, 3>(dcmat33c, emat33c, "matb  3x3 * mata  3x3 int    test ");
+
+    // 3x3 and 2x2 float and double matrices, and arrays of 3 and 2 element
+    // vectors, [ 1, 2, 3 ] and [ 4, 5, 6 ] * 3x3 a give [ 30, 36, 42 ] and
+    // [ 66, 81, 96 ], [ 1, 2 ] and [ 3, 4 ] * 2x2 a give [ 7, 10 ] and [ 15, 22 ]
+    float  tmat22af[] = { 1, 2, 3, 4 };
+    float  tmat22bf[] = { 5, 6, 7, 8 };
+    double tmat22ad[] = { 1, 2, 3, 4 };
+    double tmat22bd[] = { 5, 6, 7, 8 };
+    float  emat22cf[] = { 19, 22, 43, 50 };
+    double emat22cd[] = { 19, 22, 43, 50 };
+    float  emat33cf[9], tmat33af[9], tmat33bf[9];
+    double emat33cd[9], tmat33ad[9], tmat33bd[9];
+    float  evec30f[] = { 30, 36, 42 }, evec31f[] = { 66, 81, 96 };
+    double evec30d[] = { 30, 36, 42 }, evec31d[] = { 66, 81, 96 };
+    float  evec20f[] = { 7, 10 },      evec21f[] = { 15, 22 };
+    double evec20d[] = { 7, 10 },      evec21d[] = { 15, 22 };
+
+    for (int i = 0; i < 9; ++i) {
+        tmat33af[i] = tmat33ad[i] = tmat33a[i];
+        tmat33bf[i] = tmat33bd[i] = tmat33b[i];
+        emat33cf[i] = emat33cd[i] = emat33c[i];
+    }
+
+    rmat<float,  3, 3> srmat33af, srmat33bf, drmat33f;
+    rmat<double, 3, 3> srmat33ad, srmat33bd, drmat33d;
+    rmat<float,  2, 2> srmat22af, srmat22bf, drmat22f;
+    rmat<double, 2, 2> srmat22ad, srmat22bd, drmat22d;
+    rvec<float,  3>    srvec3f[8], drvec3f[8];
+    rvec<double, 3>    srvec3d[8], drvec3d[8];
+    rvec<float,  2>    srvec2f[8], drvec2f[8];
+    rvec<double, 2>    srvec2d[8], drvec2d[8];
+
+    srmat33af.set(tmat33af);
+    srmat33bf.set(tmat33bf);
+    srmat33ad.set(tmat33ad);
+    srmat33bd.set(tmat33bd);
+    srmat22af.set(tmat22af);
+    srmat22bf.set(tmat22bf);
+    srmat22ad.set(tmat22ad);
+    srmat22bd.set(tmat22bd);
+
+    for (int i = 0; i < 7; ++i) {
+        if (i & 1) {
+            srvec3f[i].set({ 4, 5, 6 });
+            srvec3d[i].set({ 4, 5, 6 });
+            srvec2f[i].set({ 3, 4 });
+            srvec2d[i].set({ 3, 4 });
+        } else {
+            srvec3f[i].set({ 1, 2, 3 });
+            srvec3d[i].set({ 1, 2, 3 });
+            srvec2f[i].set({ 1, 2 });
+            srvec2d[i].set({ 1, 2 });
+        }
+    }
+
+    rmata_x_rmatb(drmat33f, srmat33af, srmat33bf);
+    rmata_x_rmatb(drmat33d, srmat33ad, srmat33bd);
+    rmata_x_rmatb(drmat22f, srmat22af, srmat22bf);
+    rmata_x_rmatb(drmat22d, srmat22ad, srmat22bd);
+    compare_mat<float,  3, 3>(drmat33f, emat33cf, "mata  3x3 * matb  3x3 float  test ");
+    compare_mat<double, 3, 3>(drmat33d, emat33cd, "mata  3x3 * matb  3x3 double test ");
+    compare_mat<float,  2, 2>(drmat22f, emat22cf, "mata  2x2 * matb  2x2 float  test ");
+    compare_mat<double, 2, 2>(drmat22d, emat22cd, "mata  2x2 * matb  2x2 double test ");
+
+    memset(drvec3f, 0, sizeof(drvec3f));
+    memset(drvec3d, 0, sizeof(drvec3d));
+    memset(drvec2f, 0, sizeof(drvec2f));
+    memset(drvec2d, 0, sizeof(drvec2d));
+    rvecarr_x_rmat(drvec3f, srvec3f, srmat33af, 7);
+    rvecarr_x_rmat(drvec3d, srvec3d, srmat33ad, 7);
+    rvecarr_x_rmat(drvec2f, srvec2f, srmat22af, 7);
+    rvecarr_x_rmat(drvec2d, srvec2d, srmat22ad, 7);
+    compare_vec<float,  3>(drvec3f, evec30f, evec31f, 7,
+                           "vec[] 1x3 * mat 3x3   float  test ", true);
+    compare_vec<double, 3>(drvec3d, evec30d, evec31d, 7,
+                           "vec[] 1x3 * mat 3x3   double test ", true);
+    compare_vec<float,  2>(drvec2f, evec20f, evec21f, 7,
+                           "vec[] 1x2 * mat 2x2   float  test ", true);
+    compare_vec<double, 2>(drvec2d, evec20d, evec21d, 7,
+                           "vec[] 1x2 * mat 2x2   double test ", true);
+
+    // Single vectors, the odd numbered vectors give the even numbered results
+    rvec_x_rmat(drvec3f[0], srvec3f[1], srmat33af);
+    rvec_x_rmat(drvec3d[0], srvec3d[1], srmat33ad);
+    rvec_x_rmat(drvec2f[0], srvec2f[1], srmat22af);
+    rvec_x_rmat(drvec2d[0], srvec2d[1], srmat22ad);
+    compare_vec<float,  3>(drvec3f, evec31f, evec31f, 1,
+                           "vec   1x3 * mat 3x3   float  test ");
+    compare_vec<double, 3>(drvec3d, evec31d, evec31d, 1,
+                           "vec   1x3 * mat 3x3   double test ");
+    compare_vec<float,  2>(drvec2f, evec21f, evec21f, 1,
+                           "vec   1x2 * mat 2x2   float  test ");
+    compare_vec<double, 2>(drvec2d, evec21d, evec21d, 1,
+                           "vec   1x2 * mat 2x2   double test ");
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Time the multiplcations
+
+    volatile auto specf = other;
+    timer<int, std::milli> timer;
+    for (int i = 0; i < iterations; ++i) {
+        specf = rmata_x_rmatb(drmatf, srmataf, srmatbf);
+    }
+    auto millif = timer.elapsed();
+
+    volatile auto specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = rmata_x_rmatb(drmatd, srmatad, srmatbd);
+    }
+    auto millid = timer.elapsed();
+
+    cout.imbue(std::locale(""));
+    cout << "iterations          " << iterations            << endl
+         << "vec array elements  " << elements              << endl
+         << "                 float                 double" << endl
+         << "mata x matb " << setw(width) << millif         << " ms "
+                           << get_string(specf)             << " "
+                           << setw(width) << millid         << " ms "
+                           << get_string(specd)             << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = cmatb_x_cmata(dcmatf, scmatbf, scmataf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = cmatb_x_cmata(dcmatd, scmatbd, scmatad);
+    }
+    millid = timer.elapsed();
+
+    cout << "matb x mata " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rvecarr_x_rmat(drvecarrf, srvecarrf, srmataf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rvecarr_x_rmat(drvecarrd, srvecarrd, srmatad, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] x mat " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = cmat_x_cvecarr(dcvecarrf, scmataf, scvecarrf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = cmat_x_cvecarr(dcvecarrd, scmatad, scvecarrd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat x vec[] " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rmatarr_x_rmat(drmatarrf, srmatarraf, srmatbf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rmatarr_x_rmat(drmatarrd, srmatarrad, srmatbd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat[] x matb" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rmat_x_rmatarr(drmatarrf, srmataf, srmatarrbf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rmat_x_rmatarr(drmatarrd, srmatad, srmatarrbd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "mata x mat[]" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = matarr_x_matarr(drmatarrf, srmatarraf, srmatarrbf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = matarr_x_matarr(drmatarrd, srmatarrad, srmatarrbd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat[]xmat[] " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = matsoa_x_matsoa(dsoaf, ssoaaf, ssoabf, blocksf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = matsoa_x_matsoa(dsoad, ssoaad, ssoabd, blocksd);
+    }
+    millid = timer.elapsed();
+
+    cout << "soa x soa   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = inverse(dinvf[0], sinvf[0]);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = inverse(dinvd[0], sinvd[0]);
+    }
+    millid = timer.elapsed();
+
+    cout << "inverse     " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = determinant(detf[0], sinvf[0]);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = determinant(detd[0], sinvd[0]);
+    }
+    millid = timer.elapsed();
+
+    cout << "determinant " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = rigid_inverse(dinvf[0], srigidf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = rigid_inverse(dinvd[0], srigidd);
+    }
+    millid = timer.elapsed();
+
+    cout << "rigid inv   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = matarr_inverse(drmatarrf, srmatarrbf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = matarr_inverse(drmatarrd, srmatarrbd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "inverse[]   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = matarr_rigid_inverse(drmatarrf, srmatarrbf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = matarr_rigid_inverse(drmatarrd, srmatarrbd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "rigid inv[] " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = transpose(dtransf, srmataf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = transpose(dtransd, srmatad);
+    }
+    millid = timer.elapsed();
+
+    cout << "transpose   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rmatarr_to_cmatarr(dcmatarrf, srmatarraf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rmatarr_to_cmatarr(dcmatarrd, srmatarrad, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "transpose[] " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rnormarr_x_rmat(drvecarrf, srvecarrf, snormmatf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rnormarr_x_rmat(drvecarrd, srvecarrd, snormmatd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "normal[]    " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rnormarr_x_rmat(drvecarrf, srvecarrf, snormmatf, elements, true);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rnormarr_x_rmat(drvecarrd, srvecarrd, snormmatd, elements, true);
+    }
+    millid = timer.elapsed();
+
+    cout << "normalize[] " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rprojarr_x_rmat(drvecarrf, srvecarrf, sprojmatf, scalef, offsetf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rprojarr_x_rmat(drvecarrd, srvecarrd, sprojmatd, scaled, offsetd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "project[]   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rprojarr_x_rmat(drvecarrf, srvecarrf, sprojmatf, scalef, offsetf, elements, true);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rprojarr_x_rmat(drvecarrd, srvecarrd, sprojmatd, scaled, offsetd, elements, true);
+    }
+    millid = timer.elapsed();
+
+    cout << "project~[]  " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    // Rotating vectors directly by a quaternion against building the matrix
+    rmat<float,  4, 4> squatmatf;
+    rmat<double, 4, 4> squatmatd;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = quatarr_to_rmatarr(drmatarrf, squatarrf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = quatarr_to_rmatarr(drmatarrd, squatarrd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "quat->mat[] " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rvecarr_x_quat(drvecarrf, srvecarrf, squatf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rvecarr_x_quat(drvecarrd, srvecarrd, squatd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] x quat" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        quat_to_rmat(squatmatf, squatf);
+        specf = rvecarr_x_rmat(drvecarrf, srvecarrf, squatmatf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        quat_to_rmat(squatmatd, squatd);
+        specd = rvecarr_x_rmat(drvecarrd, srvecarrd, squatmatd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "quat->mat x " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = trsarr_to_rmatarr(drmatarrf, strsarrf, squatarrf, ssclarrf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = trsarr_to_rmatarr(drmatarrd, strsarrd, squatarrd, ssclarrd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "trs->mat[]  " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rmatarr_to_trsarr(dtrsarrf, dquatarrf, dsclarrf, drmatarrf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rmatarr_to_trsarr(dtrsarrd, dquatarrd, dsclarrd, drmatarrd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat->trs[]  " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = update_rhierarchy(drmatarrf, hlocalf, tree);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = update_rhierarchy(drmatarrd, hlocald, tree);
+    }
+    millid = timer.elapsed();
+
+    cout << "hierarchy   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rskinarr_x_rmatarr(drvecarrf, srvecarrf, spalf, sbonearr, swgtarrf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rskinarr_x_rmatarr(drvecarrd, srvecarrd, spald, sbonearr, swgtarrd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "skin[]      " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rskinarr_x_rmatarr(drvecarrf, srvecarrf, spalf, sbonearr, swgtarrf, elements,
+                                   dnrmarrf, srvecarrf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rskinarr_x_rmatarr(drvecarrd, srvecarrd, spald, sbonearr, swgtarrd, elements,
+                                   dnrmarrd, srvecarrd);
+    }
+    millid = timer.elapsed();
+
+    cout << "skin+norm[] " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rvecarr_x_rmatarr_indexed(drvecarrf, srvecarrf, spalf, sidxarr, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rvecarr_x_rmatarr_indexed(drvecarrd, srvecarrd, spald, sidxarr, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vecxmat[idx]" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rvecarr_x_rmatarr_runs(drvecarrf, srvecarrf, spalf, sidxrun, runs);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rvecarr_x_rmatarr_runs(drvecarrd, srvecarrd, spald, sidxrun, runs);
+    }
+    millid = timer.elapsed();
+
+    cout << "vecxmat[run]" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = raabbsoa_x_rmat<float>(daabbarf, dvisarr, saabbarf, sboxmf, splanef, 6, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = raabbsoa_x_rmat<double>(daabbard, dvisarr, saabbard, sboxmd, splaned, 6, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "aabb x mat  " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = raabbsoa_x_rmat<float>(nullptr, dvisarr, saabbarf, sboxmf, splanef, 6, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = raabbsoa_x_rmat<double>(nullptr, dvisarr, saabbard, sboxmd, splaned, 6, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "aabb cull   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rvecarr_x_rmat_bounds<float, 4>(drvecarrf, dlof, dhif, srvecarrf, srmataf, elements, &dsumf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rvecarr_x_rmat_bounds<double, 4>(drvecarrd, dlod, dhid, srvecarrd, srmatad, elements, &dsumd);
+    }
+    millid = timer.elapsed();
+
+    cout << "vecxmat bnds" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rvecarr_x_rmat_bounds<float, 4>(nullptr, dlof, dhif, srvecarrf, srmataf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rvecarr_x_rmat_bounds<double, 4>(nullptr, dlod, dhid, srvecarrd, srmatad, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "bounds only " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rvecarr_x_rmat_compact<float>(drvecarrf, dcountf, srvecarrf, srmataf, elements, inside_clip, sbox0f, sbox1f);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rvecarr_x_rmat_compact<double>(drvecarrd, dcountd, srvecarrd, srmatad, elements, inside_clip, sbox0d, sbox1d);
+    }
+    millid = timer.elapsed();
+
+    cout << "vecxmat cmpt" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecarr_dot<float, 4>(dscalf, srvecarrf, drvecarrf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecarr_dot<double, 4>(dscald, srvecarrd, drvecarrd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] dot   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecarr_cross<float, 4>(drvecarrf, srvecarrf, srvecarrf + 1, elements - 1);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecarr_cross<double, 4>(drvecarrd, srvecarrd, srvecarrd + 1, elements - 1);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] cross " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecarr_length<float, 4>(dscalf, srvecarrf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecarr_length<double, 4>(dscald, srvecarrd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] length" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecarr_normalize<float, 4>(drvecarrf, srvecarrf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecarr_normalize<double, 4>(drvecarrd, srvecarrd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] norm  " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecarr_normalize<float, 4>(drvecarrf, srvecarrf, elements, true);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecarr_normalize<double, 4>(drvecarrd, srvecarrd, elements, true);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] norm~ " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecsoa_dot<float, 3>(dscalf, ssoaarf, ssoaarf, vblocksf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecsoa_dot<double, 3>(dscald, ssoaard, ssoaard, vblocksd);
+    }
+    millid = timer.elapsed();
+
+    cout << "soa dot     " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecsoa_normalize<float, 3>(dsoaarf, ssoaarf, vblocksf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecsoa_normalize<double, 3>(dsoaard, ssoaard, vblocksd);
+    }
+    millid = timer.elapsed();
+
+    cout << "soa norm    " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecarr_lerp<float, 4>(drvecarrf, srvecarrf, drvecarrf, 0.25f, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecarr_lerp<double, 4>(drvecarrd, srvecarrd, drvecarrd, 0.25, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] lerp  " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = quatarr_nlerp<float>((quat<float> *) drvecarrf, squatarrf, squatarrf, 0.3f, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = quatarr_nlerp<double>((quat<double> *) drvecarrd, squatarrd, squatarrd, 0.3, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "quat nlerp  " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = quatarr_slerp<float>((quat<float> *) drvecarrf, squatarrf, squatarrf, 0.3f, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = quatarr_slerp<double>((quat<double> *) drvecarrd, squatarrd, squatarrd, 0.3, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "quat slerp  " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecarr_sample<float, 4>(drvecarrf, srvecarrf, ktimef, kfirst, kchannels,
+                                        (i % 64) / 16.0f, kcursor);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecarr_sample<double, 4>(drvecarrd, srvecarrd, ktimed, kfirst, kchannels,
+                                         (i % 64) / 16.0, kcursor);
+    }
+    millid = timer.elapsed();
+
+    cout << "key sample  " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = quatarr_sample<float>((quat<float> *) drvecarrf, squatarrf, ktimef, kfirst, kchannels,
+                                      (i % 64) / 16.0f, kcursor);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = quatarr_sample<double>((quat<double> *) drvecarrd, squatarrd, ktimed, kfirst, kchannels,
+                                       (i % 64) / 16.0, kcursor);
+    }
+    millid = timer.elapsed();
+
+    cout << "key nlerp   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = rmata_x_rmatb(drmat33f, srmat33af, srmat33bf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = rmata_x_rmatb(drmat33d, srmat33ad, srmat33bd);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat3 x mat3 " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = rmata_x_rmatb(drmat22f, srmat22af, srmat22bf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = rmata_x_rmatb(drmat22d, srmat22ad, srmat22bd);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat2 x mat2 " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rvecarr_x_rmat((rvec<float, 3> *) drvecarrf, (rvec<float, 3> *) srvecarrf,
+                               srmat33af, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rvecarr_x_rmat((rvec<double, 3> *) drvecarrd, (rvec<double, 3> *) srvecarrd,
+                               srmat33ad, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec3[]xmat3 " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = rvecarr_x_rmat((rvec<float, 2> *) drvecarrf, (rvec<float, 2> *) srvecarrf,
+                               srmat22af, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = rvecarr_x_rmat((rvec<double, 2> *) drvecarrd, (rvec<double, 2> *) srvecarrd,
+                               srmat22ad, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec2[]xmat2 " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecarr_add<float, 4>(drvecarrf, srvecarrf, srvecarrf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecarr_add<double, 4>(drvecarrd, srvecarrd, srvecarrd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] add   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecarr_blend<float, 4>(drvecarrf, srvecarrf, drvecarrf, 0.25f, 0.75f, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecarr_blend<double, 4>(drvecarrd, srvecarrd, drvecarrd, 0.25, 0.75, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] blend " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = vecarr_max<float, 4>(drvecarrf, srvecarrf, drvecarrf, elements);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = vecarr_max<double, 4>(drvecarrd, srvecarrd, drvecarrd, elements);
+    }
+    millid = timer.elapsed();
+
+    cout << "vec[] max   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
     timer.start();
-    for (int i = 0; i < iterations; ++i) {
-        specf = cmatb_x_cmata(dcmatf, scmatbf, scmataf);
+    for (int i = 0; i < iterations / elements; ++i) {
+        specf = matarr_axpy<float, 4, 4>(drmatarrf, srmatarraf, srmatarrbf, 2.0f, elements);
     }
     millif = timer.elapsed();
 
     specd = other;
     timer.start();
-    for (int i = 0; i < iterations; ++i) {
-        specd = cmatb_x_cmata(dcmatd, scmatbd, scmatad);
+    for (int i = 0; i < iterations / elements; ++i) {
+        specd = matarr_axpy<double, 4, 4>(drmatarrd, srmatarrad, srmatarrbd, 2.0, elements);
     }
     millid = timer.elapsed();
 
-    cout << "matb x mata " << setw(width) << millif << " ms "
+    cout << "mat[] axpy  " << setw(width) << millif << " ms "
                            << get_string(specf)     << " "
                            << setw(width) << millid << " ms "
                            << get_string(specd)     << endl;
@@ -737,18 +3675,18 @@ int main(void) {
     specf = other;
     timer.start();
     for (int i = 0; i < iterations / elements; ++i) {
-        specf = rvecarr_x_rmat(drvecarrf, srvecarrf, srmataf, elements);
+        specf = vecarr_x_smat<float>(drvecarrf, srvecarrf, formf[1], elements);
     }
     millif = timer.elapsed();
 
     specd = other;
     timer.start();
     for (int i = 0; i < iterations / elements; ++i) {
-        specd = rvecarr_x_rmat(drvecarrd, srvecarrd, srmatad, elements);
+        specd = vecarr_x_smat<double>(drvecarrd, srvecarrd, formd[1], elements);
     }
     millid = timer.elapsed();
 
-    cout << "vec[] x mat " << setw(width) << millif << " ms "
+    cout << "vec[] x trn " << setw(width) << millif << " ms "
                            << get_string(specf)     << " "
                            << setw(width) << millid << " ms "
                            << get_string(specd)     << endl;
@@ -756,27 +3694,589 @@ int main(void) {
     specf = other;
     timer.start();
     for (int i = 0; i < iterations / elements; ++i) {
-        specf = cmat_x_cvecarr(dcvecarrf, scmataf, scvecarrf, elements);
+        specf = vecarr_x_smat<float>(drvecarrf, srvecarrf, formf[2], elements);
     }
     millif = timer.elapsed();
 
     specd = other;
     timer.start();
     for (int i = 0; i < iterations / elements; ++i) {
-        specd = cmat_x_cvecarr(dcvecarrd, scmatad, scvecarrd, elements);
+        specd = vecarr_x_smat<double>(drvecarrd, srvecarrd, formd[2], elements);
     }
     millid = timer.elapsed();
 
-    cout << "mat x vec[] " << setw(width) << millif << " ms "
+    cout << "vec[] x scl " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = smat_x_smat(prodf, formf[3], formf[3]);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = smat_x_smat(prodd, formd[3], formd[3]);
+    }
+    millid = timer.elapsed();
+
+    cout << "aff x aff   " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = classify(formf[4]);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = classify(formd[4]);
+    }
+    millid = timer.elapsed();
+
+    cout << "classify    " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = mat_x_mat(m44f, m43f, m34f);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = mat_x_mat(m44d, m43d, m34d);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat4x3xmat3x" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specf = mat_x_mat(m88df, m88af, m88bf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        specd = mat_x_mat(m88dd, m88ad, m88bd);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat8 x mat8 " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < iterations / 8; ++i) {
+        specf = mat_x_mat(m1616df, m1616af, m1616bf);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < iterations / 8; ++i) {
+        specd = mat_x_mat(m1616dd, m1616ad, m1616bd);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat16xmat16 " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    // Sweep the size of large products, naive loops against the blocked
+    // version on one and all cores, repetitions keep the work constant
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (size_t n = 16; n <= 512; n *= 2) {
+        std::vector<float>  af(n * n, 0.5f), bf(n * n, 0.25f), df(n * n);
+        std::vector<double> ad(n * n, 0.5),  bd(n * n, 0.25),  dd(n * n);
+        long                reps = std::max<long>(1, long(iterations) / long(n * n * n));
+        std::string         label;
+
+        for (int path = 0; path < 3; ++path) {
+            unsigned threads = (path == 2) ? cores : 1;
+
+            specf = loops;
+            timer.start();
+            for (long i = 0; i < reps; ++i) {
+                if (path == 0) {
+                    naive_x_mat(df.data(), af.data(), bf.data(), n, n, n);
+                } else {
+                    specf = mat_x_mat_blocked(df.data(), af.data(), bf.data(), n, n, n, threads);
+                }
+            }
+            millif = timer.elapsed();
+
+            specd = loops;
+            timer.start();
+            for (long i = 0; i < reps; ++i) {
+                if (path == 0) {
+                    naive_x_mat(dd.data(), ad.data(), bd.data(), n, n, n);
+                } else {
+                    specd = mat_x_mat_blocked(dd.data(), ad.data(), bd.data(), n, n, n, threads);
+                }
+            }
+            millid = timer.elapsed();
+
+            label = (path == 0 ? "loops   " : path == 1 ? "blocked " : "threads ")
+                  + std::to_string(n);
+            label.resize(12, ' ');
+
+            cout << label << setw(width) << millif << " ms "
+                          << get_string(specf)     << " "
+                          << setw(width) << millid << " ms "
+                          << get_string(specd)     << endl;
+        }
+    }
+
+    // Large matrices in row major, tiled and Morton order storage
+    const size_t large = 512;
+    auto         *lmf  = new mat <float,  large, large>[3];
+    auto         *lmd  = new mat <double, large, large>[3];
+    auto         *ltf  = new lmat<float,  large, large, tiled<>> [3];
+    auto         *ltd  = new lmat<double, large, large, tiled<>> [3];
+    auto         *lzf  = new lmat<float,  large, large, morton<>>[3];
+    auto         *lzd  = new lmat<double, large, large, morton<>>[3];
+    int          lmuls = std::max(1, int(iterations / (large * large * large)));
+    int          ltrns = std::max(1, int(iterations / (large * large)));
+
+    for (int e = 0; e < 2; ++e) {
+        set_matrix(lmf[e], [e] (int r, int c) -> float  { return float ((r + c + e) % 7) / 8; });
+        set_matrix(lmd[e], [e] (int r, int c) -> double { return double((r + c + e) % 7) / 8; });
+        mat_to_lmat(ltf[e], lmf[e]);
+        mat_to_lmat(ltd[e], lmd[e]);
+        mat_to_lmat(lzf[e], lmf[e]);
+        mat_to_lmat(lzd[e], lmd[e]);
+    }
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < lmuls; ++i) {
+        specf = mat_x_mat(lmf[2], lmf[0], lmf[1]);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < lmuls; ++i) {
+        specd = mat_x_mat(lmd[2], lmd[0], lmd[1]);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat512 x mat" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < lmuls; ++i) {
+        specf = mat_x_mat(ltf[2], ltf[0], ltf[1]);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < lmuls; ++i) {
+        specd = mat_x_mat(ltd[2], ltd[0], ltd[1]);
+    }
+    millid = timer.elapsed();
+
+    cout << "tile512 x tl" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < lmuls; ++i) {
+        specf = mat_x_mat(lzf[2], lzf[0], lzf[1]);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < lmuls; ++i) {
+        specd = mat_x_mat(lzd[2], lzd[0], lzd[1]);
+    }
+    millid = timer.elapsed();
+
+    cout << "mort512 x mt" << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < ltrns; ++i) {
+        specf = transpose(lmf[2], lmf[0]);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < ltrns; ++i) {
+        specd = transpose(lmd[2], lmd[0]);
+    }
+    millid = timer.elapsed();
+
+    cout << "mat512 trn  " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < ltrns; ++i) {
+        specf = transpose(ltf[2], ltf[0]);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < ltrns; ++i) {
+        specd = transpose(ltd[2], ltd[0]);
+    }
+    millid = timer.elapsed();
+
+    cout << "tile512 trn " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    specf = other;
+    timer.start();
+    for (int i = 0; i < ltrns; ++i) {
+        specf = transpose(lzf[2], lzf[0]);
+    }
+    millif = timer.elapsed();
+
+    specd = other;
+    timer.start();
+    for (int i = 0; i < ltrns; ++i) {
+        specd = transpose(lzd[2], lzd[0]);
+    }
+    millid = timer.elapsed();
+
+    cout << "mort512 trn " << setw(width) << millif << " ms "
+                           << get_string(specf)     << " "
+                           << setw(width) << millid << " ms "
+                           << get_string(specd)     << endl;
+
+    delete[] lmf;
+    delete[] lmd;
+    delete[] ltf;
+    delete[] ltd;
+    delete[] lzf;
+    delete[] lzd;
+
+    
+    
+    // -------------------------------------------------------------------------
+    // Test and time vector arrays that are not aligned.
+    // User buffers may come from std::vector or other allocators,
+    // so offset the arrays by a number of bytes from an aligned address.
+    // An odd number of vectors verifies nothing is written past the end.
+
+    size_t offsets[] = { 0, 8, 16, 24 };
+    int    odd       = (elements - 1) | 1;
+    auto   bytesf    = (elements + 1) * sizeof(rvec<float,  4>) + alignment;
+    auto   bytesd    = (elements + 1) * sizeof(rvec<double, 4>) + alignment;
+    char   *bufdf    = (char *) alloc_aligned(bytesf);
+    char   *bufsf    = (char *) alloc_aligned(bytesf);
+    char   *bufdd    = (char *) alloc_aligned(bytesd);
+    char   *bufsd    = (char *) alloc_aligned(bytesd);
+    
+    if (   bufdf == nullptr
+        || bufsf == nullptr
+        || bufdd == nullptr
+        || bufsd == nullptr) {
+        cout << "Failed to allocate memory for misaligned vector arrays" << endl;
+        exit(1);
+    }
+
+    for (auto offset : offsets) {
+        auto *dvecarrf = (rvec<float,  4> *) (bufdf + offset);
+        auto *svecarrf = (rvec<float,  4> *) (bufsf + offset);
+        auto *dvecarrd = (rvec<double, 4> *) (bufdd + offset);
+        auto *svecarrd = (rvec<double, 4> *) (bufsd + offset);
+        
+        memcpy(svecarrf, srvecarrf, elements * sizeof(rvec<float,  4>));
+        memcpy(svecarrd, srvecarrd, elements * sizeof(rvec<double, 4>));
+        memset(dvecarrf, 0, (elements + 1) * sizeof(rvec<float,  4>));
+        memset(dvecarrd, 0, (elements + 1) * sizeof(rvec<double, 4>));
+        
+        rvecarr_x_rmat(dvecarrf, svecarrf, srmataf, odd);
+        rvecarr_x_rmat(dvecarrd, svecarrd, srmatad, odd);
+
+        cout << "vec[] 1x4 * mat   4x4 +" << setw(2) << left << offset << right;
+        compare_vec<float,  4>(dvecarrf, evec0f, evec1f, odd, " float  test ", true);
+        cout << "vec[] 1x4 * mat   4x4 +" << setw(2) << left << offset << right;
+        compare_vec<double, 4>(dvecarrd, evec0d, evec1d, odd, " double test ", true);
+    }
+
+    for (auto offset : offsets) {
+        auto *dvecarrf = (rvec<float,  4> *) (bufdf + offset);
+        auto *svecarrf = (rvec<float,  4> *) (bufsf + offset);
+        auto *dvecarrd = (rvec<double, 4> *) (bufdd + offset);
+        auto *svecarrd = (rvec<double, 4> *) (bufsd + offset);
+        
+        specf = other;
+        timer.start();
+        for (int i = 0; i < iterations / elements; ++i) {
+            specf = rvecarr_x_rmat(dvecarrf, svecarrf, srmataf, elements);
+        }
+        millif = timer.elapsed();
+
+        specd = other;
+        timer.start();
+        for (int i = 0; i < iterations / elements; ++i) {
+            specd = rvecarr_x_rmat(dvecarrd, svecarrd, srmatad, elements);
+        }
+        millid = timer.elapsed();
+
+        cout << "v[]+" << setw(2) << left << offset << right << " x mat"
+                           << setw(width) << millif << " ms "
                            << get_string(specf)     << " "
                            << setw(width) << millid << " ms "
                            << get_string(specd)     << endl;
+    }
+    
+    // Quaternion arrays, to matrices and rotating vectors. Only the intrinsics
+    // specializations are written for unaligned arrays, generic code may be
+    // vectorized for the alignment of the types. Whole blocks of 8 skip the
+    // generic remainder, results are compared bytewise with aligned arrays.
+#if defined(INTRIN) || defined(INTRIN256)
+    int  whole   = odd & ~7;
+    auto bytesmf = (elements + 1) * sizeof(rmat<float,  4, 4>) + alignment;
+    auto bytesmd = (elements + 1) * sizeof(rmat<double, 4, 4>) + alignment;
+    char *bufmf  = (char *) alloc_aligned(bytesmf);
+    char *bufmd  = (char *) alloc_aligned(bytesmd);
+
+    if (bufmf == nullptr || bufmd == nullptr) {
+        cout << "Failed to allocate memory for misaligned matrix arrays" << endl;
+        exit(1);
+    }
+
+    for (int i = 0; i < whole; ++i) {
+        memcpy(srvecarrf + i, squatvecf + (i & 1), sizeof(rvec<float,  4>));
+        memcpy(srvecarrd + i, squatvecd + (i & 1), sizeof(rvec<double, 4>));
+    }
+    quatarr_to_rmatarr(drmatarrf, squatarrf, whole);
+    quatarr_to_rmatarr(drmatarrd, squatarrd, whole);
+    rvecarr_x_quat(drvecarrf, srvecarrf, squatarrf[0], whole);
+    rvecarr_x_quat(drvecarrd, srvecarrd, squatarrd[0], whole);
+
+    for (auto offset : offsets) {
+        auto *dmatarrf = (rmat<float,  4, 4> *) (bufmf + offset);
+        auto *dmatarrd = (rmat<double, 4, 4> *) (bufmd + offset);
+        auto *dvecarrf = (rvec<float,  4>    *) (bufdf + offset);
+        auto *dvecarrd = (rvec<double, 4>    *) (bufdd + offset);
+        auto *svecarrf = (rvec<float,  4>    *) (bufsf + offset);
+        auto *svecarrd = (rvec<double, 4>    *) (bufsd + offset);
+        auto *squatf   = (quat<float>        *) (bufsf + offset);
+        auto *squatd   = (quat<double>       *) (bufsd + offset);
+        auto bytesf    = whole * sizeof(rmat<float,  4, 4>);
+        auto bytesd    = whole * sizeof(rmat<double, 4, 4>);
+
+        memcpy(squatf, squatarrf, whole * sizeof(quat<float>));
+        memcpy(squatd, squatarrd, whole * sizeof(quat<double>));
+        memset(dmatarrf, 0, bytesf + sizeof(rmat<float,  4, 4>));
+        memset(dmatarrd, 0, bytesd + sizeof(rmat<double, 4, 4>));
+
+        quatarr_to_rmatarr(dmatarrf, squatf, whole);
+        quatarr_to_rmatarr(dmatarrd, squatd, whole);
+
+        validf = memcmp(dmatarrf, drmatarrf, bytesf) == 0 && bufmf[offset + bytesf] == 0;
+        validd = memcmp(dmatarrd, drmatarrd, bytesd) == 0 && bufmd[offset + bytesd] == 0;
+
+        cout << "quat[] to rmat[] +" << setw(2) << left << offset << right
+             << " float  test " << (validf ? passed : failed) << endl;
+        cout << "quat[] to rmat[] +" << setw(2) << left << offset << right
+             << " double test " << (validd ? passed : failed) << endl;
+
+        bytesf = whole * sizeof(rvec<float,  4>);
+        bytesd = whole * sizeof(rvec<double, 4>);
+
+        memcpy(svecarrf, srvecarrf, bytesf);
+        memcpy(svecarrd, srvecarrd, bytesd);
+        memset(dvecarrf, 0, bytesf + sizeof(rvec<float,  4>));
+        memset(dvecarrd, 0, bytesd + sizeof(rvec<double, 4>));
+
+        rvecarr_x_quat(dvecarrf, svecarrf, squatarrf[0], whole);
+        rvecarr_x_quat(dvecarrd, svecarrd, squatarrd[0], whole);
+
+        validf = memcmp(dvecarrf, drvecarrf, bytesf) == 0 && bufdf[offset + bytesf] == 0;
+        validd = memcmp(dvecarrd, drvecarrd, bytesd) == 0 && bufdd[offset + bytesd] == 0;
+
+        cout << "vec[] 1x4 * quat +" << setw(2) << left << offset << right
+             << " float  test " << (validf ? passed : failed) << endl;
+        cout << "vec[] 1x4 * quat +" << setw(2) << left << offset << right
+             << " double test " << (validd ? passed : failed) << endl;
+    }
+
+    // Translation, rotation and scale arrays, composed and decomposed
+    char *bufvf = (char *) alloc_aligned(bytesf);
+    char *bufvd = (char *) alloc_aligned(bytesd);
+
+    if (bufvf == nullptr || bufvd == nullptr) {
+        cout << "Failed to allocate memory for misaligned vector arrays" << endl;
+        exit(1);
+    }
+
+    trsarr_to_rmatarr(drmatarrf, strsarrf, squatarrf, ssclarrf, whole);
+    trsarr_to_rmatarr(drmatarrd, strsarrd, squatarrd, ssclarrd, whole);
+    rmatarr_to_trsarr(dtrsarrf, dquatarrf, dsclarrf, drmatarrf, whole);
+    rmatarr_to_trsarr(dtrsarrd, dquatarrd, dsclarrd, drmatarrd, whole);
+
+    for (auto offset : offsets) {
+        auto *matarrf  = (rmat<float,  4, 4> *) (bufmf + offset);
+        auto *matarrd  = (rmat<double, 4, 4> *) (bufmd + offset);
+        auto *trsarrf  = (rvec<float,  4>    *) (bufsf + offset);
+        auto *trsarrd  = (rvec<double, 4>    *) (bufsd + offset);
+        auto *sclarrf  = (rvec<float,  4>    *) (bufdf + offset);
+        auto *sclarrd  = (rvec<double, 4>    *) (bufdd + offset);
+        auto *quatarrf = (quat<float>        *) (bufvf + offset);
+        auto *quatarrd = (quat<double>       *) (bufvd + offset);
+        auto sizevf    = whole * sizeof(rvec<float,  4>);
+        auto sizevd    = whole * sizeof(rvec<double, 4>);
+        auto sizemf    = whole * sizeof(rmat<float,  4, 4>);
+        auto sizemd    = whole * sizeof(rmat<double, 4, 4>);
+
+        memcpy(trsarrf,  strsarrf,  sizevf);
+        memcpy(trsarrd,  strsarrd,  sizevd);
+        memcpy(sclarrf,  ssclarrf,  sizevf);
+        memcpy(sclarrd,  ssclarrd,  sizevd);
+        memcpy(quatarrf, squatarrf, sizevf);
+        memcpy(quatarrd, squatarrd, sizevd);
+        memset(matarrf, 0, sizemf + sizeof(rmat<float,  4, 4>));
+        memset(matarrd, 0, sizemd + sizeof(rmat<double, 4, 4>));
+
+        trsarr_to_rmatarr(matarrf, trsarrf, quatarrf, sclarrf, whole);
+        trsarr_to_rmatarr(matarrd, trsarrd, quatarrd, sclarrd, whole);
+
+        validf = memcmp(matarrf, drmatarrf, sizemf) == 0 && bufmf[offset + sizemf] == 0;
+        validd = memcmp(matarrd, drmatarrd, sizemd) == 0 && bufmd[offset + sizemd] == 0;
+
+        cout << "trs[] to rmat[]  +" << setw(2) << left << offset << right
+             << " float  test " << (validf ? passed : failed) << endl;
+        cout << "trs[] to rmat[]  +" << setw(2) << left << offset << right
+             << " double test " << (validd ? passed : failed) << endl;
+
+        memset(trsarrf,  0, sizevf + sizeof(rvec<float,  4>));
+        memset(trsarrd,  0, sizevd + sizeof(rvec<double, 4>));
+        memset(sclarrf,  0, sizevf + sizeof(rvec<float,  4>));
+        memset(sclarrd,  0, sizevd + sizeof(rvec<double, 4>));
+        memset(quatarrf, 0, sizevf + sizeof(quat<float>));
+        memset(quatarrd, 0, sizevd + sizeof(quat<double>));
+
+        rmatarr_to_trsarr(trsarrf, quatarrf, sclarrf, matarrf, whole);
+        rmatarr_to_trsarr(trsarrd, quatarrd, sclarrd, matarrd, whole);
+
+        validf =    memcmp(trsarrf,  dtrsarrf,  sizevf) == 0 && bufsf[offset + sizevf] == 0
+                 && memcmp(quatarrf, dquatarrf, sizevf) == 0 && bufvf[offset + sizevf] == 0
+                 && memcmp(sclarrf,  dsclarrf,  sizevf) == 0 && bufdf[offset + sizevf] == 0;
+        validd =    memcmp(trsarrd,  dtrsarrd,  sizevd) == 0 && bufsd[offset + sizevd] == 0
+                 && memcmp(quatarrd, dquatarrd, sizevd) == 0 && bufvd[offset + sizevd] == 0
+                 && memcmp(sclarrd,  dsclarrd,  sizevd) == 0 && bufdd[offset + sizevd] == 0;
+
+        cout << "rmat[] to trs[]  +" << setw(2) << left << offset << right
+             << " float  test " << (validf ? passed : failed) << endl;
+        cout << "rmat[] to trs[]  +" << setw(2) << left << offset << right
+             << " double test " << (validd ? passed : failed) << endl;
+    }
+
+    free_aligned(bufvf);
+    free_aligned(bufvd);
+    free_aligned(bufmf);
+    free_aligned(bufmd);
+#endif
+
+    free_aligned(bufdf);
+    free_aligned(bufsf);
+    free_aligned(bufdd);
+    free_aligned(bufsd);
 
     
     
     // -------------------------------------------------------------------------
-    // Free the vector arrays
+    // Free the vector and matrix arrays
     
+    free_aligned(drmatarrf);
+    free_aligned(srmatarraf);
+    free_aligned(srmatarrbf);
+    free_aligned(drmatarrd);
+    free_aligned(srmatarrad);
+    free_aligned(srmatarrbd);
+    free_aligned(dsoaf);
+    free_aligned(ssoaaf);
+    free_aligned(ssoabf);
+    free_aligned(dsoad);
+    free_aligned(ssoaad);
+    free_aligned(ssoabd);
+    free_aligned(squatarrf);
+    free_aligned(squatarrd);
+    free_aligned(strsarrf);
+    free_aligned(ssclarrf);
+    free_aligned(dtrsarrf);
+    free_aligned(dsclarrf);
+    free_aligned(dquatarrf);
+    free_aligned(strsarrd);
+    free_aligned(ssclarrd);
+    free_aligned(dtrsarrd);
+    free_aligned(dsclarrd);
+    free_aligned(dquatarrd);
+    free_aligned(hlocalf);
+    free_aligned(hreff);
+    free_aligned(hlocald);
+    free_aligned(hrefd);
+    free_aligned(spalf);
+    free_aligned(spald);
+    free_aligned(sbonearr);
+    free_aligned(swgtarrf);
+    free_aligned(swgtarrd);
+    free_aligned(dnrmarrf);
+    free_aligned(dnrmarrd);
+    free_aligned(sidxarr);
+    free_aligned(sidxrun);
+    free_aligned(saabbarf);
+    free_aligned(daabbarf);
+    free_aligned(saabbard);
+    free_aligned(daabbard);
+    free_aligned(dvisarr);
+    free_aligned(ssoaarf);
+    free_aligned(dsoaarf);
+    free_aligned(ssoaard);
+    free_aligned(dsoaard);
+    free_aligned(dscalf);
+    free_aligned(dscald);
+    free_aligned(ktimef);
+    free_aligned(ktimed);
+    free_aligned(kfirst);
+    free_aligned(kcursor);
+
 #if defined(__x86_64__) || defined(_M_X64)      // 64-bit Intel
     _mm_free(drvecarrf);
     _mm_free(srvecarrf);
@@ -4,14 +4,24 @@
 #define matrix3d_h
 
 #include <cstddef>
+#include <cmath>
 #include <cstring>
+#include <algorithm>
+#include <barrier>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <type_traits>
 
 namespace matrix3d {
 
 
 
 // -----------------------------------------------------------------------------
-// Align for 256-bit register
+// Align for 256-bit register.
+// Only needed for the fastest code paths, SIMD implementations
+// also work correctly on data that is not aligned.
 const int alignment = 256 / 8;
 
 
@@ -32,6 +42,14 @@ enum specialized {
     sve,        // Specialized implmentation with ARM SVE2 assembly language
     sme,        // Specialized implmentation with ARM SME assembly language
     zero,       // Desired code not implemented, zero'd data instead
+    intrin512,  // Specialized implmentation with AVX-512 SIMD Intrinsics
+    ident,      // Structured matrix, identity, a copy
+    translate,  // Structured matrix, translation only
+    scale,      // Structured matrix, scale and translation
+    affine,     // Structured matrix, last column [ 0 0 0 1 ]
+    block256,   // Register blocked 8x8 and 16x16 AVX2 Intrinsics
+    block512,   // Register blocked 8x8 and 16x16 AVX-512 Intrinsics
+    blockneon,  // Register blocked 8x8 and 16x16 NEON Intrinsics
     other       // Something is wrong if this is reported
 };
 
@@ -49,6 +67,14 @@ inline const char *get_string(specialized spec) {
         case  sve       : return "sve      ";
         case  sme       : return "sme      ";
         case  zero      : return "zero     ";
+        case  intrin512 : return "intrin512";
+        case  ident     : return "ident    ";
+        case  translate : return "translate";
+        case  scale     : return "scale    ";
+        case  affine    : return "affine   ";
+        case  block256  : return "block256 ";
+        case  block512  : return "block512 ";
+        case  blockneon : return "blockneon";
         default         : return "other    ";
     }
 }
@@ -64,11 +90,11 @@ template <typename T, size_t N> struct vec {
 
     // Note that template will only match arrays of size N,
     // the compiler is verifying the array size for us
-    void get(      T(&dest) [N]) { std::memcpy(dest, v,   sizeof(v)); }
-    void set(const T(&src)  [N]) { std::memcpy(v,    src, sizeof(v)); }
+    constexpr void get(      T(&dest) [N]) { std::copy(v,   v + N,   dest); }
+    constexpr void set(const T(&src)  [N]) { std::copy(src, src + N, v);    }
 
     // Verify that the index is in range
-    bool validate(size_t i) { return i < N; }
+    constexpr bool validate(size_t i) { return i < N; }
 };
 
 // Aliases for row and column major versions of a vector,
@@ -86,12 +112,22 @@ template <typename T, size_t MAJ, size_t MIN> struct mat {
     
     // Note that template will only match arrays of size MAJ * MIN,
     // the compiler is verifying the array size for us
-    void get(      T(&dest) [MAJ * MIN]) { std::memcpy(dest, m,   sizeof(m)); }
-    void set(const T(&src)  [MAJ * MIN]) { std::memcpy(m,    src, sizeof(m)); }
+    // Rows one at a time, a constant expression may not index past a row
+    constexpr void get(T(&dest) [MAJ * MIN]) {
+        for (size_t i = 0; i < MAJ; ++i) {
+            std::copy(m[i], m[i] + MIN, dest + i * MIN);
+        }
+    }
+
+    constexpr void set(const T(&src) [MAJ * MIN]) {
+        for (size_t i = 0; i < MAJ; ++i) {
+            std::copy(src + i * MIN, src + (i + 1) * MIN, m[i]);
+        }
+    }
 
     // Verify that row and column are in range
-    bool validate(size_t i, size_t j) { return i < MAJ && j < MIN; }
-    bool validate(size_t i)           { return i < MAJ;            }
+    constexpr bool validate(size_t i, size_t j) { return i < MAJ && j < MIN; }
+    constexpr bool validate(size_t i)           { return i < MAJ;            }
 };
 
 // Aliases for row and column major versions of a matrix,
@@ -106,44 +142,286 @@ template <typename T, size_t MAJ, size_t MIN> struct cmat : mat<T, MAJ, MIN>{};
 
 // Use a lambda function to iterate over vector and matrix
 template <typename T, size_t N, typename F>
-inline void set_vector(vec<T, N> &dest, F func) {
+constexpr void set_vector(vec<T, N> &dest, F func) {
     for (int i = 0; i < N; ++i)
         dest.v[i] = func(i);
 }
 
 template <typename T, size_t MAJ, size_t MIN, typename F>
-inline void set_matrix(mat<T, MAJ, MIN> &dest, F func) {
+constexpr void set_matrix(mat<T, MAJ, MIN> &dest, F func) {
     for (int i = 0; i < MAJ; ++i)
         for (int j = 0; j < MIN; ++j)
             dest.m[i][j] = func(i, j);
 }
 
 template <typename T, size_t MAJ, size_t MIN>
-inline void diagonal(mat<T, MAJ, MIN> &dest, T val) {
+constexpr void diagonal(mat<T, MAJ, MIN> &dest, T val) {
     set_matrix(dest, [val] (int i, int j)
                      -> T { return (i == j) ? val : T(0); });
 }
 
 template <typename T, size_t N>
-inline void copy(mat<T, N, N> &dest, mat<T, N, N> &src) {
+constexpr void copy(mat<T, N, N> &dest, mat<T, N, N> &src) {
     set_matrix(dest, [&src] (int i, int j)
                      -> T { return src.m[i][j]; });
 }
 
 template <typename T, size_t N>
-inline void add_scalar(vec<T, N> &dest, T val) {
+constexpr void add_scalar(vec<T, N> &dest, T val) {
     set_vector(dest, [&dest, val] (int i)
                      -> T { return dest.v[i] + val; });
 }
 
 template <typename T, size_t MAJ, size_t MIN>
-inline void add_scalar(mat<T, MAJ, MIN> &dest, T val) {
+constexpr void add_scalar(mat<T, MAJ, MIN> &dest, T val) {
     set_matrix(dest, [&dest, val] (int i, int j)
                      -> T { return dest.m[i][j] + val; });
 }
 
 
 
+// -----------------------------------------------------------------------------
+// Compile time unrolling
+
+// Products of small matrices and vectors fully unrolled at compile time.
+// Index sequences expand the rows and columns and fold expressions the sums,
+// added in the same order as the loops. Used by the general products in
+// UNROLL builds when every dimension is at most max_unroll. Shapes with
+// their own specializations, such as 4x4, still use them.
+const size_t max_unroll = 8;
+
+template <size_t i, size_t j, typename T, size_t MAJ, size_t MIN, size_t K, size_t... k>
+constexpr T unrolled_sum(mat<T, MAJ, K>   &a,
+                         mat<T, K,   MIN> &b,
+                         std::index_sequence<k...>) {
+    return (... + (a.m[i][k] * b.m[k][j]));
+}
+
+template <size_t i, typename T, size_t MAJ, size_t MIN, size_t K, size_t... j>
+constexpr void unrolled_row(mat<T, MAJ, MIN> &dest,
+                            mat<T, MAJ, K>   &a,
+                            mat<T, K,   MIN> &b,
+                            std::index_sequence<j...>) {
+    ((dest.m[i][j] = unrolled_sum<i, j>(a, b, std::make_index_sequence<K>())), ...);
+}
+
+template <typename T, size_t MAJ, size_t MIN, size_t K, size_t... i>
+constexpr void unrolled_mat_x_mat(mat<T, MAJ, MIN> &dest,
+                                  mat<T, MAJ, K>   &a,
+                                  mat<T, K,   MIN> &b,
+                                  std::index_sequence<i...>) {
+    (unrolled_row<i>(dest, a, b, std::make_index_sequence<MIN>()), ...);
+}
+
+template <size_t j, typename T, size_t MAJ, size_t MIN, size_t... i>
+constexpr T unrolled_sum(vec<T, MAJ>      &v,
+                         mat<T, MAJ, MIN> &m,
+                         std::index_sequence<i...>) {
+    return (... + (v.v[i] * m.m[i][j]));
+}
+
+template <typename T, size_t MAJ, size_t MIN, size_t... j>
+constexpr void unrolled_vec_x_mat(vec<T, MIN>      &dest,
+                                  vec<T, MAJ>      &v,
+                                  mat<T, MAJ, MIN> &m,
+                                  std::index_sequence<j...>) {
+    ((dest.v[j] = unrolled_sum<j>(v, m, std::make_index_sequence<MAJ>())), ...);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Blocked matrix multiplication
+
+// Large products are computed a block at a time so the data stays in cache.
+// Blocks of b, kc x nc, and of a, mc x kc, are packed into panels that a
+// micro-kernel reads sequentially. Panels of a are mr rows, stored a column
+// at a time, panels of b are nr columns, stored a row at a time, both padded
+// with zeros. The micro-kernel keeps an mr x nr tile of dest in registers.
+// Packed a blocks are sized for L2 and panels of b for L1. SIMD
+// specializations of gemm_shape and gemm_kernel set the sizes for each
+// architecture.
+template <typename T> struct gemm_shape {
+    static const size_t mr = 4;
+    static const size_t nr = 8;
+    static const size_t mc = 128;
+    static const size_t kc = 256;
+    static const size_t nc = 4096;
+};
+
+// Products at least this large in every dimension use the blocked version
+const size_t gemm_min = 32;
+
+// dest(mr,nr) += a(mr,kc) * b(kc,nr) from packed panels,
+// rows of dest are ld elements apart
+template <typename T>
+inline specialized gemm_kernel(T *dest, size_t ld, T *pa, T *pb, size_t kc) {
+    const size_t mr = gemm_shape<T>::mr;
+    const size_t nr = gemm_shape<T>::nr;
+    T            sum[mr][nr] = {};
+
+    for (size_t p = 0; p < kc; ++p, pa += mr, pb += nr) {
+        for (size_t i = 0; i < mr; ++i) {
+            for (size_t j = 0; j < nr; ++j) {
+                sum[i][j] += pa[i] * pb[j];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < mr; ++i) {
+        for (size_t j = 0; j < nr; ++j) {
+            dest[i * ld + j] += sum[i][j];
+        }
+    }
+
+    return loops;
+}
+
+// Pack rows x cols of a, rows ld elements apart, into panels of mr rows
+template <typename T>
+inline void gemm_pack_a(T *dest, T *a, size_t ld, size_t rows, size_t cols) {
+    const size_t mr = gemm_shape<T>::mr;
+
+    for (size_t i = 0; i < rows; i += mr) {
+        for (size_t p = 0; p < cols; ++p) {
+            for (size_t r = 0; r < mr; ++r) {
+                *dest++ = (i + r < rows) ? a[(i + r) * ld + p] : T(0);
+            }
+        }
+    }
+}
+
+// Pack rows x cols of b, rows ld elements apart, into panels of nr columns
+template <typename T>
+inline void gemm_pack_b(T *dest, T *b, size_t ld, size_t rows, size_t cols) {
+    const size_t nr = gemm_shape<T>::nr;
+
+    for (size_t j = 0; j < cols; j += nr) {
+        for (size_t p = 0; p < rows; ++p) {
+            for (size_t c = 0; c < nr; ++c) {
+                *dest++ = (j + c < cols) ? b[p * ld + j + c] : T(0);
+            }
+        }
+    }
+}
+
+// Multiply a packed block of a by a packed block of b, tiles on the edges
+// are computed in a temporary tile and added to dest
+template <typename T>
+inline specialized gemm_block(T *dest, size_t ld, T *pa, T *pb,
+                              size_t rows, size_t cols, size_t kc) {
+    const size_t mr   = gemm_shape<T>::mr;
+    const size_t nr   = gemm_shape<T>::nr;
+    auto         spec = other;
+
+    for (size_t j = 0; j < cols; j += nr) {
+        for (size_t i = 0; i < rows; i += mr) {
+            T *panela = pa + i * kc;
+            T *panelb = pb + j * kc;
+
+            if (i + mr <= rows && j + nr <= cols) {
+                spec = gemm_kernel(dest + i * ld + j, ld, panela, panelb, kc);
+            } else {
+                T tile[mr * nr] = {};
+
+                spec = gemm_kernel(tile, nr, panela, panelb, kc);
+
+                for (size_t r = 0; r < mr && i + r < rows; ++r) {
+                    for (size_t c = 0; c < nr && j + c < cols; ++c) {
+                        dest[(i + r) * ld + j + c] += tile[r * nr + c];
+                    }
+                }
+            }
+        }
+    }
+
+    return spec;
+}
+
+// Row major order
+// dest(maj,min) = a(maj,k) * b(k,min)
+//
+// Column major order
+// T(dest(maj,min)) = T(b(k,min)) * T(a(maj,k))
+//
+// Note the linear arrays are the same. Blocks of rows of a are split
+// across threads, each packing its own blocks of a. The threads are
+// started once and share each packed block of b, the first thread packs
+// it and a barrier holds the others until it is ready. A second barrier
+// keeps it from being repacked while any thread still uses it.
+template <typename T>
+inline specialized mat_x_mat_blocked(T        *dest,
+                                     T        *a,
+                                     T        *b,
+                                     size_t   maj,
+                                     size_t   min,
+                                     size_t   k,
+                                     unsigned threads = 1) {
+    const size_t   mr   = gemm_shape<T>::mr;
+    const size_t   nr   = gemm_shape<T>::nr;
+    const size_t   mc   = gemm_shape<T>::mc;
+    const size_t   kc   = gemm_shape<T>::kc;
+    const size_t   nc   = gemm_shape<T>::nc;
+    size_t         rowblocks = (maj + mc - 1) / mc;
+    size_t         parts     = std::min<size_t>(std::max(threads, 1u), std::max<size_t>(rowblocks, 1));
+    size_t         chunk     = (rowblocks + parts - 1) / parts;
+    size_t         sizea     = (std::min(mc, maj) + mr - 1) / mr * mr * std::min(kc, k);
+    size_t         sizeb     = (std::min(nc, min) + nr - 1) / nr * nr * std::min(kc, k);
+    std::vector<T> packa(sizea * parts);
+    std::vector<T> packb(sizeb);
+    std::barrier   sync(parts);
+
+    std::fill(dest, dest + maj * min, T(0));
+
+    // Blocks of rows first to last of every block of b, with their own packed a
+    auto rows_x_blocks = [&] (size_t part) {
+        size_t first = part * chunk;
+        size_t last  = std::min(rowblocks, first + chunk);
+        T      *pa   = packa.data() + part * sizea;
+        auto   spec  = other;
+
+        for (size_t jc = 0; jc < min; jc += nc) {
+            size_t cols = std::min(nc, min - jc);
+
+            for (size_t pc = 0; pc < k; pc += kc) {
+                size_t depth = std::min(kc, k - pc);
+
+                if (part == 0) {
+                    gemm_pack_b(packb.data(), b + pc * min + jc, min, depth, cols);
+                }
+                sync.arrive_and_wait();
+
+                for (size_t ic = first * mc; ic < std::min(last * mc, maj); ic += mc) {
+                    size_t rows = std::min(mc, maj - ic);
+
+                    gemm_pack_a(pa, a + ic * k + pc, k, rows, depth);
+                    spec = gemm_block(dest + ic * min + jc, min, pa, packb.data(),
+                                      rows, cols, depth);
+                }
+                sync.arrive_and_wait();
+            }
+        }
+
+        return spec;
+    };
+
+    std::vector<std::thread> pool;
+
+    for (size_t t = 1; t < parts; ++t) {
+        pool.emplace_back(rows_x_blocks, t);
+    }
+
+    auto spec = rows_x_blocks(0);
+
+    for (auto &thread : pool) {
+        thread.join();
+    }
+
+    return spec;
+}
+
+
+
 // -----------------------------------------------------------------------------
 // Matrix multiplication
 
@@ -178,11 +456,16 @@ inline void add_scalar(mat<T, MAJ, MIN> &dest, T val) {
 //                  Am+En+Io+Mp, Bm+Fn+Jo+Np, Cm+Gn+Ko+Op, Dm+Hn+Lo+Pp ]
 //
 // Note the linear arrays are the same
+//
+// Products are constexpr so matrices known at compile time fold to
+// constants. Specializations use intrinsics, assembly and pointers across
+// rows, which are not constant expressions, so when std::is_constant_evaluated
+// they return the looped version instead.
 
 template <typename T, size_t MAJ, size_t MIN, size_t K>
-inline specialized mat_x_mat(mat<T, MAJ, MIN> &dest,
-                             mat<T, MAJ, K>   &a,
-                             mat<T, K,   MIN> &b) {
+constexpr specialized looped_mat_x_mat(mat<T, MAJ, MIN> &dest,
+                                       mat<T, MAJ, K>   &a,
+                                       mat<T, K,   MIN> &b) {
     for (int i = 0; i < MAJ; ++i) {
         for (int j = 0; j < MIN; ++j) {
             auto sum = T(0);
@@ -199,16 +482,36 @@ inline specialized mat_x_mat(mat<T, MAJ, MIN> &dest,
 }
 
 template <typename T, size_t MAJ, size_t MIN, size_t K>
-inline specialized rmata_x_rmatb(rmat<T, MAJ, MIN> &dest,
-                                 rmat<T, MAJ, K>   &a,
-                                 rmat<T, K,   MIN> &b) {
+constexpr specialized mat_x_mat(mat<T, MAJ, MIN> &dest,
+                                mat<T, MAJ, K>   &a,
+                                mat<T, K,   MIN> &b) {
+    if constexpr (MAJ >= gemm_min && MIN >= gemm_min && K >= gemm_min) {
+        if (!std::is_constant_evaluated()) {
+            return mat_x_mat_blocked(dest.m[0], a.m[0], b.m[0], MAJ, MIN, K);
+        }
+    }
+
+#ifdef UNROLL
+    if constexpr (MAJ <= max_unroll && MIN <= max_unroll && K <= max_unroll) {
+        unrolled_mat_x_mat(dest, a, b, std::make_index_sequence<MAJ>());
+        return unroll;
+    }
+#endif
+
+    return looped_mat_x_mat(dest, a, b);
+}
+
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+constexpr specialized rmata_x_rmatb(rmat<T, MAJ, MIN> &dest,
+                                    rmat<T, MAJ, K>   &a,
+                                    rmat<T, K,   MIN> &b) {
     return mat_x_mat(dest, a, b);
 }
 
 template <typename T, size_t MAJ, size_t MIN, size_t K>
-inline specialized cmatb_x_cmata(cmat<T, MIN, MAJ> &tdest,
-                                 cmat<T, K,   MIN> &tb,
-                                 cmat<T, MAJ, K>   &ta) {
+constexpr specialized cmatb_x_cmata(cmat<T, MIN, MAJ> &tdest,
+                                    cmat<T, K,   MIN> &tb,
+                                    cmat<T, MAJ, K>   &ta) {
     // Transpositions not needed since memory layout the same
     return mat_x_mat(tdest, ta, tb);
 }
@@ -247,9 +550,9 @@ inline specialized cmatb_x_cmata(cmat<T, MIN, MAJ> &tdest,
 // Note the linear arrays are the same
 
 template <typename T, size_t MAJ, size_t MIN>
-inline specialized vec_x_mat(vec <T, MIN>      &dest,
-                             vec <T, MAJ>      &v,
-                             mat <T, MAJ, MIN> &m) {
+constexpr specialized looped_vec_x_mat(vec <T, MIN>      &dest,
+                                       vec <T, MAJ>      &v,
+                                       mat <T, MAJ, MIN> &m) {
     for (int j = 0; j < MIN; ++j) {
         auto sum = T(0);
         
@@ -263,16 +566,30 @@ inline specialized vec_x_mat(vec <T, MIN>      &dest,
 }
 
 template <typename T, size_t MAJ, size_t MIN>
-inline specialized rvec_x_rmat(rvec <T, MIN>      &dest,
-                               rvec <T, MAJ>      &v,
-                               rmat <T, MAJ, MIN> &m) {
+constexpr specialized vec_x_mat(vec <T, MIN>      &dest,
+                                vec <T, MAJ>      &v,
+                                mat <T, MAJ, MIN> &m) {
+#ifdef UNROLL
+    if constexpr (MAJ <= max_unroll && MIN <= max_unroll) {
+        unrolled_vec_x_mat(dest, v, m, std::make_index_sequence<MIN>());
+        return unroll;
+    }
+#endif
+
+    return looped_vec_x_mat(dest, v, m);
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+constexpr specialized rvec_x_rmat(rvec <T, MIN>      &dest,
+                                  rvec <T, MAJ>      &v,
+                                  rmat <T, MAJ, MIN> &m) {
     return vec_x_mat(dest, v, m);
 }
 
 template <typename T, size_t MAJ, size_t MIN>
-inline specialized cmat_x_cvec(cvec <T, MAJ>      &tdest,
-                               cmat <T, MAJ, MIN> &tm,
-                               cvec <T, MIN>      &tv) {
+constexpr specialized cmat_x_cvec(cvec <T, MIN>      &tdest,
+                                  cmat <T, MAJ, MIN> &tm,
+                                  cvec <T, MAJ>      &tv) {
     // Transpositions not needed since memory layout the same
     return vec_x_mat(tdest, tv, tm);
 }
@@ -283,10 +600,19 @@ inline specialized cmat_x_cvec(cvec <T, MAJ>      &tdest,
 // Matrix and vector array multiplication
 
 template <typename T, size_t MAJ, size_t MIN>
-inline specialized vecarr_x_mat(vec <T, MAJ>      *dest,
+inline specialized vecarr_x_mat(vec <T, MIN>      *dest,
                                 vec <T, MAJ>      *v,
                                 mat <T, MAJ, MIN> &m,
                                 size_t            n) {
+#ifdef UNROLL
+    if constexpr (MAJ <= max_unroll && MIN <= max_unroll) {
+        for (size_t e = 0; e < n; ++e) {
+            unrolled_vec_x_mat(dest[e], v[e], m, std::make_index_sequence<MIN>());
+        }
+        return unroll;
+    }
+#endif
+
     for (int e = 0; e < n; ++e) {
         for (int j = 0; j < MIN; ++j) {
             auto sum = T(0);
@@ -302,7 +628,7 @@ inline specialized vecarr_x_mat(vec <T, MAJ>      *dest,
 }
 
 template <typename T, size_t MAJ, size_t MIN>
-inline specialized rvecarr_x_rmat(rvec <T, MAJ>      *dest,
+inline specialized rvecarr_x_rmat(rvec <T, MIN>      *dest,
                                   rvec <T, MAJ>      *v,
                                   rmat <T, MAJ, MIN> &m,
                                   size_t             n) {
@@ -312,13 +638,2786 @@ inline specialized rvecarr_x_rmat(rvec <T, MAJ>      *dest,
 template <typename T, size_t MAJ, size_t MIN>
 inline specialized cmat_x_cvecarr(cvec <T, MIN>      *dest,
                                   cmat <T, MAJ, MIN> &m,
-                                  cvec <T, MIN>      *v,
+                                  cvec <T, MAJ>      *v,
                                   size_t             n) {
     return vecarr_x_mat(dest, v, m, n);
 }
 
 
 
+
+// -----------------------------------------------------------------------------
+// Matrix array multiplication
+
+// Array of matrices multiplied by a single matrix, dest[e] = a[e] * b,
+// or a single matrix multiplied by an array of matrices, dest[e] = a * b[e].
+// SIMD specializations keep the single matrix in registers for the whole array.
+//
+// Row major order
+// dest[e](MAJ,MIN) = a[e](MAJ,K) * b(K,MIN)
+// dest[e](MAJ,MIN) = a(MAJ,K)    * b[e](K,MIN)
+//
+// Column major order
+// T(dest[e](MAJ,MIN)) = T(b(K,MIN))    * T(a[e](MAJ,K))
+// T(dest[e](MAJ,MIN)) = T(b[e](K,MIN)) * T(a(MAJ,K))
+//
+// Note the linear arrays are the same
+
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+inline specialized matarr_x_mat(mat<T, MAJ, MIN> *dest,
+                                mat<T, MAJ, K>   *a,
+                                mat<T, K,   MIN> &b,
+                                size_t           n) {
+    for (int e = 0; e < n; ++e) {
+        for (int i = 0; i < MAJ; ++i) {
+            for (int j = 0; j < MIN; ++j) {
+                auto sum = T(0);
+
+                for (int k = 0; k < K; ++k) {
+                    sum += a[e].m[i][k] * b.m[k][j];
+                }
+
+                dest[e].m[i][j] = sum;
+            }
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+inline specialized mat_x_matarr(mat<T, MAJ, MIN> *dest,
+                                mat<T, MAJ, K>   &a,
+                                mat<T, K,   MIN> *b,
+                                size_t           n) {
+    for (int e = 0; e < n; ++e) {
+        for (int i = 0; i < MAJ; ++i) {
+            for (int j = 0; j < MIN; ++j) {
+                auto sum = T(0);
+
+                for (int k = 0; k < K; ++k) {
+                    sum += a.m[i][k] * b[e].m[k][j];
+                }
+
+                dest[e].m[i][j] = sum;
+            }
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+inline specialized rmatarr_x_rmat(rmat<T, MAJ, MIN> *dest,
+                                  rmat<T, MAJ, K>   *a,
+                                  rmat<T, K,   MIN> &b,
+                                  size_t            n) {
+    return matarr_x_mat(dest, a, b, n);
+}
+
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+inline specialized rmat_x_rmatarr(rmat<T, MAJ, MIN> *dest,
+                                  rmat<T, MAJ, K>   &a,
+                                  rmat<T, K,   MIN> *b,
+                                  size_t            n) {
+    return mat_x_matarr(dest, a, b, n);
+}
+
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+inline specialized cmat_x_cmatarr(cmat<T, MIN, MAJ> *tdest,
+                                  cmat<T, K,   MIN> &tb,
+                                  cmat<T, MAJ, K>   *ta,
+                                  size_t            n) {
+    // Transpositions not needed since memory layout the same
+    return matarr_x_mat(tdest, ta, tb, n);
+}
+
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+inline specialized cmatarr_x_cmat(cmat<T, MIN, MAJ> *tdest,
+                                  cmat<T, K,   MIN> *tb,
+                                  cmat<T, MAJ, K>   &ta,
+                                  size_t            n) {
+    return mat_x_matarr(tdest, ta, tb, n);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Lane interleaved matrix arrays
+
+// Blocks of matrices stored element by element, the same element of
+// every matrix in a block is contiguous. A block of 4x4 matrices:
+// [ a00 of matrix 0, a00 of matrix 1, ... a00 of matrix lanes - 1,
+//   a01 of matrix 0, a01 of matrix 1, ... a01 of matrix lanes - 1,
+//   ...
+//   a33 of matrix 0, a33 of matrix 1, ... a33 of matrix lanes - 1 ]
+// Each SIMD lane then works on its own matrix and no broadcasts are needed.
+// The same element of all the matrices in a block fills a 64 byte cache line.
+
+template <typename T, size_t MAJ, size_t MIN> struct matsoa {
+    static const size_t lanes = 64 / sizeof(T);
+
+    alignas(alignment) T m[MAJ][MIN][lanes];
+};
+
+// Number of blocks needed for n matrices
+template <typename T, size_t MAJ, size_t MIN>
+inline size_t soa_blocks(size_t n) {
+    return (n + matsoa<T, MAJ, MIN>::lanes - 1) / matsoa<T, MAJ, MIN>::lanes;
+}
+
+// Convert an array of n matrices to lane interleaved blocks,
+// unused lanes of the last block are zero'd
+template <typename T, size_t MAJ, size_t MIN>
+inline void matarr_to_soa(matsoa<T, MAJ, MIN> *dest,
+                          mat<T, MAJ, MIN>    *src,
+                          size_t              n) {
+    const size_t lanes  = matsoa<T, MAJ, MIN>::lanes;
+    size_t       blocks = soa_blocks<T, MAJ, MIN>(n);
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t l = 0; l < lanes; ++l) {
+            size_t s = e * lanes + l;
+
+            for (int i = 0; i < MAJ; ++i) {
+                for (int j = 0; j < MIN; ++j) {
+                    dest[e].m[i][j][l] = (s < n) ? src[s].m[i][j] : T(0);
+                }
+            }
+        }
+    }
+}
+
+// Convert lane interleaved blocks back to an array of n matrices
+template <typename T, size_t MAJ, size_t MIN>
+inline void soa_to_matarr(mat<T, MAJ, MIN>    *dest,
+                          matsoa<T, MAJ, MIN> *src,
+                          size_t              n) {
+    const size_t lanes = matsoa<T, MAJ, MIN>::lanes;
+
+    for (size_t s = 0; s < n; ++s) {
+        for (int i = 0; i < MAJ; ++i) {
+            for (int j = 0; j < MIN; ++j) {
+                dest[s].m[i][j] = src[s / lanes].m[i][j][s % lanes];
+            }
+        }
+    }
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Pairwise matrix array multiplication
+
+// Array of matrices multiplied element by element, dest[e] = a[e] * b[e]
+//
+// Row major order
+// dest[e](MAJ,MIN) = a[e](MAJ,K) * b[e](K,MIN)
+//
+// Column major order
+// T(dest[e](MAJ,MIN)) = T(b[e](K,MIN)) * T(a[e](MAJ,K))
+
+// Matrix arrays, one product at a time
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+inline specialized matarr_x_matarr(mat<T, MAJ, MIN> *dest,
+                                   mat<T, MAJ, K>   *a,
+                                   mat<T, K,   MIN> *b,
+                                   size_t           n) {
+    auto spec = other;
+
+    for (size_t e = 0; e < n; ++e) {
+        spec = mat_x_mat(dest[e], a[e], b[e]);
+    }
+
+    return spec;
+}
+
+// Lane interleaved blocks, all the matrices of a block at a time
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+inline specialized matsoa_x_matsoa(matsoa<T, MAJ, MIN> *dest,
+                                   matsoa<T, MAJ, K>   *a,
+                                   matsoa<T, K,   MIN> *b,
+                                   size_t              blocks) {
+    const size_t lanes = matsoa<T, MAJ, MIN>::lanes;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (int i = 0; i < MAJ; ++i) {
+            for (int j = 0; j < MIN; ++j) {
+                for (size_t l = 0; l < lanes; ++l) {
+                    auto sum = T(0);
+
+                    for (int k = 0; k < K; ++k) {
+                        sum += a[e].m[i][k][l] * b[e].m[k][j][l];
+                    }
+
+                    dest[e].m[i][j][l] = sum;
+                }
+            }
+        }
+    }
+
+    return loops;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix inverse and determinant
+
+// The inverse of the transpose is the transpose of the inverse,
+// so the same functions are used for row and column major order.
+// The inverse of a singular matrix is not finite, check the determinant
+// when that is possible. Destination and source must be different matrices.
+
+// Gaussian elimination with partial pivoting
+template <typename T, size_t N>
+inline specialized determinant(T &dest, mat<T, N, N> &a) {
+    mat<T, N, N> m = a;
+    T            det = T(1);
+
+    for (int c = 0; c < N; ++c) {
+        // Largest remaining element of the column is the pivot
+        int p = c;
+        for (int r = c + 1; r < N; ++r) {
+            T x = m.m[r][c] < T(0) ? -m.m[r][c] : m.m[r][c];
+            T y = m.m[p][c] < T(0) ? -m.m[p][c] : m.m[p][c];
+            if (x > y) {
+                p = r;
+            }
+        }
+
+        if (m.m[p][c] == T(0)) {
+            dest = T(0);
+            return loops;
+        }
+
+        if (p != c) {
+            for (int j = 0; j < N; ++j) {
+                T t = m.m[c][j]; m.m[c][j] = m.m[p][j]; m.m[p][j] = t;
+            }
+            det = -det;
+        }
+
+        det *= m.m[c][c];
+
+        for (int r = c + 1; r < N; ++r) {
+            T f = m.m[r][c] / m.m[c][c];
+            for (int j = c; j < N; ++j) {
+                m.m[r][j] -= f * m.m[c][j];
+            }
+        }
+    }
+
+    dest = det;
+    return loops;
+}
+
+// Gauss-Jordan elimination with partial pivoting
+template <typename T, size_t N>
+inline specialized inverse(mat<T, N, N> &dest, mat<T, N, N> &a) {
+    mat<T, N, N> m = a;
+
+    diagonal(dest, T(1));
+
+    for (int c = 0; c < N; ++c) {
+        // Largest remaining element of the column is the pivot
+        int p = c;
+        for (int r = c + 1; r < N; ++r) {
+            T x = m.m[r][c] < T(0) ? -m.m[r][c] : m.m[r][c];
+            T y = m.m[p][c] < T(0) ? -m.m[p][c] : m.m[p][c];
+            if (x > y) {
+                p = r;
+            }
+        }
+
+        if (p != c) {
+            for (int j = 0; j < N; ++j) {
+                T t = m.m[c][j];    m.m[c][j]    = m.m[p][j];    m.m[p][j]    = t;
+                  t = dest.m[c][j]; dest.m[c][j] = dest.m[p][j]; dest.m[p][j] = t;
+            }
+        }
+
+        T s = T(1) / m.m[c][c];
+        for (int j = 0; j < N; ++j) {
+            m.m[c][j]    *= s;
+            dest.m[c][j] *= s;
+        }
+
+        for (int r = 0; r < N; ++r) {
+            if (r != c) {
+                T f = m.m[r][c];
+                for (int j = 0; j < N; ++j) {
+                    m.m[r][j]    -= f * m.m[c][j];
+                    dest.m[r][j] -= f * dest.m[c][j];
+                }
+            }
+        }
+    }
+
+    return loops;
+}
+
+// Inverse of a rigid transformation, a rotation followed by a translation.
+// The upper (N-1)x(N-1) block must be orthonormal, the inverse rotation
+// is its transpose and the translation is rotated back and negated.
+//
+// Row major order, translation in the last row
+// dest = [ T(R)       0 ]
+//        [ -t * T(R)  1 ]
+//
+// Column major order, translation in the last column
+// dest = [ T(R)  -T(R) * t ]
+//        [ 0     1         ]
+//
+// Note the linear arrays are the same
+template <typename T, size_t N>
+inline specialized rigid_inverse(mat<T, N, N> &dest, mat<T, N, N> &a) {
+    for (int i = 0; i < N - 1; ++i) {
+        auto sum = T(0);
+
+        for (int j = 0; j < N - 1; ++j) {
+            dest.m[i][j] = a.m[j][i];
+            sum += a.m[N - 1][j] * a.m[i][j];
+        }
+
+        dest.m[i][N - 1] = T(0);
+        dest.m[N - 1][i] = -sum;
+    }
+
+    dest.m[N - 1][N - 1] = T(1);
+
+    return loops;
+}
+
+// Arrays of matrices, one matrix at a time
+template <typename T, size_t N>
+inline specialized matarr_determinant(T *dest, mat<T, N, N> *a, size_t n) {
+    auto spec = other;
+
+    for (size_t e = 0; e < n; ++e) {
+        spec = determinant(dest[e], a[e]);
+    }
+
+    return spec;
+}
+
+template <typename T, size_t N>
+inline specialized matarr_inverse(mat<T, N, N> *dest, mat<T, N, N> *a, size_t n) {
+    auto spec = other;
+
+    for (size_t e = 0; e < n; ++e) {
+        spec = inverse(dest[e], a[e]);
+    }
+
+    return spec;
+}
+
+template <typename T, size_t N>
+inline specialized matarr_rigid_inverse(mat<T, N, N> *dest, mat<T, N, N> *a, size_t n) {
+    auto spec = other;
+
+    for (size_t e = 0; e < n; ++e) {
+        spec = rigid_inverse(dest[e], a[e]);
+    }
+
+    return spec;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix transpose
+
+// dest(MIN,MAJ) = T(a(MAJ,MIN)), destination and source must be different
+
+template <typename T, size_t MAJ, size_t MIN>
+constexpr specialized looped_transpose(mat<T, MIN, MAJ> &dest, mat<T, MAJ, MIN> &a) {
+    for (int i = 0; i < MAJ; ++i) {
+        for (int j = 0; j < MIN; ++j) {
+            dest.m[j][i] = a.m[i][j];
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+constexpr specialized transpose(mat<T, MIN, MAJ> &dest, mat<T, MAJ, MIN> &a) {
+    return looped_transpose(dest, a);
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_transpose(mat<T, MIN, MAJ> *dest,
+                                    mat<T, MAJ, MIN> *a,
+                                    size_t           n) {
+    auto spec = other;
+
+    for (size_t e = 0; e < n; ++e) {
+        spec = transpose(dest[e], a[e]);
+    }
+
+    return spec;
+}
+
+// Conversion between row and column major order keeps the same matrix,
+// a MAJxMIN row major matrix is a MINxMAJ column major array of columns.
+
+template <typename T, size_t MAJ, size_t MIN>
+constexpr specialized rmat_to_cmat(cmat<T, MIN, MAJ> &dest, rmat<T, MAJ, MIN> &a) {
+    return transpose(dest, a);
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+constexpr specialized cmat_to_rmat(rmat<T, MAJ, MIN> &dest, cmat<T, MIN, MAJ> &a) {
+    return transpose(dest, a);
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized rmatarr_to_cmatarr(cmat<T, MIN, MAJ> *dest,
+                                      rmat<T, MAJ, MIN> *a,
+                                      size_t            n) {
+    return matarr_transpose(dest, a, n);
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized cmatarr_to_rmatarr(rmat<T, MAJ, MIN> *dest,
+                                      cmat<T, MIN, MAJ> *a,
+                                      size_t            n) {
+    return matarr_transpose(dest, a, n);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Tiled matrix storage
+
+// Large matrices stored as square tiles of tile x tile elements, each tile
+// contiguous in row major order. Walking a column then touches one tile
+// per tile rows instead of one row per element, so locality no longer
+// depends on the direction of traversal. Dimensions are padded to whole
+// tiles and the padding is kept zero, so tiles multiply and transpose
+// without edge cases.
+//
+// The layout policy places the tiles:
+// tiled<B>  - tiles in row major order
+// morton<B> - tiles in Z-order, squares of tiles on a power of two grid,
+//             nearby tiles in both directions are nearby in memory.
+//             Rectangular matrices use a row of such squares along the
+//             longer dimension. morton<1> is element Morton order.
+
+template <size_t B = 16> struct tiled {
+    static const size_t tile = B;
+
+    // Tiles along a dimension of n elements
+    static constexpr size_t tiles(size_t n) { return (n + B - 1) / B; }
+
+    // Elements of storage for a MAJxMIN matrix
+    static constexpr size_t size(size_t maj, size_t min) {
+        return tiles(maj) * tiles(min) * B * B;
+    }
+
+    // Offset of tile row ti, tile column tj
+    static size_t offset(size_t ti, size_t tj, size_t maj, size_t min) {
+        return (ti * tiles(min) + tj) * B * B;
+    }
+};
+
+template <size_t B = 16> struct morton {
+    static const size_t tile = B;
+
+    static constexpr size_t tiles(size_t n) { return (n + B - 1) / B; }
+
+    // Side of the squares, smallest power of two covering the shorter side
+    static constexpr size_t side(size_t maj, size_t min) {
+        size_t s = 1;
+
+        while (s < std::min(tiles(maj), tiles(min))) {
+            s *= 2;
+        }
+
+        return s;
+    }
+
+    static constexpr size_t size(size_t maj, size_t min) {
+        size_t s = side(maj, min);
+
+        return (std::max(tiles(maj), tiles(min)) + s - 1) / s * s * s * B * B;
+    }
+
+    // Spread the low 16 bits of x to the even bits
+    static size_t spread(size_t x) {
+        x &= 0xffff;
+        x  = (x | x << 8) & 0x00ff00ff;
+        x  = (x | x << 4) & 0x0f0f0f0f;
+        x  = (x | x << 2) & 0x33333333;
+        x  = (x | x << 1) & 0x55555555;
+
+        return x;
+    }
+
+    // Square along the longer dimension, then interleaved bits within it
+    static size_t offset(size_t ti, size_t tj, size_t maj, size_t min) {
+        size_t s      = side(maj, min);
+        size_t square = (tiles(maj) > tiles(min) ? ti : tj) / s;
+        size_t z      = spread(ti % s) << 1 | spread(tj % s);
+
+        return (square * s * s + z) * B * B;
+    }
+};
+
+template <typename T, size_t MAJ, size_t MIN, typename L = tiled<>> struct lmat {
+    static const size_t tile = L::tile;
+
+    alignas(alignment) T m[L::size(MAJ, MIN)];
+
+    // Offset of element i, j
+    static size_t index(size_t i, size_t j) {
+        return L::offset(i / tile, j / tile, MAJ, MIN) + (i % tile) * tile + j % tile;
+    }
+
+    T &at(size_t i, size_t j) { return m[index(i, j)]; }
+
+    // Verify that row and column are in range
+    bool validate(size_t i, size_t j) { return i < MAJ && j < MIN; }
+};
+
+// Conversion from a row major matrix, padding is zero'd
+template <typename T, size_t MAJ, size_t MIN, typename L>
+inline void mat_to_lmat(lmat<T, MAJ, MIN, L> &dest, mat<T, MAJ, MIN> &a) {
+    std::fill(dest.m, dest.m + L::size(MAJ, MIN), T(0));
+
+    for (size_t i = 0; i < MAJ; ++i) {
+        for (size_t j = 0; j < MIN; ++j) {
+            dest.at(i, j) = a.m[i][j];
+        }
+    }
+}
+
+template <typename T, size_t MAJ, size_t MIN, typename L>
+inline void lmat_to_mat(mat<T, MAJ, MIN> &dest, lmat<T, MAJ, MIN, L> &a) {
+    for (size_t i = 0; i < MAJ; ++i) {
+        for (size_t j = 0; j < MIN; ++j) {
+            dest.m[i][j] = a.at(i, j);
+        }
+    }
+}
+
+template <typename T, size_t MAJ, size_t MIN, typename L>
+inline void rmat_to_lmat(lmat<T, MAJ, MIN, L> &dest, rmat<T, MAJ, MIN> &a) {
+    mat_to_lmat(dest, a);
+}
+
+template <typename T, size_t MAJ, size_t MIN, typename L>
+inline void lmat_to_rmat(rmat<T, MAJ, MIN> &dest, lmat<T, MAJ, MIN, L> &a) {
+    lmat_to_mat(dest, a);
+}
+
+// A MINxMAJ column major matrix holds the same matrix as the MAJxMIN
+// tiled one, the conversion transposes a tile at a time
+template <typename T, size_t MAJ, size_t MIN, typename L>
+inline void cmat_to_lmat(lmat<T, MAJ, MIN, L> &dest, cmat<T, MIN, MAJ> &a) {
+    const size_t B = L::tile;
+
+    std::fill(dest.m, dest.m + L::size(MAJ, MIN), T(0));
+
+    for (size_t ti = 0; ti < MAJ; ti += B) {
+        for (size_t tj = 0; tj < MIN; tj += B) {
+            for (size_t j = tj; j < std::min(tj + B, MIN); ++j) {
+                for (size_t i = ti; i < std::min(ti + B, MAJ); ++i) {
+                    dest.at(i, j) = a.m[j][i];
+                }
+            }
+        }
+    }
+}
+
+template <typename T, size_t MAJ, size_t MIN, typename L>
+inline void lmat_to_cmat(cmat<T, MIN, MAJ> &dest, lmat<T, MAJ, MIN, L> &a) {
+    const size_t B = L::tile;
+
+    for (size_t ti = 0; ti < MAJ; ti += B) {
+        for (size_t tj = 0; tj < MIN; tj += B) {
+            for (size_t j = tj; j < std::min(tj + B, MIN); ++j) {
+                for (size_t i = ti; i < std::min(ti + B, MAJ); ++i) {
+                    dest.m[j][i] = a.at(i, j);
+                }
+            }
+        }
+    }
+}
+
+// dest(B,B) += a(B,B) * b(B,B), contiguous tiles. Rows of dest are summed
+// R at a time in local rows the compiler keeps in registers, independent
+// sums hide the latency of the multiply adds.
+template <typename T, size_t B>
+inline void tile_x_tile(T *dest, T *a, T *b) {
+    const size_t R = (B % 4 == 0) ? 4 : 1;
+
+    for (size_t i = 0; i < B; i += R) {
+        T sum[R][B];
+
+        for (size_t r = 0; r < R; ++r) {
+            for (size_t j = 0; j < B; ++j) {
+                sum[r][j] = dest[(i + r) * B + j];
+            }
+        }
+
+        for (size_t k = 0; k < B; ++k) {
+            for (size_t r = 0; r < R; ++r) {
+                for (size_t j = 0; j < B; ++j) {
+                    sum[r][j] += a[(i + r) * B + k] * b[k * B + j];
+                }
+            }
+        }
+
+        for (size_t r = 0; r < R; ++r) {
+            for (size_t j = 0; j < B; ++j) {
+                dest[(i + r) * B + j] = sum[r][j];
+            }
+        }
+    }
+}
+
+// Row major order
+// dest(MAJ,MIN) = a(MAJ,K) * b(K,MIN)
+//
+// Column major order
+// T(dest(MAJ,MIN)) = T(b(K,MIN)) * T(a(MAJ,K))
+//
+// A tile of dest at a time, summing products of tiles of a and b
+template <typename T, size_t MAJ, size_t MIN, size_t K, typename L>
+inline specialized mat_x_mat(lmat<T, MAJ, MIN, L> &dest,
+                             lmat<T, MAJ, K,   L> &a,
+                             lmat<T, K,   MIN, L> &b) {
+    const size_t B = L::tile;
+
+    for (size_t ti = 0; ti < L::tiles(MAJ); ++ti) {
+        for (size_t tj = 0; tj < L::tiles(MIN); ++tj) {
+            alignas(alignment) T sum[B * B] = {};
+
+            // Sum in a local tile, it does not alias a or b
+            for (size_t tk = 0; tk < L::tiles(K); ++tk) {
+                tile_x_tile<T, B>(sum,
+                                  a.m + L::offset(ti, tk, MAJ, K),
+                                  b.m + L::offset(tk, tj, K,   MIN));
+            }
+
+            std::copy(sum, sum + B * B, dest.m + L::offset(ti, tj, MAJ, MIN));
+        }
+    }
+
+    return loops;
+}
+
+// dest(MIN,MAJ) = T(a(MAJ,MIN)), tile ti, tj transposed into tile tj, ti,
+// destination and source must be different
+template <typename T, size_t MAJ, size_t MIN, typename L>
+inline specialized transpose(lmat<T, MIN, MAJ, L> &dest, lmat<T, MAJ, MIN, L> &a) {
+    const size_t B = L::tile;
+
+    for (size_t ti = 0; ti < L::tiles(MAJ); ++ti) {
+        for (size_t tj = 0; tj < L::tiles(MIN); ++tj) {
+            T *dtile = dest.m + L::offset(tj, ti, MIN, MAJ);
+            T *atile = a.m    + L::offset(ti, tj, MAJ, MIN);
+
+            for (size_t i = 0; i < B; ++i) {
+                for (size_t j = 0; j < B; ++j) {
+                    dtile[j * B + i] = atile[i * B + j];
+                }
+            }
+        }
+    }
+
+    return loops;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Normal transformation
+
+// Normals are transformed by the inverse transpose of the upper 3x3 of
+// a transformation, which keeps them perpendicular to transformed surfaces.
+// With rows a, b, c the inverse transpose is [ b x c, c x a, a x b ] / det,
+// det = a . (b x c). The same linear array is used for column major order.
+
+template <typename T, size_t N>
+inline void normal_matrix(mat<T, 3, 3> &dest, mat<T, N, N> &m) {
+    T a0 = m.m[0][0], a1 = m.m[0][1], a2 = m.m[0][2],
+      b0 = m.m[1][0], b1 = m.m[1][1], b2 = m.m[1][2],
+      c0 = m.m[2][0], c1 = m.m[2][1], c2 = m.m[2][2];
+
+    dest.m[0][0] = b1 * c2 - b2 * c1;
+    dest.m[0][1] = b2 * c0 - b0 * c2;
+    dest.m[0][2] = b0 * c1 - b1 * c0;
+    dest.m[1][0] = c1 * a2 - c2 * a1;
+    dest.m[1][1] = c2 * a0 - c0 * a2;
+    dest.m[1][2] = c0 * a1 - c1 * a0;
+    dest.m[2][0] = a1 * b2 - a2 * b1;
+    dest.m[2][1] = a2 * b0 - a0 * b2;
+    dest.m[2][2] = a0 * b1 - a1 * b0;
+
+    T inv = T(1) / (a0 * dest.m[0][0] + a1 * dest.m[0][1] + a2 * dest.m[0][2]);
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            dest.m[i][j] *= inv;
+        }
+    }
+}
+
+// Arrays of 3 or 4 element normals, the 4th element is zero'd.
+// Optionally normalize in the same pass, normals must not be zero length.
+template <typename T, size_t N, size_t M>
+inline specialized normarr_x_mat(vec<T, N>    *dest,
+                                 vec<T, N>    *v,
+                                 mat<T, M, M> &m,
+                                 size_t       n,
+                                 bool         normalize = false) {
+    mat<T, 3, 3> nm;
+    normal_matrix(nm, m);
+
+    for (size_t e = 0; e < n; ++e) {
+        T x = v[e].v[0], y = v[e].v[1], z = v[e].v[2];
+
+        for (int j = 0; j < 3; ++j) {
+            dest[e].v[j] = x * nm.m[0][j] + y * nm.m[1][j] + z * nm.m[2][j];
+        }
+
+        for (int j = 3; j < N; ++j) {
+            dest[e].v[j] = T(0);
+        }
+
+        if (normalize) {
+            T s = T(1) / std::sqrt(  dest[e].v[0] * dest[e].v[0]
+                                   + dest[e].v[1] * dest[e].v[1]
+                                   + dest[e].v[2] * dest[e].v[2]);
+
+            for (int j = 0; j < 3; ++j) {
+                dest[e].v[j] *= s;
+            }
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t N, size_t M>
+inline specialized rnormarr_x_rmat(rvec<T, N>    *dest,
+                                   rvec<T, N>    *v,
+                                   rmat<T, M, M> &m,
+                                   size_t        n,
+                                   bool          normalize = false) {
+    return normarr_x_mat(dest, v, m, n, normalize);
+}
+
+template <typename T, size_t N, size_t M>
+inline specialized cmat_x_cnormarr(cvec<T, N>    *dest,
+                                   cmat<T, M, M> &m,
+                                   cvec<T, N>    *v,
+                                   size_t        n,
+                                   bool          normalize = false) {
+    return normarr_x_mat(dest, v, m, n, normalize);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Projection and perspective divide
+
+// Vectors are transformed to clip coordinates by a projection matrix,
+// divided by w, and the viewport scale and offset applied in one pass.
+// dest = [ x/w, y/w, z/w, 1/w ] * scale + offset, elementwise.
+// Set the w elements of scale and offset to 1 and 0 to keep 1/w.
+//
+// approx lets SIMD implementations use a reciprocal approximation refined
+// with Newton-Raphson instead of an exact divide.
+// clip, when not null, receives 1 for each vector with w <= 0 and 0 otherwise.
+
+template <typename T>
+inline specialized projarr_x_mat(vec<T, 4>     *dest,
+                                 vec<T, 4>     *v,
+                                 mat<T, 4, 4>  &m,
+                                 vec<T, 4>     &scale,
+                                 vec<T, 4>     &offset,
+                                 size_t        n,
+                                 bool          approx = false,
+                                 unsigned char *clip  = nullptr) {
+    for (size_t e = 0; e < n; ++e) {
+        T c[4];
+
+        for (int j = 0; j < 4; ++j) {
+            auto sum = T(0);
+
+            for (int i = 0; i < 4; ++i) {
+                sum += v[e].v[i] * m.m[i][j];
+            }
+            c[j] = sum;
+        }
+
+        if (clip != nullptr) {
+            clip[e] = c[3] <= T(0);
+        }
+
+        T r = T(1) / c[3];
+
+        for (int j = 0; j < 3; ++j) {
+            dest[e].v[j] = c[j] * r * scale.v[j] + offset.v[j];
+        }
+        dest[e].v[3] = r * scale.v[3] + offset.v[3];
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized rprojarr_x_rmat(rvec<T, 4>    *dest,
+                                   rvec<T, 4>    *v,
+                                   rmat<T, 4, 4> &m,
+                                   vec<T, 4>     &scale,
+                                   vec<T, 4>     &offset,
+                                   size_t        n,
+                                   bool          approx = false,
+                                   unsigned char *clip  = nullptr) {
+    return projarr_x_mat(dest, v, m, scale, offset, n, approx, clip);
+}
+
+template <typename T>
+inline specialized cmat_x_cprojarr(cvec<T, 4>    *dest,
+                                   cmat<T, 4, 4> &m,
+                                   cvec<T, 4>    *v,
+                                   vec<T, 4>     &scale,
+                                   vec<T, 4>     &offset,
+                                   size_t        n,
+                                   bool          approx = false,
+                                   unsigned char *clip  = nullptr) {
+    return projarr_x_mat(dest, v, m, scale, offset, n, approx, clip);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Quaternions
+
+// Unit quaternion [ x, y, z, w ] representing a rotation
+template <typename T> struct quat : vec<T, 4>{};
+
+// Rotation matrix of a unit quaternion
+//
+// Column major order, post multiplication of a vector
+// [ 1-2(yy+zz)  2(xy-zw)    2(xz+yw)    0 ]
+// [ 2(xy+zw)    1-2(xx+zz)  2(yz-xw)    0 ]
+// [ 2(xz-yw)    2(yz+xw)    1-2(xx+yy)  0 ]
+// [ 0           0           0           1 ]
+//
+// Row major order, pre multiplication of a vector, is the transpose
+//
+// Note the linear arrays are the same
+template <typename T>
+inline specialized quat_to_mat(mat<T, 4, 4> &dest, quat<T> &q) {
+    T x = q.v[0], y = q.v[1], z = q.v[2], w = q.v[3];
+
+    dest.m[0][0] = T(1) - T(2) * (y * y + z * z);
+    dest.m[0][1] =        T(2) * (x * y + z * w);
+    dest.m[0][2] =        T(2) * (x * z - y * w);
+    dest.m[0][3] = T(0);
+    dest.m[1][0] =        T(2) * (x * y - z * w);
+    dest.m[1][1] = T(1) - T(2) * (x * x + z * z);
+    dest.m[1][2] =        T(2) * (y * z + x * w);
+    dest.m[1][3] = T(0);
+    dest.m[2][0] =        T(2) * (x * z + y * w);
+    dest.m[2][1] =        T(2) * (y * z - x * w);
+    dest.m[2][2] = T(1) - T(2) * (x * x + y * y);
+    dest.m[2][3] = T(0);
+    dest.m[3][0] = T(0);
+    dest.m[3][1] = T(0);
+    dest.m[3][2] = T(0);
+    dest.m[3][3] = T(1);
+
+    return loops;
+}
+
+template <typename T>
+inline specialized quatarr_to_matarr(mat<T, 4, 4> *dest, quat<T> *q, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        quat_to_mat(dest[e], q[e]);
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized quat_to_rmat(rmat<T, 4, 4> &dest, quat<T> &q) {
+    return quat_to_mat(dest, q);
+}
+
+template <typename T>
+inline specialized quat_to_cmat(cmat<T, 4, 4> &dest, quat<T> &q) {
+    return quat_to_mat(dest, q);
+}
+
+template <typename T>
+inline specialized quatarr_to_rmatarr(rmat<T, 4, 4> *dest, quat<T> *q, size_t n) {
+    return quatarr_to_matarr(dest, q, n);
+}
+
+template <typename T>
+inline specialized quatarr_to_cmatarr(cmat<T, 4, 4> *dest, quat<T> *q, size_t n) {
+    return quatarr_to_matarr(dest, q, n);
+}
+
+// Rotate 3 or 4 element vectors directly by a unit quaternion,
+// the same result as multiplying by its rotation matrix.
+// Elements after the 3rd are copied.
+// t = 2 * cross(q.xyz, v)
+// dest = v + w * t + cross(q.xyz, t)
+template <typename T, size_t N>
+inline specialized vecarr_x_quat(vec<T, N> *dest,
+                                 vec<T, N> *v,
+                                 quat<T>   &q,
+                                 size_t    n) {
+    T x = q.v[0], y = q.v[1], z = q.v[2], w = q.v[3];
+
+    for (size_t e = 0; e < n; ++e) {
+        T vx = v[e].v[0], vy = v[e].v[1], vz = v[e].v[2];
+
+        T tx = T(2) * (y * vz - z * vy);
+        T ty = T(2) * (z * vx - x * vz);
+        T tz = T(2) * (x * vy - y * vx);
+
+        dest[e].v[0] = vx + w * tx + (y * tz - z * ty);
+        dest[e].v[1] = vy + w * ty + (z * tx - x * tz);
+        dest[e].v[2] = vz + w * tz + (x * ty - y * tx);
+
+        for (int j = 3; j < N; ++j) {
+            dest[e].v[j] = v[e].v[j];
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t N>
+inline specialized rvecarr_x_quat(rvec<T, N> *dest,
+                                  rvec<T, N> *v,
+                                  quat<T>    &q,
+                                  size_t     n) {
+    return vecarr_x_quat(dest, v, q, n);
+}
+
+template <typename T, size_t N>
+inline specialized quat_x_cvecarr(cvec<T, N> *dest,
+                                  quat<T>    &q,
+                                  cvec<T, N> *v,
+                                  size_t     n) {
+    return vecarr_x_quat(dest, v, q, n);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Translation, rotation and scale
+
+// Compose matrices from arrays of translations, rotations and scales,
+// scale first, then rotate, then translate. The general multiplication is
+// skipped, the rotation rows are scaled and the translation is the last row.
+//
+// Row major order, pre multiplication of a vector
+// [ sx * r0     0 ]
+// [ sy * r1     0 ]
+// [ sz * r2     0 ]
+// [ tx  ty  tz  1 ]
+//
+// Column major order, post multiplication of a vector, is the transpose,
+// T * R * S. Note the linear arrays are the same.
+// The 4th elements of the translations and scales are ignored.
+template <typename T>
+inline specialized trsarr_to_matarr(mat<T, 4, 4> *dest,
+                                    vec<T, 4>    *t,
+                                    quat<T>      *r,
+                                    vec<T, 4>    *s,
+                                    size_t       n) {
+    for (size_t e = 0; e < n; ++e) {
+        quat_to_mat(dest[e], r[e]);
+
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                dest[e].m[i][j] *= s[e].v[i];
+            }
+
+            dest[e].m[3][i] = t[e].v[i];
+        }
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized trsarr_to_rmatarr(rmat<T, 4, 4> *dest,
+                                     rvec<T, 4>    *t,
+                                     quat<T>       *r,
+                                     rvec<T, 4>    *s,
+                                     size_t        n) {
+    return trsarr_to_matarr(dest, t, r, s, n);
+}
+
+template <typename T>
+inline specialized trsarr_to_cmatarr(cmat<T, 4, 4> *dest,
+                                     cvec<T, 4>    *t,
+                                     quat<T>       *r,
+                                     cvec<T, 4>    *s,
+                                     size_t        n) {
+    return trsarr_to_matarr(dest, t, r, s, n);
+}
+
+// Decompose matrices into translations, rotations and scales, the inverse
+// of trsarr_to_matarr. Scales are the lengths of the rotation rows and are
+// assumed positive. The 4th elements of translations and scales are set to 1.
+//
+// The quaternion is found from the largest of the w, x, y and z candidates,
+// 4w^2 = 1 + m00 + m11 + m22, 4x^2 = 1 + m00 - m11 - m22, etc., so it is
+// stable for every rotation. q and -q are the same rotation.
+template <typename T>
+inline specialized matarr_to_trsarr(vec<T, 4>    *t,
+                                    quat<T>      *r,
+                                    vec<T, 4>    *s,
+                                    mat<T, 4, 4> *m,
+                                    size_t       n) {
+    for (size_t e = 0; e < n; ++e) {
+        T rm[3][3];
+
+        for (int i = 0; i < 3; ++i) {
+            T len = std::sqrt(m[e].m[i][0] * m[e].m[i][0]
+                            + m[e].m[i][1] * m[e].m[i][1]
+                            + m[e].m[i][2] * m[e].m[i][2]);
+            T inv = T(1) / len;
+
+            for (int j = 0; j < 3; ++j) {
+                rm[i][j] = m[e].m[i][j] * inv;
+            }
+
+            s[e].v[i] = len;
+            t[e].v[i] = m[e].m[3][i];
+        }
+
+        s[e].v[3] = T(1);
+        t[e].v[3] = T(1);
+
+        T a = rm[1][2] - rm[2][1];                      // 4xw
+        T b = rm[2][0] - rm[0][2];                      // 4yw
+        T c = rm[0][1] - rm[1][0];                      // 4zw
+        T d = rm[0][1] + rm[1][0];                      // 4xy
+        T f = rm[2][0] + rm[0][2];                      // 4xz
+        T g = rm[1][2] + rm[2][1];                      // 4yz
+
+        T tw = T(1) + rm[0][0] + rm[1][1] + rm[2][2];   // 4ww
+        T tx = T(1) + rm[0][0] - rm[1][1] - rm[2][2];   // 4xx
+        T ty = T(1) - rm[0][0] + rm[1][1] - rm[2][2];   // 4yy
+        T tz = T(1) - rm[0][0] - rm[1][1] + rm[2][2];   // 4zz
+
+        T best = tw, q[4] = { a, b, c, tw };
+
+        if (tx > best) { best = tx; q[0] = tx; q[1] = d;  q[2] = f;  q[3] = a; }
+        if (ty > best) { best = ty; q[0] = d;  q[1] = ty; q[2] = g;  q[3] = b; }
+        if (tz > best) { best = tz; q[0] = f;  q[1] = g;  q[2] = tz; q[3] = c; }
+
+        T k = T(0.5) / std::sqrt(best);
+
+        for (int j = 0; j < 4; ++j) {
+            r[e].v[j] = q[j] * k;
+        }
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized rmatarr_to_trsarr(rvec<T, 4>    *t,
+                                     quat<T>       *r,
+                                     rvec<T, 4>    *s,
+                                     rmat<T, 4, 4> *m,
+                                     size_t        n) {
+    return matarr_to_trsarr(t, r, s, m, n);
+}
+
+template <typename T>
+inline specialized cmatarr_to_trsarr(cvec<T, 4>    *t,
+                                     quat<T>       *r,
+                                     cvec<T, 4>    *s,
+                                     cmat<T, 4, 4> *m,
+                                     size_t        n) {
+    return matarr_to_trsarr(t, r, s, m, n);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Hierarchies
+
+// Indexed pairwise matrix array multiplication,
+// dest[index[e]] = a[index[e]] * b[bindex[e]]
+//
+// Row major order
+// dest[index[e]](MAJ,MIN) = a[index[e]](MAJ,K) * b[bindex[e]](K,MIN)
+//
+// Column major order
+// T(dest[index[e]](MAJ,MIN)) = T(b[bindex[e]](K,MIN)) * T(a[index[e]](MAJ,K))
+template <typename T, size_t MAJ, size_t MIN, size_t K>
+inline specialized matarr_x_matarr_indexed(mat<T, MAJ, MIN> *dest,
+                                           mat<T, MAJ, K>   *a,
+                                           mat<T, K,   MIN> *b,
+                                           const size_t     *index,
+                                           const size_t     *bindex,
+                                           size_t           n) {
+    auto spec = other;
+
+    for (size_t e = 0; e < n; ++e) {
+        spec = mat_x_mat(dest[index[e]], a[index[e]], b[bindex[e]]);
+    }
+
+    return spec;
+}
+
+// Nodes of a hierarchy sorted into depth levels, roots first.
+// Every node follows its parent, nodes of the same level are independent.
+struct hierarchy {
+    std::vector<size_t> node;       // Node indices, level by level
+    std::vector<size_t> parent;     // Parent of each entry of node
+    std::vector<size_t> level;      // Start of each level in node, then the end
+
+    size_t levels() { return level.empty() ? 0 : level.size() - 1; }
+};
+
+// Sort nodes into depth levels, parent[i] < 0 for a root.
+// Within a level the nodes stay in index order for streaming access.
+// Returns false if a parent is out of range or the parents form a cycle.
+inline bool build_hierarchy(hierarchy &h, const long *parent, size_t n) {
+    std::vector<size_t> depth(n, n), path;
+    size_t              levels = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t p = i;
+
+        // Walk up to a root or a node with a known depth
+        while (depth[p] == n) {
+            if (parent[p] >= long(n) || path.size() == n) {
+                return false;
+            }
+
+            path.push_back(p);
+
+            if (parent[p] < 0) {
+                break;
+            }
+
+            p = size_t(parent[p]);
+        }
+
+        size_t d = (depth[p] == n) ? 0 : depth[p] + 1;
+
+        while (!path.empty()) {
+            if (depth[path.back()] == n) {
+                depth[path.back()] = d++;
+            }
+
+            path.pop_back();
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        levels = std::max(levels, depth[i] + 1);
+    }
+
+    // Counting sort by depth
+    h.level.assign(levels + 1, 0);
+    h.node.resize(n);
+    h.parent.resize(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        ++h.level[depth[i] + 1];
+    }
+
+    for (size_t l = 0; l < levels; ++l) {
+        h.level[l + 1] += h.level[l];
+    }
+
+    std::vector<size_t> next(h.level.begin(), h.level.end() - 1);
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t k = next[depth[i]]++;
+
+        h.node[k]   = i;
+        h.parent[k] = parent[i] < 0 ? i : size_t(parent[i]);
+    }
+
+    return true;
+}
+
+// World matrices of a hierarchy from local matrices, level by level.
+// Each level is one batched product, split across threads when large.
+//
+// Row major order, pre multiplication of a vector
+// world[i] = local[i] * world[parent[i]]
+//
+// Column major order, post multiplication of a vector
+// world[i] = world[parent[i]] * local[i]
+//
+// Note the linear arrays are the same
+template <typename T, size_t N>
+inline specialized update_hierarchy(mat<T, N, N> *world,
+                                    mat<T, N, N> *local,
+                                    hierarchy    &h,
+                                    unsigned     threads = 1) {
+    const size_t grain = 64;    // Fewest nodes worth a thread
+    auto         spec  = other;
+
+    if (h.levels() == 0) {
+        return spec;
+    }
+
+    // Roots
+    for (size_t k = h.level[0]; k < h.level[1]; ++k) {
+        world[h.node[k]] = local[h.node[k]];
+    }
+
+    for (size_t l = 1; l < h.levels(); ++l) {
+        size_t begin = h.level[l];
+        size_t count = h.level[l + 1] - begin;
+        size_t parts = std::min<size_t>(std::max(threads, 1u), count / grain);
+
+        if (parts > 1) {
+            std::vector<std::thread> pool;
+            size_t                   chunk = (count + parts - 1) / parts;
+
+            parts = (count + chunk - 1) / chunk;    // Rounding may leave fewer
+
+            for (size_t t = 1; t < parts; ++t) {
+                size_t first = begin + t * chunk;
+                size_t last  = std::min(begin + count, first + chunk);
+
+                pool.emplace_back([=, &h] {
+                    matarr_x_matarr_indexed(world, local, world,
+                                            &h.node[first], &h.parent[first], last - first);
+                });
+            }
+
+            spec = matarr_x_matarr_indexed(world, local, world,
+                                           &h.node[begin], &h.parent[begin], chunk);
+
+            for (auto &thread : pool) {
+                thread.join();
+            }
+        } else {
+            spec = matarr_x_matarr_indexed(world, local, world,
+                                           &h.node[begin], &h.parent[begin], count);
+        }
+    }
+
+    return spec;
+}
+
+template <typename T, size_t N>
+inline specialized update_rhierarchy(rmat<T, N, N> *world,
+                                     rmat<T, N, N> *local,
+                                     hierarchy     &h,
+                                     unsigned      threads = 1) {
+    return update_hierarchy(world, local, h, threads);
+}
+
+template <typename T, size_t N>
+inline specialized update_chierarchy(cmat<T, N, N> *world,
+                                     cmat<T, N, N> *local,
+                                     hierarchy     &h,
+                                     unsigned      threads = 1) {
+    return update_hierarchy(world, local, h, threads);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Skinning
+
+// Linear blend skinning, each vertex is transformed by the weighted sum
+// of up to 4 matrices of a palette. Unused bones need a valid index and
+// a zero weight. The blended matrix is built once per vertex and used for
+// both the position and the optional normal.
+//
+// Row major order, pre multiplication of a vector
+// dest[e] = v[e] * sum(weight[e][k] * palette[bone[e][k]])
+//
+// Column major order, post multiplication of a vector
+// dest[e] = sum(weight[e][k] * palette[bone[e][k]]) * v[e]
+//
+// Normals are transformed without the translation, the 4th element is 0.
+// They are not normalized, which is exact for rigid palettes.
+template <typename T>
+inline specialized skinarr_x_matarr(vec<T, 4>        *dest,
+                                    vec<T, 4>        *v,
+                                    mat<T, 4, 4>     *palette,
+                                    vec<unsigned, 4> *bone,
+                                    vec<T, 4>        *weight,
+                                    size_t           n,
+                                    vec<T, 4>        *ndest = nullptr,
+                                    vec<T, 4>        *nv    = nullptr) {
+    for (size_t e = 0; e < n; ++e) {
+        T blend[4][4] = {};
+
+        for (int k = 0; k < 4; ++k) {
+            auto &m = palette[bone[e].v[k]];
+            T     w = weight[e].v[k];
+
+            for (int i = 0; i < 4; ++i) {
+                for (int j = 0; j < 4; ++j) {
+                    blend[i][j] += w * m.m[i][j];
+                }
+            }
+        }
+
+        for (int j = 0; j < 4; ++j) {
+            T sum = T(0);
+
+            for (int i = 0; i < 4; ++i) {
+                sum += v[e].v[i] * blend[i][j];
+            }
+
+            dest[e].v[j] = sum;
+        }
+
+        if (ndest != nullptr) {
+            for (int j = 0; j < 3; ++j) {
+                T sum = T(0);
+
+                for (int i = 0; i < 3; ++i) {
+                    sum += nv[e].v[i] * blend[i][j];
+                }
+
+                ndest[e].v[j] = sum;
+            }
+
+            ndest[e].v[3] = T(0);
+        }
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized rskinarr_x_rmatarr(rvec<T, 4>       *dest,
+                                      rvec<T, 4>       *v,
+                                      rmat<T, 4, 4>    *palette,
+                                      vec<unsigned, 4> *bone,
+                                      vec<T, 4>        *weight,
+                                      size_t           n,
+                                      rvec<T, 4>       *ndest = nullptr,
+                                      rvec<T, 4>       *nv    = nullptr) {
+    return skinarr_x_matarr<T>(dest, v, palette, bone, weight, n, ndest, nv);
+}
+
+template <typename T>
+inline specialized cmatarr_x_cskinarr(cvec<T, 4>       *dest,
+                                      cmat<T, 4, 4>    *palette,
+                                      cvec<T, 4>       *v,
+                                      vec<unsigned, 4> *bone,
+                                      vec<T, 4>        *weight,
+                                      size_t           n,
+                                      cvec<T, 4>       *ndest = nullptr,
+                                      cvec<T, 4>       *nv    = nullptr) {
+    return skinarr_x_matarr<T>(dest, v, palette, bone, weight, n, ndest, nv);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Indexed vector array multiplication
+
+// Each vector selects its matrix from a palette,
+// dest[e] = v[e] * palette[index[e]]
+//
+// Column major order, post multiplication of a vector
+// dest[e] = palette[index[e]] * v[e]
+//
+// Note the linear arrays are the same
+template <typename T, size_t N>
+inline specialized vecarr_x_matarr_indexed(vec<T, N>      *dest,
+                                           vec<T, N>      *v,
+                                           mat<T, N, N>   *palette,
+                                           const unsigned *index,
+                                           size_t         n) {
+    for (size_t e = 0; e < n; ++e) {
+        auto &m = palette[index[e]];
+
+        for (int j = 0; j < N; ++j) {
+            auto sum = T(0);
+
+            for (int i = 0; i < N; ++i) {
+                sum += v[e].v[i] * m.m[i][j];
+            }
+            dest[e].v[j] = sum;
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t N>
+inline specialized rvecarr_x_rmatarr_indexed(rvec<T, N>     *dest,
+                                             rvec<T, N>     *v,
+                                             rmat<T, N, N>  *palette,
+                                             const unsigned *index,
+                                             size_t         n) {
+    return vecarr_x_matarr_indexed(dest, v, palette, index, n);
+}
+
+template <typename T, size_t N>
+inline specialized cmatarr_x_cvecarr_indexed(cvec<T, N>     *dest,
+                                             cmat<T, N, N>  *palette,
+                                             cvec<T, N>     *v,
+                                             const unsigned *index,
+                                             size_t         n) {
+    return vecarr_x_matarr_indexed(dest, v, palette, index, n);
+}
+
+// Runs of consecutive vectors that share a matrix, found once per index
+// array. Runs of at least min_run vectors use the single matrix vecarr_x_mat,
+// the vectors between them are gathered with vecarr_x_matarr_indexed.
+struct index_run {
+    size_t   start;     // First vector
+    size_t   count;     // Number of vectors
+    bool     single;    // All use palette[index], otherwise indexed
+    unsigned index;
+};
+
+inline void build_index_runs(std::vector<index_run> &runs,
+                             const unsigned         *index,
+                             size_t                 n,
+                             size_t                 min_run = 16) {
+    size_t mixed = 0;   // Start of the pending indexed vectors
+
+    runs.clear();
+
+    for (size_t e = 0; e < n; ) {
+        size_t end = e + 1;
+
+        while (end < n && index[end] == index[e]) {
+            ++end;
+        }
+
+        if (end - e >= min_run) {
+            if (mixed < e) {
+                runs.push_back({ mixed, e - mixed, false, 0 });
+            }
+
+            runs.push_back({ e, end - e, true, index[e] });
+            mixed = end;
+        }
+
+        e = end;
+    }
+
+    if (mixed < n) {
+        runs.push_back({ mixed, n - mixed, false, 0 });
+    }
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_x_matarr_runs(vec<T, N>              *dest,
+                                        vec<T, N>              *v,
+                                        mat<T, N, N>           *palette,
+                                        const unsigned         *index,
+                                        std::vector<index_run> &runs) {
+    auto spec = other;
+
+    for (auto &run : runs) {
+        if (run.single) {
+            spec = vecarr_x_mat(dest + run.start, v + run.start,
+                                palette[run.index], run.count);
+        } else {
+            spec = vecarr_x_matarr_indexed(dest + run.start, v + run.start,
+                                           palette, index + run.start, run.count);
+        }
+    }
+
+    return spec;
+}
+
+template <typename T, size_t N>
+inline specialized rvecarr_x_rmatarr_runs(rvec<T, N>             *dest,
+                                          rvec<T, N>             *v,
+                                          rmat<T, N, N>          *palette,
+                                          const unsigned         *index,
+                                          std::vector<index_run> &runs) {
+    return vecarr_x_matarr_runs<T, N>(dest, v, palette, index, runs);
+}
+
+template <typename T, size_t N>
+inline specialized cmatarr_x_cvecarr_runs(cvec<T, N>             *dest,
+                                          cmat<T, N, N>          *palette,
+                                          cvec<T, N>             *v,
+                                          const unsigned         *index,
+                                          std::vector<index_run> &runs) {
+    return vecarr_x_matarr_runs<T, N>(dest, v, palette, index, runs);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Bounding box transform and frustum culling
+
+// Axis aligned boxes stored as a center and a half size extent, in blocks
+// of boxes with the same element of every box contiguous, as with matsoa.
+// A box transformed by an affine matrix is bounded by
+// center' = [ center, 1 ] * m and extent' = extent * abs(upper 3x3 of m).
+// A box is outside of the plane [ a, b, c, d ] when
+// dot(center', [ a, b, c ]) + d + dot(extent', abs([ a, b, c ])) < 0,
+// and visible when it is not outside of any of the planes.
+
+template <typename T> struct aabbsoa {
+    static const size_t lanes = 64 / sizeof(T);
+
+    alignas(alignment) T c[3][lanes];   // Center x, y and z of each box
+    alignas(alignment) T e[3][lanes];   // Extent x, y and z of each box
+};
+
+// Number of blocks needed for n boxes
+template <typename T>
+inline size_t aabb_blocks(size_t n) {
+    return (n + aabbsoa<T>::lanes - 1) / aabbsoa<T>::lanes;
+}
+
+// Convert arrays of n centers and extents to blocks,
+// unused lanes of the last block are zero'd
+template <typename T>
+inline void aabbarr_to_soa(aabbsoa<T> *dest,
+                           vec<T, 4>  *center,
+                           vec<T, 4>  *extent,
+                           size_t     n) {
+    const size_t lanes  = aabbsoa<T>::lanes;
+    size_t       blocks = aabb_blocks<T>(n);
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t l = 0; l < lanes; ++l) {
+            size_t s = e * lanes + l;
+
+            for (int i = 0; i < 3; ++i) {
+                dest[e].c[i][l] = (s < n) ? center[s].v[i] : T(0);
+                dest[e].e[i][l] = (s < n) ? extent[s].v[i] : T(0);
+            }
+        }
+    }
+}
+
+// Convert blocks back to arrays of n centers and extents,
+// the 4th elements are set to 1 and 0
+template <typename T>
+inline void soa_to_aabbarr(vec<T, 4>  *center,
+                           vec<T, 4>  *extent,
+                           aabbsoa<T> *src,
+                           size_t     n) {
+    const size_t lanes = aabbsoa<T>::lanes;
+
+    for (size_t s = 0; s < n; ++s) {
+        for (int i = 0; i < 3; ++i) {
+            center[s].v[i] = src[s / lanes].c[i][s % lanes];
+            extent[s].v[i] = src[s / lanes].e[i][s % lanes];
+        }
+        center[s].v[3] = T(1);
+        extent[s].v[3] = T(0);
+    }
+}
+
+// The 6 planes left, right, bottom, top, near and far of a view projection
+// matrix, for row vectors transformed to clip coordinates by v * m.
+// Visible points satisfy -w <= x, y <= w and -w <= z <= w,
+// or 0 <= z <= w when zero_to_one is set. Planes are not normalized,
+// which does not change which side of a plane a point is on.
+template <typename T>
+inline void frustum_planes(vec<T, 4>    *planes,
+                           mat<T, 4, 4> &m,
+                           bool         zero_to_one = false) {
+    for (int i = 0; i < 4; ++i) {
+        planes[0].v[i] = m.m[i][3] + m.m[i][0];
+        planes[1].v[i] = m.m[i][3] - m.m[i][0];
+        planes[2].v[i] = m.m[i][3] + m.m[i][1];
+        planes[3].v[i] = m.m[i][3] - m.m[i][1];
+        planes[4].v[i] = zero_to_one ? m.m[i][2] : m.m[i][3] + m.m[i][2];
+        planes[5].v[i] = m.m[i][3] - m.m[i][2];
+    }
+}
+
+// Transform n boxes by an affine matrix and test them against the planes.
+// Bit l of visible[e] is set when box e * lanes + l is visible, bits of
+// unused lanes are clear. Either dest or visible may be null when only
+// the other result is needed.
+template <typename T>
+inline specialized aabbsoa_x_mat(aabbsoa<T>   *dest,
+                                 unsigned     *visible,
+                                 aabbsoa<T>   *src,
+                                 mat<T, 4, 4> &m,
+                                 vec<T, 4>    *planes,
+                                 size_t       nplanes,
+                                 size_t       n) {
+    const size_t lanes  = aabbsoa<T>::lanes;
+    size_t       blocks = aabb_blocks<T>(n);
+
+    for (size_t e = 0; e < blocks; ++e) {
+        unsigned bits = 0;
+
+        for (size_t l = 0; l < lanes; ++l) {
+            T    c[3], x[3];
+            bool in = e * lanes + l < n;
+
+            for (int j = 0; j < 3; ++j) {
+                c[j] = m.m[3][j];
+                x[j] = T(0);
+
+                for (int i = 0; i < 3; ++i) {
+                    c[j] += src[e].c[i][l] * m.m[i][j];
+                    x[j] += src[e].e[i][l] * std::abs(m.m[i][j]);
+                }
+            }
+
+            for (size_t p = 0; p < nplanes && in; ++p) {
+                T d = planes[p].v[3];
+
+                for (int j = 0; j < 3; ++j) {
+                    d += c[j] * planes[p].v[j] + x[j] * std::abs(planes[p].v[j]);
+                }
+                in = d >= T(0);
+            }
+
+            if (dest != nullptr) {
+                for (int j = 0; j < 3; ++j) {
+                    dest[e].c[j][l] = c[j];
+                    dest[e].e[j][l] = x[j];
+                }
+            }
+
+            bits |= unsigned(in) << l;
+        }
+
+        if (visible != nullptr) {
+            visible[e] = bits;
+        }
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized raabbsoa_x_rmat(aabbsoa<T>    *dest,
+                                   unsigned      *visible,
+                                   aabbsoa<T>    *src,
+                                   rmat<T, 4, 4> &m,
+                                   vec<T, 4>     *planes,
+                                   size_t        nplanes,
+                                   size_t        n) {
+    return aabbsoa_x_mat<T>(dest, visible, src, m, planes, nplanes, n);
+}
+
+template <typename T>
+inline specialized cmat_x_caabbsoa(aabbsoa<T>    *dest,
+                                   unsigned      *visible,
+                                   cmat<T, 4, 4> &m,
+                                   aabbsoa<T>    *src,
+                                   vec<T, 4>     *planes,
+                                   size_t        nplanes,
+                                   size_t        n) {
+    return aabbsoa_x_mat<T>(dest, visible, src, m, planes, nplanes, n);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Transform with bounds
+
+// Vector array multiplied by a matrix while the elementwise minimum, maximum
+// and sum of the results are kept, lo <= dest[e] <= hi for every e.
+// The centroid is the sum divided by n. dest may be null when only the
+// bounds are needed, the results are then never written to memory.
+// With no vectors lo is the largest and hi the lowest value of T.
+
+template <typename T, size_t N>
+inline specialized vecarr_x_mat_bounds(vec<T, N>    *dest,
+                                       vec<T, N>    &lo,
+                                       vec<T, N>    &hi,
+                                       vec<T, N>    *v,
+                                       mat<T, N, N> &m,
+                                       size_t       n,
+                                       vec<T, N>    *sum = nullptr) {
+    T s[N];
+
+    for (int j = 0; j < N; ++j) {
+        lo.v[j] = std::numeric_limits<T>::max();
+        hi.v[j] = std::numeric_limits<T>::lowest();
+        s[j]    = T(0);
+    }
+
+    for (size_t e = 0; e < n; ++e) {
+        for (int j = 0; j < N; ++j) {
+            auto d = T(0);
+
+            for (int i = 0; i < N; ++i) {
+                d += v[e].v[i] * m.m[i][j];
+            }
+
+            if (dest != nullptr) {
+                dest[e].v[j] = d;
+            }
+
+            lo.v[j] = std::min(lo.v[j], d);
+            hi.v[j] = std::max(hi.v[j], d);
+            s[j]   += d;
+        }
+    }
+
+    if (sum != nullptr) {
+        std::memcpy(sum->v, s, sizeof(s));
+    }
+
+    return loops;
+}
+
+template <typename T, size_t N>
+inline specialized rvecarr_x_rmat_bounds(rvec<T, N>    *dest,
+                                         vec<T, N>     &lo,
+                                         vec<T, N>     &hi,
+                                         rvec<T, N>    *v,
+                                         rmat<T, N, N> &m,
+                                         size_t        n,
+                                         vec<T, N>     *sum = nullptr) {
+    return vecarr_x_mat_bounds<T, N>(dest, lo, hi, v, m, n, sum);
+}
+
+template <typename T, size_t N>
+inline specialized cmat_x_cvecarr_bounds(cvec<T, N>    *dest,
+                                         vec<T, N>     &lo,
+                                         vec<T, N>     &hi,
+                                         cmat<T, N, N> &m,
+                                         cvec<T, N>    *v,
+                                         size_t        n,
+                                         vec<T, N>     *sum = nullptr) {
+    return vecarr_x_mat_bounds<T, N>(dest, lo, hi, v, m, n, sum);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Transform with compaction
+
+// Tests applied to transformed vectors d
+enum condition {
+    inside_box,     // lo <= x, y, z <= hi elementwise, w is not tested
+    above_plane,    // dot(d, lo) >= 0 with the plane in lo, hi is not used
+    inside_clip     // -w <= x, y, z <= w, lo and hi are not used
+};
+
+// True when the transformed vector d passes the test
+template <typename T>
+inline bool passes(vec<T, 4> &d, condition test, vec<T, 4> &lo, vec<T, 4> &hi) {
+    bool in = true;
+
+    switch (test) {
+        case inside_box:
+            for (int j = 0; j < 3; ++j) {
+                in = in && lo.v[j] <= d.v[j] && d.v[j] <= hi.v[j];
+            }
+            return in;
+        case above_plane:
+            return d.v[0] * lo.v[0] + d.v[1] * lo.v[1]
+                 + d.v[2] * lo.v[2] + d.v[3] * lo.v[3] >= T(0);
+        default:
+            for (int j = 0; j < 3; ++j) {
+                in = in && std::abs(d.v[j]) <= d.v[3];
+            }
+            return in;
+    }
+}
+
+// Vector array multiplied by a matrix, only the results passing the test
+// are written, contiguously and in order, and count receives their number.
+// dest needs room for n vectors, SIMD implementations may write vectors
+// after the last one counted.
+template <typename T>
+inline specialized vecarr_x_mat_compact(vec<T, 4>    *dest,
+                                        size_t       &count,
+                                        vec<T, 4>    *v,
+                                        mat<T, 4, 4> &m,
+                                        size_t       n,
+                                        condition    test,
+                                        vec<T, 4>    &lo,
+                                        vec<T, 4>    &hi) {
+    count = 0;
+
+    for (size_t e = 0; e < n; ++e) {
+        vec<T, 4> d;
+
+        for (int j = 0; j < 4; ++j) {
+            auto sum = T(0);
+
+            for (int i = 0; i < 4; ++i) {
+                sum += v[e].v[i] * m.m[i][j];
+            }
+            d.v[j] = sum;
+        }
+
+        if (passes(d, test, lo, hi)) {
+            dest[count++] = d;
+        }
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized rvecarr_x_rmat_compact(rvec<T, 4>    *dest,
+                                          size_t        &count,
+                                          rvec<T, 4>    *v,
+                                          rmat<T, 4, 4> &m,
+                                          size_t        n,
+                                          condition     test,
+                                          vec<T, 4>     &lo,
+                                          vec<T, 4>     &hi) {
+    return vecarr_x_mat_compact<T>(dest, count, v, m, n, test, lo, hi);
+}
+
+template <typename T>
+inline specialized cmat_x_cvecarr_compact(cvec<T, 4>    *dest,
+                                          size_t        &count,
+                                          cmat<T, 4, 4> &m,
+                                          cvec<T, 4>    *v,
+                                          size_t        n,
+                                          condition     test,
+                                          vec<T, 4>     &lo,
+                                          vec<T, 4>     &hi) {
+    return vecarr_x_mat_compact<T>(dest, count, v, m, n, test, lo, hi);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Vector array operations
+
+// Arrays of vectors processed element by element, dest[e] = op(a[e], b[e]).
+// Dot products and lengths use all N elements, so 3 element directions
+// held in vec<T, 4> need a 4th element of 0. Cross products use the
+// first 3 elements and zero the rest.
+//
+// approx lets SIMD implementations normalize with a reciprocal square root
+// approximation refined with Newton-Raphson instead of an exact divide.
+// Vectors to be normalized must not be zero length.
+
+template <typename T, size_t N>
+inline specialized vecarr_dot(T *dest, vec<T, N> *a, vec<T, N> *b, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        auto sum = T(0);
+
+        for (int i = 0; i < N; ++i) {
+            sum += a[e].v[i] * b[e].v[i];
+        }
+        dest[e] = sum;
+    }
+
+    return loops;
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_cross(vec<T, N> *dest, vec<T, N> *a, vec<T, N> *b, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        T *pa = a[e].v;
+        T *pb = b[e].v;
+        T c[3];
+
+        c[0] = pa[1] * pb[2] - pa[2] * pb[1];
+        c[1] = pa[2] * pb[0] - pa[0] * pb[2];
+        c[2] = pa[0] * pb[1] - pa[1] * pb[0];
+
+        for (int i = 0; i < N; ++i) {
+            dest[e].v[i] = i < 3 ? c[i] : T(0);
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_length(T *dest, vec<T, N> *a, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        auto sum = T(0);
+
+        for (int i = 0; i < N; ++i) {
+            sum += a[e].v[i] * a[e].v[i];
+        }
+        dest[e] = std::sqrt(sum);
+    }
+
+    return loops;
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_normalize(vec<T, N> *dest,
+                                    vec<T, N> *a,
+                                    size_t    n,
+                                    bool      approx = false) {
+    for (size_t e = 0; e < n; ++e) {
+        auto sum = T(0);
+
+        for (int i = 0; i < N; ++i) {
+            sum += a[e].v[i] * a[e].v[i];
+        }
+
+        T r = T(1) / std::sqrt(sum);
+
+        for (int i = 0; i < N; ++i) {
+            dest[e].v[i] = a[e].v[i] * r;
+        }
+    }
+
+    return loops;
+}
+
+// Blocks of vectors stored element by element, as with matsoa.
+// [ x of vector 0, x of vector 1, ... x of vector lanes - 1,
+//   y of vector 0, ... ]
+// Operations on blocks write all their lanes, the dot products and
+// lengths of block e are results e * lanes to e * lanes + lanes - 1.
+
+template <typename T, size_t N> struct vecsoa {
+    static const size_t lanes = 64 / sizeof(T);
+
+    alignas(alignment) T v[N][lanes];
+};
+
+// Number of blocks needed for n vectors
+template <typename T, size_t N>
+inline size_t vec_blocks(size_t n) {
+    return (n + vecsoa<T, N>::lanes - 1) / vecsoa<T, N>::lanes;
+}
+
+// Convert an array of n vectors to blocks, unused lanes of the last block
+// are zero'd, normalizing those lanes gives undefined values
+template <typename T, size_t N>
+inline void vecarr_to_soa(vecsoa<T, N> *dest, vec<T, N> *src, size_t n) {
+    const size_t lanes  = vecsoa<T, N>::lanes;
+    size_t       blocks = vec_blocks<T, N>(n);
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t l = 0; l < lanes; ++l) {
+            size_t s = e * lanes + l;
+
+            for (int i = 0; i < N; ++i) {
+                dest[e].v[i][l] = (s < n) ? src[s].v[i] : T(0);
+            }
+        }
+    }
+}
+
+// Convert blocks back to an array of n vectors
+template <typename T, size_t N>
+inline void soa_to_vecarr(vec<T, N> *dest, vecsoa<T, N> *src, size_t n) {
+    const size_t lanes = vecsoa<T, N>::lanes;
+
+    for (size_t s = 0; s < n; ++s) {
+        for (int i = 0; i < N; ++i) {
+            dest[s].v[i] = src[s / lanes].v[i][s % lanes];
+        }
+    }
+}
+
+template <typename T, size_t N>
+inline specialized vecsoa_dot(T            *dest,
+                              vecsoa<T, N> *a,
+                              vecsoa<T, N> *b,
+                              size_t       blocks) {
+    const size_t lanes = vecsoa<T, N>::lanes;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t l = 0; l < lanes; ++l) {
+            auto sum = T(0);
+
+            for (int i = 0; i < N; ++i) {
+                sum += a[e].v[i][l] * b[e].v[i][l];
+            }
+            dest[e * lanes + l] = sum;
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t N>
+inline specialized vecsoa_cross(vecsoa<T, N> *dest,
+                                vecsoa<T, N> *a,
+                                vecsoa<T, N> *b,
+                                size_t       blocks) {
+    const size_t lanes = vecsoa<T, N>::lanes;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t l = 0; l < lanes; ++l) {
+            T c[3];
+
+            c[0] = a[e].v[1][l] * b[e].v[2][l] - a[e].v[2][l] * b[e].v[1][l];
+            c[1] = a[e].v[2][l] * b[e].v[0][l] - a[e].v[0][l] * b[e].v[2][l];
+            c[2] = a[e].v[0][l] * b[e].v[1][l] - a[e].v[1][l] * b[e].v[0][l];
+
+            for (int i = 0; i < N; ++i) {
+                dest[e].v[i][l] = i < 3 ? c[i] : T(0);
+            }
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t N>
+inline specialized vecsoa_length(T *dest, vecsoa<T, N> *a, size_t blocks) {
+    const size_t lanes = vecsoa<T, N>::lanes;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t l = 0; l < lanes; ++l) {
+            auto sum = T(0);
+
+            for (int i = 0; i < N; ++i) {
+                sum += a[e].v[i][l] * a[e].v[i][l];
+            }
+            dest[e * lanes + l] = std::sqrt(sum);
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t N>
+inline specialized vecsoa_normalize(vecsoa<T, N> *dest,
+                                    vecsoa<T, N> *a,
+                                    size_t       blocks,
+                                    bool         approx = false) {
+    const size_t lanes = vecsoa<T, N>::lanes;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t l = 0; l < lanes; ++l) {
+            auto sum = T(0);
+
+            for (int i = 0; i < N; ++i) {
+                sum += a[e].v[i][l] * a[e].v[i][l];
+            }
+
+            T r = T(1) / std::sqrt(sum);
+
+            for (int i = 0; i < N; ++i) {
+                dest[e].v[i][l] = a[e].v[i][l] * r;
+            }
+        }
+    }
+
+    return loops;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Interpolation
+
+// Linear interpolation of arrays, dest[e] = a[e] + t * (b[e] - a[e]),
+// t of 0 gives a[e] and 1 gives b[e].
+template <typename T, size_t N>
+inline specialized vecarr_lerp(vec<T, N> *dest,
+                               vec<T, N> *a,
+                               vec<T, N> *b,
+                               T         t,
+                               size_t    n) {
+    for (size_t e = 0; e < n; ++e) {
+        for (int i = 0; i < N; ++i) {
+            dest[e].v[i] = a[e].v[i] + t * (b[e].v[i] - a[e].v[i]);
+        }
+    }
+
+    return loops;
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_lerp(mat<T, MAJ, MIN> *dest,
+                               mat<T, MAJ, MIN> *a,
+                               mat<T, MAJ, MIN> *b,
+                               T                t,
+                               size_t           n) {
+    for (size_t e = 0; e < n; ++e) {
+        for (int i = 0; i < MAJ; ++i) {
+            for (int j = 0; j < MIN; ++j) {
+                dest[e].m[i][j] = a[e].m[i][j] + t * (b[e].m[i][j] - a[e].m[i][j]);
+            }
+        }
+    }
+
+    return loops;
+}
+
+// Interpolate arrays of unit quaternions along the shorter path,
+// b[e] is negated when its dot product with a[e] is negative.
+// nlerp normalizes the linear interpolation, the rotation speeds up
+// towards the middle. slerp rotates at a constant speed.
+//
+// slerp(a, b, t) = a * sin((1 - t) * angle) / sin(angle)
+//                + b * sin(t * angle) / sin(angle),  cos(angle) = dot(a, b)
+//
+// The weights are found with a polynomial in t and dot(a, b) - 1,
+// no inverse cosine or sine, and are within about 2e-5 of the exact
+// weights for all angles. See Eberly, "A Fast and Accurate Algorithm
+// for Computing SLERP". Coefficients for a given t are found once per
+// call with slerp_coefficients, each weight is then 8 multiply adds.
+
+const int slerp_terms = 8;
+
+// k[i - 1] = t * t / (i * (2i + 1)) - i / (2i + 1), the last term is scaled
+// by mu to account for the terms that are left out
+template <typename T>
+inline void slerp_coefficients(T *k, T t) {
+    const T mu = T(1.85298109240830);
+
+    for (int i = 1; i <= slerp_terms; ++i) {
+        T s = (i == slerp_terms) ? mu : T(1);
+
+        k[i - 1] = s * (t * t / T(i * (2 * i + 1)) - T(i) / T(2 * i + 1));
+    }
+}
+
+// sin(t * angle) / sin(angle) with k from slerp_coefficients and
+// xm1 = cos(angle) - 1
+template <typename T>
+inline T slerp_weight(T *k, T t, T xm1) {
+    auto r = T(1);
+
+    for (int i = slerp_terms - 1; i >= 0; --i) {
+        r = T(1) + k[i] * xm1 * r;
+    }
+
+    return t * r;
+}
+
+template <typename T>
+inline specialized quatarr_nlerp(quat<T> *dest,
+                                 quat<T> *a,
+                                 quat<T> *b,
+                                 T       t,
+                                 size_t  n) {
+    for (size_t e = 0; e < n; ++e) {
+        auto d = T(0);
+
+        for (int i = 0; i < 4; ++i) {
+            d += a[e].v[i] * b[e].v[i];
+        }
+
+        T wb  = (d < T(0)) ? -t : t;
+        T sum = T(0);
+        T r[4];
+
+        for (int i = 0; i < 4; ++i) {
+            r[i] = a[e].v[i] * (T(1) - t) + b[e].v[i] * wb;
+            sum += r[i] * r[i];
+        }
+
+        T inv = T(1) / std::sqrt(sum);
+
+        for (int i = 0; i < 4; ++i) {
+            dest[e].v[i] = r[i] * inv;
+        }
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized quatarr_slerp(quat<T> *dest,
+                                 quat<T> *a,
+                                 quat<T> *b,
+                                 T       t,
+                                 size_t  n) {
+    T ka[slerp_terms], kb[slerp_terms];
+
+    slerp_coefficients(ka, T(1) - t);
+    slerp_coefficients(kb, t);
+
+    for (size_t e = 0; e < n; ++e) {
+        auto d = T(0);
+
+        for (int i = 0; i < 4; ++i) {
+            d += a[e].v[i] * b[e].v[i];
+        }
+
+        T sign = (d < T(0)) ? T(-1) : T(1);
+        T xm1  = d * sign - T(1);
+        T wa   = slerp_weight(ka, T(1) - t, xm1);
+        T wb   = slerp_weight(kb, t, xm1) * sign;
+
+        for (int i = 0; i < 4; ++i) {
+            dest[e].v[i] = a[e].v[i] * wa + b[e].v[i] * wb;
+        }
+    }
+
+    return loops;
+}
+
+// Keyframe sampling
+//
+// Channel c has the keys first[c] to first[c + 1] - 1 of the times and keys
+// arrays, at least one key with times increasing. dest[c] interpolates the
+// keys either side of time, before the first or after the last key the end
+// key is used. Vectors are interpolated with lerp, quaternions with nlerp.
+//
+// cursor, when not null, holds a key index for each channel that is updated
+// by each call. Playback moving forward or backward a little at a time then
+// only steps over a key or two instead of searching from the first key.
+
+// Find keys i and j of a channel either side of time,
+// returns the interpolation parameter between them
+template <typename T>
+inline T key_interval(size_t &i,
+                      size_t &j,
+                      size_t *cursor,
+                      T      *times,
+                      size_t first,
+                      size_t last,
+                      T      time) {
+    i = (cursor != nullptr && *cursor >= first && *cursor < last) ? *cursor : first;
+
+    while (i + 1 < last && times[i + 1] <= time) {
+        ++i;
+    }
+    while (i > first && times[i] > time) {
+        --i;
+    }
+
+    j = (i + 1 < last) ? i + 1 : i;
+
+    if (cursor != nullptr) {
+        *cursor = i;
+    }
+
+    return (j == i || time <= times[i]) ? T(0) : (time - times[i]) / (times[j] - times[i]);
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_sample(vec<T, N> *dest,
+                                 vec<T, N> *keys,
+                                 T         *times,
+                                 size_t    *first,
+                                 size_t    channels,
+                                 T         time,
+                                 size_t    *cursor = nullptr) {
+    for (size_t c = 0; c < channels; ++c) {
+        size_t i, j;
+        T      t = key_interval(i, j, cursor ? cursor + c : nullptr,
+                                times, first[c], first[c + 1], time);
+
+        for (int k = 0; k < N; ++k) {
+            dest[c].v[k] = keys[i].v[k] + t * (keys[j].v[k] - keys[i].v[k]);
+        }
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized quatarr_sample(quat<T> *dest,
+                                  quat<T> *keys,
+                                  T       *times,
+                                  size_t  *first,
+                                  size_t  channels,
+                                  T       time,
+                                  size_t  *cursor = nullptr) {
+    for (size_t c = 0; c < channels; ++c) {
+        size_t i, j;
+        T      t = key_interval(i, j, cursor ? cursor + c : nullptr,
+                                times, first[c], first[c + 1], time);
+
+        quatarr_nlerp(dest + c, keys + i, keys + j, t, 1);
+    }
+
+    return loops;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Elementwise array operations
+
+// Operations applied to each element of arrays of n scalars
+//   add        dest = a + b
+//   sub        dest = a - b
+//   add_scalar dest = a + s
+//   scale      dest = a * s
+//   axpy       dest = alpha * x + y
+//   blend      dest = wa * a + wb * b
+//   abs        dest = |a|
+//   min        dest = std::min(a, b)
+//   max        dest = std::max(a, b)
+// dest may be the same array as a source.
+//
+// The vecarr_ and matarr_ versions treat arrays of n vectors or matrices
+// as a single array of scalars, including the padding that aligns each
+// vector or matrix, see vec and mat. So 4 element float vectors and 4x4
+// matrices have no padding, 3 element vectors are processed as 4.
+
+template <typename T>
+inline specialized arr_add(T *dest, T *a, T *b, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        dest[e] = a[e] + b[e];
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized arr_sub(T *dest, T *a, T *b, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        dest[e] = a[e] - b[e];
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized arr_add_scalar(T *dest, T *a, T s, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        dest[e] = a[e] + s;
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized arr_scale(T *dest, T *a, T s, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        dest[e] = a[e] * s;
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized arr_axpy(T *dest, T *x, T *y, T alpha, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        dest[e] = alpha * x[e] + y[e];
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized arr_blend(T *dest, T *a, T *b, T wa, T wb, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        dest[e] = wa * a[e] + wb * b[e];
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized arr_abs(T *dest, T *a, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        dest[e] = std::abs(a[e]);
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized arr_min(T *dest, T *a, T *b, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        dest[e] = std::min(a[e], b[e]);
+    }
+
+    return loops;
+}
+
+template <typename T>
+inline specialized arr_max(T *dest, T *a, T *b, size_t n) {
+    for (size_t e = 0; e < n; ++e) {
+        dest[e] = std::max(a[e], b[e]);
+    }
+
+    return loops;
+}
+
+// Number of scalars in arrays of n vectors or matrices, including padding
+template <typename T, size_t N>
+inline size_t scalars(vec<T, N> *, size_t n) {
+    return n * sizeof(vec<T, N>) / sizeof(T);
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline size_t scalars(mat<T, MAJ, MIN> *, size_t n) {
+    return n * sizeof(mat<T, MAJ, MIN>) / sizeof(T);
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_add(vec<T, N> *dest,
+                              vec<T, N> *a,
+                              vec<T, N> *b,
+                              size_t    n) {
+    return arr_add(dest->v, a->v, b->v, scalars(dest, n));
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_add(mat<T, MAJ, MIN> *dest,
+                              mat<T, MAJ, MIN> *a,
+                              mat<T, MAJ, MIN> *b,
+                              size_t           n) {
+    return arr_add(dest->m[0], a->m[0], b->m[0], scalars(dest, n));
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_sub(vec<T, N> *dest,
+                              vec<T, N> *a,
+                              vec<T, N> *b,
+                              size_t    n) {
+    return arr_sub(dest->v, a->v, b->v, scalars(dest, n));
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_sub(mat<T, MAJ, MIN> *dest,
+                              mat<T, MAJ, MIN> *a,
+                              mat<T, MAJ, MIN> *b,
+                              size_t           n) {
+    return arr_sub(dest->m[0], a->m[0], b->m[0], scalars(dest, n));
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_add_scalar(vec<T, N> *dest,
+                                     vec<T, N> *a,
+                                     T         s,
+                                     size_t    n) {
+    return arr_add_scalar(dest->v, a->v, s, scalars(dest, n));
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_add_scalar(mat<T, MAJ, MIN> *dest,
+                                     mat<T, MAJ, MIN> *a,
+                                     T                s,
+                                     size_t           n) {
+    return arr_add_scalar(dest->m[0], a->m[0], s, scalars(dest, n));
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_scale(vec<T, N> *dest,
+                                vec<T, N> *a,
+                                T         s,
+                                size_t    n) {
+    return arr_scale(dest->v, a->v, s, scalars(dest, n));
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_scale(mat<T, MAJ, MIN> *dest,
+                                mat<T, MAJ, MIN> *a,
+                                T                s,
+                                size_t           n) {
+    return arr_scale(dest->m[0], a->m[0], s, scalars(dest, n));
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_axpy(vec<T, N> *dest,
+                               vec<T, N> *x,
+                               vec<T, N> *y,
+                               T         alpha,
+                               size_t    n) {
+    return arr_axpy(dest->v, x->v, y->v, alpha, scalars(dest, n));
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_axpy(mat<T, MAJ, MIN> *dest,
+                               mat<T, MAJ, MIN> *x,
+                               mat<T, MAJ, MIN> *y,
+                               T                alpha,
+                               size_t           n) {
+    return arr_axpy(dest->m[0], x->m[0], y->m[0], alpha, scalars(dest, n));
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_blend(vec<T, N> *dest,
+                                vec<T, N> *a,
+                                vec<T, N> *b,
+                                T         wa,
+                                T         wb,
+                                size_t    n) {
+    return arr_blend(dest->v, a->v, b->v, wa, wb, scalars(dest, n));
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_blend(mat<T, MAJ, MIN> *dest,
+                                mat<T, MAJ, MIN> *a,
+                                mat<T, MAJ, MIN> *b,
+                                T                wa,
+                                T                wb,
+                                size_t           n) {
+    return arr_blend(dest->m[0], a->m[0], b->m[0], wa, wb, scalars(dest, n));
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_abs(vec<T, N> *dest,
+                              vec<T, N> *a,
+                              size_t    n) {
+    return arr_abs(dest->v, a->v, scalars(dest, n));
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_abs(mat<T, MAJ, MIN> *dest,
+                              mat<T, MAJ, MIN> *a,
+                              size_t           n) {
+    return arr_abs(dest->m[0], a->m[0], scalars(dest, n));
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_min(vec<T, N> *dest,
+                              vec<T, N> *a,
+                              vec<T, N> *b,
+                              size_t    n) {
+    return arr_min(dest->v, a->v, b->v, scalars(dest, n));
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_min(mat<T, MAJ, MIN> *dest,
+                              mat<T, MAJ, MIN> *a,
+                              mat<T, MAJ, MIN> *b,
+                              size_t           n) {
+    return arr_min(dest->m[0], a->m[0], b->m[0], scalars(dest, n));
+}
+
+template <typename T, size_t N>
+inline specialized vecarr_max(vec<T, N> *dest,
+                              vec<T, N> *a,
+                              vec<T, N> *b,
+                              size_t    n) {
+    return arr_max(dest->v, a->v, b->v, scalars(dest, n));
+}
+
+template <typename T, size_t MAJ, size_t MIN>
+inline specialized matarr_max(mat<T, MAJ, MIN> *dest,
+                              mat<T, MAJ, MIN> *a,
+                              mat<T, MAJ, MIN> *b,
+                              size_t           n) {
+    return arr_max(dest->m[0], a->m[0], b->m[0], scalars(dest, n));
+}
+
+
+// -----------------------------------------------------------------------------
+// Matrix structure
+
+// Most transformations need less than a general 4x4 matrix. The structure
+// of a matrix, from the simplest, in row major order:
+//   identity     the identity matrix
+//   translation  identity with a translation [ tx ty tz 1 ] in the last row
+//   scale        diagonal [ sx sy sz 1 ] with a translation in the last row
+//   affine       any matrix with a last column of [ 0 0 0 1 ]
+//   general      anything else
+// Column major order is the transpose. Note the linear arrays are the same.
+//
+// The product of two matrices has the structure of the more general one.
+enum class structure { identity, translation, scale, affine, general };
+
+// 4x4 matrix that records its structure, set by the set_ functions when the
+// matrix is built, or detected by classify after the elements are changed
+template <typename T> struct smat : mat<T, 4, 4> {
+    structure form = structure::general;
+};
+
+// Structure from a mask of the elements equal to the identity,
+// bit 4 * i + j is set when a.m[i][j] equals the identity element.
+//   0x8888  last column
+//   0x0356  off diagonal elements of the upper 3x3
+//   0x0421  diagonal elements of the upper 3x3
+//   0x7000  translation
+inline structure mask_to_structure(unsigned mask) {
+    if  (mask == 0xffff)            return structure::identity;
+    if ((mask & 0x8fff) == 0x8fff)  return structure::translation;
+    if ((mask & 0x8bde) == 0x8bde)  return structure::scale;
+    if ((mask & 0x8888) == 0x8888)  return structure::affine;
+    return structure::general;
+}
+
+// Detect the structure of a matrix by comparing it to the identity
+template <typename T>
+inline specialized classify(structure &dest, mat<T, 4, 4> &a) {
+    unsigned mask = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            if (a.m[i][j] == (i == j ? T(1) : T(0))) {
+                mask |= 1u << (4 * i + j);
+            }
+        }
+    }
+
+    dest = mask_to_structure(mask);
+
+    return loops;
+}
+
+template <typename T>
+inline specialized classify(smat<T> &a) {
+    return classify(a.form, a);
+}
+
+template <typename T>
+inline void set_identity(smat<T> &dest) {
+    diagonal(dest, T(1));
+    dest.form = structure::identity;
+}
+
+// The 4th element of the translation is ignored
+template <typename T>
+inline void set_translation(smat<T> &dest, vec<T, 4> &t) {
+    diagonal(dest, T(1));
+    for (int j = 0; j < 3; ++j) {
+        dest.m[3][j] = t.v[j];
+    }
+    dest.form = structure::translation;
+}
+
+// Scale first, then translate. The 4th elements are ignored.
+template <typename T>
+inline void set_scale(smat<T> &dest, vec<T, 4> &s, vec<T, 4> &t) {
+    diagonal(dest, T(1));
+    for (int j = 0; j < 3; ++j) {
+        dest.m[j][j] = s.v[j];
+        dest.m[3][j] = t.v[j];
+    }
+    dest.form = structure::scale;
+}
+
+// Kernels for structured matrices, row major order.
+// The structure of the matrices is assumed, not checked.
+//
+// Affine product, the last columns of a and b are [ 0 0 0 1 ],
+// a 3x4 product that skips the last columns
+// dest(4,4) = a(4,4) * b(4,4)
+template <typename T>
+inline specialized affine_x_affine(mat<T, 4, 4> &dest,
+                                   mat<T, 4, 4> &a,
+                                   mat<T, 4, 4> &b) {
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            auto sum = (i == 3) ? b.m[3][j] : T(0);
+
+            for (int k = 0; k < 3; ++k) {
+                sum += a.m[i][k] * b.m[k][j];
+            }
+
+            dest.m[i][j] = sum;
+        }
+
+        dest.m[i][3] = (i == 3) ? T(1) : T(0);
+    }
+
+    return loops;
+}
+
+// Translate vectors by w times the translation, the 4th element is kept
+// dest[e] = v[e] + v[e].w * [ tx ty tz 0 ]
+template <typename T>
+inline specialized vecarr_x_translation(vec<T, 4>    *dest,
+                                        vec<T, 4>    *v,
+                                        mat<T, 4, 4> &m,
+                                        size_t       n) {
+    for (size_t e = 0; e < n; ++e) {
+        auto w = v[e].v[3];
+
+        for (int j = 0; j < 3; ++j) {
+            dest[e].v[j] = v[e].v[j] + w * m.m[3][j];
+        }
+        dest[e].v[3] = w;
+    }
+
+    return loops;
+}
+
+// Scale and translate vectors, the 4th element is kept
+// dest[e] = v[e] * [ sx sy sz 0 ] + v[e].w * [ tx ty tz 1 ]
+template <typename T>
+inline specialized vecarr_x_scale(vec<T, 4>    *dest,
+                                  vec<T, 4>    *v,
+                                  mat<T, 4, 4> &m,
+                                  size_t       n) {
+    for (size_t e = 0; e < n; ++e) {
+        auto w = v[e].v[3];
+
+        for (int j = 0; j < 3; ++j) {
+            dest[e].v[j] = v[e].v[j] * m.m[j][j] + w * m.m[3][j];
+        }
+        dest[e].v[3] = w;
+    }
+
+    return loops;
+}
+
+// Multiply structured matrices and vectors with the cheapest kernel.
+// The specialization returned is the structure used, identity, translate,
+// scale or affine, or that of the general kernel.
+// dest must not be a or b, and may be v only for the identity, translation
+// and scale. Note the column major products are the same,
+// T(dest) = T(b) * T(a) and T(dest[e]) = T(a) * T(v[e]).
+template <typename T>
+inline specialized smat_x_smat(smat<T> &dest, smat<T> &a, smat<T> &b) {
+    if (a.form == structure::identity || b.form == structure::identity) {
+        smat<T> &src = (a.form == structure::identity) ? b : a;
+
+        copy(dest, src);
+        dest.form = src.form;
+        return ident;
+    }
+
+    dest.form = std::max(a.form, b.form);
+
+    switch (dest.form) {
+        case structure::translation:
+            diagonal(dest, T(1));
+            for (int j = 0; j < 3; ++j) {
+                dest.m[3][j] = a.m[3][j] + b.m[3][j];
+            }
+            return translate;
+
+        case structure::scale:
+            diagonal(dest, T(1));
+            for (int j = 0; j < 3; ++j) {
+                dest.m[j][j] = a.m[j][j] * b.m[j][j];
+                dest.m[3][j] = a.m[3][j] * b.m[j][j] + b.m[3][j];
+            }
+            return scale;
+
+        case structure::affine:
+            affine_x_affine(dest, a, b);
+            return affine;
+
+        default:
+            return mat_x_mat(dest, a, b);
+    }
+}
+
+template <typename T>
+inline specialized vecarr_x_smat(vec<T, 4> *dest,
+                                 vec<T, 4> *v,
+                                 smat<T>   &m,
+                                 size_t    n) {
+    switch (m.form) {
+        case structure::identity:
+            if (dest != v) {
+                std::memcpy(dest, v, n * sizeof(vec<T, 4>));
+            }
+            return ident;
+
+        case structure::translation:
+            vecarr_x_translation(dest, v, m, n);
+            return translate;
+
+        case structure::scale:
+            vecarr_x_scale(dest, v, m, n);
+            return scale;
+
+        // Affine has no cheaper kernel, report the general product's kernel
+        default:
+            return vecarr_x_mat(dest, v, m, n);
+    }
+}
+
+
 }   // namespace matrix3d
 
 #endif  // matrix3d_h
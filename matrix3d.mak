@@ -1,13 +1,14 @@
 # matrix3d.mak
 
-optcpp = /std:c++17 /O2 /EHsc
+optcpp = /std:c++20 /O2 /EHsc
 optc   = /std:c17 /O2 /EHsc
 optavx = /arch:AVX2
+opt512 = /arch:AVX512
 optas  =
 
 # General C / C++ code and intrinsics
 
-all: matrix3d-loops.exe matrix3d-unroll.exe matrix3d-intrin.exe  matrix3d-avx.exe
+all: matrix3d-loops.exe matrix3d-unroll.exe matrix3d-intrin.exe matrix3d-intrin512.exe matrix3d-avx.exe
 
 matrix3d-loops.exe: timer.h cpuinfo.h matrix3d.h matrix3d44.h cpuinfo.cpp main.cpp
 	cl /Fematrix3d-loops $(optcpp) $(optavx) cpuinfo.cpp main.cpp
@@ -18,6 +19,9 @@ matrix3d-unroll.exe: timer.h cpuinfo.h matrix3d.h matrix3d44.h cpuinfo.cpp main.
 matrix3d-intrin.exe: timer.h cpuinfo.h matrix3d.h matrix3d44.h cpuinfo.cpp main.cpp
 	cl /Fematrix3d-intrin $(optcpp) $(optavx) -DUNROLL -DINTRIN256 cpuinfo.cpp main.cpp
 
+matrix3d-intrin512.exe: timer.h cpuinfo.h matrix3d.h matrix3d44.h cpuinfo.cpp main.cpp
+	cl /Fematrix3d-intrin512 $(optcpp) $(opt512) -DUNROLL -DINTRIN256 cpuinfo.cpp main.cpp
+
 matrix3d-avx.exe: timer.h cpuinfo.h matrix3d.h matrix3d44.h cpuinfo.cpp avx.obj main.cpp
 	cl /Fematrix3d-avx $(optcpp) $(optavx) -DUNROLL -DASM256 cpuinfo.cpp avx.obj main.cpp
 
@@ -4,6 +4,7 @@
 #define matrix3d44_h
 
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 
 #if defined(__x86_64__) || defined(_M_X64)      // 64-bit Intel
@@ -44,9 +45,12 @@ specialized vecarr_x_mat_d  (double *dest, double *v, double *m, size_t n);
 // Matrix multiplication
 
 template <typename T>
-inline specialized mat_x_mat(mat<T, 4, 4> &dest,
-                             mat<T, 4, 4> &a,
-                             mat<T, 4, 4> &b) {
+constexpr specialized mat_x_mat(mat<T, 4, 4> &dest,
+                                mat<T, 4, 4> &a,
+                                mat<T, 4, 4> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
     
     T *pd = dest.m[0];
     T *pa = a.m[0];
@@ -116,9 +120,9 @@ inline specialized mat_x_mat(mat<T, 4, 4> &dest,
 // Matrix and vector multiplication
 
 template <typename T>
-inline specialized vec_x_mat(vec <T, 4>    &dest,
-                             vec <T, 4>    &v,
-                             mat <T, 4, 4> &m) {
+constexpr specialized vec_x_mat(vec <T, 4>    &dest,
+                                vec <T, 4>    &v,
+                                mat <T, 4, 4> &m) {
     dest.v[0] =   v.v[0] * m.m[0][0]
                 + v.v[1] * m.m[1][0]
                 + v.v[2] * m.m[2][0]
@@ -188,13 +192,254 @@ inline specialized vecarr_x_mat(vec <T, 4>    *dest,
     return unroll;
 }
 
+
+
+// -----------------------------------------------------------------------------
+// Matrix array multiplication
+
+template <typename T>
+inline specialized matarr_x_mat(mat<T, 4, 4> *dest,
+                                mat<T, 4, 4> *a,
+                                mat<T, 4, 4> &b,
+                                size_t       n) {
+    T *pd = dest->m[0];
+    T *pa = a->m[0];
+    T *pb = b.m[0];
+
+    T b00 = pb[ 0],             // Shared matrix is loaded once
+      b01 = pb[ 1],             //   for the whole array
+      b02 = pb[ 2],
+      b03 = pb[ 3],
+      b10 = pb[ 4],
+      b11 = pb[ 5],
+      b12 = pb[ 6],
+      b13 = pb[ 7],
+      b20 = pb[ 8],
+      b21 = pb[ 9],
+      b22 = pb[10],
+      b23 = pb[11],
+      b30 = pb[12],
+      b31 = pb[13],
+      b32 = pb[14],
+      b33 = pb[15];
+
+    // Every row of every matrix in the array is a vector times b
+    size_t rows = n * 4;
+
+    for (size_t i = 0; i < rows; ++i, pd += 4, pa += 4) {
+        T a0 = pa[0],
+          a1 = pa[1],
+          a2 = pa[2],
+          a3 = pa[3];
+
+        pd[0] = a0 * b00 + a1 * b10 + a2 * b20 + a3 * b30;
+        pd[1] = a0 * b01 + a1 * b11 + a2 * b21 + a3 * b31;
+        pd[2] = a0 * b02 + a1 * b12 + a2 * b22 + a3 * b32;
+        pd[3] = a0 * b03 + a1 * b13 + a2 * b23 + a3 * b33;
+    }
+
+    return unroll;
+}
+
+template <typename T>
+inline specialized mat_x_matarr(mat<T, 4, 4> *dest,
+                                mat<T, 4, 4> &a,
+                                mat<T, 4, 4> *b,
+                                size_t       n) {
+    T *pd = dest->m[0];
+    T *pa = a.m[0];
+    T *pb = b->m[0];
+
+    T a00 = pa[ 0],             // Shared matrix is loaded once
+      a01 = pa[ 1],             //   for the whole array
+      a02 = pa[ 2],
+      a03 = pa[ 3],
+      a10 = pa[ 4],
+      a11 = pa[ 5],
+      a12 = pa[ 6],
+      a13 = pa[ 7],
+      a20 = pa[ 8],
+      a21 = pa[ 9],
+      a22 = pa[10],
+      a23 = pa[11],
+      a30 = pa[12],
+      a31 = pa[13],
+      a32 = pa[14],
+      a33 = pa[15];
+
+    for (size_t e = 0; e < n; ++e, pd += 16, pb += 16) {
+        // One column of b at a time, compiler unrolls the columns
+        for (int j = 0; j < 4; ++j) {
+            T b0 = pb[j],
+              b1 = pb[j +  4],
+              b2 = pb[j +  8],
+              b3 = pb[j + 12];
+
+            pd[j]      = a00 * b0 + a01 * b1 + a02 * b2 + a03 * b3;
+            pd[j +  4] = a10 * b0 + a11 * b1 + a12 * b2 + a13 * b3;
+            pd[j +  8] = a20 * b0 + a21 * b1 + a22 * b2 + a23 * b3;
+            pd[j + 12] = a30 * b0 + a31 * b1 + a32 * b2 + a33 * b3;
+        }
+    }
+
+    return unroll;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Pairwise matrix array multiplication
+
+template <typename T>
+inline specialized matsoa_x_matsoa(matsoa<T, 4, 4> *dest,
+                                   matsoa<T, 4, 4> *a,
+                                   matsoa<T, 4, 4> *b,
+                                   size_t          blocks) {
+    const size_t lanes = matsoa<T, 4, 4>::lanes;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        auto &d  = dest[e].m;
+        auto &ma = a[e].m;
+        auto &mb = b[e].m;
+
+        // Lanes are independent, the compiler may vectorize across them
+        for (int i = 0; i < 4; ++i) {
+            for (size_t l = 0; l < lanes; ++l) {
+                T a0 = ma[i][0][l],
+                  a1 = ma[i][1][l],
+                  a2 = ma[i][2][l],
+                  a3 = ma[i][3][l];
+
+                d[i][0][l] = a0 * mb[0][0][l] + a1 * mb[1][0][l] + a2 * mb[2][0][l] + a3 * mb[3][0][l];
+                d[i][1][l] = a0 * mb[0][1][l] + a1 * mb[1][1][l] + a2 * mb[2][1][l] + a3 * mb[3][1][l];
+                d[i][2][l] = a0 * mb[0][2][l] + a1 * mb[1][2][l] + a2 * mb[2][2][l] + a3 * mb[3][2][l];
+                d[i][3][l] = a0 * mb[0][3][l] + a1 * mb[1][3][l] + a2 * mb[2][3][l] + a3 * mb[3][3][l];
+            }
+        }
+    }
+
+    return unroll;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix inverse and determinant
+
+// Cofactor expansion using the 2x2 sub-determinants
+// of the upper and lower pairs of rows
+
+template <typename T>
+inline specialized determinant(T &dest, mat<T, 4, 4> &a) {
+    T *pa = a.m[0];
+
+    T a00 = pa[ 0], a01 = pa[ 1], a02 = pa[ 2], a03 = pa[ 3],
+      a10 = pa[ 4], a11 = pa[ 5], a12 = pa[ 6], a13 = pa[ 7],
+      a20 = pa[ 8], a21 = pa[ 9], a22 = pa[10], a23 = pa[11],
+      a30 = pa[12], a31 = pa[13], a32 = pa[14], a33 = pa[15];
+
+    T s0 = a00 * a11 - a10 * a01,   c0 = a20 * a31 - a30 * a21,
+      s1 = a00 * a12 - a10 * a02,   c1 = a20 * a32 - a30 * a22,
+      s2 = a00 * a13 - a10 * a03,   c2 = a20 * a33 - a30 * a23,
+      s3 = a01 * a12 - a11 * a02,   c3 = a21 * a32 - a31 * a22,
+      s4 = a01 * a13 - a11 * a03,   c4 = a21 * a33 - a31 * a23,
+      s5 = a02 * a13 - a12 * a03,   c5 = a22 * a33 - a32 * a23;
+
+    dest = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+    return unroll;
+}
+
+template <typename T>
+inline specialized inverse(mat<T, 4, 4> &dest, mat<T, 4, 4> &a) {
+    T *pd = dest.m[0];
+    T *pa = a.m[0];
+
+    T a00 = pa[ 0], a01 = pa[ 1], a02 = pa[ 2], a03 = pa[ 3],
+      a10 = pa[ 4], a11 = pa[ 5], a12 = pa[ 6], a13 = pa[ 7],
+      a20 = pa[ 8], a21 = pa[ 9], a22 = pa[10], a23 = pa[11],
+      a30 = pa[12], a31 = pa[13], a32 = pa[14], a33 = pa[15];
+
+    T s0 = a00 * a11 - a10 * a01,   c0 = a20 * a31 - a30 * a21,
+      s1 = a00 * a12 - a10 * a02,   c1 = a20 * a32 - a30 * a22,
+      s2 = a00 * a13 - a10 * a03,   c2 = a20 * a33 - a30 * a23,
+      s3 = a01 * a12 - a11 * a02,   c3 = a21 * a32 - a31 * a22,
+      s4 = a01 * a13 - a11 * a03,   c4 = a21 * a33 - a31 * a23,
+      s5 = a02 * a13 - a12 * a03,   c5 = a22 * a33 - a32 * a23;
+
+    T inv = T(1) / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+    pd[ 0] = ( a11 * c5 - a12 * c4 + a13 * c3) * inv;
+    pd[ 1] = (-a01 * c5 + a02 * c4 - a03 * c3) * inv;
+    pd[ 2] = ( a31 * s5 - a32 * s4 + a33 * s3) * inv;
+    pd[ 3] = (-a21 * s5 + a22 * s4 - a23 * s3) * inv;
+    pd[ 4] = (-a10 * c5 + a12 * c2 - a13 * c1) * inv;
+    pd[ 5] = ( a00 * c5 - a02 * c2 + a03 * c1) * inv;
+    pd[ 6] = (-a30 * s5 + a32 * s2 - a33 * s1) * inv;
+    pd[ 7] = ( a20 * s5 - a22 * s2 + a23 * s1) * inv;
+    pd[ 8] = ( a10 * c4 - a11 * c2 + a13 * c0) * inv;
+    pd[ 9] = (-a00 * c4 + a01 * c2 - a03 * c0) * inv;
+    pd[10] = ( a30 * s4 - a31 * s2 + a33 * s0) * inv;
+    pd[11] = (-a20 * s4 + a21 * s2 - a23 * s0) * inv;
+    pd[12] = (-a10 * c3 + a11 * c1 - a12 * c0) * inv;
+    pd[13] = ( a00 * c3 - a01 * c1 + a02 * c0) * inv;
+    pd[14] = (-a30 * s3 + a31 * s1 - a32 * s0) * inv;
+    pd[15] = ( a20 * s3 - a21 * s1 + a22 * s0) * inv;
+
+    return unroll;
+}
+
+template <typename T>
+inline specialized rigid_inverse(mat<T, 4, 4> &dest, mat<T, 4, 4> &a) {
+    T *pd = dest.m[0];
+    T *pa = a.m[0];
+
+    T a00 = pa[ 0], a01 = pa[ 1], a02 = pa[ 2],
+      a10 = pa[ 4], a11 = pa[ 5], a12 = pa[ 6],
+      a20 = pa[ 8], a21 = pa[ 9], a22 = pa[10],
+      t0  = pa[12], t1  = pa[13], t2  = pa[14];
+
+    pd[ 0] = a00;   pd[ 1] = a10;   pd[ 2] = a20;   pd[ 3] = T(0);
+    pd[ 4] = a01;   pd[ 5] = a11;   pd[ 6] = a21;   pd[ 7] = T(0);
+    pd[ 8] = a02;   pd[ 9] = a12;   pd[10] = a22;   pd[11] = T(0);
+
+    pd[12] = -(t0 * a00 + t1 * a01 + t2 * a02);
+    pd[13] = -(t0 * a10 + t1 * a11 + t2 * a12);
+    pd[14] = -(t0 * a20 + t1 * a21 + t2 * a22);
+    pd[15] = T(1);
+
+    return unroll;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix transpose
+
+template <typename T>
+constexpr specialized transpose(mat<T, 4, 4> &dest, mat<T, 4, 4> &a) {
+    if (std::is_constant_evaluated()) {
+        return looped_transpose(dest, a);
+    }
+
+    T *pd = dest.m[0];
+    T *pa = a.m[0];
+
+    pd[ 0] = pa[ 0];    pd[ 1] = pa[ 4];    pd[ 2] = pa[ 8];    pd[ 3] = pa[12];
+    pd[ 4] = pa[ 1];    pd[ 5] = pa[ 5];    pd[ 6] = pa[ 9];    pd[ 7] = pa[13];
+    pd[ 8] = pa[ 2];    pd[ 9] = pa[ 6];    pd[10] = pa[10];    pd[11] = pa[14];
+    pd[12] = pa[ 3];    pd[13] = pa[ 7];    pd[14] = pa[11];    pd[15] = pa[15];
+
+    return unroll;
+}
+
 // Use looped 4x4 specializations
 #else
 
 template <typename T>
-inline specialized mat_x_mat(mat<T, 4, 4> &dest,
-                             mat<T, 4, 4> &a,
-                             mat<T, 4, 4> &b) {
+constexpr specialized mat_x_mat(mat<T, 4, 4> &dest,
+                                mat<T, 4, 4> &a,
+                                mat<T, 4, 4> &b) {
     for (int i = 0; i < 4; ++i) {
         for (int j = 0; j < 4; ++j) {
             dest.m[i][j] =   a.m[i][0] * b.m[0][j]
@@ -208,9 +453,9 @@ inline specialized mat_x_mat(mat<T, 4, 4> &dest,
 }
 
 template <typename T>
-inline specialized vec_x_mat(vec <T, 4>    &dest,
-                             vec <T, 4>    &v,
-                             mat <T, 4, 4> &m) {
+constexpr specialized vec_x_mat(vec <T, 4>    &dest,
+                                vec <T, 4>    &v,
+                                mat <T, 4, 4> &m) {
     for (int i = 0; i < 4; ++i) {
         dest.v[i] =   v.v[0] * m.m[0][i]
                     + v.v[1] * m.m[1][i]
@@ -242,6 +487,68 @@ inline specialized vecarr_x_mat(vec <T, 4>    *dest,
     return loops44;
 }
 
+template <typename T>
+inline specialized matarr_x_mat(mat<T, 4, 4> *dest,
+                                mat<T, 4, 4> *a,
+                                mat<T, 4, 4> &b,
+                                size_t       n) {
+    for (int e = 0; e < n; ++e) {
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                dest[e].m[i][j] =   a[e].m[i][0] * b.m[0][j]
+                                  + a[e].m[i][1] * b.m[1][j]
+                                  + a[e].m[i][2] * b.m[2][j]
+                                  + a[e].m[i][3] * b.m[3][j];
+            }
+        }
+    }
+
+    return loops44;
+}
+
+template <typename T>
+inline specialized mat_x_matarr(mat<T, 4, 4> *dest,
+                                mat<T, 4, 4> &a,
+                                mat<T, 4, 4> *b,
+                                size_t       n) {
+    for (int e = 0; e < n; ++e) {
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                dest[e].m[i][j] =   a.m[i][0] * b[e].m[0][j]
+                                  + a.m[i][1] * b[e].m[1][j]
+                                  + a.m[i][2] * b[e].m[2][j]
+                                  + a.m[i][3] * b[e].m[3][j];
+            }
+        }
+    }
+
+    return loops44;
+}
+
+
+template <typename T>
+inline specialized matsoa_x_matsoa(matsoa<T, 4, 4> *dest,
+                                   matsoa<T, 4, 4> *a,
+                                   matsoa<T, 4, 4> *b,
+                                   size_t          blocks) {
+    const size_t lanes = matsoa<T, 4, 4>::lanes;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                for (size_t l = 0; l < lanes; ++l) {
+                    dest[e].m[i][j][l] =   a[e].m[i][0][l] * b[e].m[0][j][l]
+                                         + a[e].m[i][1][l] * b[e].m[1][j][l]
+                                         + a[e].m[i][2][l] * b[e].m[2][j][l]
+                                         + a[e].m[i][3][l] * b[e].m[3][j][l];
+                }
+            }
+        }
+    }
+
+    return loops44;
+}
+
 #endif  // UNROLL
 
 
@@ -257,18 +564,22 @@ inline specialized vecarr_x_mat(vec <T, 4>    *dest,
 // Matrix multiplication
 
 template <>
-inline specialized mat_x_mat(mat<float, 4, 4> &dest,
-                             mat<float, 4, 4> &a,
-                             mat<float, 4, 4> &b) {
+constexpr specialized mat_x_mat(mat<float, 4, 4> &dest,
+                                mat<float, 4, 4> &a,
+                                mat<float, 4, 4> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
     __m128 row0, row1, row2, row3, vec0, vec1, vec2, vec3, vecd;
     float *pd = dest.m[0];
     float *pa = a.m[0];
     float *pb = b.m[0];
 
-    row0 = _mm_load_ps    (pb +  0);                        // Load all the matrix rows
-    row1 = _mm_load_ps    (pb +  4);
-    row2 = _mm_load_ps    (pb +  8);
-    row3 = _mm_load_ps    (pb + 12);
+    row0 = _mm_loadu_ps   (pb +  0);                        // Load all the matrix rows
+    row1 = _mm_loadu_ps   (pb +  4);
+    row2 = _mm_loadu_ps   (pb +  8);
+    row3 = _mm_loadu_ps   (pb + 12);
     
     vecd = _mm_setzero_ps ();                               // Zero out vector
     vec0 = _mm_set_ps1    (*(pa + 0));                      // Duplicate the 1st element
@@ -279,7 +590,7 @@ inline specialized mat_x_mat(mat<float, 4, 4> &dest,
     vecd = _mm_fmadd_ps   (row1, vec1, vecd);
     vecd = _mm_fmadd_ps   (row2, vec2, vecd);
     vecd = _mm_fmadd_ps   (row3, vec3, vecd);
-           _mm_store_ps   (pd, vecd);                       // Store a vector
+           _mm_storeu_ps  (pd, vecd);                       // Store a vector
     
     vecd = _mm_setzero_ps ();
     vec0 = _mm_set_ps1    (*(pa + 4));                      // 2nd element of each column
@@ -290,7 +601,7 @@ inline specialized mat_x_mat(mat<float, 4, 4> &dest,
     vecd = _mm_fmadd_ps   (row1, vec1, vecd);
     vecd = _mm_fmadd_ps   (row2, vec2, vecd);
     vecd = _mm_fmadd_ps   (row3, vec3, vecd);
-           _mm_store_ps   (pd + 4, vecd);
+           _mm_storeu_ps  (pd + 4, vecd);
 
     vecd = _mm_setzero_ps ();
     vec0 = _mm_set_ps1    (*(pa +  8));                     // 3rd element of each column
@@ -301,7 +612,7 @@ inline specialized mat_x_mat(mat<float, 4, 4> &dest,
     vecd = _mm_fmadd_ps   (row1, vec1, vecd);
     vecd = _mm_fmadd_ps   (row2, vec2, vecd);
     vecd = _mm_fmadd_ps   (row3, vec3, vecd);
-           _mm_store_ps   (pd + 8, vecd);
+           _mm_storeu_ps  (pd + 8, vecd);
 
     vecd = _mm_setzero_ps ();
     vec0 = _mm_set_ps1    (*(pa + 12));                     // 4th element of each column
@@ -312,24 +623,28 @@ inline specialized mat_x_mat(mat<float, 4, 4> &dest,
     vecd = _mm_fmadd_ps   (row1, vec1, vecd);
     vecd = _mm_fmadd_ps   (row2, vec2, vecd);
     vecd = _mm_fmadd_ps   (row3, vec3, vecd);
-           _mm_store_ps   (pd + 12, vecd);
+           _mm_storeu_ps  (pd + 12, vecd);
     
     return intrin;
 }
 
 template <>
-inline specialized mat_x_mat(mat<double, 4, 4> &dest,
-                             mat<double, 4, 4> &a,
-                             mat<double, 4, 4> &b) {
+constexpr specialized mat_x_mat(mat<double, 4, 4> &dest,
+                                mat<double, 4, 4> &a,
+                                mat<double, 4, 4> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
     __m256d row0, row1, row2, row3, vec0, vec1, vec2, vec3, vecd;
     double *pd = dest.m[0];
     double *pa = a.m[0];
     double *pb = b.m[0];
 
-    row0 = _mm256_load_pd    (pb +  0);                     // Load all the matrix rows
-    row1 = _mm256_load_pd    (pb +  4);
-    row2 = _mm256_load_pd    (pb +  8);
-    row3 = _mm256_load_pd    (pb + 12);
+    row0 = _mm256_loadu_pd   (pb +  0);                     // Load all the matrix rows
+    row1 = _mm256_loadu_pd   (pb +  4);
+    row2 = _mm256_loadu_pd   (pb +  8);
+    row3 = _mm256_loadu_pd   (pb + 12);
     
     vecd = _mm256_setzero_pd ();                            // Zero out vector
     vec0 = _mm256_set1_pd    (*(pa + 0));                   // Duplicate the 1st element
@@ -340,7 +655,7 @@ inline specialized mat_x_mat(mat<double, 4, 4> &dest,
     vecd = _mm256_fmadd_pd   (row1, vec1, vecd);
     vecd = _mm256_fmadd_pd   (row2, vec2, vecd);
     vecd = _mm256_fmadd_pd   (row3, vec3, vecd);
-           _mm256_store_pd   (pd, vecd);                    // Store a vector
+           _mm256_storeu_pd  (pd, vecd);                    // Store a vector
     
     vecd = _mm256_setzero_pd ();
     vec0 = _mm256_set1_pd    (*(pa + 4));                   // 2nd element of each column
@@ -351,7 +666,7 @@ inline specialized mat_x_mat(mat<double, 4, 4> &dest,
     vecd = _mm256_fmadd_pd   (row1, vec1, vecd);
     vecd = _mm256_fmadd_pd   (row2, vec2, vecd);
     vecd = _mm256_fmadd_pd   (row3, vec3, vecd);
-           _mm256_store_pd   (pd + 4, vecd);
+           _mm256_storeu_pd  (pd + 4, vecd);
 
     vecd = _mm256_setzero_pd ();
     vec0 = _mm256_set1_pd    (*(pa +  8));                  // 3rd element of each column
@@ -362,7 +677,7 @@ inline specialized mat_x_mat(mat<double, 4, 4> &dest,
     vecd = _mm256_fmadd_pd   (row1, vec1, vecd);
     vecd = _mm256_fmadd_pd   (row2, vec2, vecd);
     vecd = _mm256_fmadd_pd   (row3, vec3, vecd);
-           _mm256_store_pd   (pd + 8, vecd);
+           _mm256_storeu_pd  (pd + 8, vecd);
 
     vecd = _mm256_setzero_pd  ();
     vec0 = _mm256_set1_pd     (*(pa + 12));                 // 4th element of each column
@@ -373,7 +688,7 @@ inline specialized mat_x_mat(mat<double, 4, 4> &dest,
     vecd = _mm256_fmadd_pd    (row1, vec1, vecd);
     vecd = _mm256_fmadd_pd    (row2, vec2, vecd);
     vecd = _mm256_fmadd_pd    (row3, vec3, vecd);
-           _mm256_store_pd    (pd + 12, vecd);
+           _mm256_storeu_pd   (pd + 12, vecd);
     
     return intrin;
 }
@@ -392,6 +707,7 @@ inline specialized vecarr_x_mat(vec <float, 4>    *dest,
 #ifdef INTRIN256
     
     __m256 row0, row1, row2, row3, vec0, vec1, vec2, vec3, vecd;
+    __m128 low0, low1, low2, low3, vecs;
     float *pd = dest->v;
     float *pv = v->v;
     float *pm = m.m[0];
@@ -400,10 +716,30 @@ inline specialized vecarr_x_mat(vec <float, 4>    *dest,
     row1 = _mm256_loadu2_m128(pm +  4, pm +  4);        //   into upper and lower
     row2 = _mm256_loadu2_m128(pm +  8, pm +  8);        //   halves of vector
     row3 = _mm256_loadu2_m128(pm + 12, pm + 12);
+    low0 = _mm256_castps256_ps128(row0);                // Lower halves used
+    low1 = _mm256_castps256_ps128(row1);                //   for single vectors
+    low2 = _mm256_castps256_ps128(row2);
+    low3 = _mm256_castps256_ps128(row3);
+
+    // Peel off a single vector when that makes the paired stores aligned.
+    // Destinations that are not even vector aligned are left as is,
+    // they are handled correctly by the unaligned stores.
+    if (n > 0 && (uintptr_t(pd) & (alignment - 1)) == alignment / 2) {
+        vecs = _mm_setzero_ps ();                       // Zero out vector
+        vecs = _mm_fmadd_ps   (low0, _mm_set1_ps(*(pv + 0)), vecs);
+        vecs = _mm_fmadd_ps   (low1, _mm_set1_ps(*(pv + 1)), vecs);
+        vecs = _mm_fmadd_ps   (low2, _mm_set1_ps(*(pv + 2)), vecs);
+        vecs = _mm_fmadd_ps   (low3, _mm_set1_ps(*(pv + 3)), vecs);
+               _mm_storeu_ps  (pd, vecs);               // Store a vector
+        
+        pd += 4;
+        pv += 4;
+        --n;
+    }
     
-    n = (n + 1) / 2;                                    // Process vectors in pairs
+    size_t pairs = n / 2;                               // Process vectors in pairs
     
-    for (int i = 0; i < n; ++i, pd += 8, pv += 8) {
+    for (size_t i = 0; i < pairs; ++i, pd += 8, pv += 8) {
         vecd = _mm256_setzero_ps ();                    // Zero out vectors
         vec0 = _mm256_set_ps     (*(pv + 4), *(pv + 4), // Duplicate 1st elements from
                                   *(pv + 4), *(pv + 4), //   each column into 4 lanes
@@ -425,7 +761,17 @@ inline specialized vecarr_x_mat(vec <float, 4>    *dest,
         vecd = _mm256_fmadd_ps   (row1, vec1, vecd);
         vecd = _mm256_fmadd_ps   (row2, vec2, vecd);
         vecd = _mm256_fmadd_ps   (row3, vec3, vecd);
-               _mm256_store_ps   (pd, vecd);            // Store a vector
+               _mm256_storeu_ps  (pd, vecd);            // Store a pair of vectors
+    }
+    
+    // Odd vector left over, never write past the end of the array
+    if (n & 1) {
+        vecs = _mm_setzero_ps ();
+        vecs = _mm_fmadd_ps   (low0, _mm_set1_ps(*(pv + 0)), vecs);
+        vecs = _mm_fmadd_ps   (low1, _mm_set1_ps(*(pv + 1)), vecs);
+        vecs = _mm_fmadd_ps   (low2, _mm_set1_ps(*(pv + 2)), vecs);
+        vecs = _mm_fmadd_ps   (low3, _mm_set1_ps(*(pv + 3)), vecs);
+               _mm_storeu_ps  (pd, vecs);
     }
     
     return intrin256;
@@ -438,10 +784,10 @@ inline specialized vecarr_x_mat(vec <float, 4>    *dest,
     float *pv = v->v;
     float *pm = m.m[0];
 
-    row0 = _mm_load_ps(pm +  0);                        // Load all the matrix rows
-    row1 = _mm_load_ps(pm +  4);
-    row2 = _mm_load_ps(pm +  8);
-    row3 = _mm_load_ps(pm + 12);
+    row0 = _mm_loadu_ps(pm +  0);                       // Load all the matrix rows
+    row1 = _mm_loadu_ps(pm +  4);
+    row2 = _mm_loadu_ps(pm +  8);
+    row3 = _mm_loadu_ps(pm + 12);
     
     for (int i = 0; i < n; ++i, pd += 4, pv += 4) {
         vecd = _mm_setzero_ps ();                       // Zero out vector
@@ -453,7 +799,7 @@ inline specialized vecarr_x_mat(vec <float, 4>    *dest,
         vecd = _mm_fmadd_ps   (row1, vec1, vecd);
         vecd = _mm_fmadd_ps   (row2, vec2, vecd);
         vecd = _mm_fmadd_ps   (row3, vec3, vecd);
-               _mm_store_ps   (pd, vecd);               // Store a vector
+               _mm_storeu_ps  (pd, vecd);               // Store a vector
     }
     
     return intrin;
@@ -471,11 +817,13 @@ inline specialized vecarr_x_mat(vec <double, 4>    *dest,
     double *pv = v->v;
     double *pm = m.m[0];
 
-    row0 = _mm256_load_pd(pm +  0);                     // Load all the matrix rows
-    row1 = _mm256_load_pd(pm +  4);
-    row2 = _mm256_load_pd(pm +  8);
-    row3 = _mm256_load_pd(pm + 12);
+    row0 = _mm256_loadu_pd(pm +  0);                    // Load all the matrix rows
+    row1 = _mm256_loadu_pd(pm +  4);
+    row2 = _mm256_loadu_pd(pm +  8);
+    row3 = _mm256_loadu_pd(pm + 12);
 
+    // Each vector fills a 256-bit register, so peeling can not
+    // bring a misaligned array into alignment, rely on unaligned stores
     for (int i = 0; i < n; ++i, pd += 4, pv += 4) {
         vecd = _mm256_setzero_pd ();                    // Zero out vector
         vec0 = _mm256_set1_pd    (*(pv + 0));           // Duplicate the nth element
@@ -486,7 +834,7 @@ inline specialized vecarr_x_mat(vec <double, 4>    *dest,
         vecd = _mm256_fmadd_pd   (row1, vec1, vecd);
         vecd = _mm256_fmadd_pd   (row2, vec2, vecd);
         vecd = _mm256_fmadd_pd   (row3, vec3, vecd);
-               _mm256_store_pd   (pd, vecd);            // Store a vector
+               _mm256_storeu_pd  (pd, vecd);            // Store a vector
     }
     
     return intrin;
@@ -494,156 +842,9806 @@ inline specialized vecarr_x_mat(vec <double, 4>    *dest,
 
 
 
-#elif defined(__aarch64__) || defined(__arm__)  // 64- or 32-bit ARM
-
-
+// -----------------------------------------------------------------------------
+// Matrix array multiplication
 
 template <>
-inline specialized mat_x_mat(mat<float, 4, 4> &dest,
-                             mat<float, 4, 4> &a,
-                             mat<float, 4, 4> &b) {
-    float32x4_t row0, row1, row2, row3, vec0, vec1, vec2, vec3;
-    float *pd = dest.m[0];
-    float *pa = a.m[0];
+inline specialized matarr_x_mat(mat<float, 4, 4> *dest,
+                                mat<float, 4, 4> *a,
+                                mat<float, 4, 4> &b,
+                                size_t           n) {
+    float *pd = dest->m[0];
+    float *pa = a->m[0];
     float *pb = b.m[0];
 
-    row0 = vld1q_f32     (pb);              // Load all the matrix rows
-    row1 = vld1q_f32     (pb +  4);
-    row2 = vld1q_f32     (pb +  8);
-    row3 = vld1q_f32     (pb + 12);
+// Compiler targeting AVX-512, a whole 4x4 matrix in a register
+#if defined(__AVX512F__)
 
-    vec0 = vld1q_dup_f32 (pa);              // Duplicate the 1st element
-    vec1 = vld1q_dup_f32 (pa + 1);          //   of each column
-    vec2 = vld1q_dup_f32 (pa + 2);
-    vec3 = vld1q_dup_f32 (pa + 3);
-    vec0 = vmulq_f32     (row0, vec0);      // Multiply the elements
-    vec1 = vmulq_f32     (row1, vec1);
-    vec2 = vmulq_f32     (row2, vec2);
-    vec3 = vmulq_f32     (row3, vec3);
-    vec0 = vaddq_f32     (vec0, vec1);      // Add the products
-    vec1 = vaddq_f32     (vec2, vec3);
-    vec0 = vaddq_f32     (vec0, vec1);
-           vst1q_f32     (pd, vec0);        // Store a vector
+    __m512 row0, row1, row2, row3, mata, matd;
 
-    vec0 = vld1q_dup_f32 (pa + 4);          // 2nd element of each column
-    vec1 = vld1q_dup_f32 (pa + 5);
-    vec2 = vld1q_dup_f32 (pa + 6);
-    vec3 = vld1q_dup_f32 (pa + 7);
-    vec0 = vmulq_f32     (row0, vec0);
-    vec1 = vmulq_f32     (row1, vec1);
-    vec2 = vmulq_f32     (row2, vec2);
-    vec3 = vmulq_f32     (row3, vec3);
-    vec0 = vaddq_f32     (vec0, vec1);
-    vec1 = vaddq_f32     (vec2, vec3);
-    vec0 = vaddq_f32     (vec0, vec1);
-           vst1q_f32     (pd + 4, vec0);
+    row0 = _mm512_broadcast_f32x4(_mm_loadu_ps(pb +  0));   // Load each row of b
+    row1 = _mm512_broadcast_f32x4(_mm_loadu_ps(pb +  4));   //   into all four
+    row2 = _mm512_broadcast_f32x4(_mm_loadu_ps(pb +  8));   //   128-bit lanes
+    row3 = _mm512_broadcast_f32x4(_mm_loadu_ps(pb + 12));
 
-    vec0 = vld1q_dup_f32 (pa +  8);         // 3rd element of each column
-    vec1 = vld1q_dup_f32 (pa +  9);
-    vec2 = vld1q_dup_f32 (pa + 10);
-    vec3 = vld1q_dup_f32 (pa + 11);
-    vec0 = vmulq_f32     (row0, vec0);
-    vec1 = vmulq_f32     (row1, vec1);
-    vec2 = vmulq_f32     (row2, vec2);
-    vec3 = vmulq_f32     (row3, vec3);
-    vec0 = vaddq_f32     (vec0, vec1);
-    vec1 = vaddq_f32     (vec2, vec3);
-    vec0 = vaddq_f32     (vec0, vec1);
-           vst1q_f32     (pd + 8, vec0);
+    for (size_t i = 0; i < n; ++i, pd += 16, pa += 16) {
+        mata = _mm512_loadu_ps   (pa);                      // Load a, one row per lane
+        matd = _mm512_mul_ps     (row0, _mm512_permute_ps(mata, 0x00));
+        matd = _mm512_fmadd_ps   (row1, _mm512_permute_ps(mata, 0x55), matd);
+        matd = _mm512_fmadd_ps   (row2, _mm512_permute_ps(mata, 0xaa), matd);
+        matd = _mm512_fmadd_ps   (row3, _mm512_permute_ps(mata, 0xff), matd);
+               _mm512_storeu_ps  (pd, matd);                // Store the whole matrix
+    }
 
-    vec0 = vld1q_dup_f32 (pa + 12);         // 4th element of each column
-    vec1 = vld1q_dup_f32 (pa + 13);
-    vec2 = vld1q_dup_f32 (pa + 14);
-    vec3 = vld1q_dup_f32 (pa + 15);
-    vec0 = vmulq_f32     (row0, vec0);
-    vec1 = vmulq_f32     (row1, vec1);
-    vec2 = vmulq_f32     (row2, vec2);
-    vec3 = vmulq_f32     (row3, vec3);
-    vec0 = vaddq_f32     (vec0, vec1);
-    vec1 = vaddq_f32     (vec2, vec3);
-    vec0 = vaddq_f32     (vec0, vec1);
-           vst1q_f32     (pd + 12, vec0);
+    return intrin512;
 
-    return intrin;
-}
+// User defined compiler macro that allows two row, 8 lane, implementations
+#elif defined(INTRIN256)
 
-template <>
-inline specialized mat_x_mat(mat<double, 4, 4> &dest,
-                             mat<double, 4, 4> &a,
-                             mat<double, 4, 4> &b) {
-    uint32x4_t vec0;
-    uint32_t   *pd = (uint32_t *) dest.m[0];
+    __m256 row0, row1, row2, row3, mat01, mat23, dst01, dst23;
 
-    // Just zero out destination
-    vec0 = vmovq_n_u32 (0);
-           vst1q_u32   (pd,      vec0);
-           vst1q_u32   (pd + 4,  vec0);
-           vst1q_u32   (pd + 8,  vec0);
-           vst1q_u32   (pd + 12, vec0);
-           vst1q_u32   (pd + 16, vec0);
-           vst1q_u32   (pd + 20, vec0);
-           vst1q_u32   (pd + 24, vec0);
-           vst1q_u32   (pd + 28, vec0);
+    row0 = _mm256_broadcast_ps((__m128 *) (pb +  0));       // Load each row of b into
+    row1 = _mm256_broadcast_ps((__m128 *) (pb +  4));       //   upper and lower halves
+    row2 = _mm256_broadcast_ps((__m128 *) (pb +  8));
+    row3 = _mm256_broadcast_ps((__m128 *) (pb + 12));
 
-    return zero;
-}
+    for (size_t i = 0; i < n; ++i, pd += 16, pa += 16) {
+        mat01 = _mm256_loadu_ps  (pa);                      // Load two rows of a
+        mat23 = _mm256_loadu_ps  (pa + 8);                  //   per register
 
+        // Duplicate the nth element of each row within its half
+        dst01 = _mm256_mul_ps    (row0, _mm256_permute_ps(mat01, 0x00));
+        dst23 = _mm256_mul_ps    (row0, _mm256_permute_ps(mat23, 0x00));
+        dst01 = _mm256_fmadd_ps  (row1, _mm256_permute_ps(mat01, 0x55), dst01);
+        dst23 = _mm256_fmadd_ps  (row1, _mm256_permute_ps(mat23, 0x55), dst23);
+        dst01 = _mm256_fmadd_ps  (row2, _mm256_permute_ps(mat01, 0xaa), dst01);
+        dst23 = _mm256_fmadd_ps  (row2, _mm256_permute_ps(mat23, 0xaa), dst23);
+        dst01 = _mm256_fmadd_ps  (row3, _mm256_permute_ps(mat01, 0xff), dst01);
+        dst23 = _mm256_fmadd_ps  (row3, _mm256_permute_ps(mat23, 0xff), dst23);
+                _mm256_storeu_ps (pd,     dst01);
+                _mm256_storeu_ps (pd + 8, dst23);
+    }
 
+    return intrin256;
 
-// -----------------------------------------------------------------------------
-// Matrix and vector array multiplication
+// Single row, 4 lane, implementations
+#else
 
-template <>
-inline specialized vecarr_x_mat(vec <float, 4>    *dest,
-                                vec <float, 4>    *v,
-                                mat <float, 4, 4> &m,
-                                size_t            n) {
-    float32x4_t   row0, row1, row2, row3, vec0, vec1, vec2, vec3, vecs;
-    float *pd = dest->v;
-    float *pv = v->v;
-    float *pm = m.m[0];
+    __m128 row0, row1, row2, row3, vecd;
 
-    row0 = vld1q_f32(pm +  0);              // Load all the matrix rows
-    row1 = vld1q_f32(pm +  4);
-    row2 = vld1q_f32(pm +  8);
-    row3 = vld1q_f32(pm + 12);
+    row0 = _mm_loadu_ps(pb +  0);                           // Load all the matrix rows
+    row1 = _mm_loadu_ps(pb +  4);
+    row2 = _mm_loadu_ps(pb +  8);
+    row3 = _mm_loadu_ps(pb + 12);
 
-    for (int i = 0; i < n; ++i, pv += 4, pd += 4) {
-        vec0 = vld1q_dup_f32 (pv + 0);      // Duplicate the nth element
-        vec1 = vld1q_dup_f32 (pv + 1);      //   of each column in a vector
-        vec2 = vld1q_dup_f32 (pv + 2);
-        vec3 = vld1q_dup_f32 (pv + 3);
-        vec0 = vmulq_f32     (row0, vec0);  // Multiply the elements
-        vec1 = vmulq_f32     (row1, vec1);
-        vec2 = vmulq_f32     (row2, vec2);
-        vec3 = vmulq_f32     (row3, vec3);
-        vec0 = vaddq_f32     (vec0, vec1);  // Add the products
-        vec1 = vaddq_f32     (vec2, vec3);
-        vec0 = vaddq_f32     (vec0, vec1);
-               vst1q_f32     (pd, vec0);    // Store a vector
+    // Every row of every matrix in the array is a vector times b
+    size_t rows = n * 4;
+
+    for (size_t i = 0; i < rows; ++i, pd += 4, pa += 4) {
+        vecd = _mm_mul_ps    (row0, _mm_set1_ps(*(pa + 0)));
+        vecd = _mm_fmadd_ps  (row1, _mm_set1_ps(*(pa + 1)), vecd);
+        vecd = _mm_fmadd_ps  (row2, _mm_set1_ps(*(pa + 2)), vecd);
+        vecd = _mm_fmadd_ps  (row3, _mm_set1_ps(*(pa + 3)), vecd);
+               _mm_storeu_ps (pd, vecd);
     }
 
     return intrin;
+
+#endif  // __AVX512F__ INTRIN256
 }
 
 template <>
-inline specialized vecarr_x_mat(vec <double, 4>    *dest,
-                                vec <double, 4>    *v,
-                                mat <double, 4, 4> &m,
-                                size_t             n) {
-    uint32x4_t vec0;
+inline specialized mat_x_matarr(mat<float, 4, 4> *dest,
+                                mat<float, 4, 4> &a,
+                                mat<float, 4, 4> *b,
+                                size_t           n) {
+    float *pd = dest->m[0];
+    float *pa = a.m[0];
+    float *pb = b->m[0];
+
+#if defined(__AVX512F__)
+
+    __m512 mata, col0, col1, col2, col3, matd;
+
+    mata = _mm512_loadu_ps   (pa);                          // Load a, one row per lane
+    col0 = _mm512_permute_ps (mata, 0x00);                  // Duplicate the nth element
+    col1 = _mm512_permute_ps (mata, 0x55);                  //   of each row of a
+    col2 = _mm512_permute_ps (mata, 0xaa);                  //   within its lane
+    col3 = _mm512_permute_ps (mata, 0xff);
+
+    for (size_t i = 0; i < n; ++i, pd += 16, pb += 16) {
+        // Rows of b are copied to all four lanes
+        matd = _mm512_mul_ps    (col0, _mm512_broadcast_f32x4(_mm_loadu_ps(pb +  0)));
+        matd = _mm512_fmadd_ps  (col1, _mm512_broadcast_f32x4(_mm_loadu_ps(pb +  4)), matd);
+        matd = _mm512_fmadd_ps  (col2, _mm512_broadcast_f32x4(_mm_loadu_ps(pb +  8)), matd);
+        matd = _mm512_fmadd_ps  (col3, _mm512_broadcast_f32x4(_mm_loadu_ps(pb + 12)), matd);
+               _mm512_storeu_ps (pd, matd);
+    }
+
+    return intrin512;
+
+#elif defined(INTRIN256)
+
+    __m256 mat01, mat23, col01_0, col01_1, col01_2, col01_3,
+                         col23_0, col23_1, col23_2, col23_3,
+           row0, row1, row2, row3, dst01, dst23;
+
+    mat01   = _mm256_loadu_ps   (pa);                       // Load two rows of a
+    mat23   = _mm256_loadu_ps   (pa + 8);                   //   per register
+    col01_0 = _mm256_permute_ps (mat01, 0x00);              // Duplicate the nth element
+    col01_1 = _mm256_permute_ps (mat01, 0x55);              //   of each row of a
+    col01_2 = _mm256_permute_ps (mat01, 0xaa);              //   within its half
+    col01_3 = _mm256_permute_ps (mat01, 0xff);
+    col23_0 = _mm256_permute_ps (mat23, 0x00);
+    col23_1 = _mm256_permute_ps (mat23, 0x55);
+    col23_2 = _mm256_permute_ps (mat23, 0xaa);
+    col23_3 = _mm256_permute_ps (mat23, 0xff);
+
+    for (size_t i = 0; i < n; ++i, pd += 16, pb += 16) {
+        row0  = _mm256_broadcast_ps((__m128 *) (pb +  0));  // Load each row of b into
+        row1  = _mm256_broadcast_ps((__m128 *) (pb +  4));  //   upper and lower halves
+        row2  = _mm256_broadcast_ps((__m128 *) (pb +  8));
+        row3  = _mm256_broadcast_ps((__m128 *) (pb + 12));
+        dst01 = _mm256_mul_ps    (col01_0, row0);
+        dst23 = _mm256_mul_ps    (col23_0, row0);
+        dst01 = _mm256_fmadd_ps  (col01_1, row1, dst01);
+        dst23 = _mm256_fmadd_ps  (col23_1, row1, dst23);
+        dst01 = _mm256_fmadd_ps  (col01_2, row2, dst01);
+        dst23 = _mm256_fmadd_ps  (col23_2, row2, dst23);
+        dst01 = _mm256_fmadd_ps  (col01_3, row3, dst01);
+        dst23 = _mm256_fmadd_ps  (col23_3, row3, dst23);
+                _mm256_storeu_ps (pd,     dst01);
+                _mm256_storeu_ps (pd + 8, dst23);
+    }
+
+    return intrin256;
+
+#else
+
+    __m128 a00, a01, a02, a03, a10, a11, a12, a13,
+           a20, a21, a22, a23, a30, a31, a32, a33,
+           row0, row1, row2, row3, vecd;
+
+    a00 = _mm_set1_ps(pa[ 0]);  a01 = _mm_set1_ps(pa[ 1]);  // Duplicate every element
+    a02 = _mm_set1_ps(pa[ 2]);  a03 = _mm_set1_ps(pa[ 3]);  //   of a once
+    a10 = _mm_set1_ps(pa[ 4]);  a11 = _mm_set1_ps(pa[ 5]);
+    a12 = _mm_set1_ps(pa[ 6]);  a13 = _mm_set1_ps(pa[ 7]);
+    a20 = _mm_set1_ps(pa[ 8]);  a21 = _mm_set1_ps(pa[ 9]);
+    a22 = _mm_set1_ps(pa[10]);  a23 = _mm_set1_ps(pa[11]);
+    a30 = _mm_set1_ps(pa[12]);  a31 = _mm_set1_ps(pa[13]);
+    a32 = _mm_set1_ps(pa[14]);  a33 = _mm_set1_ps(pa[15]);
+
+    for (size_t i = 0; i < n; ++i, pd += 16, pb += 16) {
+        row0 = _mm_loadu_ps  (pb +  0);                     // Load all the rows of b
+        row1 = _mm_loadu_ps  (pb +  4);
+        row2 = _mm_loadu_ps  (pb +  8);
+        row3 = _mm_loadu_ps  (pb + 12);
+
+        vecd = _mm_mul_ps    (a00, row0);
+        vecd = _mm_fmadd_ps  (a01, row1, vecd);
+        vecd = _mm_fmadd_ps  (a02, row2, vecd);
+        vecd = _mm_fmadd_ps  (a03, row3, vecd);
+               _mm_storeu_ps (pd, vecd);
+
+        vecd = _mm_mul_ps    (a10, row0);
+        vecd = _mm_fmadd_ps  (a11, row1, vecd);
+        vecd = _mm_fmadd_ps  (a12, row2, vecd);
+        vecd = _mm_fmadd_ps  (a13, row3, vecd);
+               _mm_storeu_ps (pd + 4, vecd);
+
+        vecd = _mm_mul_ps    (a20, row0);
+        vecd = _mm_fmadd_ps  (a21, row1, vecd);
+        vecd = _mm_fmadd_ps  (a22, row2, vecd);
+        vecd = _mm_fmadd_ps  (a23, row3, vecd);
+               _mm_storeu_ps (pd + 8, vecd);
+
+        vecd = _mm_mul_ps    (a30, row0);
+        vecd = _mm_fmadd_ps  (a31, row1, vecd);
+        vecd = _mm_fmadd_ps  (a32, row2, vecd);
+        vecd = _mm_fmadd_ps  (a33, row3, vecd);
+               _mm_storeu_ps (pd + 12, vecd);
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__ INTRIN256
+}
+
+template <>
+inline specialized matarr_x_mat(mat<double, 4, 4> *dest,
+                                mat<double, 4, 4> *a,
+                                mat<double, 4, 4> &b,
+                                size_t            n) {
+    double *pd = dest->m[0];
+    double *pa = a->m[0];
+    double *pb = b.m[0];
+
+// Compiler targeting AVX-512, two rows of a 4x4 matrix per register
+#if defined(__AVX512F__)
+
+    __m512d row0, row1, row2, row3, mat01, mat23, dst01, dst23;
+
+    row0 = _mm512_broadcast_f64x4(_mm256_loadu_pd(pb +  0));    // Load each row of b
+    row1 = _mm512_broadcast_f64x4(_mm256_loadu_pd(pb +  4));    //   into both 256-bit
+    row2 = _mm512_broadcast_f64x4(_mm256_loadu_pd(pb +  8));    //   halves
+    row3 = _mm512_broadcast_f64x4(_mm256_loadu_pd(pb + 12));
+
+    for (size_t i = 0; i < n; ++i, pd += 16, pa += 16) {
+        mat01 = _mm512_loadu_pd  (pa);                      // Load two rows of a
+        mat23 = _mm512_loadu_pd  (pa + 8);                  //   per register
+
+        // Duplicate the nth element of each row within its half
+        dst01 = _mm512_mul_pd    (row0, _mm512_permutex_pd(mat01, 0x00));
+        dst23 = _mm512_mul_pd    (row0, _mm512_permutex_pd(mat23, 0x00));
+        dst01 = _mm512_fmadd_pd  (row1, _mm512_permutex_pd(mat01, 0x55), dst01);
+        dst23 = _mm512_fmadd_pd  (row1, _mm512_permutex_pd(mat23, 0x55), dst23);
+        dst01 = _mm512_fmadd_pd  (row2, _mm512_permutex_pd(mat01, 0xaa), dst01);
+        dst23 = _mm512_fmadd_pd  (row2, _mm512_permutex_pd(mat23, 0xaa), dst23);
+        dst01 = _mm512_fmadd_pd  (row3, _mm512_permutex_pd(mat01, 0xff), dst01);
+        dst23 = _mm512_fmadd_pd  (row3, _mm512_permutex_pd(mat23, 0xff), dst23);
+                _mm512_storeu_pd (pd,     dst01);
+                _mm512_storeu_pd (pd + 8, dst23);
+    }
+
+    return intrin512;
+
+#else
+
+    __m256d row0, row1, row2, row3, vecd;
+
+    row0 = _mm256_loadu_pd(pb +  0);                        // Load all the matrix rows
+    row1 = _mm256_loadu_pd(pb +  4);
+    row2 = _mm256_loadu_pd(pb +  8);
+    row3 = _mm256_loadu_pd(pb + 12);
+
+    // Every row of every matrix in the array is a vector times b
+    size_t rows = n * 4;
+
+    for (size_t i = 0; i < rows; ++i, pd += 4, pa += 4) {
+        vecd = _mm256_mul_pd    (row0, _mm256_set1_pd(*(pa + 0)));
+        vecd = _mm256_fmadd_pd  (row1, _mm256_set1_pd(*(pa + 1)), vecd);
+        vecd = _mm256_fmadd_pd  (row2, _mm256_set1_pd(*(pa + 2)), vecd);
+        vecd = _mm256_fmadd_pd  (row3, _mm256_set1_pd(*(pa + 3)), vecd);
+               _mm256_storeu_pd (pd, vecd);
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+template <>
+inline specialized mat_x_matarr(mat<double, 4, 4> *dest,
+                                mat<double, 4, 4> &a,
+                                mat<double, 4, 4> *b,
+                                size_t            n) {
+    double *pd = dest->m[0];
+    double *pa = a.m[0];
+    double *pb = b->m[0];
+
+#if defined(__AVX512F__)
+
+    __m512d mat01, mat23, col01_0, col01_1, col01_2, col01_3,
+                          col23_0, col23_1, col23_2, col23_3,
+            row0, row1, row2, row3, dst01, dst23;
+
+    mat01   = _mm512_loadu_pd    (pa);                      // Load two rows of a
+    mat23   = _mm512_loadu_pd    (pa + 8);                  //   per register
+    col01_0 = _mm512_permutex_pd (mat01, 0x00);             // Duplicate the nth element
+    col01_1 = _mm512_permutex_pd (mat01, 0x55);             //   of each row of a
+    col01_2 = _mm512_permutex_pd (mat01, 0xaa);             //   within its half
+    col01_3 = _mm512_permutex_pd (mat01, 0xff);
+    col23_0 = _mm512_permutex_pd (mat23, 0x00);
+    col23_1 = _mm512_permutex_pd (mat23, 0x55);
+    col23_2 = _mm512_permutex_pd (mat23, 0xaa);
+    col23_3 = _mm512_permutex_pd (mat23, 0xff);
+
+    for (size_t i = 0; i < n; ++i, pd += 16, pb += 16) {
+        row0  = _mm512_broadcast_f64x4(_mm256_loadu_pd(pb +  0));   // Load each row of b
+        row1  = _mm512_broadcast_f64x4(_mm256_loadu_pd(pb +  4));   //   into both halves
+        row2  = _mm512_broadcast_f64x4(_mm256_loadu_pd(pb +  8));
+        row3  = _mm512_broadcast_f64x4(_mm256_loadu_pd(pb + 12));
+        dst01 = _mm512_mul_pd    (col01_0, row0);
+        dst23 = _mm512_mul_pd    (col23_0, row0);
+        dst01 = _mm512_fmadd_pd  (col01_1, row1, dst01);
+        dst23 = _mm512_fmadd_pd  (col23_1, row1, dst23);
+        dst01 = _mm512_fmadd_pd  (col01_2, row2, dst01);
+        dst23 = _mm512_fmadd_pd  (col23_2, row2, dst23);
+        dst01 = _mm512_fmadd_pd  (col01_3, row3, dst01);
+        dst23 = _mm512_fmadd_pd  (col23_3, row3, dst23);
+                _mm512_storeu_pd (pd,     dst01);
+                _mm512_storeu_pd (pd + 8, dst23);
+    }
+
+    return intrin512;
+
+#else
+
+    // 16 duplicated elements of a exceed the 16 AVX2 registers,
+    // the compiler will reload some of them from the stack
+    __m256d a00, a01, a02, a03, a10, a11, a12, a13,
+            a20, a21, a22, a23, a30, a31, a32, a33,
+            row0, row1, row2, row3, vecd;
+
+    a00 = _mm256_set1_pd(pa[ 0]);  a01 = _mm256_set1_pd(pa[ 1]);
+    a02 = _mm256_set1_pd(pa[ 2]);  a03 = _mm256_set1_pd(pa[ 3]);
+    a10 = _mm256_set1_pd(pa[ 4]);  a11 = _mm256_set1_pd(pa[ 5]);
+    a12 = _mm256_set1_pd(pa[ 6]);  a13 = _mm256_set1_pd(pa[ 7]);
+    a20 = _mm256_set1_pd(pa[ 8]);  a21 = _mm256_set1_pd(pa[ 9]);
+    a22 = _mm256_set1_pd(pa[10]);  a23 = _mm256_set1_pd(pa[11]);
+    a30 = _mm256_set1_pd(pa[12]);  a31 = _mm256_set1_pd(pa[13]);
+    a32 = _mm256_set1_pd(pa[14]);  a33 = _mm256_set1_pd(pa[15]);
+
+    for (size_t i = 0; i < n; ++i, pd += 16, pb += 16) {
+        row0 = _mm256_loadu_pd  (pb +  0);                  // Load all the rows of b
+        row1 = _mm256_loadu_pd  (pb +  4);
+        row2 = _mm256_loadu_pd  (pb +  8);
+        row3 = _mm256_loadu_pd  (pb + 12);
+
+        vecd = _mm256_mul_pd    (a00, row0);
+        vecd = _mm256_fmadd_pd  (a01, row1, vecd);
+        vecd = _mm256_fmadd_pd  (a02, row2, vecd);
+        vecd = _mm256_fmadd_pd  (a03, row3, vecd);
+               _mm256_storeu_pd (pd, vecd);
+
+        vecd = _mm256_mul_pd    (a10, row0);
+        vecd = _mm256_fmadd_pd  (a11, row1, vecd);
+        vecd = _mm256_fmadd_pd  (a12, row2, vecd);
+        vecd = _mm256_fmadd_pd  (a13, row3, vecd);
+               _mm256_storeu_pd (pd + 4, vecd);
+
+        vecd = _mm256_mul_pd    (a20, row0);
+        vecd = _mm256_fmadd_pd  (a21, row1, vecd);
+        vecd = _mm256_fmadd_pd  (a22, row2, vecd);
+        vecd = _mm256_fmadd_pd  (a23, row3, vecd);
+               _mm256_storeu_pd (pd + 8, vecd);
+
+        vecd = _mm256_mul_pd    (a30, row0);
+        vecd = _mm256_fmadd_pd  (a31, row1, vecd);
+        vecd = _mm256_fmadd_pd  (a32, row2, vecd);
+        vecd = _mm256_fmadd_pd  (a33, row3, vecd);
+               _mm256_storeu_pd (pd + 12, vecd);
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Pairwise matrix array multiplication
+
+// Element (i,j) of the lane interleaved blocks starts at (i * 4 + j) * lanes.
+// A row of a is held in registers while it multiplies each column of b.
+
+template <>
+inline specialized matsoa_x_matsoa(matsoa<float, 4, 4> *dest,
+                                   matsoa<float, 4, 4> *a,
+                                   matsoa<float, 4, 4> *b,
+                                   size_t              blocks) {
+    const size_t lanes = matsoa<float, 4, 4>::lanes;
+
+// Compiler targeting AVX-512, 16 matrices per register
+#if defined(__AVX512F__)
+
+    __m512 row0, row1, row2, row3, vecd;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        float *pd = dest[e].m[0][0];
+        float *pa = a[e].m[0][0];
+        float *pb = b[e].m[0][0];
+
+        for (int i = 0; i < 4; ++i, pd += 4 * lanes, pa += 4 * lanes) {
+            row0 = _mm512_loadu_ps (pa + 0 * lanes);            // Load a row of a
+            row1 = _mm512_loadu_ps (pa + 1 * lanes);
+            row2 = _mm512_loadu_ps (pa + 2 * lanes);
+            row3 = _mm512_loadu_ps (pa + 3 * lanes);
+
+            for (int j = 0; j < 4; ++j) {                       // Each column of b
+                vecd = _mm512_mul_ps    (row0, _mm512_loadu_ps(pb + ( 0 + j) * lanes));
+                vecd = _mm512_fmadd_ps  (row1, _mm512_loadu_ps(pb + ( 4 + j) * lanes), vecd);
+                vecd = _mm512_fmadd_ps  (row2, _mm512_loadu_ps(pb + ( 8 + j) * lanes), vecd);
+                vecd = _mm512_fmadd_ps  (row3, _mm512_loadu_ps(pb + (12 + j) * lanes), vecd);
+                       _mm512_storeu_ps (pd + j * lanes, vecd);
+            }
+        }
+    }
+
+    return intrin512;
+
+// 8 matrices per register, two halves of a block
+#else
+
+    __m256 row0, row1, row2, row3, vecd;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 8) {
+            float *pd = dest[e].m[0][0] + h;
+            float *pa = a[e].m[0][0] + h;
+            float *pb = b[e].m[0][0] + h;
+
+            for (int i = 0; i < 4; ++i, pd += 4 * lanes, pa += 4 * lanes) {
+                row0 = _mm256_loadu_ps (pa + 0 * lanes);        // Load a row of a
+                row1 = _mm256_loadu_ps (pa + 1 * lanes);
+                row2 = _mm256_loadu_ps (pa + 2 * lanes);
+                row3 = _mm256_loadu_ps (pa + 3 * lanes);
+
+                for (int j = 0; j < 4; ++j) {                   // Each column of b
+                    vecd = _mm256_mul_ps    (row0, _mm256_loadu_ps(pb + ( 0 + j) * lanes));
+                    vecd = _mm256_fmadd_ps  (row1, _mm256_loadu_ps(pb + ( 4 + j) * lanes), vecd);
+                    vecd = _mm256_fmadd_ps  (row2, _mm256_loadu_ps(pb + ( 8 + j) * lanes), vecd);
+                    vecd = _mm256_fmadd_ps  (row3, _mm256_loadu_ps(pb + (12 + j) * lanes), vecd);
+                           _mm256_storeu_ps (pd + j * lanes, vecd);
+                }
+            }
+        }
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+template <>
+inline specialized matsoa_x_matsoa(matsoa<double, 4, 4> *dest,
+                                   matsoa<double, 4, 4> *a,
+                                   matsoa<double, 4, 4> *b,
+                                   size_t               blocks) {
+    const size_t lanes = matsoa<double, 4, 4>::lanes;
+
+// Compiler targeting AVX-512, 8 matrices per register
+#if defined(__AVX512F__)
+
+    __m512d row0, row1, row2, row3, vecd;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        double *pd = dest[e].m[0][0];
+        double *pa = a[e].m[0][0];
+        double *pb = b[e].m[0][0];
+
+        for (int i = 0; i < 4; ++i, pd += 4 * lanes, pa += 4 * lanes) {
+            row0 = _mm512_loadu_pd (pa + 0 * lanes);            // Load a row of a
+            row1 = _mm512_loadu_pd (pa + 1 * lanes);
+            row2 = _mm512_loadu_pd (pa + 2 * lanes);
+            row3 = _mm512_loadu_pd (pa + 3 * lanes);
+
+            for (int j = 0; j < 4; ++j) {                       // Each column of b
+                vecd = _mm512_mul_pd    (row0, _mm512_loadu_pd(pb + ( 0 + j) * lanes));
+                vecd = _mm512_fmadd_pd  (row1, _mm512_loadu_pd(pb + ( 4 + j) * lanes), vecd);
+                vecd = _mm512_fmadd_pd  (row2, _mm512_loadu_pd(pb + ( 8 + j) * lanes), vecd);
+                vecd = _mm512_fmadd_pd  (row3, _mm512_loadu_pd(pb + (12 + j) * lanes), vecd);
+                       _mm512_storeu_pd (pd + j * lanes, vecd);
+            }
+        }
+    }
+
+    return intrin512;
+
+// 4 matrices per register, two halves of a block
+#else
+
+    __m256d row0, row1, row2, row3, vecd;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 4) {
+            double *pd = dest[e].m[0][0] + h;
+            double *pa = a[e].m[0][0] + h;
+            double *pb = b[e].m[0][0] + h;
+
+            for (int i = 0; i < 4; ++i, pd += 4 * lanes, pa += 4 * lanes) {
+                row0 = _mm256_loadu_pd (pa + 0 * lanes);        // Load a row of a
+                row1 = _mm256_loadu_pd (pa + 1 * lanes);
+                row2 = _mm256_loadu_pd (pa + 2 * lanes);
+                row3 = _mm256_loadu_pd (pa + 3 * lanes);
+
+                for (int j = 0; j < 4; ++j) {                   // Each column of b
+                    vecd = _mm256_mul_pd    (row0, _mm256_loadu_pd(pb + ( 0 + j) * lanes));
+                    vecd = _mm256_fmadd_pd  (row1, _mm256_loadu_pd(pb + ( 4 + j) * lanes), vecd);
+                    vecd = _mm256_fmadd_pd  (row2, _mm256_loadu_pd(pb + ( 8 + j) * lanes), vecd);
+                    vecd = _mm256_fmadd_pd  (row3, _mm256_loadu_pd(pb + (12 + j) * lanes), vecd);
+                           _mm256_storeu_pd (pd + j * lanes, vecd);
+                }
+            }
+        }
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix inverse and determinant
+
+// The columns of a are held in registers, and the columns with the upper
+// and lower pairs of rows swapped, rev = [ a1k, a0k, a3k, a2k ].
+// col(i) * rev(j) - rev(i) * col(j) then holds the 2x2 sub-determinants
+// of columns i and j as [ s, -s, c, -c ], s from rows 0 and 1, c from
+// rows 2 and 3. Swapping its halves gives the cofactor signs needed to
+// build each row of the adjugate from three of the rev columns.
+// The determinant is row 0 of the adjugate times column 0 of a.
+
+template <>
+inline specialized determinant(float &dest, mat<float, 4, 4> &a) {
+    __m128 col0, col1, col2, col3, rev1, rev2, rev3,
+           sub3, sub4, sub5, vecd;
+    float *pa = a.m[0];
+
+    col0 = _mm_loadu_ps     (pa +  0);                      // Load the rows
+    col1 = _mm_loadu_ps     (pa +  4);
+    col2 = _mm_loadu_ps     (pa +  8);
+    col3 = _mm_loadu_ps     (pa + 12);
+    _MM_TRANSPOSE4_PS       (col0, col1, col2, col3);       // Rows to columns
+
+    rev1 = _mm_shuffle_ps   (col1, col1, 0xb1);             // Swap pairs of rows
+    rev2 = _mm_shuffle_ps   (col2, col2, 0xb1);
+    rev3 = _mm_shuffle_ps   (col3, col3, 0xb1);
+
+    sub3 = _mm_fmsub_ps     (col1, rev2, _mm_mul_ps(rev1, col2));   // Columns 1 2
+    sub4 = _mm_fmsub_ps     (col1, rev3, _mm_mul_ps(rev1, col3));   // Columns 1 3
+    sub5 = _mm_fmsub_ps     (col2, rev3, _mm_mul_ps(rev2, col3));   // Columns 2 3
+    sub3 = _mm_shuffle_ps   (sub3, sub3, 0x4e);             // Swap halves
+    sub4 = _mm_shuffle_ps   (sub4, sub4, 0x4e);
+    sub5 = _mm_shuffle_ps   (sub5, sub5, 0x4e);
+
+    vecd = _mm_mul_ps       (rev1, sub5);                   // Row 0 of the adjugate
+    vecd = _mm_fnmadd_ps    (rev2, sub4, vecd);
+    vecd = _mm_fmadd_ps     (rev3, sub3, vecd);
+    vecd = _mm_mul_ps       (vecd, col0);                   // Sum of the products
+    vecd = _mm_hadd_ps      (vecd, vecd);
+    vecd = _mm_hadd_ps      (vecd, vecd);
+    dest = _mm_cvtss_f32    (vecd);
+
+    return intrin;
+}
+
+template <>
+inline specialized determinant(double &dest, mat<double, 4, 4> &a) {
+    __m256d col0, col1, col2, col3, rev1, rev2, rev3,
+            sub3, sub4, sub5, vecd;
+    double *pa = a.m[0];
+
+    col0 = _mm256_loadu_pd      (pa +  0);                  // Load the rows
+    rev1 = _mm256_loadu_pd      (pa +  4);
+    rev2 = _mm256_loadu_pd      (pa +  8);
+    rev3 = _mm256_loadu_pd      (pa + 12);
+    sub3 = _mm256_unpacklo_pd   (col0, rev1);               // Rows to columns
+    sub4 = _mm256_unpackhi_pd   (col0, rev1);
+    sub5 = _mm256_unpacklo_pd   (rev2, rev3);
+    vecd = _mm256_unpackhi_pd   (rev2, rev3);
+    col0 = _mm256_permute2f128_pd (sub3, sub5, 0x20);
+    col1 = _mm256_permute2f128_pd (sub4, vecd, 0x20);
+    col2 = _mm256_permute2f128_pd (sub3, sub5, 0x31);
+    col3 = _mm256_permute2f128_pd (sub4, vecd, 0x31);
+
+    rev1 = _mm256_permute_pd    (col1, 0x5);                // Swap pairs of rows
+    rev2 = _mm256_permute_pd    (col2, 0x5);
+    rev3 = _mm256_permute_pd    (col3, 0x5);
+
+    sub3 = _mm256_fmsub_pd      (col1, rev2, _mm256_mul_pd(rev1, col2));    // Columns 1 2
+    sub4 = _mm256_fmsub_pd      (col1, rev3, _mm256_mul_pd(rev1, col3));    // Columns 1 3
+    sub5 = _mm256_fmsub_pd      (col2, rev3, _mm256_mul_pd(rev2, col3));    // Columns 2 3
+    sub3 = _mm256_permute2f128_pd (sub3, sub3, 0x01);       // Swap halves
+    sub4 = _mm256_permute2f128_pd (sub4, sub4, 0x01);
+    sub5 = _mm256_permute2f128_pd (sub5, sub5, 0x01);
+
+    vecd = _mm256_mul_pd        (rev1, sub5);               // Row 0 of the adjugate
+    vecd = _mm256_fnmadd_pd     (rev2, sub4, vecd);
+    vecd = _mm256_fmadd_pd      (rev3, sub3, vecd);
+    vecd = _mm256_mul_pd        (vecd, col0);               // Sum of the products
+    vecd = _mm256_hadd_pd       (vecd, vecd);
+    vecd = _mm256_add_pd        (vecd, _mm256_permute2f128_pd(vecd, vecd, 0x01));
+    dest = _mm256_cvtsd_f64     (vecd);
+
+    return intrin;
+}
+
+template <>
+inline specialized inverse(mat<float, 4, 4> &dest, mat<float, 4, 4> &a) {
+    __m128 col0, col1, col2, col3, rev0, rev1, rev2, rev3,
+           sub0, sub1, sub2, sub3, sub4, sub5, row0, row1, row2, row3, vecd;
+    float *pd = dest.m[0];
+    float *pa = a.m[0];
+
+    col0 = _mm_loadu_ps     (pa +  0);                      // Load the rows
+    col1 = _mm_loadu_ps     (pa +  4);
+    col2 = _mm_loadu_ps     (pa +  8);
+    col3 = _mm_loadu_ps     (pa + 12);
+    _MM_TRANSPOSE4_PS       (col0, col1, col2, col3);       // Rows to columns
+
+    rev0 = _mm_shuffle_ps   (col0, col0, 0xb1);             // Swap pairs of rows
+    rev1 = _mm_shuffle_ps   (col1, col1, 0xb1);
+    rev2 = _mm_shuffle_ps   (col2, col2, 0xb1);
+    rev3 = _mm_shuffle_ps   (col3, col3, 0xb1);
+
+    sub0 = _mm_fmsub_ps     (col0, rev1, _mm_mul_ps(rev0, col1));   // Columns 0 1
+    sub1 = _mm_fmsub_ps     (col0, rev2, _mm_mul_ps(rev0, col2));   // Columns 0 2
+    sub2 = _mm_fmsub_ps     (col0, rev3, _mm_mul_ps(rev0, col3));   // Columns 0 3
+    sub3 = _mm_fmsub_ps     (col1, rev2, _mm_mul_ps(rev1, col2));   // Columns 1 2
+    sub4 = _mm_fmsub_ps     (col1, rev3, _mm_mul_ps(rev1, col3));   // Columns 1 3
+    sub5 = _mm_fmsub_ps     (col2, rev3, _mm_mul_ps(rev2, col3));   // Columns 2 3
+    sub0 = _mm_shuffle_ps   (sub0, sub0, 0x4e);             // Swap halves
+    sub1 = _mm_shuffle_ps   (sub1, sub1, 0x4e);
+    sub2 = _mm_shuffle_ps   (sub2, sub2, 0x4e);
+    sub3 = _mm_shuffle_ps   (sub3, sub3, 0x4e);
+    sub4 = _mm_shuffle_ps   (sub4, sub4, 0x4e);
+    sub5 = _mm_shuffle_ps   (sub5, sub5, 0x4e);
+
+    row0 = _mm_mul_ps       (rev1, sub5);                   // Rows of the adjugate
+    row0 = _mm_fnmadd_ps    (rev2, sub4, row0);
+    row0 = _mm_fmadd_ps     (rev3, sub3, row0);
+    row1 = _mm_mul_ps       (rev2, sub2);
+    row1 = _mm_fnmadd_ps    (rev0, sub5, row1);
+    row1 = _mm_fnmadd_ps    (rev3, sub1, row1);
+    row2 = _mm_mul_ps       (rev0, sub4);
+    row2 = _mm_fnmadd_ps    (rev1, sub2, row2);
+    row2 = _mm_fmadd_ps     (rev3, sub0, row2);
+    row3 = _mm_mul_ps       (rev1, sub1);
+    row3 = _mm_fnmadd_ps    (rev0, sub3, row3);
+    row3 = _mm_fnmadd_ps    (rev2, sub0, row3);
+
+    vecd = _mm_mul_ps       (row0, col0);                   // Determinant in every element
+    vecd = _mm_hadd_ps      (vecd, vecd);
+    vecd = _mm_hadd_ps      (vecd, vecd);
+    vecd = _mm_div_ps       (_mm_set1_ps(1.0f), vecd);      // Reciprocal
+
+           _mm_storeu_ps    (pd +  0, _mm_mul_ps(row0, vecd));
+           _mm_storeu_ps    (pd +  4, _mm_mul_ps(row1, vecd));
+           _mm_storeu_ps    (pd +  8, _mm_mul_ps(row2, vecd));
+           _mm_storeu_ps    (pd + 12, _mm_mul_ps(row3, vecd));
+
+    return intrin;
+}
+
+template <>
+inline specialized inverse(mat<double, 4, 4> &dest, mat<double, 4, 4> &a) {
+    __m256d col0, col1, col2, col3, rev0, rev1, rev2, rev3,
+            sub0, sub1, sub2, sub3, sub4, sub5, row0, row1, row2, row3, vecd;
+    double *pd = dest.m[0];
+    double *pa = a.m[0];
+
+    rev0 = _mm256_loadu_pd      (pa +  0);                  // Load the rows
+    rev1 = _mm256_loadu_pd      (pa +  4);
+    rev2 = _mm256_loadu_pd      (pa +  8);
+    rev3 = _mm256_loadu_pd      (pa + 12);
+    row0 = _mm256_unpacklo_pd   (rev0, rev1);               // Rows to columns
+    row1 = _mm256_unpackhi_pd   (rev0, rev1);
+    row2 = _mm256_unpacklo_pd   (rev2, rev3);
+    row3 = _mm256_unpackhi_pd   (rev2, rev3);
+    col0 = _mm256_permute2f128_pd (row0, row2, 0x20);
+    col1 = _mm256_permute2f128_pd (row1, row3, 0x20);
+    col2 = _mm256_permute2f128_pd (row0, row2, 0x31);
+    col3 = _mm256_permute2f128_pd (row1, row3, 0x31);
+
+    rev0 = _mm256_permute_pd    (col0, 0x5);                // Swap pairs of rows
+    rev1 = _mm256_permute_pd    (col1, 0x5);
+    rev2 = _mm256_permute_pd    (col2, 0x5);
+    rev3 = _mm256_permute_pd    (col3, 0x5);
+
+    sub0 = _mm256_fmsub_pd      (col0, rev1, _mm256_mul_pd(rev0, col1));    // Columns 0 1
+    sub1 = _mm256_fmsub_pd      (col0, rev2, _mm256_mul_pd(rev0, col2));    // Columns 0 2
+    sub2 = _mm256_fmsub_pd      (col0, rev3, _mm256_mul_pd(rev0, col3));    // Columns 0 3
+    sub3 = _mm256_fmsub_pd      (col1, rev2, _mm256_mul_pd(rev1, col2));    // Columns 1 2
+    sub4 = _mm256_fmsub_pd      (col1, rev3, _mm256_mul_pd(rev1, col3));    // Columns 1 3
+    sub5 = _mm256_fmsub_pd      (col2, rev3, _mm256_mul_pd(rev2, col3));    // Columns 2 3
+    sub0 = _mm256_permute2f128_pd (sub0, sub0, 0x01);       // Swap halves
+    sub1 = _mm256_permute2f128_pd (sub1, sub1, 0x01);
+    sub2 = _mm256_permute2f128_pd (sub2, sub2, 0x01);
+    sub3 = _mm256_permute2f128_pd (sub3, sub3, 0x01);
+    sub4 = _mm256_permute2f128_pd (sub4, sub4, 0x01);
+    sub5 = _mm256_permute2f128_pd (sub5, sub5, 0x01);
+
+    row0 = _mm256_mul_pd        (rev1, sub5);               // Rows of the adjugate
+    row0 = _mm256_fnmadd_pd     (rev2, sub4, row0);
+    row0 = _mm256_fmadd_pd      (rev3, sub3, row0);
+    row1 = _mm256_mul_pd        (rev2, sub2);
+    row1 = _mm256_fnmadd_pd     (rev0, sub5, row1);
+    row1 = _mm256_fnmadd_pd     (rev3, sub1, row1);
+    row2 = _mm256_mul_pd        (rev0, sub4);
+    row2 = _mm256_fnmadd_pd     (rev1, sub2, row2);
+    row2 = _mm256_fmadd_pd      (rev3, sub0, row2);
+    row3 = _mm256_mul_pd        (rev1, sub1);
+    row3 = _mm256_fnmadd_pd     (rev0, sub3, row3);
+    row3 = _mm256_fnmadd_pd     (rev2, sub0, row3);
+
+    vecd = _mm256_mul_pd        (row0, col0);               // Determinant in every element
+    vecd = _mm256_hadd_pd       (vecd, vecd);
+    vecd = _mm256_add_pd        (vecd, _mm256_permute2f128_pd(vecd, vecd, 0x01));
+    vecd = _mm256_div_pd        (_mm256_set1_pd(1.0), vecd);    // Reciprocal
+
+           _mm256_storeu_pd     (pd +  0, _mm256_mul_pd(row0, vecd));
+           _mm256_storeu_pd     (pd +  4, _mm256_mul_pd(row1, vecd));
+           _mm256_storeu_pd     (pd +  8, _mm256_mul_pd(row2, vecd));
+           _mm256_storeu_pd     (pd + 12, _mm256_mul_pd(row3, vecd));
+
+    return intrin;
+}
+
+// Transposing with a zero'd 4th row leaves the rotation transposed
+// and the 4th column zero'd. The translation row is built from those.
+
+template <>
+inline specialized rigid_inverse(mat<float, 4, 4> &dest, mat<float, 4, 4> &a) {
+    __m128 col0, col1, col2, col3, vecd;
+    float *pd = dest.m[0];
+    float *pa = a.m[0];
+
+    col0 = _mm_loadu_ps     (pa +  0);                      // Load the rotation rows
+    col1 = _mm_loadu_ps     (pa +  4);
+    col2 = _mm_loadu_ps     (pa +  8);
+    col3 = _mm_setzero_ps   ();
+    _MM_TRANSPOSE4_PS       (col0, col1, col2, col3);       // Transpose the rotation
+
+    vecd = _mm_set_ps       (1.0f, 0.0f, 0.0f, 0.0f);       // -t * T(R), last element 1
+    vecd = _mm_fnmadd_ps    (_mm_broadcast_ss(pa + 12), col0, vecd);
+    vecd = _mm_fnmadd_ps    (_mm_broadcast_ss(pa + 13), col1, vecd);
+    vecd = _mm_fnmadd_ps    (_mm_broadcast_ss(pa + 14), col2, vecd);
+
+           _mm_storeu_ps    (pd +  0, col0);
+           _mm_storeu_ps    (pd +  4, col1);
+           _mm_storeu_ps    (pd +  8, col2);
+           _mm_storeu_ps    (pd + 12, vecd);
+
+    return intrin;
+}
+
+template <>
+inline specialized rigid_inverse(mat<double, 4, 4> &dest, mat<double, 4, 4> &a) {
+    __m256d row0, row1, row2, col0, col1, col2, vecd;
+    double *pd = dest.m[0];
+    double *pa = a.m[0];
+
+    row0 = _mm256_loadu_pd      (pa +  0);                  // Load the rotation rows
+    row1 = _mm256_loadu_pd      (pa +  4);
+    row2 = _mm256_loadu_pd      (pa +  8);
+    vecd = _mm256_setzero_pd    ();
+    col0 = _mm256_unpacklo_pd   (row0, row1);               // Transpose the rotation
+    col1 = _mm256_unpackhi_pd   (row0, row1);
+    col2 = _mm256_unpacklo_pd   (row2, vecd);
+    vecd = _mm256_unpackhi_pd   (row2, vecd);
+    row0 = _mm256_permute2f128_pd (col0, col2, 0x20);
+    row1 = _mm256_permute2f128_pd (col1, vecd, 0x20);
+    row2 = _mm256_permute2f128_pd (col0, col2, 0x31);
+
+    vecd = _mm256_set_pd        (1.0, 0.0, 0.0, 0.0);       // -t * T(R), last element 1
+    vecd = _mm256_fnmadd_pd     (_mm256_broadcast_sd(pa + 12), row0, vecd);
+    vecd = _mm256_fnmadd_pd     (_mm256_broadcast_sd(pa + 13), row1, vecd);
+    vecd = _mm256_fnmadd_pd     (_mm256_broadcast_sd(pa + 14), row2, vecd);
+
+           _mm256_storeu_pd     (pd +  0, row0);
+           _mm256_storeu_pd     (pd +  4, row1);
+           _mm256_storeu_pd     (pd +  8, row2);
+           _mm256_storeu_pd     (pd + 12, vecd);
+
+    return intrin;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix transpose
+
+template <>
+constexpr specialized transpose(mat<float, 4, 4> &dest, mat<float, 4, 4> &a) {
+    if (std::is_constant_evaluated()) {
+        return looped_transpose(dest, a);
+    }
+
+    float *pd = dest.m[0];
+    float *pa = a.m[0];
+
+// Compiler targeting AVX-512, whole matrix in a register
+#if defined(__AVX512F__)
+
+    __m512i idx  = _mm512_setr_epi32 (0, 4,  8, 12, 1, 5,  9, 13,
+                                      2, 6, 10, 14, 3, 7, 11, 15);
+    __m512  vecd = _mm512_permutexvar_ps (idx, _mm512_loadu_ps(pa));
+                   _mm512_storeu_ps      (pd, vecd);
+
+    return intrin512;
+
+#else
+
+    __m128 row0, row1, row2, row3;
+
+    row0 = _mm_loadu_ps     (pa +  0);                      // Load all the matrix rows
+    row1 = _mm_loadu_ps     (pa +  4);
+    row2 = _mm_loadu_ps     (pa +  8);
+    row3 = _mm_loadu_ps     (pa + 12);
+    _MM_TRANSPOSE4_PS       (row0, row1, row2, row3);       // Unpack and move halves
+           _mm_storeu_ps    (pd +  0, row0);
+           _mm_storeu_ps    (pd +  4, row1);
+           _mm_storeu_ps    (pd +  8, row2);
+           _mm_storeu_ps    (pd + 12, row3);
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+template <>
+constexpr specialized transpose(mat<double, 4, 4> &dest, mat<double, 4, 4> &a) {
+    if (std::is_constant_evaluated()) {
+        return looped_transpose(dest, a);
+    }
+
+    double *pd = dest.m[0];
+    double *pa = a.m[0];
+
+// Compiler targeting AVX-512, two rows per register
+#if defined(__AVX512F__)
+
+    __m512i idx0 = _mm512_setr_epi64 (0, 4,  8, 12, 1, 5,  9, 13);
+    __m512i idx1 = _mm512_setr_epi64 (2, 6, 10, 14, 3, 7, 11, 15);
+    __m512d lo   = _mm512_loadu_pd   (pa + 0);
+    __m512d hi   = _mm512_loadu_pd   (pa + 8);
+                   _mm512_storeu_pd  (pd + 0, _mm512_permutex2var_pd(lo, idx0, hi));
+                   _mm512_storeu_pd  (pd + 8, _mm512_permutex2var_pd(lo, idx1, hi));
+
+    return intrin512;
+
+#else
+
+    __m256d row0, row1, row2, row3, tmp0, tmp1, tmp2, tmp3;
+
+    row0 = _mm256_loadu_pd      (pa +  0);                  // Load all the matrix rows
+    row1 = _mm256_loadu_pd      (pa +  4);
+    row2 = _mm256_loadu_pd      (pa +  8);
+    row3 = _mm256_loadu_pd      (pa + 12);
+    tmp0 = _mm256_unpacklo_pd   (row0, row1);               // Pairs within 128-bit lanes
+    tmp1 = _mm256_unpackhi_pd   (row0, row1);
+    tmp2 = _mm256_unpacklo_pd   (row2, row3);
+    tmp3 = _mm256_unpackhi_pd   (row2, row3);
+           _mm256_storeu_pd     (pd +  0, _mm256_permute2f128_pd(tmp0, tmp2, 0x20));
+           _mm256_storeu_pd     (pd +  4, _mm256_permute2f128_pd(tmp1, tmp3, 0x20));
+           _mm256_storeu_pd     (pd +  8, _mm256_permute2f128_pd(tmp0, tmp2, 0x31));
+           _mm256_storeu_pd     (pd + 12, _mm256_permute2f128_pd(tmp1, tmp3, 0x31));
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+template <>
+inline specialized matarr_transpose(mat<float, 4, 4> *dest,
+                                    mat<float, 4, 4> *a,
+                                    size_t           n) {
+
+// Compiler targeting AVX-512, one matrix per register
+#if defined(__AVX512F__)
+
+    __m512i idx = _mm512_setr_epi32 (0, 4,  8, 12, 1, 5,  9, 13,
+                                     2, 6, 10, 14, 3, 7, 11, 15);
+
+    for (size_t e = 0; e < n; ++e) {
+        _mm512_storeu_ps (dest[e].m[0], _mm512_permutexvar_ps(idx, _mm512_loadu_ps(a[e].m[0])));
+    }
+
+    return intrin512;
+
+// Two matrices at a time, one in each 128-bit lane.
+// Unpack and shuffle work within lanes, as _MM_TRANSPOSE4_PS.
+#elif defined(INTRIN256)
+
+    __m256 row0, row1, row2, row3, tmp0, tmp1, tmp2, tmp3;
+    size_t e = 0;
+
+    for (; e + 1 < n; e += 2) {
+        float *pd = dest[e].m[0];
+        float *pa = a[e].m[0];
+
+        row0 = _mm256_insertf128_ps (_mm256_castps128_ps256(_mm_loadu_ps(pa +  0)),
+                                     _mm_loadu_ps(pa + 16), 1);
+        row1 = _mm256_insertf128_ps (_mm256_castps128_ps256(_mm_loadu_ps(pa +  4)),
+                                     _mm_loadu_ps(pa + 20), 1);
+        row2 = _mm256_insertf128_ps (_mm256_castps128_ps256(_mm_loadu_ps(pa +  8)),
+                                     _mm_loadu_ps(pa + 24), 1);
+        row3 = _mm256_insertf128_ps (_mm256_castps128_ps256(_mm_loadu_ps(pa + 12)),
+                                     _mm_loadu_ps(pa + 28), 1);
+
+        tmp0 = _mm256_unpacklo_ps   (row0, row1);
+        tmp1 = _mm256_unpackhi_ps   (row0, row1);
+        tmp2 = _mm256_unpacklo_ps   (row2, row3);
+        tmp3 = _mm256_unpackhi_ps   (row2, row3);
+        row0 = _mm256_shuffle_ps    (tmp0, tmp2, 0x44);
+        row1 = _mm256_shuffle_ps    (tmp0, tmp2, 0xee);
+        row2 = _mm256_shuffle_ps    (tmp1, tmp3, 0x44);
+        row3 = _mm256_shuffle_ps    (tmp1, tmp3, 0xee);
+
+               _mm_storeu_ps        (pd +  0, _mm256_castps256_ps128(row0));
+               _mm_storeu_ps        (pd +  4, _mm256_castps256_ps128(row1));
+               _mm_storeu_ps        (pd +  8, _mm256_castps256_ps128(row2));
+               _mm_storeu_ps        (pd + 12, _mm256_castps256_ps128(row3));
+               _mm_storeu_ps        (pd + 16, _mm256_extractf128_ps(row0, 1));
+               _mm_storeu_ps        (pd + 20, _mm256_extractf128_ps(row1, 1));
+               _mm_storeu_ps        (pd + 24, _mm256_extractf128_ps(row2, 1));
+               _mm_storeu_ps        (pd + 28, _mm256_extractf128_ps(row3, 1));
+    }
+
+    // Odd matrix
+    if (e < n) {
+        transpose(dest[e], a[e]);
+    }
+
+    return intrin256;
+
+#else
+
+    for (size_t e = 0; e < n; ++e) {
+        transpose(dest[e], a[e]);
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__ INTRIN256
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Normal transformation
+
+// Rows of the normal matrix padded with zero, so the 4th element is zero'd.
+// Float normalization uses the approximate reciprocal square root refined
+// with one Newton-Raphson step, y = y * (1.5 - 0.5 * x * y * y).
+
+template <>
+inline specialized normarr_x_mat(vec<float, 4>    *dest,
+                                 vec<float, 4>    *v,
+                                 mat<float, 4, 4> &m,
+                                 size_t           n,
+                                 bool             normalize) {
+    mat<float, 3, 3> nm;
+    __m128 row0, row1, row2, half, three, vecd, vecs, vecy;
+
+    normal_matrix(nm, m);
+    row0  = _mm_setr_ps     (nm.m[0][0], nm.m[0][1], nm.m[0][2], 0.0f);
+    row1  = _mm_setr_ps     (nm.m[1][0], nm.m[1][1], nm.m[1][2], 0.0f);
+    row2  = _mm_setr_ps     (nm.m[2][0], nm.m[2][1], nm.m[2][2], 0.0f);
+    half  = _mm_set1_ps     (0.5f);
+    three = _mm_set1_ps     (1.5f);
+
+    for (size_t e = 0; e < n; ++e) {
+        float *pd = dest[e].v;
+        float *pv = v[e].v;
+
+        vecd = _mm_mul_ps       (row0, _mm_broadcast_ss(pv + 0));
+        vecd = _mm_fmadd_ps     (row1, _mm_broadcast_ss(pv + 1), vecd);
+        vecd = _mm_fmadd_ps     (row2, _mm_broadcast_ss(pv + 2), vecd);
+
+        if (normalize) {
+            vecs = _mm_dp_ps    (vecd, vecd, 0x7f);             // Squared length in every element
+            vecy = _mm_rsqrt_ps (vecs);                         // Approximation
+            vecs = _mm_mul_ps   (_mm_mul_ps(vecs, half), _mm_mul_ps(vecy, vecy));
+            vecy = _mm_mul_ps   (vecy, _mm_sub_ps(three, vecs));    // Newton-Raphson step
+            vecd = _mm_mul_ps   (vecd, vecy);
+        }
+
+               _mm_storeu_ps    (pd, vecd);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized normarr_x_mat(vec<double, 4>    *dest,
+                                 vec<double, 4>    *v,
+                                 mat<double, 4, 4> &m,
+                                 size_t            n,
+                                 bool              normalize) {
+    mat<double, 3, 3> nm;
+    __m256d row0, row1, row2, vecd, vecs;
+    __m128d one, sum;
+
+    normal_matrix(nm, m);
+    row0 = _mm256_setr_pd (nm.m[0][0], nm.m[0][1], nm.m[0][2], 0.0);
+    row1 = _mm256_setr_pd (nm.m[1][0], nm.m[1][1], nm.m[1][2], 0.0);
+    row2 = _mm256_setr_pd (nm.m[2][0], nm.m[2][1], nm.m[2][2], 0.0);
+    one  = _mm_set_sd     (1.0);
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pd = dest[e].v;
+        double *pv = v[e].v;
+
+        vecd = _mm256_mul_pd        (row0, _mm256_broadcast_sd(pv + 0));
+        vecd = _mm256_fmadd_pd      (row1, _mm256_broadcast_sd(pv + 1), vecd);
+        vecd = _mm256_fmadd_pd      (row2, _mm256_broadcast_sd(pv + 2), vecd);
+
+        if (normalize) {
+            vecs = _mm256_mul_pd    (vecd, vecd);               // Squared length
+            vecs = _mm256_hadd_pd   (vecs, vecs);
+            sum  = _mm_add_pd       (_mm256_castpd256_pd128(vecs), _mm256_extractf128_pd(vecs, 1));
+            sum  = _mm_div_sd       (one, _mm_sqrt_sd(sum, sum));   // Scalar reciprocal
+            vecd = _mm256_mul_pd    (vecd, _mm256_broadcastsd_pd(sum));
+        }
+
+               _mm256_storeu_pd     (pd, vecd);
+    }
+
+    return intrin;
+}
+
+// 3 element vectors are padded to 4 elements, the memory layout is the same
+
+template <>
+inline specialized normarr_x_mat(vec<float, 3>    *dest,
+                                 vec<float, 3>    *v,
+                                 mat<float, 4, 4> &m,
+                                 size_t           n,
+                                 bool             normalize) {
+    return normarr_x_mat((vec<float, 4> *) dest, (vec<float, 4> *) v, m, n, normalize);
+}
+
+template <>
+inline specialized normarr_x_mat(vec<double, 3>    *dest,
+                                 vec<double, 3>    *v,
+                                 mat<double, 4, 4> &m,
+                                 size_t            n,
+                                 bool              normalize) {
+    return normarr_x_mat((vec<double, 4> *) dest, (vec<double, 4> *) v, m, n, normalize);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Projection and perspective divide
+
+// Reciprocal approximations are refined with Newton-Raphson, r = r * (2 - w * r).
+// The w element of each vector is replaced by 1/w before the viewport.
+
+template <>
+inline specialized projarr_x_mat(vec<float, 4>    *dest,
+                                 vec<float, 4>    *v,
+                                 mat<float, 4, 4> &m,
+                                 vec<float, 4>    &scale,
+                                 vec<float, 4>    &offset,
+                                 size_t           n,
+                                 bool             approx,
+                                 unsigned char    *clip) {
+    float *pd = dest[0].v;
+    float *pv = v[0].v;
+    float *pm = m.m[0];
+
+// Compiler targeting AVX-512, 4 vectors per register.
+// The last vectors use masked loads and stores.
+#if defined(__AVX512F__)
+
+    __m512    row0, row1, row2, row3, vecs, veco, one, two, vecv, vecd, vecw, vecr;
+    __mmask16 mask, le;
+
+    row0 = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm +  0));  // Rows in each 128-bit lane
+    row1 = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm +  4));
+    row2 = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm +  8));
+    row3 = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm + 12));
+    vecs = _mm512_broadcast_f32x4 (_mm_loadu_ps(scale.v));
+    veco = _mm512_broadcast_f32x4 (_mm_loadu_ps(offset.v));
+    one  = _mm512_set1_ps         (1.0f);
+    two  = _mm512_set1_ps         (2.0f);
+
+    for (size_t e = 0; e < n; e += 4, pd += 16, pv += 16) {
+        mask = (n - e >= 4) ? 0xffff : (__mmask16) ((1 << (4 * (n - e))) - 1);
+
+        vecv = _mm512_maskz_loadu_ps  (mask, pv);
+        vecd = _mm512_mul_ps          (row0, _mm512_permute_ps(vecv, 0x00));
+        vecd = _mm512_fmadd_ps        (row1, _mm512_permute_ps(vecv, 0x55), vecd);
+        vecd = _mm512_fmadd_ps        (row2, _mm512_permute_ps(vecv, 0xaa), vecd);
+        vecd = _mm512_fmadd_ps        (row3, _mm512_permute_ps(vecv, 0xff), vecd);
+        vecw = _mm512_permute_ps      (vecd, 0xff);         // Duplicate w
+
+        if (approx) {
+            vecr = _mm512_rcp14_ps    (vecw);
+            vecr = _mm512_mul_ps      (vecr, _mm512_fnmadd_ps(vecw, vecr, two));
+        } else {
+            vecr = _mm512_div_ps      (one, vecw);
+        }
+
+        vecd = _mm512_mask_blend_ps   (0x8888, _mm512_mul_ps(vecd, vecr), vecr);
+        vecd = _mm512_fmadd_ps        (vecd, vecs, veco);   // Viewport
+               _mm512_mask_storeu_ps  (pd, mask, vecd);
+
+        if (clip != nullptr) {
+            le = _mm512_mask_cmp_ps_mask (mask, vecw, _mm512_setzero_ps(), _CMP_LE_OQ);
+            for (size_t k = 0; k < 4 && e + k < n; ++k) {
+                clip[e + k] = (le >> (4 * k + 3)) & 1;
+            }
+        }
+    }
+
+    return intrin512;
+
+#else
+
+    __m128 row0, row1, row2, row3, vecs, veco, one, two, vecv, vecd, vecw, vecr;
+    size_t e = 0;
+
+    row0 = _mm_loadu_ps (pm +  0);                          // Load all the matrix rows
+    row1 = _mm_loadu_ps (pm +  4);
+    row2 = _mm_loadu_ps (pm +  8);
+    row3 = _mm_loadu_ps (pm + 12);
+    vecs = _mm_loadu_ps (scale.v);
+    veco = _mm_loadu_ps (offset.v);
+    one  = _mm_set1_ps  (1.0f);
+    two  = _mm_set1_ps  (2.0f);
+
+// Two vectors at a time, one in each 128-bit lane
+#if defined(INTRIN256)
+
+    __m256 row0x2, row1x2, row2x2, row3x2, vecsx2, vecox2, onex2, twox2,
+           vecvx2, vecdx2, vecwx2, vecrx2;
+
+    row0x2 = _mm256_set_m128 (row0, row0);
+    row1x2 = _mm256_set_m128 (row1, row1);
+    row2x2 = _mm256_set_m128 (row2, row2);
+    row3x2 = _mm256_set_m128 (row3, row3);
+    vecsx2 = _mm256_set_m128 (vecs, vecs);
+    vecox2 = _mm256_set_m128 (veco, veco);
+    onex2  = _mm256_set1_ps  (1.0f);
+    twox2  = _mm256_set1_ps  (2.0f);
+
+    for (; e + 1 < n; e += 2, pd += 8, pv += 8) {
+        vecvx2 = _mm256_loadu_ps      (pv);
+        vecdx2 = _mm256_mul_ps        (row0x2, _mm256_permute_ps(vecvx2, 0x00));
+        vecdx2 = _mm256_fmadd_ps      (row1x2, _mm256_permute_ps(vecvx2, 0x55), vecdx2);
+        vecdx2 = _mm256_fmadd_ps      (row2x2, _mm256_permute_ps(vecvx2, 0xaa), vecdx2);
+        vecdx2 = _mm256_fmadd_ps      (row3x2, _mm256_permute_ps(vecvx2, 0xff), vecdx2);
+        vecwx2 = _mm256_permute_ps    (vecdx2, 0xff);       // Duplicate w
+
+        if (approx) {
+            vecrx2 = _mm256_rcp_ps    (vecwx2);
+            vecrx2 = _mm256_mul_ps    (vecrx2, _mm256_fnmadd_ps(vecwx2, vecrx2, twox2));
+        } else {
+            vecrx2 = _mm256_div_ps    (onex2, vecwx2);
+        }
+
+        vecdx2 = _mm256_blend_ps      (_mm256_mul_ps(vecdx2, vecrx2), vecrx2, 0x88);
+        vecdx2 = _mm256_fmadd_ps      (vecdx2, vecsx2, vecox2); // Viewport
+                 _mm256_storeu_ps     (pd, vecdx2);
+
+        if (clip != nullptr) {
+            int le = _mm256_movemask_ps (_mm256_cmp_ps(vecwx2, _mm256_setzero_ps(), _CMP_LE_OQ));
+            clip[e + 0] = (le >> 3) & 1;
+            clip[e + 1] = (le >> 7) & 1;
+        }
+    }
+
+#endif  // INTRIN256
+
+    // One vector at a time, or the odd vector
+    for (; e < n; ++e, pd += 4, pv += 4) {
+        vecv = _mm_loadu_ps         (pv);
+        vecd = _mm_mul_ps           (row0, _mm_permute_ps(vecv, 0x00));
+        vecd = _mm_fmadd_ps         (row1, _mm_permute_ps(vecv, 0x55), vecd);
+        vecd = _mm_fmadd_ps         (row2, _mm_permute_ps(vecv, 0xaa), vecd);
+        vecd = _mm_fmadd_ps         (row3, _mm_permute_ps(vecv, 0xff), vecd);
+        vecw = _mm_permute_ps       (vecd, 0xff);           // Duplicate w
+
+        if (approx) {
+            vecr = _mm_rcp_ps       (vecw);
+            vecr = _mm_mul_ps       (vecr, _mm_fnmadd_ps(vecw, vecr, two));
+        } else {
+            vecr = _mm_div_ps       (one, vecw);
+        }
+
+        vecd = _mm_blend_ps         (_mm_mul_ps(vecd, vecr), vecr, 0x8);
+        vecd = _mm_fmadd_ps         (vecd, vecs, veco);     // Viewport
+               _mm_storeu_ps        (pd, vecd);
+
+        if (clip != nullptr) {
+            clip[e] = _mm_comile_ss (vecw, _mm_setzero_ps());
+        }
+    }
+
+#if defined(INTRIN256)
+    return intrin256;
+#else
+    return intrin;
+#endif  // INTRIN256
+
+#endif  // __AVX512F__
+}
+
+template <>
+inline specialized projarr_x_mat(vec<double, 4>    *dest,
+                                 vec<double, 4>    *v,
+                                 mat<double, 4, 4> &m,
+                                 vec<double, 4>    &scale,
+                                 vec<double, 4>    &offset,
+                                 size_t            n,
+                                 bool              approx,
+                                 unsigned char     *clip) {
+    double *pd = dest[0].v;
+    double *pv = v[0].v;
+    double *pm = m.m[0];
+
+// Compiler targeting AVX-512, 2 vectors per register.
+// The last vector uses masked loads and stores.
+#if defined(__AVX512F__)
+
+    __m512d  row0, row1, row2, row3, vecs, veco, one, two, vecv, vecd, vecw, vecr;
+    __mmask8 mask, le;
+
+    row0 = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm +  0));  // Rows in each 256-bit lane
+    row1 = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm +  4));
+    row2 = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm +  8));
+    row3 = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm + 12));
+    vecs = _mm512_broadcast_f64x4 (_mm256_loadu_pd(scale.v));
+    veco = _mm512_broadcast_f64x4 (_mm256_loadu_pd(offset.v));
+    one  = _mm512_set1_pd         (1.0);
+    two  = _mm512_set1_pd         (2.0);
+
+    for (size_t e = 0; e < n; e += 2, pd += 8, pv += 8) {
+        mask = (n - e >= 2) ? 0xff : 0x0f;
+
+        vecv = _mm512_maskz_loadu_pd  (mask, pv);
+        vecd = _mm512_mul_pd          (row0, _mm512_permutex_pd(vecv, 0x00));
+        vecd = _mm512_fmadd_pd        (row1, _mm512_permutex_pd(vecv, 0x55), vecd);
+        vecd = _mm512_fmadd_pd        (row2, _mm512_permutex_pd(vecv, 0xaa), vecd);
+        vecd = _mm512_fmadd_pd        (row3, _mm512_permutex_pd(vecv, 0xff), vecd);
+        vecw = _mm512_permutex_pd     (vecd, 0xff);         // Duplicate w
+
+        if (approx) {                                       // 14 bits, two steps to 52
+            vecr = _mm512_rcp14_pd    (vecw);
+            vecr = _mm512_mul_pd      (vecr, _mm512_fnmadd_pd(vecw, vecr, two));
+            vecr = _mm512_mul_pd      (vecr, _mm512_fnmadd_pd(vecw, vecr, two));
+        } else {
+            vecr = _mm512_div_pd      (one, vecw);
+        }
+
+        vecd = _mm512_mask_blend_pd   (0x88, _mm512_mul_pd(vecd, vecr), vecr);
+        vecd = _mm512_fmadd_pd        (vecd, vecs, veco);   // Viewport
+               _mm512_mask_storeu_pd  (pd, mask, vecd);
+
+        if (clip != nullptr) {
+            le = _mm512_mask_cmp_pd_mask (mask, vecw, _mm512_setzero_pd(), _CMP_LE_OQ);
+            clip[e] = (le >> 3) & 1;
+            if (e + 1 < n) {
+                clip[e + 1] = (le >> 7) & 1;
+            }
+        }
+    }
+
+    return intrin512;
+
+// No double reciprocal approximation in AVX2, always divide
+#else
+
+    __m256d row0, row1, row2, row3, vecs, veco, one, vecd, vecw, vecr;
+
+    row0 = _mm256_loadu_pd (pm +  0);                       // Load all the matrix rows
+    row1 = _mm256_loadu_pd (pm +  4);
+    row2 = _mm256_loadu_pd (pm +  8);
+    row3 = _mm256_loadu_pd (pm + 12);
+    vecs = _mm256_loadu_pd (scale.v);
+    veco = _mm256_loadu_pd (offset.v);
+    one  = _mm256_set1_pd  (1.0);
+
+    for (size_t e = 0; e < n; ++e, pd += 4, pv += 4) {
+        vecd = _mm256_mul_pd        (row0, _mm256_broadcast_sd(pv + 0));
+        vecd = _mm256_fmadd_pd      (row1, _mm256_broadcast_sd(pv + 1), vecd);
+        vecd = _mm256_fmadd_pd      (row2, _mm256_broadcast_sd(pv + 2), vecd);
+        vecd = _mm256_fmadd_pd      (row3, _mm256_broadcast_sd(pv + 3), vecd);
+        vecw = _mm256_permute4x64_pd (vecd, 0xff);          // Duplicate w
+        vecr = _mm256_div_pd        (one, vecw);
+        vecd = _mm256_blend_pd      (_mm256_mul_pd(vecd, vecr), vecr, 0x8);
+        vecd = _mm256_fmadd_pd      (vecd, vecs, veco);     // Viewport
+               _mm256_storeu_pd     (pd, vecd);
+
+        if (clip != nullptr) {
+            clip[e] = _mm_comile_sd(_mm256_castpd256_pd128(vecw), _mm_setzero_pd());
+        }
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Quaternions
+
+// Quaternions are transposed to x, y, z and w registers, 8 or 4 at a time,
+// the matrix elements computed side by side, and transposed back into rows.
+// The remaining quaternions use the generic conversion.
+
+template <>
+inline specialized quatarr_to_matarr(mat<float, 4, 4> *dest, quat<float> *q, size_t n) {
+    __m256 q0, q1, q2, q3, t0, t1, t2, t3, x, y, z, w, x2, y2, z2,
+           xx, yy, zz, xy, xz, yz, xw, yw, zw, one, zero;
+    __m256 ra[3], rb[3], rc[3];
+    __m128 last;
+    size_t e;
+
+    one  = _mm256_set1_ps (1.0f);
+    zero = _mm256_setzero_ps();
+    last = _mm_setr_ps    (0.0f, 0.0f, 0.0f, 1.0f);
+
+    for (e = 0; e + 8 <= n; e += 8) {
+        float *pd = dest[e].m[0];
+        float *pq = q[e].v;
+
+        q0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pq +  0)), _mm_loadu_ps(pq + 16), 1);
+        q1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pq +  4)), _mm_loadu_ps(pq + 20), 1);
+        q2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pq +  8)), _mm_loadu_ps(pq + 24), 1);
+        q3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pq + 12)), _mm_loadu_ps(pq + 28), 1);
+
+        t0 = _mm256_unpacklo_ps (q0, q1);                   // Transpose to x, y, z, w
+        t1 = _mm256_unpackhi_ps (q0, q1);
+        t2 = _mm256_unpacklo_ps (q2, q3);
+        t3 = _mm256_unpackhi_ps (q2, q3);
+        x  = _mm256_shuffle_ps  (t0, t2, 0x44);
+        y  = _mm256_shuffle_ps  (t0, t2, 0xee);
+        z  = _mm256_shuffle_ps  (t1, t3, 0x44);
+        w  = _mm256_shuffle_ps  (t1, t3, 0xee);
+
+        x2 = _mm256_add_ps      (x, x);
+        y2 = _mm256_add_ps      (y, y);
+        z2 = _mm256_add_ps      (z, z);
+        xx = _mm256_mul_ps      (x, x2);
+        yy = _mm256_mul_ps      (y, y2);
+        zz = _mm256_mul_ps      (z, z2);
+        xy = _mm256_mul_ps      (x, y2);
+        xz = _mm256_mul_ps      (x, z2);
+        yz = _mm256_mul_ps      (y, z2);
+        xw = _mm256_mul_ps      (w, x2);
+        yw = _mm256_mul_ps      (w, y2);
+        zw = _mm256_mul_ps      (w, z2);
+
+        ra[0] = _mm256_sub_ps   (one, _mm256_add_ps(yy, zz));
+        rb[0] = _mm256_add_ps   (xy, zw);
+        rc[0] = _mm256_sub_ps   (xz, yw);
+        ra[1] = _mm256_sub_ps   (xy, zw);
+        rb[1] = _mm256_sub_ps   (one, _mm256_add_ps(xx, zz));
+        rc[1] = _mm256_add_ps   (yz, xw);
+        ra[2] = _mm256_add_ps   (xz, yw);
+        rb[2] = _mm256_sub_ps   (yz, xw);
+        rc[2] = _mm256_sub_ps   (one, _mm256_add_ps(xx, yy));
+
+        for (int r = 0; r < 3; ++r, pd += 4) {
+            t0 = _mm256_unpacklo_ps (ra[r], rb[r]);         // Transpose back to rows
+            t1 = _mm256_unpackhi_ps (ra[r], rb[r]);
+            t2 = _mm256_unpacklo_ps (rc[r], zero);
+            t3 = _mm256_unpackhi_ps (rc[r], zero);
+            q0 = _mm256_shuffle_ps  (t0, t2, 0x44);
+            q1 = _mm256_shuffle_ps  (t0, t2, 0xee);
+            q2 = _mm256_shuffle_ps  (t1, t3, 0x44);
+            q3 = _mm256_shuffle_ps  (t1, t3, 0xee);
+                 _mm_storeu_ps      (pd +   0, _mm256_castps256_ps128(q0));
+                 _mm_storeu_ps      (pd +  16, _mm256_castps256_ps128(q1));
+                 _mm_storeu_ps      (pd +  32, _mm256_castps256_ps128(q2));
+                 _mm_storeu_ps      (pd +  48, _mm256_castps256_ps128(q3));
+                 _mm_storeu_ps      (pd +  64, _mm256_extractf128_ps(q0, 1));
+                 _mm_storeu_ps      (pd +  80, _mm256_extractf128_ps(q1, 1));
+                 _mm_storeu_ps      (pd +  96, _mm256_extractf128_ps(q2, 1));
+                 _mm_storeu_ps      (pd + 112, _mm256_extractf128_ps(q3, 1));
+        }
+
+        for (int k = 0; k < 8; ++k) {
+            _mm_storeu_ps(pd + 16 * k, last);
+        }
+    }
+
+    for (; e < n; ++e) {
+        quat_to_mat(dest[e], q[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized quatarr_to_matarr(mat<double, 4, 4> *dest, quat<double> *q, size_t n) {
+    __m256d q0, q1, q2, q3, t0, t1, t2, t3, x, y, z, w, x2, y2, z2,
+            xx, yy, zz, xy, xz, yz, xw, yw, zw, one, zero, last;
+    __m256d ra[3], rb[3], rc[3];
+    size_t  e;
+
+    one  = _mm256_set1_pd (1.0);
+    zero = _mm256_setzero_pd();
+    last = _mm256_setr_pd (0.0, 0.0, 0.0, 1.0);
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        double *pd = dest[e].m[0];
+        double *pq = q[e].v;
+
+        q0 = _mm256_loadu_pd        (pq +  0);
+        q1 = _mm256_loadu_pd        (pq +  4);
+        q2 = _mm256_loadu_pd        (pq +  8);
+        q3 = _mm256_loadu_pd        (pq + 12);
+
+        t0 = _mm256_unpacklo_pd     (q0, q1);               // Transpose to x, y, z, w
+        t1 = _mm256_unpackhi_pd     (q0, q1);
+        t2 = _mm256_unpacklo_pd     (q2, q3);
+        t3 = _mm256_unpackhi_pd     (q2, q3);
+        x  = _mm256_permute2f128_pd (t0, t2, 0x20);
+        y  = _mm256_permute2f128_pd (t1, t3, 0x20);
+        z  = _mm256_permute2f128_pd (t0, t2, 0x31);
+        w  = _mm256_permute2f128_pd (t1, t3, 0x31);
+
+        x2 = _mm256_add_pd          (x, x);
+        y2 = _mm256_add_pd          (y, y);
+        z2 = _mm256_add_pd          (z, z);
+        xx = _mm256_mul_pd          (x, x2);
+        yy = _mm256_mul_pd          (y, y2);
+        zz = _mm256_mul_pd          (z, z2);
+        xy = _mm256_mul_pd          (x, y2);
+        xz = _mm256_mul_pd          (x, z2);
+        yz = _mm256_mul_pd          (y, z2);
+        xw = _mm256_mul_pd          (w, x2);
+        yw = _mm256_mul_pd          (w, y2);
+        zw = _mm256_mul_pd          (w, z2);
+
+        ra[0] = _mm256_sub_pd       (one, _mm256_add_pd(yy, zz));
+        rb[0] = _mm256_add_pd       (xy, zw);
+        rc[0] = _mm256_sub_pd       (xz, yw);
+        ra[1] = _mm256_sub_pd       (xy, zw);
+        rb[1] = _mm256_sub_pd       (one, _mm256_add_pd(xx, zz));
+        rc[1] = _mm256_add_pd       (yz, xw);
+        ra[2] = _mm256_add_pd       (xz, yw);
+        rb[2] = _mm256_sub_pd       (yz, xw);
+        rc[2] = _mm256_sub_pd       (one, _mm256_add_pd(xx, yy));
+
+        for (int r = 0; r < 3; ++r, pd += 4) {
+            t0 = _mm256_unpacklo_pd     (ra[r], rb[r]);     // Transpose back to rows
+            t1 = _mm256_unpackhi_pd     (ra[r], rb[r]);
+            t2 = _mm256_unpacklo_pd     (rc[r], zero);
+            t3 = _mm256_unpackhi_pd     (rc[r], zero);
+                 _mm256_storeu_pd       (pd +  0, _mm256_permute2f128_pd(t0, t2, 0x20));
+                 _mm256_storeu_pd       (pd + 16, _mm256_permute2f128_pd(t1, t3, 0x20));
+                 _mm256_storeu_pd       (pd + 32, _mm256_permute2f128_pd(t0, t2, 0x31));
+                 _mm256_storeu_pd       (pd + 48, _mm256_permute2f128_pd(t1, t3, 0x31));
+        }
+
+        for (int k = 0; k < 4; ++k) {
+            _mm256_storeu_pd(pd + 16 * k, last);
+        }
+    }
+
+    for (; e < n; ++e) {
+        quat_to_mat(dest[e], q[e]);
+    }
+
+    return intrin;
+}
+
+// Direct rotation keeps x, y, z in one register, each cross product is
+// two shuffles, cross(a, b) = yzx(a * yzx(b) - yzx(a) * b).
+// The 4th element of the quaternion is zero'd so the 4th element is copied.
+
+template <>
+inline specialized vecarr_x_quat(vec<float, 4> *dest,
+                                 vec<float, 4> *v,
+                                 quat<float>   &q,
+                                 size_t        n) {
+    __m128 qv, qs, qv2, qs2, vecw, vecv, vecs, vect, vecd;
+
+    qv   = _mm_blend_ps     (_mm_loadu_ps(q.v), _mm_setzero_ps(), 0x8);
+    qs   = _mm_shuffle_ps   (qv, qv, _MM_SHUFFLE(3, 0, 2, 1));
+    qv2  = _mm_add_ps       (qv, qv);
+    qs2  = _mm_add_ps       (qs, qs);
+    vecw = _mm_broadcast_ss (q.v + 3);
+
+    for (size_t e = 0; e < n; ++e) {
+        float *pd = dest[e].v;
+        float *pv = v[e].v;
+
+        vecv = _mm_loadu_ps     (pv);
+        vecs = _mm_shuffle_ps   (vecv, vecv, _MM_SHUFFLE(3, 0, 2, 1));
+        vect = _mm_fmsub_ps     (qv2, vecs, _mm_mul_ps(qs2, vecv));
+        vect = _mm_shuffle_ps   (vect, vect, _MM_SHUFFLE(3, 0, 2, 1));  // t = 2 * cross(q, v)
+        vecs = _mm_shuffle_ps   (vect, vect, _MM_SHUFFLE(3, 0, 2, 1));
+        vecd = _mm_fmsub_ps     (qv, vecs, _mm_mul_ps(qs, vect));
+        vecd = _mm_shuffle_ps   (vecd, vecd, _MM_SHUFFLE(3, 0, 2, 1));  // cross(q, t)
+        vecd = _mm_add_ps       (vecd, _mm_fmadd_ps(vecw, vect, vecv));
+               _mm_storeu_ps    (pd, vecd);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_quat(vec<double, 4> *dest,
+                                 vec<double, 4> *v,
+                                 quat<double>   &q,
+                                 size_t         n) {
+    __m256d qv, qs, qv2, qs2, vecw, vecv, vecs, vect, vecd;
+
+    qv   = _mm256_blend_pd       (_mm256_loadu_pd(q.v), _mm256_setzero_pd(), 0x8);
+    qs   = _mm256_permute4x64_pd (qv, _MM_SHUFFLE(3, 0, 2, 1));
+    qv2  = _mm256_add_pd         (qv, qv);
+    qs2  = _mm256_add_pd         (qs, qs);
+    vecw = _mm256_broadcast_sd   (q.v + 3);
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pd = dest[e].v;
+        double *pv = v[e].v;
+
+        vecv = _mm256_loadu_pd       (pv);
+        vecs = _mm256_permute4x64_pd (vecv, _MM_SHUFFLE(3, 0, 2, 1));
+        vect = _mm256_fmsub_pd       (qv2, vecs, _mm256_mul_pd(qs2, vecv));
+        vect = _mm256_permute4x64_pd (vect, _MM_SHUFFLE(3, 0, 2, 1));   // t = 2 * cross(q, v)
+        vecs = _mm256_permute4x64_pd (vect, _MM_SHUFFLE(3, 0, 2, 1));
+        vecd = _mm256_fmsub_pd       (qv, vecs, _mm256_mul_pd(qs, vect));
+        vecd = _mm256_permute4x64_pd (vecd, _MM_SHUFFLE(3, 0, 2, 1));   // cross(q, t)
+        vecd = _mm256_add_pd         (vecd, _mm256_fmadd_pd(vecw, vect, vecv));
+               _mm256_storeu_pd      (pd, vecd);
+    }
+
+    return intrin;
+}
+
+// 3 element vectors are padded to 4 elements, the memory layout is the same
+
+template <>
+inline specialized vecarr_x_quat(vec<float, 3> *dest,
+                                 vec<float, 3> *v,
+                                 quat<float>   &q,
+                                 size_t        n) {
+    return vecarr_x_quat((vec<float, 4> *) dest, (vec<float, 4> *) v, q, n);
+}
+
+template <>
+inline specialized vecarr_x_quat(vec<double, 3> *dest,
+                                 vec<double, 3> *v,
+                                 quat<double>   &q,
+                                 size_t         n) {
+    return vecarr_x_quat((vec<double, 4> *) dest, (vec<double, 4> *) v, q, n);
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Translation, rotation and scale
+
+// Quaternions, scales and matrix rows are transposed so 8 floats or 4 doubles
+// are computed side by side, as with the quaternion conversions, and
+// transposed back. The translation row is copied with its 4th element set to 1.
+
+template <>
+inline specialized trsarr_to_matarr(mat<float, 4, 4> *dest,
+                                    vec<float, 4>    *t,
+                                    quat<float>      *r,
+                                    vec<float, 4>    *s,
+                                    size_t           n) {
+    __m256 q0, q1, q2, q3, t0, t1, t2, t3, x, y, z, w, x2, y2, z2, sx, sy, sz,
+           xx, yy, zz, xy, xz, yz, xw, yw, zw, one, zero;
+    __m256 ra[3], rb[3], rc[3];
+    __m128 last;
+    size_t e;
+
+    one  = _mm256_set1_ps (1.0f);
+    zero = _mm256_setzero_ps();
+    last = _mm_setr_ps    (0.0f, 0.0f, 0.0f, 1.0f);
+
+    for (e = 0; e + 8 <= n; e += 8) {
+        float *pd = dest[e].m[0];
+        float *pt = t[e].v;
+        float *pq = r[e].v;
+        float *ps = s[e].v;
+
+        q0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ps +  0)), _mm_loadu_ps(ps + 16), 1);
+        q1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ps +  4)), _mm_loadu_ps(ps + 20), 1);
+        q2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ps +  8)), _mm_loadu_ps(ps + 24), 1);
+        q3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ps + 12)), _mm_loadu_ps(ps + 28), 1);
+
+        t0 = _mm256_unpacklo_ps (q0, q1);                   // Transpose scales
+        t1 = _mm256_unpackhi_ps (q0, q1);
+        t2 = _mm256_unpacklo_ps (q2, q3);
+        t3 = _mm256_unpackhi_ps (q2, q3);
+        sx = _mm256_shuffle_ps  (t0, t2, 0x44);
+        sy = _mm256_shuffle_ps  (t0, t2, 0xee);
+        sz = _mm256_shuffle_ps  (t1, t3, 0x44);
+
+        q0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pq +  0)), _mm_loadu_ps(pq + 16), 1);
+        q1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pq +  4)), _mm_loadu_ps(pq + 20), 1);
+        q2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pq +  8)), _mm_loadu_ps(pq + 24), 1);
+        q3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pq + 12)), _mm_loadu_ps(pq + 28), 1);
+
+        t0 = _mm256_unpacklo_ps (q0, q1);                   // Transpose quaternions
+        t1 = _mm256_unpackhi_ps (q0, q1);
+        t2 = _mm256_unpacklo_ps (q2, q3);
+        t3 = _mm256_unpackhi_ps (q2, q3);
+        x  = _mm256_shuffle_ps  (t0, t2, 0x44);
+        y  = _mm256_shuffle_ps  (t0, t2, 0xee);
+        z  = _mm256_shuffle_ps  (t1, t3, 0x44);
+        w  = _mm256_shuffle_ps  (t1, t3, 0xee);
+
+        x2 = _mm256_add_ps      (x, x);
+        y2 = _mm256_add_ps      (y, y);
+        z2 = _mm256_add_ps      (z, z);
+        xx = _mm256_mul_ps      (x, x2);
+        yy = _mm256_mul_ps      (y, y2);
+        zz = _mm256_mul_ps      (z, z2);
+        xy = _mm256_mul_ps      (x, y2);
+        xz = _mm256_mul_ps      (x, z2);
+        yz = _mm256_mul_ps      (y, z2);
+        xw = _mm256_mul_ps      (w, x2);
+        yw = _mm256_mul_ps      (w, y2);
+        zw = _mm256_mul_ps      (w, z2);
+
+        ra[0] = _mm256_mul_ps   (_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx);
+        rb[0] = _mm256_mul_ps   (_mm256_add_ps(xy, zw), sx);
+        rc[0] = _mm256_mul_ps   (_mm256_sub_ps(xz, yw), sx);
+        ra[1] = _mm256_mul_ps   (_mm256_sub_ps(xy, zw), sy);
+        rb[1] = _mm256_mul_ps   (_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy);
+        rc[1] = _mm256_mul_ps   (_mm256_add_ps(yz, xw), sy);
+        ra[2] = _mm256_mul_ps   (_mm256_add_ps(xz, yw), sz);
+        rb[2] = _mm256_mul_ps   (_mm256_sub_ps(yz, xw), sz);
+        rc[2] = _mm256_mul_ps   (_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz);
+
+        for (int i = 0; i < 3; ++i, pd += 4) {
+            t0 = _mm256_unpacklo_ps (ra[i], rb[i]);         // Transpose back to rows
+            t1 = _mm256_unpackhi_ps (ra[i], rb[i]);
+            t2 = _mm256_unpacklo_ps (rc[i], zero);
+            t3 = _mm256_unpackhi_ps (rc[i], zero);
+            q0 = _mm256_shuffle_ps  (t0, t2, 0x44);
+            q1 = _mm256_shuffle_ps  (t0, t2, 0xee);
+            q2 = _mm256_shuffle_ps  (t1, t3, 0x44);
+            q3 = _mm256_shuffle_ps  (t1, t3, 0xee);
+                 _mm_storeu_ps      (pd +   0, _mm256_castps256_ps128(q0));
+                 _mm_storeu_ps      (pd +  16, _mm256_castps256_ps128(q1));
+                 _mm_storeu_ps      (pd +  32, _mm256_castps256_ps128(q2));
+                 _mm_storeu_ps      (pd +  48, _mm256_castps256_ps128(q3));
+                 _mm_storeu_ps      (pd +  64, _mm256_extractf128_ps(q0, 1));
+                 _mm_storeu_ps      (pd +  80, _mm256_extractf128_ps(q1, 1));
+                 _mm_storeu_ps      (pd +  96, _mm256_extractf128_ps(q2, 1));
+                 _mm_storeu_ps      (pd + 112, _mm256_extractf128_ps(q3, 1));
+        }
+
+        for (int k = 0; k < 8; ++k) {
+            _mm_storeu_ps(pd + 16 * k, _mm_blend_ps(_mm_loadu_ps(pt + 4 * k), last, 0x8));
+        }
+    }
+
+    for (; e < n; ++e) {
+        quat_to_mat(dest[e], r[e]);
+
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                dest[e].m[i][j] *= s[e].v[i];
+            }
+
+            dest[e].m[3][i] = t[e].v[i];
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized trsarr_to_matarr(mat<double, 4, 4> *dest,
+                                    vec<double, 4>    *t,
+                                    quat<double>      *r,
+                                    vec<double, 4>    *s,
+                                    size_t            n) {
+    __m256d q0, q1, q2, q3, t0, t1, t2, t3, x, y, z, w, x2, y2, z2, sx, sy, sz,
+            xx, yy, zz, xy, xz, yz, xw, yw, zw, one, zero, last;
+    __m256d ra[3], rb[3], rc[3];
+    size_t  e;
+
+    one  = _mm256_set1_pd (1.0);
+    zero = _mm256_setzero_pd();
+    last = _mm256_setr_pd (0.0, 0.0, 0.0, 1.0);
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        double *pd = dest[e].m[0];
+        double *pt = t[e].v;
+        double *pq = r[e].v;
+        double *ps = s[e].v;
+
+        q0 = _mm256_loadu_pd        (ps +  0);
+        q1 = _mm256_loadu_pd        (ps +  4);
+        q2 = _mm256_loadu_pd        (ps +  8);
+        q3 = _mm256_loadu_pd        (ps + 12);
+
+        t0 = _mm256_unpacklo_pd     (q0, q1);               // Transpose scales
+        t1 = _mm256_unpackhi_pd     (q0, q1);
+        t2 = _mm256_unpacklo_pd     (q2, q3);
+        t3 = _mm256_unpackhi_pd     (q2, q3);
+        sx = _mm256_permute2f128_pd (t0, t2, 0x20);
+        sy = _mm256_permute2f128_pd (t1, t3, 0x20);
+        sz = _mm256_permute2f128_pd (t0, t2, 0x31);
+
+        q0 = _mm256_loadu_pd        (pq +  0);
+        q1 = _mm256_loadu_pd        (pq +  4);
+        q2 = _mm256_loadu_pd        (pq +  8);
+        q3 = _mm256_loadu_pd        (pq + 12);
+
+        t0 = _mm256_unpacklo_pd     (q0, q1);               // Transpose quaternions
+        t1 = _mm256_unpackhi_pd     (q0, q1);
+        t2 = _mm256_unpacklo_pd     (q2, q3);
+        t3 = _mm256_unpackhi_pd     (q2, q3);
+        x  = _mm256_permute2f128_pd (t0, t2, 0x20);
+        y  = _mm256_permute2f128_pd (t1, t3, 0x20);
+        z  = _mm256_permute2f128_pd (t0, t2, 0x31);
+        w  = _mm256_permute2f128_pd (t1, t3, 0x31);
+
+        x2 = _mm256_add_pd          (x, x);
+        y2 = _mm256_add_pd          (y, y);
+        z2 = _mm256_add_pd          (z, z);
+        xx = _mm256_mul_pd          (x, x2);
+        yy = _mm256_mul_pd          (y, y2);
+        zz = _mm256_mul_pd          (z, z2);
+        xy = _mm256_mul_pd          (x, y2);
+        xz = _mm256_mul_pd          (x, z2);
+        yz = _mm256_mul_pd          (y, z2);
+        xw = _mm256_mul_pd          (w, x2);
+        yw = _mm256_mul_pd          (w, y2);
+        zw = _mm256_mul_pd          (w, z2);
+
+        ra[0] = _mm256_mul_pd       (_mm256_sub_pd(one, _mm256_add_pd(yy, zz)), sx);
+        rb[0] = _mm256_mul_pd       (_mm256_add_pd(xy, zw), sx);
+        rc[0] = _mm256_mul_pd       (_mm256_sub_pd(xz, yw), sx);
+        ra[1] = _mm256_mul_pd       (_mm256_sub_pd(xy, zw), sy);
+        rb[1] = _mm256_mul_pd       (_mm256_sub_pd(one, _mm256_add_pd(xx, zz)), sy);
+        rc[1] = _mm256_mul_pd       (_mm256_add_pd(yz, xw), sy);
+        ra[2] = _mm256_mul_pd       (_mm256_add_pd(xz, yw), sz);
+        rb[2] = _mm256_mul_pd       (_mm256_sub_pd(yz, xw), sz);
+        rc[2] = _mm256_mul_pd       (_mm256_sub_pd(one, _mm256_add_pd(xx, yy)), sz);
+
+        for (int i = 0; i < 3; ++i, pd += 4) {
+            t0 = _mm256_unpacklo_pd     (ra[i], rb[i]);     // Transpose back to rows
+            t1 = _mm256_unpackhi_pd     (ra[i], rb[i]);
+            t2 = _mm256_unpacklo_pd     (rc[i], zero);
+            t3 = _mm256_unpackhi_pd     (rc[i], zero);
+                 _mm256_storeu_pd       (pd +  0, _mm256_permute2f128_pd(t0, t2, 0x20));
+                 _mm256_storeu_pd       (pd + 16, _mm256_permute2f128_pd(t1, t3, 0x20));
+                 _mm256_storeu_pd       (pd + 32, _mm256_permute2f128_pd(t0, t2, 0x31));
+                 _mm256_storeu_pd       (pd + 48, _mm256_permute2f128_pd(t1, t3, 0x31));
+        }
+
+        for (int k = 0; k < 4; ++k) {
+            _mm256_storeu_pd(pd + 16 * k, _mm256_blend_pd(_mm256_loadu_pd(pt + 4 * k), last, 0x8));
+        }
+    }
+
+    for (; e < n; ++e) {
+        quat_to_mat(dest[e], r[e]);
+
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                dest[e].m[i][j] *= s[e].v[i];
+            }
+
+            dest[e].m[3][i] = t[e].v[i];
+        }
+    }
+
+    return intrin;
+}
+
+// The quaternion candidates are selected with compares and blends,
+// a later candidate replaces the current one only when it is larger.
+
+template <>
+inline specialized matarr_to_trsarr(vec<float, 4>    *t,
+                                    quat<float>      *r,
+                                    vec<float, 4>    *s,
+                                    mat<float, 4, 4> *m,
+                                    size_t           n) {
+    __m256 q0, q1, q2, q3, t0, t1, t2, t3, a, b, c, d, f, g, tw, tx, ty, tz,
+           best, mask, qx, qy, qz, qw, one, half;
+    __m256 rm[3][3], len[3];
+    __m128 last;
+    size_t e;
+
+    one  = _mm256_set1_ps (1.0f);
+    half = _mm256_set1_ps (0.5f);
+    last = _mm_setr_ps    (0.0f, 0.0f, 0.0f, 1.0f);
+
+    for (e = 0; e + 8 <= n; e += 8) {
+        float *pt = t[e].v;
+        float *pr = r[e].v;
+        float *ps = s[e].v;
+        float *pm = m[e].m[0];
+
+        for (int i = 0; i < 3; ++i) {
+            q0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pm + 4 * i +  0)), _mm_loadu_ps(pm + 4 * i +  64), 1);
+            q1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pm + 4 * i + 16)), _mm_loadu_ps(pm + 4 * i +  80), 1);
+            q2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pm + 4 * i + 32)), _mm_loadu_ps(pm + 4 * i +  96), 1);
+            q3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pm + 4 * i + 48)), _mm_loadu_ps(pm + 4 * i + 112), 1);
+
+            t0 = _mm256_unpacklo_ps (q0, q1);               // Transpose the row
+            t1 = _mm256_unpackhi_ps (q0, q1);
+            t2 = _mm256_unpacklo_ps (q2, q3);
+            t3 = _mm256_unpackhi_ps (q2, q3);
+            q0 = _mm256_shuffle_ps  (t0, t2, 0x44);
+            q1 = _mm256_shuffle_ps  (t0, t2, 0xee);
+            q2 = _mm256_shuffle_ps  (t1, t3, 0x44);
+
+            len[i]   = _mm256_mul_ps    (q0, q0);           // Scale is the row length
+            len[i]   = _mm256_fmadd_ps  (q1, q1, len[i]);
+            len[i]   = _mm256_fmadd_ps  (q2, q2, len[i]);
+            len[i]   = _mm256_sqrt_ps   (len[i]);
+            t0       = _mm256_div_ps    (one, len[i]);
+            rm[i][0] = _mm256_mul_ps    (q0, t0);
+            rm[i][1] = _mm256_mul_ps    (q1, t0);
+            rm[i][2] = _mm256_mul_ps    (q2, t0);
+        }
+
+        a  = _mm256_sub_ps      (rm[1][2], rm[2][1]);       // 4xw
+        b  = _mm256_sub_ps      (rm[2][0], rm[0][2]);       // 4yw
+        c  = _mm256_sub_ps      (rm[0][1], rm[1][0]);       // 4zw
+        d  = _mm256_add_ps      (rm[0][1], rm[1][0]);       // 4xy
+        f  = _mm256_add_ps      (rm[2][0], rm[0][2]);       // 4xz
+        g  = _mm256_add_ps      (rm[1][2], rm[2][1]);       // 4yz
+
+        tw = _mm256_add_ps      (_mm256_add_ps(_mm256_add_ps(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        tx = _mm256_sub_ps      (_mm256_sub_ps(_mm256_add_ps(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        ty = _mm256_sub_ps      (_mm256_add_ps(_mm256_sub_ps(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        tz = _mm256_add_ps      (_mm256_sub_ps(_mm256_sub_ps(one, rm[0][0]), rm[1][1]), rm[2][2]);
+
+        best = tw;
+        qx   = a;
+        qy   = b;
+        qz   = c;
+        qw   = tw;
+
+        mask = _mm256_cmp_ps    (tx, best, _CMP_GT_OQ);     // x candidate
+        best = _mm256_blendv_ps (best, tx, mask);
+        qx   = _mm256_blendv_ps (qx,   tx, mask);
+        qy   = _mm256_blendv_ps (qy,   d,  mask);
+        qz   = _mm256_blendv_ps (qz,   f,  mask);
+        qw   = _mm256_blendv_ps (qw,   a,  mask);
+
+        mask = _mm256_cmp_ps    (ty, best, _CMP_GT_OQ);     // y candidate
+        best = _mm256_blendv_ps (best, ty, mask);
+        qx   = _mm256_blendv_ps (qx,   d,  mask);
+        qy   = _mm256_blendv_ps (qy,   ty, mask);
+        qz   = _mm256_blendv_ps (qz,   g,  mask);
+        qw   = _mm256_blendv_ps (qw,   b,  mask);
+
+        mask = _mm256_cmp_ps    (tz, best, _CMP_GT_OQ);     // z candidate
+        best = _mm256_blendv_ps (best, tz, mask);
+        qx   = _mm256_blendv_ps (qx,   f,  mask);
+        qy   = _mm256_blendv_ps (qy,   g,  mask);
+        qz   = _mm256_blendv_ps (qz,   tz, mask);
+        qw   = _mm256_blendv_ps (qw,   c,  mask);
+
+        best = _mm256_div_ps    (half, _mm256_sqrt_ps(best));
+        qx   = _mm256_mul_ps    (qx, best);
+        qy   = _mm256_mul_ps    (qy, best);
+        qz   = _mm256_mul_ps    (qz, best);
+        qw   = _mm256_mul_ps    (qw, best);
+
+        t0 = _mm256_unpacklo_ps (qx, qy);                   // Transpose back quaternions
+        t1 = _mm256_unpackhi_ps (qx, qy);
+        t2 = _mm256_unpacklo_ps (qz, qw);
+        t3 = _mm256_unpackhi_ps (qz, qw);
+        q0 = _mm256_shuffle_ps  (t0, t2, 0x44);
+        q1 = _mm256_shuffle_ps  (t0, t2, 0xee);
+        q2 = _mm256_shuffle_ps  (t1, t3, 0x44);
+        q3 = _mm256_shuffle_ps  (t1, t3, 0xee);
+             _mm_storeu_ps      (pr +  0, _mm256_castps256_ps128(q0));
+             _mm_storeu_ps      (pr +  4, _mm256_castps256_ps128(q1));
+             _mm_storeu_ps      (pr +  8, _mm256_castps256_ps128(q2));
+             _mm_storeu_ps      (pr + 12, _mm256_castps256_ps128(q3));
+             _mm_storeu_ps      (pr + 16, _mm256_extractf128_ps(q0, 1));
+             _mm_storeu_ps      (pr + 20, _mm256_extractf128_ps(q1, 1));
+             _mm_storeu_ps      (pr + 24, _mm256_extractf128_ps(q2, 1));
+             _mm_storeu_ps      (pr + 28, _mm256_extractf128_ps(q3, 1));
+
+        t0 = _mm256_unpacklo_ps (len[0], len[1]);           // Transpose back scales
+        t1 = _mm256_unpackhi_ps (len[0], len[1]);
+        t2 = _mm256_unpacklo_ps (len[2], one);
+        t3 = _mm256_unpackhi_ps (len[2], one);
+        q0 = _mm256_shuffle_ps  (t0, t2, 0x44);
+        q1 = _mm256_shuffle_ps  (t0, t2, 0xee);
+        q2 = _mm256_shuffle_ps  (t1, t3, 0x44);
+        q3 = _mm256_shuffle_ps  (t1, t3, 0xee);
+             _mm_storeu_ps      (ps +  0, _mm256_castps256_ps128(q0));
+             _mm_storeu_ps      (ps +  4, _mm256_castps256_ps128(q1));
+             _mm_storeu_ps      (ps +  8, _mm256_castps256_ps128(q2));
+             _mm_storeu_ps      (ps + 12, _mm256_castps256_ps128(q3));
+             _mm_storeu_ps      (ps + 16, _mm256_extractf128_ps(q0, 1));
+             _mm_storeu_ps      (ps + 20, _mm256_extractf128_ps(q1, 1));
+             _mm_storeu_ps      (ps + 24, _mm256_extractf128_ps(q2, 1));
+             _mm_storeu_ps      (ps + 28, _mm256_extractf128_ps(q3, 1));
+
+        for (int k = 0; k < 8; ++k) {
+            _mm_storeu_ps(pt + 4 * k, _mm_blend_ps(_mm_loadu_ps(pm + 16 * k + 12), last, 0x8));
+        }
+    }
+
+    // The remaining matrices are padded with identity matrices
+    if (e < n) {
+        mat<float, 4, 4> tm[8];
+        vec<float, 4>    tt[8], ts[8];
+        quat<float>      tr[8];
+
+        for (size_t k = 0; k < 8; ++k) {
+            diagonal(tm[k], 1.0f);
+
+            if (e + k < n) {
+                tm[k] = m[e + k];
+            }
+        }
+
+        matarr_to_trsarr(tt, tr, ts, tm, 8);
+
+        for (size_t k = 0; e + k < n; ++k) {
+            t[e + k] = tt[k];
+            r[e + k] = tr[k];
+            s[e + k] = ts[k];
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized matarr_to_trsarr(vec<double, 4>    *t,
+                                    quat<double>      *r,
+                                    vec<double, 4>    *s,
+                                    mat<double, 4, 4> *m,
+                                    size_t            n) {
+    __m256d q0, q1, q2, q3, t0, t1, t2, t3, a, b, c, d, f, g, tw, tx, ty, tz,
+            best, mask, qx, qy, qz, qw, one, half, last;
+    __m256d rm[3][3], len[3];
+    size_t  e;
+
+    one  = _mm256_set1_pd (1.0);
+    half = _mm256_set1_pd (0.5);
+    last = _mm256_setr_pd (0.0, 0.0, 0.0, 1.0);
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        double *pt = t[e].v;
+        double *pr = r[e].v;
+        double *ps = s[e].v;
+        double *pm = m[e].m[0];
+
+        for (int i = 0; i < 3; ++i) {
+            q0 = _mm256_loadu_pd        (pm + 4 * i +  0);
+            q1 = _mm256_loadu_pd        (pm + 4 * i + 16);
+            q2 = _mm256_loadu_pd        (pm + 4 * i + 32);
+            q3 = _mm256_loadu_pd        (pm + 4 * i + 48);
+
+            t0 = _mm256_unpacklo_pd     (q0, q1);           // Transpose the row
+            t1 = _mm256_unpackhi_pd     (q0, q1);
+            t2 = _mm256_unpacklo_pd     (q2, q3);
+            t3 = _mm256_unpackhi_pd     (q2, q3);
+            q0 = _mm256_permute2f128_pd (t0, t2, 0x20);
+            q1 = _mm256_permute2f128_pd (t1, t3, 0x20);
+            q2 = _mm256_permute2f128_pd (t0, t2, 0x31);
+
+            len[i]   = _mm256_mul_pd    (q0, q0);           // Scale is the row length
+            len[i]   = _mm256_fmadd_pd  (q1, q1, len[i]);
+            len[i]   = _mm256_fmadd_pd  (q2, q2, len[i]);
+            len[i]   = _mm256_sqrt_pd   (len[i]);
+            t0       = _mm256_div_pd    (one, len[i]);
+            rm[i][0] = _mm256_mul_pd    (q0, t0);
+            rm[i][1] = _mm256_mul_pd    (q1, t0);
+            rm[i][2] = _mm256_mul_pd    (q2, t0);
+        }
+
+        a  = _mm256_sub_pd      (rm[1][2], rm[2][1]);       // 4xw
+        b  = _mm256_sub_pd      (rm[2][0], rm[0][2]);       // 4yw
+        c  = _mm256_sub_pd      (rm[0][1], rm[1][0]);       // 4zw
+        d  = _mm256_add_pd      (rm[0][1], rm[1][0]);       // 4xy
+        f  = _mm256_add_pd      (rm[2][0], rm[0][2]);       // 4xz
+        g  = _mm256_add_pd      (rm[1][2], rm[2][1]);       // 4yz
+
+        tw = _mm256_add_pd      (_mm256_add_pd(_mm256_add_pd(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        tx = _mm256_sub_pd      (_mm256_sub_pd(_mm256_add_pd(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        ty = _mm256_sub_pd      (_mm256_add_pd(_mm256_sub_pd(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        tz = _mm256_add_pd      (_mm256_sub_pd(_mm256_sub_pd(one, rm[0][0]), rm[1][1]), rm[2][2]);
+
+        best = tw;
+        qx   = a;
+        qy   = b;
+        qz   = c;
+        qw   = tw;
+
+        mask = _mm256_cmp_pd    (tx, best, _CMP_GT_OQ);     // x candidate
+        best = _mm256_blendv_pd (best, tx, mask);
+        qx   = _mm256_blendv_pd (qx,   tx, mask);
+        qy   = _mm256_blendv_pd (qy,   d,  mask);
+        qz   = _mm256_blendv_pd (qz,   f,  mask);
+        qw   = _mm256_blendv_pd (qw,   a,  mask);
+
+        mask = _mm256_cmp_pd    (ty, best, _CMP_GT_OQ);     // y candidate
+        best = _mm256_blendv_pd (best, ty, mask);
+        qx   = _mm256_blendv_pd (qx,   d,  mask);
+        qy   = _mm256_blendv_pd (qy,   ty, mask);
+        qz   = _mm256_blendv_pd (qz,   g,  mask);
+        qw   = _mm256_blendv_pd (qw,   b,  mask);
+
+        mask = _mm256_cmp_pd    (tz, best, _CMP_GT_OQ);     // z candidate
+        best = _mm256_blendv_pd (best, tz, mask);
+        qx   = _mm256_blendv_pd (qx,   f,  mask);
+        qy   = _mm256_blendv_pd (qy,   g,  mask);
+        qz   = _mm256_blendv_pd (qz,   tz, mask);
+        qw   = _mm256_blendv_pd (qw,   c,  mask);
+
+        best = _mm256_div_pd    (half, _mm256_sqrt_pd(best));
+        qx   = _mm256_mul_pd    (qx, best);
+        qy   = _mm256_mul_pd    (qy, best);
+        qz   = _mm256_mul_pd    (qz, best);
+        qw   = _mm256_mul_pd    (qw, best);
+
+        t0 = _mm256_unpacklo_pd     (qx, qy);               // Transpose back quaternions
+        t1 = _mm256_unpackhi_pd     (qx, qy);
+        t2 = _mm256_unpacklo_pd     (qz, qw);
+        t3 = _mm256_unpackhi_pd     (qz, qw);
+             _mm256_storeu_pd       (pr +  0, _mm256_permute2f128_pd(t0, t2, 0x20));
+             _mm256_storeu_pd       (pr +  4, _mm256_permute2f128_pd(t1, t3, 0x20));
+             _mm256_storeu_pd       (pr +  8, _mm256_permute2f128_pd(t0, t2, 0x31));
+             _mm256_storeu_pd       (pr + 12, _mm256_permute2f128_pd(t1, t3, 0x31));
+
+        t0 = _mm256_unpacklo_pd     (len[0], len[1]);       // Transpose back scales
+        t1 = _mm256_unpackhi_pd     (len[0], len[1]);
+        t2 = _mm256_unpacklo_pd     (len[2], one);
+        t3 = _mm256_unpackhi_pd     (len[2], one);
+             _mm256_storeu_pd       (ps +  0, _mm256_permute2f128_pd(t0, t2, 0x20));
+             _mm256_storeu_pd       (ps +  4, _mm256_permute2f128_pd(t1, t3, 0x20));
+             _mm256_storeu_pd       (ps +  8, _mm256_permute2f128_pd(t0, t2, 0x31));
+             _mm256_storeu_pd       (ps + 12, _mm256_permute2f128_pd(t1, t3, 0x31));
+
+        for (int k = 0; k < 4; ++k) {
+            _mm256_storeu_pd(pt + 4 * k, _mm256_blend_pd(_mm256_loadu_pd(pm + 16 * k + 12), last, 0x8));
+        }
+    }
+
+    // The remaining matrices are padded with identity matrices
+    if (e < n) {
+        mat<double, 4, 4> tm[4];
+        vec<double, 4>    tt[4], ts[4];
+        quat<double>      tr[4];
+
+        for (size_t k = 0; k < 4; ++k) {
+            diagonal(tm[k], 1.0);
+
+            if (e + k < n) {
+                tm[k] = m[e + k];
+            }
+        }
+
+        matarr_to_trsarr(tt, tr, ts, tm, 4);
+
+        for (size_t k = 0; e + k < n; ++k) {
+            t[e + k] = tt[k];
+            r[e + k] = tr[k];
+            s[e + k] = ts[k];
+        }
+    }
+
+    return intrin;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Hierarchies
+
+// Indexed products gather their operands, so the matrix of a later
+// element of b is prefetched while the current product is computed.
+// Rows of a are broadcast within 128-bit lanes, 2 result rows per 256-bit
+// register, 4 rows of floats or 2 rows of doubles per 512-bit register.
+
+template <>
+inline specialized matarr_x_matarr_indexed(mat<float, 4, 4> *dest,
+                                           mat<float, 4, 4> *a,
+                                           mat<float, 4, 4> *b,
+                                           const size_t     *index,
+                                           const size_t     *bindex,
+                                           size_t           n) {
+    const size_t ahead = 4;
+
+// Compiler targeting AVX-512, all the rows in one register
+#if defined(__AVX512F__)
+
+    __m512 row0, row1, row2, row3, veca, vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        float *pd = dest[index[e]].m[0];
+        float *pa = a[index[e]].m[0];
+        float *pb = b[bindex[e]].m[0];
+
+        if (e + ahead < n) {
+            _mm_prefetch((const char *) b[bindex[e + ahead]].m[0],        _MM_HINT_T0);
+            _mm_prefetch((const char *) (b[bindex[e + ahead]].m[0] + 15), _MM_HINT_T0);
+        }
+
+        row0 = _mm512_broadcast_f32x4 (_mm_loadu_ps(pb +  0));  // Each row of b 4 times
+        row1 = _mm512_broadcast_f32x4 (_mm_loadu_ps(pb +  4));
+        row2 = _mm512_broadcast_f32x4 (_mm_loadu_ps(pb +  8));
+        row3 = _mm512_broadcast_f32x4 (_mm_loadu_ps(pb + 12));
+        veca = _mm512_loadu_ps        (pa);
+
+        vecd = _mm512_mul_ps          (row0, _mm512_permute_ps(veca, 0x00));
+        vecd = _mm512_fmadd_ps        (row1, _mm512_permute_ps(veca, 0x55), vecd);
+        vecd = _mm512_fmadd_ps        (row2, _mm512_permute_ps(veca, 0xaa), vecd);
+        vecd = _mm512_fmadd_ps        (row3, _mm512_permute_ps(veca, 0xff), vecd);
+               _mm512_storeu_ps       (pd, vecd);
+    }
+
+    return intrin512;
+
+#else
+
+    __m256 row0, row1, row2, row3, veca, vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        float *pd = dest[index[e]].m[0];
+        float *pa = a[index[e]].m[0];
+        float *pb = b[bindex[e]].m[0];
+
+        if (e + ahead < n) {
+            _mm_prefetch((const char *) b[bindex[e + ahead]].m[0],        _MM_HINT_T0);
+            _mm_prefetch((const char *) (b[bindex[e + ahead]].m[0] + 15), _MM_HINT_T0);
+        }
+
+        row0 = _mm256_broadcast_ps    ((__m128 *) (pb +  0));   // Each row of b twice
+        row1 = _mm256_broadcast_ps    ((__m128 *) (pb +  4));
+        row2 = _mm256_broadcast_ps    ((__m128 *) (pb +  8));
+        row3 = _mm256_broadcast_ps    ((__m128 *) (pb + 12));
+
+        veca = _mm256_loadu_ps        (pa);                     // 1st and 2nd rows of a
+        vecd = _mm256_mul_ps          (row0, _mm256_permute_ps(veca, 0x00));
+        vecd = _mm256_fmadd_ps        (row1, _mm256_permute_ps(veca, 0x55), vecd);
+        vecd = _mm256_fmadd_ps        (row2, _mm256_permute_ps(veca, 0xaa), vecd);
+        vecd = _mm256_fmadd_ps        (row3, _mm256_permute_ps(veca, 0xff), vecd);
+               _mm256_storeu_ps       (pd, vecd);
+
+        veca = _mm256_loadu_ps        (pa + 8);                 // 3rd and 4th rows of a
+        vecd = _mm256_mul_ps          (row0, _mm256_permute_ps(veca, 0x00));
+        vecd = _mm256_fmadd_ps        (row1, _mm256_permute_ps(veca, 0x55), vecd);
+        vecd = _mm256_fmadd_ps        (row2, _mm256_permute_ps(veca, 0xaa), vecd);
+        vecd = _mm256_fmadd_ps        (row3, _mm256_permute_ps(veca, 0xff), vecd);
+               _mm256_storeu_ps       (pd + 8, vecd);
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+template <>
+inline specialized matarr_x_matarr_indexed(mat<double, 4, 4> *dest,
+                                           mat<double, 4, 4> *a,
+                                           mat<double, 4, 4> *b,
+                                           const size_t      *index,
+                                           const size_t      *bindex,
+                                           size_t            n) {
+    const size_t ahead = 4;
+
+// Compiler targeting AVX-512, 2 rows per register
+#if defined(__AVX512F__)
+
+    __m512d row0, row1, row2, row3, veca, vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pd = dest[index[e]].m[0];
+        double *pa = a[index[e]].m[0];
+        double *pb = b[bindex[e]].m[0];
+
+        if (e + ahead < n) {
+            _mm_prefetch((const char *) b[bindex[e + ahead]].m[0],        _MM_HINT_T0);
+            _mm_prefetch((const char *) (b[bindex[e + ahead]].m[0] +  8), _MM_HINT_T0);
+            _mm_prefetch((const char *) (b[bindex[e + ahead]].m[0] + 15), _MM_HINT_T0);
+        }
+
+        row0 = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pb +  0));  // Each row of b twice
+        row1 = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pb +  4));
+        row2 = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pb +  8));
+        row3 = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pb + 12));
+
+        veca = _mm512_loadu_pd        (pa);                     // 1st and 2nd rows of a
+        vecd = _mm512_mul_pd          (row0, _mm512_permutex_pd(veca, 0x00));
+        vecd = _mm512_fmadd_pd        (row1, _mm512_permutex_pd(veca, 0x55), vecd);
+        vecd = _mm512_fmadd_pd        (row2, _mm512_permutex_pd(veca, 0xaa), vecd);
+        vecd = _mm512_fmadd_pd        (row3, _mm512_permutex_pd(veca, 0xff), vecd);
+               _mm512_storeu_pd       (pd, vecd);
+
+        veca = _mm512_loadu_pd        (pa + 8);                 // 3rd and 4th rows of a
+        vecd = _mm512_mul_pd          (row0, _mm512_permutex_pd(veca, 0x00));
+        vecd = _mm512_fmadd_pd        (row1, _mm512_permutex_pd(veca, 0x55), vecd);
+        vecd = _mm512_fmadd_pd        (row2, _mm512_permutex_pd(veca, 0xaa), vecd);
+        vecd = _mm512_fmadd_pd        (row3, _mm512_permutex_pd(veca, 0xff), vecd);
+               _mm512_storeu_pd       (pd + 8, vecd);
+    }
+
+    return intrin512;
+
+#else
+
+    __m256d row0, row1, row2, row3, vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pd = dest[index[e]].m[0];
+        double *pa = a[index[e]].m[0];
+        double *pb = b[bindex[e]].m[0];
+
+        if (e + ahead < n) {
+            _mm_prefetch((const char *) b[bindex[e + ahead]].m[0],        _MM_HINT_T0);
+            _mm_prefetch((const char *) (b[bindex[e + ahead]].m[0] +  8), _MM_HINT_T0);
+            _mm_prefetch((const char *) (b[bindex[e + ahead]].m[0] + 15), _MM_HINT_T0);
+        }
+
+        row0 = _mm256_loadu_pd        (pb +  0);                // Load all the matrix rows
+        row1 = _mm256_loadu_pd        (pb +  4);
+        row2 = _mm256_loadu_pd        (pb +  8);
+        row3 = _mm256_loadu_pd        (pb + 12);
+
+        for (int i = 0; i < 16; i += 4) {
+            vecd = _mm256_mul_pd      (row0, _mm256_broadcast_sd(pa + i + 0));
+            vecd = _mm256_fmadd_pd    (row1, _mm256_broadcast_sd(pa + i + 1), vecd);
+            vecd = _mm256_fmadd_pd    (row2, _mm256_broadcast_sd(pa + i + 2), vecd);
+            vecd = _mm256_fmadd_pd    (row3, _mm256_broadcast_sd(pa + i + 3), vecd);
+                   _mm256_storeu_pd   (pd + i, vecd);
+        }
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Skinning
+
+// The blended matrix stays in registers, a whole float matrix or half a
+// double matrix per 512-bit register, or half a float matrix per 256-bit
+// register. The vector elements are broadcast to match the rows, the
+// products of each row are then summed across the register.
+
+template <>
+inline specialized skinarr_x_matarr(vec<float, 4>    *dest,
+                                    vec<float, 4>    *v,
+                                    mat<float, 4, 4> *palette,
+                                    vec<unsigned, 4> *bone,
+                                    vec<float, 4>    *weight,
+                                    size_t           n,
+                                    vec<float, 4>    *ndest,
+                                    vec<float, 4>    *nv) {
+// Compiler targeting AVX-512, the blended matrix in one register
+#if defined(__AVX512F__)
+
+    __m512i perm;
+    __m512  vecm, vecv;
+    __m128  vecd;
+
+    perm = _mm512_setr_epi32 (0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+
+    for (size_t e = 0; e < n; ++e) {
+        unsigned *pb = bone[e].v;
+        float    *pw = weight[e].v;
+
+        vecm = _mm512_mul_ps        (_mm512_loadu_ps(palette[pb[0]].m[0]), _mm512_set1_ps(pw[0]));
+        vecm = _mm512_fmadd_ps      (_mm512_loadu_ps(palette[pb[1]].m[0]), _mm512_set1_ps(pw[1]), vecm);
+        vecm = _mm512_fmadd_ps      (_mm512_loadu_ps(palette[pb[2]].m[0]), _mm512_set1_ps(pw[2]), vecm);
+        vecm = _mm512_fmadd_ps      (_mm512_loadu_ps(palette[pb[3]].m[0]), _mm512_set1_ps(pw[3]), vecm);
+
+        vecv = _mm512_permutexvar_ps (perm, _mm512_castps128_ps512(_mm_loadu_ps(v[e].v)));
+        vecv = _mm512_mul_ps        (vecm, vecv);           // Sum the 4 rows
+        vecd = _mm_add_ps           (_mm_add_ps(_mm512_castps512_ps128(vecv),
+                                                _mm512_extractf32x4_ps(vecv, 1)),
+                                     _mm_add_ps(_mm512_extractf32x4_ps(vecv, 2),
+                                                _mm512_extractf32x4_ps(vecv, 3)));
+               _mm_storeu_ps        (dest[e].v, vecd);
+
+        if (ndest != nullptr) {                             // Without the 4th row
+            vecv = _mm512_permutexvar_ps (perm, _mm512_castps128_ps512(_mm_loadu_ps(nv[e].v)));
+            vecv = _mm512_maskz_mul_ps   (0x0fff, vecm, vecv);
+            vecd = _mm_add_ps       (_mm_add_ps(_mm512_castps512_ps128(vecv),
+                                                _mm512_extractf32x4_ps(vecv, 1)),
+                                     _mm512_extractf32x4_ps(vecv, 2));
+                   _mm_storeu_ps    (ndest[e].v, _mm_blend_ps(vecd, _mm_setzero_ps(), 0x8));
+        }
+    }
+
+    return intrin512;
+
+#else
+
+    __m256 vecm01, vecm23, vecp, vecq, vecs;
+    __m128 vecv, vecd, zero;
+
+    zero = _mm_setzero_ps();
+
+    for (size_t e = 0; e < n; ++e) {
+        unsigned *pb = bone[e].v;
+        float    *pw = weight[e].v;
+        float    *p0 = palette[pb[0]].m[0];
+        float    *p1 = palette[pb[1]].m[0];
+        float    *p2 = palette[pb[2]].m[0];
+        float    *p3 = palette[pb[3]].m[0];
+
+        vecs   = _mm256_broadcast_ss (pw + 0);              // Blend the 1st and 2nd rows
+        vecm01 = _mm256_mul_ps       (_mm256_loadu_ps(p0), vecs);
+        vecm23 = _mm256_mul_ps       (_mm256_loadu_ps(p0 + 8), vecs);
+        vecs   = _mm256_broadcast_ss (pw + 1);              //   and the 3rd and 4th rows
+        vecm01 = _mm256_fmadd_ps     (_mm256_loadu_ps(p1), vecs, vecm01);
+        vecm23 = _mm256_fmadd_ps     (_mm256_loadu_ps(p1 + 8), vecs, vecm23);
+        vecs   = _mm256_broadcast_ss (pw + 2);
+        vecm01 = _mm256_fmadd_ps     (_mm256_loadu_ps(p2), vecs, vecm01);
+        vecm23 = _mm256_fmadd_ps     (_mm256_loadu_ps(p2 + 8), vecs, vecm23);
+        vecs   = _mm256_broadcast_ss (pw + 3);
+        vecm01 = _mm256_fmadd_ps     (_mm256_loadu_ps(p3), vecs, vecm01);
+        vecm23 = _mm256_fmadd_ps     (_mm256_loadu_ps(p3 + 8), vecs, vecm23);
+
+        vecv = _mm_loadu_ps          (v[e].v);
+        vecp = _mm256_setr_m128      (_mm_permute_ps(vecv, 0x00), _mm_permute_ps(vecv, 0x55));
+        vecq = _mm256_setr_m128      (_mm_permute_ps(vecv, 0xaa), _mm_permute_ps(vecv, 0xff));
+        vecp = _mm256_fmadd_ps       (vecm23, vecq, _mm256_mul_ps(vecm01, vecp));
+        vecd = _mm_add_ps            (_mm256_castps256_ps128(vecp), _mm256_extractf128_ps(vecp, 1));
+               _mm_storeu_ps         (dest[e].v, vecd);
+
+        if (ndest != nullptr) {                             // Without the 4th row
+            vecv = _mm_loadu_ps      (nv[e].v);
+            vecp = _mm256_setr_m128  (_mm_permute_ps(vecv, 0x00), _mm_permute_ps(vecv, 0x55));
+            vecq = _mm256_setr_m128  (_mm_permute_ps(vecv, 0xaa), zero);
+            vecp = _mm256_fmadd_ps   (vecm23, vecq, _mm256_mul_ps(vecm01, vecp));
+            vecd = _mm_add_ps        (_mm256_castps256_ps128(vecp), _mm256_extractf128_ps(vecp, 1));
+                   _mm_storeu_ps     (ndest[e].v, _mm_blend_ps(vecd, zero, 0x8));
+        }
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+template <>
+inline specialized skinarr_x_matarr(vec<double, 4>    *dest,
+                                    vec<double, 4>    *v,
+                                    mat<double, 4, 4> *palette,
+                                    vec<unsigned, 4>  *bone,
+                                    vec<double, 4>    *weight,
+                                    size_t            n,
+                                    vec<double, 4>    *ndest,
+                                    vec<double, 4>    *nv) {
+// Compiler targeting AVX-512, half the blended matrix per register
+#if defined(__AVX512F__)
+
+    __m512i perm01, perm23;
+    __m512d vecm01, vecm23, vecv, vecp, vecs;
+    __m256d vecd;
+
+    perm01 = _mm512_setr_epi64 (0, 0, 0, 0, 1, 1, 1, 1);
+    perm23 = _mm512_setr_epi64 (2, 2, 2, 2, 3, 3, 3, 3);
+
+    for (size_t e = 0; e < n; ++e) {
+        unsigned *pb = bone[e].v;
+        double   *pw = weight[e].v;
+        double   *p0 = palette[pb[0]].m[0];
+        double   *p1 = palette[pb[1]].m[0];
+        double   *p2 = palette[pb[2]].m[0];
+        double   *p3 = palette[pb[3]].m[0];
+
+        vecs   = _mm512_set1_pd     (pw[0]);
+        vecm01 = _mm512_mul_pd      (_mm512_loadu_pd(p0), vecs);
+        vecm23 = _mm512_mul_pd      (_mm512_loadu_pd(p0 + 8), vecs);
+        vecs   = _mm512_set1_pd     (pw[1]);
+        vecm01 = _mm512_fmadd_pd    (_mm512_loadu_pd(p1), vecs, vecm01);
+        vecm23 = _mm512_fmadd_pd    (_mm512_loadu_pd(p1 + 8), vecs, vecm23);
+        vecs   = _mm512_set1_pd     (pw[2]);
+        vecm01 = _mm512_fmadd_pd    (_mm512_loadu_pd(p2), vecs, vecm01);
+        vecm23 = _mm512_fmadd_pd    (_mm512_loadu_pd(p2 + 8), vecs, vecm23);
+        vecs   = _mm512_set1_pd     (pw[3]);
+        vecm01 = _mm512_fmadd_pd    (_mm512_loadu_pd(p3), vecs, vecm01);
+        vecm23 = _mm512_fmadd_pd    (_mm512_loadu_pd(p3 + 8), vecs, vecm23);
+
+        vecv = _mm512_castpd256_pd512 (_mm256_loadu_pd(v[e].v));
+        vecp = _mm512_mul_pd        (vecm01, _mm512_permutexvar_pd(perm01, vecv));
+        vecp = _mm512_fmadd_pd      (vecm23, _mm512_permutexvar_pd(perm23, vecv), vecp);
+        vecd = _mm256_add_pd        (_mm512_castpd512_pd256(vecp), _mm512_extractf64x4_pd(vecp, 1));
+               _mm256_storeu_pd     (dest[e].v, vecd);
+
+        if (ndest != nullptr) {                             // Without the 4th row
+            vecv = _mm512_castpd256_pd512 (_mm256_loadu_pd(nv[e].v));
+            vecp = _mm512_mul_pd    (vecm01, _mm512_permutexvar_pd(perm01, vecv));
+            vecp = _mm512_mask3_fmadd_pd  (vecm23, _mm512_permutexvar_pd(perm23, vecv), vecp, 0x0f);
+            vecd = _mm256_add_pd    (_mm512_castpd512_pd256(vecp), _mm512_extractf64x4_pd(vecp, 1));
+                   _mm256_storeu_pd (ndest[e].v, _mm256_blend_pd(vecd, _mm256_setzero_pd(), 0x8));
+        }
+    }
+
+    return intrin512;
+
+#else
+
+    __m256d row0, row1, row2, row3, vecs, vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        unsigned *pb = bone[e].v;
+        double   *pw = weight[e].v;
+        double   *pv = v[e].v;
+        double   *pm = palette[pb[0]].m[0];
+
+        vecs = _mm256_broadcast_sd   (pw + 0);              // Blend the rows
+        row0 = _mm256_mul_pd         (_mm256_loadu_pd(pm +  0), vecs);
+        row1 = _mm256_mul_pd         (_mm256_loadu_pd(pm +  4), vecs);
+        row2 = _mm256_mul_pd         (_mm256_loadu_pd(pm +  8), vecs);
+        row3 = _mm256_mul_pd         (_mm256_loadu_pd(pm + 12), vecs);
+
+        for (int k = 1; k < 4; ++k) {
+            pm   = palette[pb[k]].m[0];
+            vecs = _mm256_broadcast_sd (pw + k);
+            row0 = _mm256_fmadd_pd     (_mm256_loadu_pd(pm +  0), vecs, row0);
+            row1 = _mm256_fmadd_pd     (_mm256_loadu_pd(pm +  4), vecs, row1);
+            row2 = _mm256_fmadd_pd     (_mm256_loadu_pd(pm +  8), vecs, row2);
+            row3 = _mm256_fmadd_pd     (_mm256_loadu_pd(pm + 12), vecs, row3);
+        }
+
+        vecd = _mm256_mul_pd         (row0, _mm256_broadcast_sd(pv + 0));
+        vecd = _mm256_fmadd_pd       (row1, _mm256_broadcast_sd(pv + 1), vecd);
+        vecd = _mm256_fmadd_pd       (row2, _mm256_broadcast_sd(pv + 2), vecd);
+        vecd = _mm256_fmadd_pd       (row3, _mm256_broadcast_sd(pv + 3), vecd);
+               _mm256_storeu_pd      (dest[e].v, vecd);
+
+        if (ndest != nullptr) {                             // Without the 4th row
+            pv   = nv[e].v;
+            vecd = _mm256_mul_pd     (row0, _mm256_broadcast_sd(pv + 0));
+            vecd = _mm256_fmadd_pd   (row1, _mm256_broadcast_sd(pv + 1), vecd);
+            vecd = _mm256_fmadd_pd   (row2, _mm256_broadcast_sd(pv + 2), vecd);
+                   _mm256_storeu_pd  (ndest[e].v, _mm256_blend_pd(vecd, _mm256_setzero_pd(), 0x8));
+        }
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Indexed vector array multiplication
+
+// Every vector loads its own matrix, the matrix of a later vector is
+// prefetched. Float matrices are 2 rows per 256-bit register with the
+// vector elements broadcast to match, then the halves are summed.
+
+template <>
+inline specialized vecarr_x_matarr_indexed(vec<float, 4>    *dest,
+                                           vec<float, 4>    *v,
+                                           mat<float, 4, 4> *palette,
+                                           const unsigned   *index,
+                                           size_t           n) {
+    const size_t ahead = 8;
+    __m256       vecp, vecq;
+    __m128       vecv, vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        float *pm = palette[index[e]].m[0];
+
+        if (e + ahead < n) {
+            _mm_prefetch((const char *) palette[index[e + ahead]].m[0],        _MM_HINT_T0);
+            _mm_prefetch((const char *) (palette[index[e + ahead]].m[0] + 15), _MM_HINT_T0);
+        }
+
+        vecv = _mm_loadu_ps          (v[e].v);
+        vecp = _mm256_setr_m128      (_mm_permute_ps(vecv, 0x00), _mm_permute_ps(vecv, 0x55));
+        vecq = _mm256_setr_m128      (_mm_permute_ps(vecv, 0xaa), _mm_permute_ps(vecv, 0xff));
+        vecp = _mm256_mul_ps         (_mm256_loadu_ps(pm), vecp);
+        vecp = _mm256_fmadd_ps       (_mm256_loadu_ps(pm + 8), vecq, vecp);
+        vecd = _mm_add_ps            (_mm256_castps256_ps128(vecp), _mm256_extractf128_ps(vecp, 1));
+               _mm_storeu_ps         (dest[e].v, vecd);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_matarr_indexed(vec<double, 4>    *dest,
+                                           vec<double, 4>    *v,
+                                           mat<double, 4, 4> *palette,
+                                           const unsigned    *index,
+                                           size_t            n) {
+    const size_t ahead = 8;
+    __m256d      vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pm = palette[index[e]].m[0];
+        double *pv = v[e].v;
+
+        if (e + ahead < n) {
+            _mm_prefetch((const char *) palette[index[e + ahead]].m[0],        _MM_HINT_T0);
+            _mm_prefetch((const char *) (palette[index[e + ahead]].m[0] +  8), _MM_HINT_T0);
+            _mm_prefetch((const char *) (palette[index[e + ahead]].m[0] + 15), _MM_HINT_T0);
+        }
+
+        vecd = _mm256_mul_pd         (_mm256_loadu_pd(pm +  0), _mm256_broadcast_sd(pv + 0));
+        vecd = _mm256_fmadd_pd       (_mm256_loadu_pd(pm +  4), _mm256_broadcast_sd(pv + 1), vecd);
+        vecd = _mm256_fmadd_pd       (_mm256_loadu_pd(pm +  8), _mm256_broadcast_sd(pv + 2), vecd);
+        vecd = _mm256_fmadd_pd       (_mm256_loadu_pd(pm + 12), _mm256_broadcast_sd(pv + 3), vecd);
+               _mm256_storeu_pd      (dest[e].v, vecd);
+    }
+
+    return intrin;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Bounding box transform and frustum culling
+
+// Each lane works on its own box, the matrix and plane elements are
+// broadcast. Plane tests are compared lane by lane and the lanes that pass
+// all the planes collect in a bit mask.
+
+template <>
+inline specialized aabbsoa_x_mat(aabbsoa<float>   *dest,
+                                 unsigned         *visible,
+                                 aabbsoa<float>   *src,
+                                 mat<float, 4, 4> &m,
+                                 vec<float, 4>    *planes,
+                                 size_t           nplanes,
+                                 size_t           n) {
+    const size_t lanes  = aabbsoa<float>::lanes;
+    size_t       blocks = aabb_blocks<float>(n);
+    float        *pm    = m.m[0];
+
+// Compiler targeting AVX-512, a block of 16 boxes per register
+#if defined(__AVX512F__)
+
+    __m512    vecm[12], veca[9];
+    __m512    cx, cy, cz, ex, ey, ez, vecd;
+    __m512    sign = _mm512_set1_ps(-0.0f);
+    __mmask16 in;
+
+    for (int i = 0; i < 12; ++i) {                          // Rows without 4th column
+        vecm[i] = _mm512_set1_ps(pm[i / 3 * 4 + i % 3]);
+    }
+    for (int i = 0; i < 9; ++i) {
+        veca[i] = _mm512_andnot_ps(sign, vecm[i]);
+    }
+
+    for (size_t e = 0; e < blocks; ++e) {
+        size_t rest = n - e * lanes;
+
+        cx = _mm512_loadu_ps         (src[e].c[0]);         // Transform centers
+        cy = _mm512_loadu_ps         (src[e].c[1]);
+        cz = _mm512_loadu_ps         (src[e].c[2]);
+        ex = _mm512_fmadd_ps         (cx, vecm[0], vecm[ 9]);
+        ey = _mm512_fmadd_ps         (cx, vecm[1], vecm[10]);
+        ez = _mm512_fmadd_ps         (cx, vecm[2], vecm[11]);
+        ex = _mm512_fmadd_ps         (cy, vecm[3], ex);
+        ey = _mm512_fmadd_ps         (cy, vecm[4], ey);
+        ez = _mm512_fmadd_ps         (cy, vecm[5], ez);
+        cx = _mm512_fmadd_ps         (cz, vecm[6], ex);
+        cy = _mm512_fmadd_ps         (cz, vecm[7], ey);
+        cz = _mm512_fmadd_ps         (cz, vecm[8], ez);
+
+        vecd = _mm512_loadu_ps       (src[e].e[0]);         // Transform extents
+        ex   = _mm512_mul_ps         (vecd, veca[0]);
+        ey   = _mm512_mul_ps         (vecd, veca[1]);
+        ez   = _mm512_mul_ps         (vecd, veca[2]);
+        vecd = _mm512_loadu_ps       (src[e].e[1]);
+        ex   = _mm512_fmadd_ps       (vecd, veca[3], ex);
+        ey   = _mm512_fmadd_ps       (vecd, veca[4], ey);
+        ez   = _mm512_fmadd_ps       (vecd, veca[5], ez);
+        vecd = _mm512_loadu_ps       (src[e].e[2]);
+        ex   = _mm512_fmadd_ps       (vecd, veca[6], ex);
+        ey   = _mm512_fmadd_ps       (vecd, veca[7], ey);
+        ez   = _mm512_fmadd_ps       (vecd, veca[8], ez);
+
+        in = (rest < lanes) ? __mmask16((1u << rest) - 1) : __mmask16(0xffff);
+
+        for (size_t p = 0; p < nplanes; ++p) {
+            float *pp = planes[p].v;
+
+            vecd = _mm512_fmadd_ps   (cx, _mm512_set1_ps(pp[0]), _mm512_set1_ps(pp[3]));
+            vecd = _mm512_fmadd_ps   (cy, _mm512_set1_ps(pp[1]), vecd);
+            vecd = _mm512_fmadd_ps   (cz, _mm512_set1_ps(pp[2]), vecd);
+            vecd = _mm512_fmadd_ps   (ex, _mm512_set1_ps(std::abs(pp[0])), vecd);
+            vecd = _mm512_fmadd_ps   (ey, _mm512_set1_ps(std::abs(pp[1])), vecd);
+            vecd = _mm512_fmadd_ps   (ez, _mm512_set1_ps(std::abs(pp[2])), vecd);
+            in   = _mm512_mask_cmp_ps_mask (in, vecd, _mm512_setzero_ps(), _CMP_GE_OQ);
+        }
+
+        if (dest != nullptr) {
+            _mm512_storeu_ps         (dest[e].c[0], cx);
+            _mm512_storeu_ps         (dest[e].c[1], cy);
+            _mm512_storeu_ps         (dest[e].c[2], cz);
+            _mm512_storeu_ps         (dest[e].e[0], ex);
+            _mm512_storeu_ps         (dest[e].e[1], ey);
+            _mm512_storeu_ps         (dest[e].e[2], ez);
+        }
+
+        if (visible != nullptr) {
+            visible[e] = in;
+        }
+    }
+
+    return intrin512;
+
+#else
+
+    __m256   vecm[12], veca[9];
+    __m256   cx, cy, cz, ex, ey, ez, vecd, in;
+    __m256   sign = _mm256_set1_ps(-0.0f);
+    unsigned bits;
+
+    for (int i = 0; i < 12; ++i) {                          // Rows without 4th column
+        vecm[i] = _mm256_set1_ps(pm[i / 3 * 4 + i % 3]);
+    }
+    for (int i = 0; i < 9; ++i) {
+        veca[i] = _mm256_andnot_ps(sign, vecm[i]);
+    }
+
+    for (size_t e = 0; e < blocks; ++e) {
+        size_t rest = n - e * lanes;
+
+        bits = 0;
+        for (size_t h = 0; h < lanes; h += 8) {             // 8 boxes per register
+            cx = _mm256_loadu_ps     (src[e].c[0] + h);     // Transform centers
+            cy = _mm256_loadu_ps     (src[e].c[1] + h);
+            cz = _mm256_loadu_ps     (src[e].c[2] + h);
+            ex = _mm256_fmadd_ps     (cx, vecm[0], vecm[ 9]);
+            ey = _mm256_fmadd_ps     (cx, vecm[1], vecm[10]);
+            ez = _mm256_fmadd_ps     (cx, vecm[2], vecm[11]);
+            ex = _mm256_fmadd_ps     (cy, vecm[3], ex);
+            ey = _mm256_fmadd_ps     (cy, vecm[4], ey);
+            ez = _mm256_fmadd_ps     (cy, vecm[5], ez);
+            cx = _mm256_fmadd_ps     (cz, vecm[6], ex);
+            cy = _mm256_fmadd_ps     (cz, vecm[7], ey);
+            cz = _mm256_fmadd_ps     (cz, vecm[8], ez);
+
+            vecd = _mm256_loadu_ps   (src[e].e[0] + h);     // Transform extents
+            ex   = _mm256_mul_ps     (vecd, veca[0]);
+            ey   = _mm256_mul_ps     (vecd, veca[1]);
+            ez   = _mm256_mul_ps     (vecd, veca[2]);
+            vecd = _mm256_loadu_ps   (src[e].e[1] + h);
+            ex   = _mm256_fmadd_ps   (vecd, veca[3], ex);
+            ey   = _mm256_fmadd_ps   (vecd, veca[4], ey);
+            ez   = _mm256_fmadd_ps   (vecd, veca[5], ez);
+            vecd = _mm256_loadu_ps   (src[e].e[2] + h);
+            ex   = _mm256_fmadd_ps   (vecd, veca[6], ex);
+            ey   = _mm256_fmadd_ps   (vecd, veca[7], ey);
+            ez   = _mm256_fmadd_ps   (vecd, veca[8], ez);
+
+            in = _mm256_castsi256_ps (_mm256_set1_epi32(-1));
+
+            for (size_t p = 0; p < nplanes; ++p) {
+                float *pp = planes[p].v;
+
+                vecd = _mm256_fmadd_ps (cx, _mm256_set1_ps(pp[0]), _mm256_set1_ps(pp[3]));
+                vecd = _mm256_fmadd_ps (cy, _mm256_set1_ps(pp[1]), vecd);
+                vecd = _mm256_fmadd_ps (cz, _mm256_set1_ps(pp[2]), vecd);
+                vecd = _mm256_fmadd_ps (ex, _mm256_set1_ps(std::abs(pp[0])), vecd);
+                vecd = _mm256_fmadd_ps (ey, _mm256_set1_ps(std::abs(pp[1])), vecd);
+                vecd = _mm256_fmadd_ps (ez, _mm256_set1_ps(std::abs(pp[2])), vecd);
+                in   = _mm256_and_ps   (in, _mm256_cmp_ps(vecd, _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+
+            if (dest != nullptr) {
+                _mm256_storeu_ps     (dest[e].c[0] + h, cx);
+                _mm256_storeu_ps     (dest[e].c[1] + h, cy);
+                _mm256_storeu_ps     (dest[e].c[2] + h, cz);
+                _mm256_storeu_ps     (dest[e].e[0] + h, ex);
+                _mm256_storeu_ps     (dest[e].e[1] + h, ey);
+                _mm256_storeu_ps     (dest[e].e[2] + h, ez);
+            }
+
+            bits |= unsigned(_mm256_movemask_ps(in)) << h;
+        }
+
+        if (visible != nullptr) {
+            visible[e] = (rest < lanes) ? bits & ((1u << rest) - 1) : bits;
+        }
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+template <>
+inline specialized aabbsoa_x_mat(aabbsoa<double>   *dest,
+                                 unsigned          *visible,
+                                 aabbsoa<double>   *src,
+                                 mat<double, 4, 4> &m,
+                                 vec<double, 4>    *planes,
+                                 size_t            nplanes,
+                                 size_t            n) {
+    const size_t lanes  = aabbsoa<double>::lanes;
+    size_t       blocks = aabb_blocks<double>(n);
+    double       *pm    = m.m[0];
+
+// Compiler targeting AVX-512, a block of 8 boxes per register
+#if defined(__AVX512F__)
+
+    __m512d   vecm[12], veca[9];
+    __m512d   cx, cy, cz, ex, ey, ez, vecd;
+    __m512d   sign = _mm512_set1_pd(-0.0);
+    __mmask8  in;
+
+    for (int i = 0; i < 12; ++i) {                          // Rows without 4th column
+        vecm[i] = _mm512_set1_pd(pm[i / 3 * 4 + i % 3]);
+    }
+    for (int i = 0; i < 9; ++i) {
+        veca[i] = _mm512_castsi512_pd(_mm512_andnot_si512(_mm512_castpd_si512(sign),
+                                                          _mm512_castpd_si512(vecm[i])));
+    }
+
+    for (size_t e = 0; e < blocks; ++e) {
+        size_t rest = n - e * lanes;
+
+        cx = _mm512_loadu_pd         (src[e].c[0]);         // Transform centers
+        cy = _mm512_loadu_pd         (src[e].c[1]);
+        cz = _mm512_loadu_pd         (src[e].c[2]);
+        ex = _mm512_fmadd_pd         (cx, vecm[0], vecm[ 9]);
+        ey = _mm512_fmadd_pd         (cx, vecm[1], vecm[10]);
+        ez = _mm512_fmadd_pd         (cx, vecm[2], vecm[11]);
+        ex = _mm512_fmadd_pd         (cy, vecm[3], ex);
+        ey = _mm512_fmadd_pd         (cy, vecm[4], ey);
+        ez = _mm512_fmadd_pd         (cy, vecm[5], ez);
+        cx = _mm512_fmadd_pd         (cz, vecm[6], ex);
+        cy = _mm512_fmadd_pd         (cz, vecm[7], ey);
+        cz = _mm512_fmadd_pd         (cz, vecm[8], ez);
+
+        vecd = _mm512_loadu_pd       (src[e].e[0]);         // Transform extents
+        ex   = _mm512_mul_pd         (vecd, veca[0]);
+        ey   = _mm512_mul_pd         (vecd, veca[1]);
+        ez   = _mm512_mul_pd         (vecd, veca[2]);
+        vecd = _mm512_loadu_pd       (src[e].e[1]);
+        ex   = _mm512_fmadd_pd       (vecd, veca[3], ex);
+        ey   = _mm512_fmadd_pd       (vecd, veca[4], ey);
+        ez   = _mm512_fmadd_pd       (vecd, veca[5], ez);
+        vecd = _mm512_loadu_pd       (src[e].e[2]);
+        ex   = _mm512_fmadd_pd       (vecd, veca[6], ex);
+        ey   = _mm512_fmadd_pd       (vecd, veca[7], ey);
+        ez   = _mm512_fmadd_pd       (vecd, veca[8], ez);
+
+        in = (rest < lanes) ? __mmask8((1u << rest) - 1) : __mmask8(0xff);
+
+        for (size_t p = 0; p < nplanes; ++p) {
+            double *pp = planes[p].v;
+
+            vecd = _mm512_fmadd_pd   (cx, _mm512_set1_pd(pp[0]), _mm512_set1_pd(pp[3]));
+            vecd = _mm512_fmadd_pd   (cy, _mm512_set1_pd(pp[1]), vecd);
+            vecd = _mm512_fmadd_pd   (cz, _mm512_set1_pd(pp[2]), vecd);
+            vecd = _mm512_fmadd_pd   (ex, _mm512_set1_pd(std::abs(pp[0])), vecd);
+            vecd = _mm512_fmadd_pd   (ey, _mm512_set1_pd(std::abs(pp[1])), vecd);
+            vecd = _mm512_fmadd_pd   (ez, _mm512_set1_pd(std::abs(pp[2])), vecd);
+            in   = _mm512_mask_cmp_pd_mask (in, vecd, _mm512_setzero_pd(), _CMP_GE_OQ);
+        }
+
+        if (dest != nullptr) {
+            _mm512_storeu_pd         (dest[e].c[0], cx);
+            _mm512_storeu_pd         (dest[e].c[1], cy);
+            _mm512_storeu_pd         (dest[e].c[2], cz);
+            _mm512_storeu_pd         (dest[e].e[0], ex);
+            _mm512_storeu_pd         (dest[e].e[1], ey);
+            _mm512_storeu_pd         (dest[e].e[2], ez);
+        }
+
+        if (visible != nullptr) {
+            visible[e] = in;
+        }
+    }
+
+    return intrin512;
+
+#else
+
+    __m256d  vecm[12], veca[9];
+    __m256d  cx, cy, cz, ex, ey, ez, vecd, in;
+    __m256d  sign = _mm256_set1_pd(-0.0);
+    unsigned bits;
+
+    for (int i = 0; i < 12; ++i) {                          // Rows without 4th column
+        vecm[i] = _mm256_set1_pd(pm[i / 3 * 4 + i % 3]);
+    }
+    for (int i = 0; i < 9; ++i) {
+        veca[i] = _mm256_andnot_pd(sign, vecm[i]);
+    }
+
+    for (size_t e = 0; e < blocks; ++e) {
+        size_t rest = n - e * lanes;
+
+        bits = 0;
+        for (size_t h = 0; h < lanes; h += 4) {             // 4 boxes per register
+            cx = _mm256_loadu_pd     (src[e].c[0] + h);     // Transform centers
+            cy = _mm256_loadu_pd     (src[e].c[1] + h);
+            cz = _mm256_loadu_pd     (src[e].c[2] + h);
+            ex = _mm256_fmadd_pd     (cx, vecm[0], vecm[ 9]);
+            ey = _mm256_fmadd_pd     (cx, vecm[1], vecm[10]);
+            ez = _mm256_fmadd_pd     (cx, vecm[2], vecm[11]);
+            ex = _mm256_fmadd_pd     (cy, vecm[3], ex);
+            ey = _mm256_fmadd_pd     (cy, vecm[4], ey);
+            ez = _mm256_fmadd_pd     (cy, vecm[5], ez);
+            cx = _mm256_fmadd_pd     (cz, vecm[6], ex);
+            cy = _mm256_fmadd_pd     (cz, vecm[7], ey);
+            cz = _mm256_fmadd_pd     (cz, vecm[8], ez);
+
+            vecd = _mm256_loadu_pd   (src[e].e[0] + h);     // Transform extents
+            ex   = _mm256_mul_pd     (vecd, veca[0]);
+            ey   = _mm256_mul_pd     (vecd, veca[1]);
+            ez   = _mm256_mul_pd     (vecd, veca[2]);
+            vecd = _mm256_loadu_pd   (src[e].e[1] + h);
+            ex   = _mm256_fmadd_pd   (vecd, veca[3], ex);
+            ey   = _mm256_fmadd_pd   (vecd, veca[4], ey);
+            ez   = _mm256_fmadd_pd   (vecd, veca[5], ez);
+            vecd = _mm256_loadu_pd   (src[e].e[2] + h);
+            ex   = _mm256_fmadd_pd   (vecd, veca[6], ex);
+            ey   = _mm256_fmadd_pd   (vecd, veca[7], ey);
+            ez   = _mm256_fmadd_pd   (vecd, veca[8], ez);
+
+            in = _mm256_castsi256_pd (_mm256_set1_epi64x(-1));
+
+            for (size_t p = 0; p < nplanes; ++p) {
+                double *pp = planes[p].v;
+
+                vecd = _mm256_fmadd_pd (cx, _mm256_set1_pd(pp[0]), _mm256_set1_pd(pp[3]));
+                vecd = _mm256_fmadd_pd (cy, _mm256_set1_pd(pp[1]), vecd);
+                vecd = _mm256_fmadd_pd (cz, _mm256_set1_pd(pp[2]), vecd);
+                vecd = _mm256_fmadd_pd (ex, _mm256_set1_pd(std::abs(pp[0])), vecd);
+                vecd = _mm256_fmadd_pd (ey, _mm256_set1_pd(std::abs(pp[1])), vecd);
+                vecd = _mm256_fmadd_pd (ez, _mm256_set1_pd(std::abs(pp[2])), vecd);
+                in   = _mm256_and_pd   (in, _mm256_cmp_pd(vecd, _mm256_setzero_pd(), _CMP_GE_OQ));
+            }
+
+            if (dest != nullptr) {
+                _mm256_storeu_pd     (dest[e].c[0] + h, cx);
+                _mm256_storeu_pd     (dest[e].c[1] + h, cy);
+                _mm256_storeu_pd     (dest[e].c[2] + h, cz);
+                _mm256_storeu_pd     (dest[e].e[0] + h, ex);
+                _mm256_storeu_pd     (dest[e].e[1] + h, ey);
+                _mm256_storeu_pd     (dest[e].e[2] + h, ez);
+            }
+
+            bits |= unsigned(_mm256_movemask_pd(in)) << h;
+        }
+
+        if (visible != nullptr) {
+            visible[e] = (rest < lanes) ? bits & ((1u << rest) - 1) : bits;
+        }
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Transform with bounds
+
+// Matrix rows are repeated in each 128-bit (float) or 256-bit (double) lane
+// so every lane transforms its own vector. Minimum, maximum and sum stay in
+// registers and the lanes are only combined at the end.
+
+template <>
+inline specialized vecarr_x_mat_bounds(vec<float, 4>    *dest,
+                                       vec<float, 4>    &lo,
+                                       vec<float, 4>    &hi,
+                                       vec<float, 4>    *v,
+                                       mat<float, 4, 4> &m,
+                                       size_t           n,
+                                       vec<float, 4>    *sum) {
+    float  *pm = m.m[0];
+    __m128 veclo4, vechi4, vecs4;
+
+// Compiler targeting AVX-512, 4 vectors per register
+#if defined(__AVX512F__)
+
+    __m512    row0, row1, row2, row3, vecv, vecd, veclo, vechi, vecs;
+    __mmask16 mask;
+
+    row0  = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm +  0));
+    row1  = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm +  4));
+    row2  = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm +  8));
+    row3  = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm + 12));
+    veclo = _mm512_set1_ps         (std::numeric_limits<float>::max());
+    vechi = _mm512_set1_ps         (std::numeric_limits<float>::lowest());
+    vecs  = _mm512_setzero_ps      ();
+
+    for (size_t e = 0; e < n; e += 4) {                     // Last vectors masked
+        mask  = (n - e < 4) ? __mmask16((1u << (4 * (n - e))) - 1) : __mmask16(0xffff);
+        vecv  = _mm512_maskz_loadu_ps (mask, v[e].v);
+        vecd  = _mm512_mul_ps      (row0, _mm512_permute_ps(vecv, 0x00));
+        vecd  = _mm512_fmadd_ps    (row1, _mm512_permute_ps(vecv, 0x55), vecd);
+        vecd  = _mm512_fmadd_ps    (row2, _mm512_permute_ps(vecv, 0xaa), vecd);
+        vecd  = _mm512_fmadd_ps    (row3, _mm512_permute_ps(vecv, 0xff), vecd);
+
+        if (dest != nullptr) {
+            _mm512_mask_storeu_ps  (dest[e].v, mask, vecd);
+        }
+
+        veclo = _mm512_mask_min_ps (veclo, mask, veclo, vecd);
+        vechi = _mm512_mask_max_ps (vechi, mask, vechi, vecd);
+        vecs  = _mm512_add_ps      (vecs, vecd);            // Masked lanes are zero
+    }
+
+    veclo4 = _mm_min_ps            (_mm_min_ps(_mm512_castps512_ps128(veclo), _mm512_extractf32x4_ps(veclo, 1)),
+                                    _mm_min_ps(_mm512_extractf32x4_ps(veclo, 2), _mm512_extractf32x4_ps(veclo, 3)));
+    vechi4 = _mm_max_ps            (_mm_max_ps(_mm512_castps512_ps128(vechi), _mm512_extractf32x4_ps(vechi, 1)),
+                                    _mm_max_ps(_mm512_extractf32x4_ps(vechi, 2), _mm512_extractf32x4_ps(vechi, 3)));
+    vecs4  = _mm_add_ps            (_mm_add_ps(_mm512_castps512_ps128(vecs), _mm512_extractf32x4_ps(vecs, 1)),
+                                    _mm_add_ps(_mm512_extractf32x4_ps(vecs, 2), _mm512_extractf32x4_ps(vecs, 3)));
+             _mm_storeu_ps         (lo.v, veclo4);
+             _mm_storeu_ps         (hi.v, vechi4);
+
+    if (sum != nullptr) {
+             _mm_storeu_ps         (sum->v, vecs4);
+    }
+
+    return intrin512;
+
+#else
+
+    __m256 row0, row1, row2, row3, vecv, vecd, veclo, vechi, vecs;
+    __m128 vecv4, vecd4;
+    size_t e;
+
+    row0  = _mm256_broadcast_ps    ((const __m128 *) (pm +  0));
+    row1  = _mm256_broadcast_ps    ((const __m128 *) (pm +  4));
+    row2  = _mm256_broadcast_ps    ((const __m128 *) (pm +  8));
+    row3  = _mm256_broadcast_ps    ((const __m128 *) (pm + 12));
+    veclo = _mm256_set1_ps         (std::numeric_limits<float>::max());
+    vechi = _mm256_set1_ps         (std::numeric_limits<float>::lowest());
+    vecs  = _mm256_setzero_ps      ();
+
+    for (e = 0; e + 2 <= n; e += 2) {                       // 2 vectors per register
+        vecv  = _mm256_loadu_ps    (v[e].v);
+        vecd  = _mm256_mul_ps      (row0, _mm256_permute_ps(vecv, 0x00));
+        vecd  = _mm256_fmadd_ps    (row1, _mm256_permute_ps(vecv, 0x55), vecd);
+        vecd  = _mm256_fmadd_ps    (row2, _mm256_permute_ps(vecv, 0xaa), vecd);
+        vecd  = _mm256_fmadd_ps    (row3, _mm256_permute_ps(vecv, 0xff), vecd);
+
+        if (dest != nullptr) {
+            _mm256_storeu_ps       (dest[e].v, vecd);
+        }
+
+        veclo = _mm256_min_ps      (veclo, vecd);
+        vechi = _mm256_max_ps      (vechi, vecd);
+        vecs  = _mm256_add_ps      (vecs, vecd);
+    }
+
+    veclo4 = _mm_min_ps            (_mm256_castps256_ps128(veclo), _mm256_extractf128_ps(veclo, 1));
+    vechi4 = _mm_max_ps            (_mm256_castps256_ps128(vechi), _mm256_extractf128_ps(vechi, 1));
+    vecs4  = _mm_add_ps            (_mm256_castps256_ps128(vecs),  _mm256_extractf128_ps(vecs,  1));
+
+    if (e < n) {                                            // Odd vector, lower halves
+        vecv4  = _mm_loadu_ps      (v[e].v);
+        vecd4  = _mm_mul_ps        (_mm256_castps256_ps128(row0), _mm_permute_ps(vecv4, 0x00));
+        vecd4  = _mm_fmadd_ps      (_mm256_castps256_ps128(row1), _mm_permute_ps(vecv4, 0x55), vecd4);
+        vecd4  = _mm_fmadd_ps      (_mm256_castps256_ps128(row2), _mm_permute_ps(vecv4, 0xaa), vecd4);
+        vecd4  = _mm_fmadd_ps      (_mm256_castps256_ps128(row3), _mm_permute_ps(vecv4, 0xff), vecd4);
+
+        if (dest != nullptr) {
+            _mm_storeu_ps          (dest[e].v, vecd4);
+        }
+
+        veclo4 = _mm_min_ps        (veclo4, vecd4);
+        vechi4 = _mm_max_ps        (vechi4, vecd4);
+        vecs4  = _mm_add_ps        (vecs4,  vecd4);
+    }
+
+             _mm_storeu_ps         (lo.v, veclo4);
+             _mm_storeu_ps         (hi.v, vechi4);
+
+    if (sum != nullptr) {
+             _mm_storeu_ps         (sum->v, vecs4);
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+template <>
+inline specialized vecarr_x_mat_bounds(vec<double, 4>    *dest,
+                                       vec<double, 4>    &lo,
+                                       vec<double, 4>    &hi,
+                                       vec<double, 4>    *v,
+                                       mat<double, 4, 4> &m,
+                                       size_t            n,
+                                       vec<double, 4>    *sum) {
+    double  *pm = m.m[0];
+    __m256d veclo4, vechi4, vecs4;
+
+// Compiler targeting AVX-512, 2 vectors per register
+#if defined(__AVX512F__)
+
+    __m512d  row0, row1, row2, row3, vecv, vecd, veclo, vechi, vecs;
+    __mmask8 mask;
+
+    row0  = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm +  0));
+    row1  = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm +  4));
+    row2  = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm +  8));
+    row3  = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm + 12));
+    veclo = _mm512_set1_pd         (std::numeric_limits<double>::max());
+    vechi = _mm512_set1_pd         (std::numeric_limits<double>::lowest());
+    vecs  = _mm512_setzero_pd      ();
+
+    for (size_t e = 0; e < n; e += 2) {                     // Last vector masked
+        mask  = (n - e < 2) ? __mmask8(0x0f) : __mmask8(0xff);
+        vecv  = _mm512_maskz_loadu_pd (mask, v[e].v);
+        vecd  = _mm512_mul_pd      (row0, _mm512_permutex_pd(vecv, 0x00));
+        vecd  = _mm512_fmadd_pd    (row1, _mm512_permutex_pd(vecv, 0x55), vecd);
+        vecd  = _mm512_fmadd_pd    (row2, _mm512_permutex_pd(vecv, 0xaa), vecd);
+        vecd  = _mm512_fmadd_pd    (row3, _mm512_permutex_pd(vecv, 0xff), vecd);
+
+        if (dest != nullptr) {
+            _mm512_mask_storeu_pd  (dest[e].v, mask, vecd);
+        }
+
+        veclo = _mm512_mask_min_pd (veclo, mask, veclo, vecd);
+        vechi = _mm512_mask_max_pd (vechi, mask, vechi, vecd);
+        vecs  = _mm512_add_pd      (vecs, vecd);            // Masked lanes are zero
+    }
+
+    veclo4 = _mm256_min_pd         (_mm512_castpd512_pd256(veclo), _mm512_extractf64x4_pd(veclo, 1));
+    vechi4 = _mm256_max_pd         (_mm512_castpd512_pd256(vechi), _mm512_extractf64x4_pd(vechi, 1));
+    vecs4  = _mm256_add_pd         (_mm512_castpd512_pd256(vecs),  _mm512_extractf64x4_pd(vecs,  1));
+
+             _mm256_storeu_pd      (lo.v, veclo4);
+             _mm256_storeu_pd      (hi.v, vechi4);
+
+    if (sum != nullptr) {
+             _mm256_storeu_pd      (sum->v, vecs4);
+    }
+
+    return intrin512;
+
+#else
+
+    __m256d row0, row1, row2, row3, vecd;
+
+    row0   = _mm256_loadu_pd       (pm +  0);
+    row1   = _mm256_loadu_pd       (pm +  4);
+    row2   = _mm256_loadu_pd       (pm +  8);
+    row3   = _mm256_loadu_pd       (pm + 12);
+    veclo4 = _mm256_set1_pd        (std::numeric_limits<double>::max());
+    vechi4 = _mm256_set1_pd        (std::numeric_limits<double>::lowest());
+    vecs4  = _mm256_setzero_pd     ();
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pv = v[e].v;
+
+        vecd   = _mm256_mul_pd     (row0, _mm256_broadcast_sd(pv + 0));
+        vecd   = _mm256_fmadd_pd   (row1, _mm256_broadcast_sd(pv + 1), vecd);
+        vecd   = _mm256_fmadd_pd   (row2, _mm256_broadcast_sd(pv + 2), vecd);
+        vecd   = _mm256_fmadd_pd   (row3, _mm256_broadcast_sd(pv + 3), vecd);
+
+        if (dest != nullptr) {
+            _mm256_storeu_pd       (dest[e].v, vecd);
+        }
+
+        veclo4 = _mm256_min_pd     (veclo4, vecd);
+        vechi4 = _mm256_max_pd     (vechi4, vecd);
+        vecs4  = _mm256_add_pd     (vecs4,  vecd);
+    }
+
+             _mm256_storeu_pd      (lo.v, veclo4);
+             _mm256_storeu_pd      (hi.v, vechi4);
+
+    if (sum != nullptr) {
+             _mm256_storeu_pd      (sum->v, vecs4);
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Transform with compaction
+
+// Each lane is tested and the lanes of a vector must all pass. AVX-512
+// compresses the passing vectors to the bottom of a register and stores
+// only those, AVX2 permutes a passing upper vector down using a lookup
+// table and stores the pair, the next store overwrites what did not pass.
+
+template <>
+inline specialized vecarr_x_mat_compact(vec<float, 4>    *dest,
+                                        size_t           &count,
+                                        vec<float, 4>    *v,
+                                        mat<float, 4, 4> &m,
+                                        size_t           n,
+                                        condition        test,
+                                        vec<float, 4>    &lo,
+                                        vec<float, 4>    &hi) {
+    float *pm = m.m[0];
+
+    count = 0;
+
+// Compiler targeting AVX-512, 4 vectors per register
+#if defined(__AVX512F__)
+
+    __m512    row0, row1, row2, row3, vecv, vecd, veclo, vechi, vect;
+    __mmask16 mask, in;
+    unsigned  pass;
+
+    row0  = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm +  0));
+    row1  = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm +  4));
+    row2  = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm +  8));
+    row3  = _mm512_broadcast_f32x4 (_mm_loadu_ps(pm + 12));
+    veclo = _mm512_broadcast_f32x4 (_mm_loadu_ps(lo.v));
+    vechi = _mm512_broadcast_f32x4 (_mm_loadu_ps(hi.v));
+
+    for (size_t e = 0; e < n; e += 4) {                     // Last vectors masked
+        mask = (n - e < 4) ? __mmask16((1u << (4 * (n - e))) - 1) : __mmask16(0xffff);
+        vecv = _mm512_maskz_loadu_ps (mask, v[e].v);
+        vecd = _mm512_mul_ps       (row0, _mm512_permute_ps(vecv, 0x00));
+        vecd = _mm512_fmadd_ps     (row1, _mm512_permute_ps(vecv, 0x55), vecd);
+        vecd = _mm512_fmadd_ps     (row2, _mm512_permute_ps(vecv, 0xaa), vecd);
+        vecd = _mm512_fmadd_ps     (row3, _mm512_permute_ps(vecv, 0xff), vecd);
+
+        switch (test) {
+            case inside_box:                                // w lanes always pass
+                in   = _mm512_mask_cmp_ps_mask (_mm512_cmp_ps_mask(veclo, vecd, _CMP_LE_OQ),
+                                                vecd, vechi, _CMP_LE_OQ) | 0x8888;
+                break;
+            case above_plane:                               // Dot in every lane
+                vect = _mm512_mul_ps (vecd, veclo);
+                vect = _mm512_add_ps (vect, _mm512_permute_ps(vect, 0xb1));
+                vect = _mm512_add_ps (vect, _mm512_permute_ps(vect, 0x4e));
+                in   = _mm512_cmp_ps_mask (vect, _mm512_setzero_ps(), _CMP_GE_OQ);
+                break;
+            default:
+                vect = _mm512_permute_ps (vecd, 0xff);
+                in   = _mm512_cmp_ps_mask (_mm512_abs_ps(vecd), vect, _CMP_LE_OQ) | 0x8888;
+                break;
+        }
+
+        in   &= mask;                                       // 1st lane bit of passing vectors
+        pass  = in & (in >> 1) & (in >> 2) & (in >> 3) & 0x1111;
+        vect  = _mm512_maskz_compress_ps (__mmask16(pass * 0xf), vecd);
+                _mm512_mask_storeu_ps    (dest[count].v, __mmask16((1u << (4 * _mm_popcnt_u32(pass))) - 1), vect);
+        count += _mm_popcnt_u32(pass);
+    }
+
+    return intrin512;
+
+#else
+
+    alignas(32) static const int order[4][8] = {
+        { 0, 1, 2, 3, 4, 5, 6, 7 },                         // Neither
+        { 0, 1, 2, 3, 4, 5, 6, 7 },                         // Lower
+        { 4, 5, 6, 7, 0, 1, 2, 3 },                         // Upper moved down
+        { 0, 1, 2, 3, 4, 5, 6, 7 }                          // Both
+    };
+
+    __m256   row0, row1, row2, row3, vecv, vecd, veclo, vechi, vect, sign;
+    __m128   vecv4, vecd4;
+    unsigned bits, pass;
+    size_t   e;
+
+    row0  = _mm256_broadcast_ps    ((const __m128 *) (pm +  0));
+    row1  = _mm256_broadcast_ps    ((const __m128 *) (pm +  4));
+    row2  = _mm256_broadcast_ps    ((const __m128 *) (pm +  8));
+    row3  = _mm256_broadcast_ps    ((const __m128 *) (pm + 12));
+    veclo = _mm256_broadcast_ps    ((const __m128 *) lo.v);
+    vechi = _mm256_broadcast_ps    ((const __m128 *) hi.v);
+    sign  = _mm256_set1_ps         (-0.0f);
+
+    for (e = 0; e + 2 <= n; e += 2) {                       // 2 vectors per register
+        vecv = _mm256_loadu_ps     (v[e].v);
+        vecd = _mm256_mul_ps       (row0, _mm256_permute_ps(vecv, 0x00));
+        vecd = _mm256_fmadd_ps     (row1, _mm256_permute_ps(vecv, 0x55), vecd);
+        vecd = _mm256_fmadd_ps     (row2, _mm256_permute_ps(vecv, 0xaa), vecd);
+        vecd = _mm256_fmadd_ps     (row3, _mm256_permute_ps(vecv, 0xff), vecd);
+
+        switch (test) {
+            case inside_box:                                // w lanes always pass
+                vect = _mm256_and_ps (_mm256_cmp_ps(veclo, vecd, _CMP_LE_OQ),
+                                      _mm256_cmp_ps(vecd, vechi, _CMP_LE_OQ));
+                bits = _mm256_movemask_ps (vect) | 0x88;
+                break;
+            case above_plane:                               // Dot in every lane
+                vect = _mm256_mul_ps (vecd, veclo);
+                vect = _mm256_add_ps (vect, _mm256_permute_ps(vect, 0xb1));
+                vect = _mm256_add_ps (vect, _mm256_permute_ps(vect, 0x4e));
+                bits = _mm256_movemask_ps (_mm256_cmp_ps(vect, _mm256_setzero_ps(), _CMP_GE_OQ));
+                break;
+            default:
+                vect = _mm256_permute_ps (vecd, 0xff);
+                bits = _mm256_movemask_ps (_mm256_cmp_ps(_mm256_andnot_ps(sign, vecd), vect, _CMP_LE_OQ)) | 0x88;
+                break;
+        }
+
+        pass   = ((bits & 0x0f) == 0x0f) | (((bits & 0xf0) == 0xf0) << 1);
+        vecd   = _mm256_permutevar8x32_ps (vecd, _mm256_load_si256((const __m256i *) order[pass]));
+                 _mm256_storeu_ps  (dest[count].v, vecd);
+        count += (pass & 1) + (pass >> 1);
+    }
+
+    if (e < n) {                                            // Odd vector, lower halves
+        vec<float, 4> d;
+
+        vecv4 = _mm_loadu_ps       (v[e].v);
+        vecd4 = _mm_mul_ps         (_mm256_castps256_ps128(row0), _mm_permute_ps(vecv4, 0x00));
+        vecd4 = _mm_fmadd_ps       (_mm256_castps256_ps128(row1), _mm_permute_ps(vecv4, 0x55), vecd4);
+        vecd4 = _mm_fmadd_ps       (_mm256_castps256_ps128(row2), _mm_permute_ps(vecv4, 0xaa), vecd4);
+        vecd4 = _mm_fmadd_ps       (_mm256_castps256_ps128(row3), _mm_permute_ps(vecv4, 0xff), vecd4);
+                _mm_storeu_ps      (d.v, vecd4);
+
+        if (passes(d, test, lo, hi)) {
+            dest[count++] = d;
+        }
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+template <>
+inline specialized vecarr_x_mat_compact(vec<double, 4>    *dest,
+                                        size_t            &count,
+                                        vec<double, 4>    *v,
+                                        mat<double, 4, 4> &m,
+                                        size_t            n,
+                                        condition         test,
+                                        vec<double, 4>    &lo,
+                                        vec<double, 4>    &hi) {
+    double *pm = m.m[0];
+
+    count = 0;
+
+// Compiler targeting AVX-512, 2 vectors per register
+#if defined(__AVX512F__)
+
+    __m512d  row0, row1, row2, row3, vecv, vecd, veclo, vechi, vect;
+    __mmask8 mask, in;
+    unsigned pass;
+
+    row0  = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm +  0));
+    row1  = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm +  4));
+    row2  = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm +  8));
+    row3  = _mm512_broadcast_f64x4 (_mm256_loadu_pd(pm + 12));
+    veclo = _mm512_broadcast_f64x4 (_mm256_loadu_pd(lo.v));
+    vechi = _mm512_broadcast_f64x4 (_mm256_loadu_pd(hi.v));
+
+    for (size_t e = 0; e < n; e += 2) {                     // Last vector masked
+        mask = (n - e < 2) ? __mmask8(0x0f) : __mmask8(0xff);
+        vecv = _mm512_maskz_loadu_pd (mask, v[e].v);
+        vecd = _mm512_mul_pd       (row0, _mm512_permutex_pd(vecv, 0x00));
+        vecd = _mm512_fmadd_pd     (row1, _mm512_permutex_pd(vecv, 0x55), vecd);
+        vecd = _mm512_fmadd_pd     (row2, _mm512_permutex_pd(vecv, 0xaa), vecd);
+        vecd = _mm512_fmadd_pd     (row3, _mm512_permutex_pd(vecv, 0xff), vecd);
+
+        switch (test) {
+            case inside_box:                                // w lanes always pass
+                in   = _mm512_mask_cmp_pd_mask (_mm512_cmp_pd_mask(veclo, vecd, _CMP_LE_OQ),
+                                                vecd, vechi, _CMP_LE_OQ) | 0x88;
+                break;
+            case above_plane:                               // Dot in every lane
+                vect = _mm512_mul_pd (vecd, veclo);
+                vect = _mm512_add_pd (vect, _mm512_permutex_pd(vect, 0xb1));
+                vect = _mm512_add_pd (vect, _mm512_permutex_pd(vect, 0x4e));
+                in   = _mm512_cmp_pd_mask (vect, _mm512_setzero_pd(), _CMP_GE_OQ);
+                break;
+            default:
+                vect = _mm512_permutex_pd (vecd, 0xff);
+                in   = _mm512_cmp_pd_mask (_mm512_abs_pd(vecd), vect, _CMP_LE_OQ) | 0x88;
+                break;
+        }
+
+        in   &= mask;                                       // 1st lane bit of passing vectors
+        pass  = in & (in >> 1) & (in >> 2) & (in >> 3) & 0x11;
+        vect  = _mm512_maskz_compress_pd (__mmask8(pass * 0xf), vecd);
+                _mm512_mask_storeu_pd    (dest[count].v, __mmask8((1u << (4 * _mm_popcnt_u32(pass))) - 1), vect);
+        count += _mm_popcnt_u32(pass);
+    }
+
+    return intrin512;
+
+#else
+
+    __m256d  row0, row1, row2, row3, vecd, veclo, vechi, vect, sign;
+    unsigned bits;
+
+    row0  = _mm256_loadu_pd        (pm +  0);
+    row1  = _mm256_loadu_pd        (pm +  4);
+    row2  = _mm256_loadu_pd        (pm +  8);
+    row3  = _mm256_loadu_pd        (pm + 12);
+    veclo = _mm256_loadu_pd        (lo.v);
+    vechi = _mm256_loadu_pd        (hi.v);
+    sign  = _mm256_set1_pd         (-0.0);
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pv = v[e].v;
+
+        vecd = _mm256_mul_pd       (row0, _mm256_broadcast_sd(pv + 0));
+        vecd = _mm256_fmadd_pd     (row1, _mm256_broadcast_sd(pv + 1), vecd);
+        vecd = _mm256_fmadd_pd     (row2, _mm256_broadcast_sd(pv + 2), vecd);
+        vecd = _mm256_fmadd_pd     (row3, _mm256_broadcast_sd(pv + 3), vecd);
+
+        switch (test) {
+            case inside_box:                                // w lane always passes
+                vect = _mm256_and_pd (_mm256_cmp_pd(veclo, vecd, _CMP_LE_OQ),
+                                      _mm256_cmp_pd(vecd, vechi, _CMP_LE_OQ));
+                bits = _mm256_movemask_pd (vect) | 0x8;
+                break;
+            case above_plane:                               // Dot in every lane
+                vect = _mm256_mul_pd (vecd, veclo);
+                vect = _mm256_add_pd (vect, _mm256_permute_pd(vect, 0x5));
+                vect = _mm256_add_pd (vect, _mm256_permute2f128_pd(vect, vect, 0x01));
+                bits = _mm256_movemask_pd (_mm256_cmp_pd(vect, _mm256_setzero_pd(), _CMP_GE_OQ));
+                break;
+            default:
+                vect = _mm256_permute4x64_pd (vecd, 0xff);
+                bits = _mm256_movemask_pd (_mm256_cmp_pd(_mm256_andnot_pd(sign, vecd), vect, _CMP_LE_OQ)) | 0x8;
+                break;
+        }
+
+               _mm256_storeu_pd    (dest[count].v, vecd);   // Kept when counted
+        count += bits == 0xf;
+    }
+
+    return intrin;
+
+#endif  // __AVX512F__
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Vector array operations
+
+// Dot products and squared lengths of 8 float or 4 double vectors are summed
+// horizontally in registers and handled together. Cross products keep each
+// vector in its own 128-bit (float) or 256-bit (double) lane. Float
+// normalization may use the approximate reciprocal square root refined with
+// one Newton-Raphson step, y = y * (1.5 - 0.5 * x * y * y).
+// Blocks of 3 element vectors are processed 8 floats or 4 doubles at a time.
+
+template <>
+inline specialized vecarr_dot(float *dest, vec<float, 4> *a, vec<float, 4> *b, size_t n) {
+    __m256i order = _mm256_setr_epi32 (0, 4, 1, 5, 2, 6, 3, 7);
+    __m256  vec0, vec1, vec2, vec3, vecd;
+    __m128  vecs;
+    size_t  e;
+
+    for (e = 0; e + 8 <= n; e += 8) {
+        vec0 = _mm256_mul_ps         (_mm256_loadu_ps(a[e + 0].v), _mm256_loadu_ps(b[e + 0].v));
+        vec1 = _mm256_mul_ps         (_mm256_loadu_ps(a[e + 2].v), _mm256_loadu_ps(b[e + 2].v));
+        vec2 = _mm256_mul_ps         (_mm256_loadu_ps(a[e + 4].v), _mm256_loadu_ps(b[e + 4].v));
+        vec3 = _mm256_mul_ps         (_mm256_loadu_ps(a[e + 6].v), _mm256_loadu_ps(b[e + 6].v));
+        vec0 = _mm256_hadd_ps        (vec0, vec1);
+        vec2 = _mm256_hadd_ps        (vec2, vec3);
+        vecd = _mm256_hadd_ps        (vec0, vec2);          // Even products, then odd
+               _mm256_storeu_ps      (dest + e, _mm256_permutevar8x32_ps(vecd, order));
+    }
+
+    for (; e < n; ++e) {
+        vecs = _mm_mul_ps            (_mm_loadu_ps(a[e].v), _mm_loadu_ps(b[e].v));
+        vecs = _mm_hadd_ps           (vecs, vecs);
+        vecs = _mm_hadd_ps           (vecs, vecs);
+               _mm_store_ss          (dest + e, vecs);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_dot(double *dest, vec<double, 4> *a, vec<double, 4> *b, size_t n) {
+    __m256d vec0, vec1, vec2, vec3, vecd;
+    size_t  e;
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        vec0 = _mm256_mul_pd         (_mm256_loadu_pd(a[e + 0].v), _mm256_loadu_pd(b[e + 0].v));
+        vec1 = _mm256_mul_pd         (_mm256_loadu_pd(a[e + 1].v), _mm256_loadu_pd(b[e + 1].v));
+        vec2 = _mm256_mul_pd         (_mm256_loadu_pd(a[e + 2].v), _mm256_loadu_pd(b[e + 2].v));
+        vec3 = _mm256_mul_pd         (_mm256_loadu_pd(a[e + 3].v), _mm256_loadu_pd(b[e + 3].v));
+        vec0 = _mm256_hadd_pd        (vec0, vec1);          // Lower and upper half sums
+        vec2 = _mm256_hadd_pd        (vec2, vec3);
+        vecd = _mm256_add_pd         (_mm256_permute2f128_pd(vec0, vec2, 0x20),
+                                      _mm256_permute2f128_pd(vec0, vec2, 0x31));
+               _mm256_storeu_pd      (dest + e, vecd);
+    }
+
+    for (; e < n; ++e) {
+        vecd = _mm256_mul_pd         (_mm256_loadu_pd(a[e].v), _mm256_loadu_pd(b[e].v));
+        vecd = _mm256_add_pd         (vecd, _mm256_permute_pd(vecd, 0x5));
+        vecd = _mm256_add_pd         (vecd, _mm256_permute2f128_pd(vecd, vecd, 0x01));
+               _mm_store_sd          (dest + e, _mm256_castpd256_pd128(vecd));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_cross(vec<float, 4> *dest, vec<float, 4> *a, vec<float, 4> *b, size_t n) {
+    __m256 veca, vecb, vecd;
+    __m128 veca4, vecb4, vecd4;
+    size_t e;
+
+    for (e = 0; e + 2 <= n; e += 2) {                       // [ y z x w ] * [ z x y w ]
+        veca = _mm256_loadu_ps       (a[e].v);              //   - [ z x y w ] * [ y z x w ]
+        vecb = _mm256_loadu_ps       (b[e].v);
+        vecd = _mm256_sub_ps         (_mm256_mul_ps(_mm256_permute_ps(veca, 0xc9), _mm256_permute_ps(vecb, 0xd2)),
+                                      _mm256_mul_ps(_mm256_permute_ps(veca, 0xd2), _mm256_permute_ps(vecb, 0xc9)));
+               _mm256_storeu_ps      (dest[e].v, vecd);
+    }
+
+    if (e < n) {
+        veca4 = _mm_loadu_ps         (a[e].v);
+        vecb4 = _mm_loadu_ps         (b[e].v);
+        vecd4 = _mm_sub_ps           (_mm_mul_ps(_mm_permute_ps(veca4, 0xc9), _mm_permute_ps(vecb4, 0xd2)),
+                                      _mm_mul_ps(_mm_permute_ps(veca4, 0xd2), _mm_permute_ps(vecb4, 0xc9)));
+                _mm_storeu_ps        (dest[e].v, vecd4);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_cross(vec<double, 4> *dest, vec<double, 4> *a, vec<double, 4> *b, size_t n) {
+    __m256d veca, vecb, vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        veca = _mm256_loadu_pd       (a[e].v);
+        vecb = _mm256_loadu_pd       (b[e].v);
+        vecd = _mm256_sub_pd         (_mm256_mul_pd(_mm256_permute4x64_pd(veca, 0xc9), _mm256_permute4x64_pd(vecb, 0xd2)),
+                                      _mm256_mul_pd(_mm256_permute4x64_pd(veca, 0xd2), _mm256_permute4x64_pd(vecb, 0xc9)));
+               _mm256_storeu_pd      (dest[e].v, vecd);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_length(float *dest, vec<float, 4> *a, size_t n) {
+    __m256i order = _mm256_setr_epi32 (0, 4, 1, 5, 2, 6, 3, 7);
+    __m256  vec0, vec1, vec2, vec3, vecd;
+    __m128  vecs;
+    size_t  e;
+
+    for (e = 0; e + 8 <= n; e += 8) {
+        vec0 = _mm256_loadu_ps       (a[e + 0].v);
+        vec1 = _mm256_loadu_ps       (a[e + 2].v);
+        vec2 = _mm256_loadu_ps       (a[e + 4].v);
+        vec3 = _mm256_loadu_ps       (a[e + 6].v);
+        vec0 = _mm256_hadd_ps        (_mm256_mul_ps(vec0, vec0), _mm256_mul_ps(vec1, vec1));
+        vec2 = _mm256_hadd_ps        (_mm256_mul_ps(vec2, vec2), _mm256_mul_ps(vec3, vec3));
+        vecd = _mm256_sqrt_ps        (_mm256_hadd_ps(vec0, vec2));
+               _mm256_storeu_ps      (dest + e, _mm256_permutevar8x32_ps(vecd, order));
+    }
+
+    for (; e < n; ++e) {
+        vecs = _mm_loadu_ps          (a[e].v);
+        vecs = _mm_mul_ps            (vecs, vecs);
+        vecs = _mm_hadd_ps           (vecs, vecs);
+        vecs = _mm_hadd_ps           (vecs, vecs);
+               _mm_store_ss          (dest + e, _mm_sqrt_ss(vecs));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_length(double *dest, vec<double, 4> *a, size_t n) {
+    __m256d vec0, vec1, vec2, vec3, vecd;
+    size_t  e;
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        vec0 = _mm256_loadu_pd       (a[e + 0].v);
+        vec1 = _mm256_loadu_pd       (a[e + 1].v);
+        vec2 = _mm256_loadu_pd       (a[e + 2].v);
+        vec3 = _mm256_loadu_pd       (a[e + 3].v);
+        vec0 = _mm256_hadd_pd        (_mm256_mul_pd(vec0, vec0), _mm256_mul_pd(vec1, vec1));
+        vec2 = _mm256_hadd_pd        (_mm256_mul_pd(vec2, vec2), _mm256_mul_pd(vec3, vec3));
+        vecd = _mm256_add_pd         (_mm256_permute2f128_pd(vec0, vec2, 0x20),
+                                      _mm256_permute2f128_pd(vec0, vec2, 0x31));
+               _mm256_storeu_pd      (dest + e, _mm256_sqrt_pd(vecd));
+    }
+
+    for (; e < n; ++e) {
+        vecd = _mm256_loadu_pd       (a[e].v);
+        vecd = _mm256_mul_pd         (vecd, vecd);
+        vecd = _mm256_add_pd         (vecd, _mm256_permute_pd(vecd, 0x5));
+        vecd = _mm256_add_pd         (vecd, _mm256_permute2f128_pd(vecd, vecd, 0x01));
+               _mm_store_sd          (dest + e, _mm_sqrt_pd(_mm256_castpd256_pd128(vecd)));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_normalize(vec<float, 4> *dest,
+                                    vec<float, 4> *a,
+                                    size_t        n,
+                                    bool          approx) {
+    __m256 vec0, vec1, vec2, vec3, vecs, vecr, half, three;
+    __m128 veca4, vecs4, vecr4;
+    size_t e;
+
+    half  = _mm256_set1_ps           (0.5f);
+    three = _mm256_set1_ps           (1.5f);
+
+    for (e = 0; e + 8 <= n; e += 8) {
+        vec0 = _mm256_loadu_ps       (a[e + 0].v);
+        vec1 = _mm256_loadu_ps       (a[e + 2].v);
+        vec2 = _mm256_loadu_ps       (a[e + 4].v);
+        vec3 = _mm256_loadu_ps       (a[e + 6].v);
+        vecr = _mm256_hadd_ps        (_mm256_mul_ps(vec0, vec0), _mm256_mul_ps(vec1, vec1));
+        vecs = _mm256_hadd_ps        (_mm256_mul_ps(vec2, vec2), _mm256_mul_ps(vec3, vec3));
+        vecs = _mm256_hadd_ps        (vecr, vecs);          // Even squared lengths, then odd
+
+        if (approx) {
+            vecr = _mm256_rsqrt_ps   (vecs);                // Approximation
+            vecs = _mm256_mul_ps     (_mm256_mul_ps(vecs, half), _mm256_mul_ps(vecr, vecr));
+            vecr = _mm256_mul_ps     (vecr, _mm256_sub_ps(three, vecs));    // Newton-Raphson step
+        } else {
+            vecr = _mm256_div_ps     (_mm256_set1_ps(1.0f), _mm256_sqrt_ps(vecs));
+        }
+
+               _mm256_storeu_ps      (dest[e + 0].v, _mm256_mul_ps(vec0, _mm256_permute_ps(vecr, 0x00)));
+               _mm256_storeu_ps      (dest[e + 2].v, _mm256_mul_ps(vec1, _mm256_permute_ps(vecr, 0x55)));
+               _mm256_storeu_ps      (dest[e + 4].v, _mm256_mul_ps(vec2, _mm256_permute_ps(vecr, 0xaa)));
+               _mm256_storeu_ps      (dest[e + 6].v, _mm256_mul_ps(vec3, _mm256_permute_ps(vecr, 0xff)));
+    }
+
+    for (; e < n; ++e) {
+        veca4 = _mm_loadu_ps         (a[e].v);
+        vecs4 = _mm_mul_ps           (veca4, veca4);        // Squared length in every element
+        vecs4 = _mm_add_ps           (vecs4, _mm_permute_ps(vecs4, 0xb1));
+        vecs4 = _mm_add_ps           (vecs4, _mm_permute_ps(vecs4, 0x4e));
+
+        if (approx) {
+            vecr4 = _mm_rsqrt_ps     (vecs4);
+            vecs4 = _mm_mul_ps       (_mm_mul_ps(vecs4, _mm256_castps256_ps128(half)), _mm_mul_ps(vecr4, vecr4));
+            vecr4 = _mm_mul_ps       (vecr4, _mm_sub_ps(_mm256_castps256_ps128(three), vecs4));
+            veca4 = _mm_mul_ps       (veca4, vecr4);
+        } else {
+            veca4 = _mm_div_ps       (veca4, _mm_sqrt_ps(vecs4));
+        }
+
+                _mm_storeu_ps        (dest[e].v, veca4);
+    }
+
+    return intrin;
+}
+
+// No double reciprocal square root approximation in AVX2, always divide
+template <>
+inline specialized vecarr_normalize(vec<double, 4> *dest,
+                                    vec<double, 4> *a,
+                                    size_t         n,
+                                    bool           approx) {
+    __m256d vec0, vec1, vec2, vec3, vecs, vecr;
+    size_t  e;
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        vec0 = _mm256_loadu_pd       (a[e + 0].v);
+        vec1 = _mm256_loadu_pd       (a[e + 1].v);
+        vec2 = _mm256_loadu_pd       (a[e + 2].v);
+        vec3 = _mm256_loadu_pd       (a[e + 3].v);
+        vecr = _mm256_hadd_pd        (_mm256_mul_pd(vec0, vec0), _mm256_mul_pd(vec1, vec1));
+        vecs = _mm256_hadd_pd        (_mm256_mul_pd(vec2, vec2), _mm256_mul_pd(vec3, vec3));
+        vecs = _mm256_add_pd         (_mm256_permute2f128_pd(vecr, vecs, 0x20),
+                                      _mm256_permute2f128_pd(vecr, vecs, 0x31));
+        vecr = _mm256_div_pd         (_mm256_set1_pd(1.0), _mm256_sqrt_pd(vecs));
+               _mm256_storeu_pd      (dest[e + 0].v, _mm256_mul_pd(vec0, _mm256_permute4x64_pd(vecr, 0x00)));
+               _mm256_storeu_pd      (dest[e + 1].v, _mm256_mul_pd(vec1, _mm256_permute4x64_pd(vecr, 0x55)));
+               _mm256_storeu_pd      (dest[e + 2].v, _mm256_mul_pd(vec2, _mm256_permute4x64_pd(vecr, 0xaa)));
+               _mm256_storeu_pd      (dest[e + 3].v, _mm256_mul_pd(vec3, _mm256_permute4x64_pd(vecr, 0xff)));
+    }
+
+    for (; e < n; ++e) {
+        vec0 = _mm256_loadu_pd       (a[e].v);
+        vecs = _mm256_mul_pd         (vec0, vec0);          // Squared length in every element
+        vecs = _mm256_add_pd         (vecs, _mm256_permute_pd(vecs, 0x5));
+        vecs = _mm256_add_pd         (vecs, _mm256_permute2f128_pd(vecs, vecs, 0x01));
+               _mm256_storeu_pd      (dest[e].v, _mm256_div_pd(vec0, _mm256_sqrt_pd(vecs)));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_dot(float           *dest,
+                              vecsoa<float, 3> *a,
+                              vecsoa<float, 3> *b,
+                              size_t           blocks) {
+    const size_t lanes = vecsoa<float, 3>::lanes;
+    __m256       vecd;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 8) {
+            vecd = _mm256_mul_ps     (_mm256_loadu_ps(a[e].v[0] + h), _mm256_loadu_ps(b[e].v[0] + h));
+            vecd = _mm256_fmadd_ps   (_mm256_loadu_ps(a[e].v[1] + h), _mm256_loadu_ps(b[e].v[1] + h), vecd);
+            vecd = _mm256_fmadd_ps   (_mm256_loadu_ps(a[e].v[2] + h), _mm256_loadu_ps(b[e].v[2] + h), vecd);
+                   _mm256_storeu_ps  (dest + e * lanes + h, vecd);
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_dot(double           *dest,
+                              vecsoa<double, 3> *a,
+                              vecsoa<double, 3> *b,
+                              size_t            blocks) {
+    const size_t lanes = vecsoa<double, 3>::lanes;
+    __m256d      vecd;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 4) {
+            vecd = _mm256_mul_pd     (_mm256_loadu_pd(a[e].v[0] + h), _mm256_loadu_pd(b[e].v[0] + h));
+            vecd = _mm256_fmadd_pd   (_mm256_loadu_pd(a[e].v[1] + h), _mm256_loadu_pd(b[e].v[1] + h), vecd);
+            vecd = _mm256_fmadd_pd   (_mm256_loadu_pd(a[e].v[2] + h), _mm256_loadu_pd(b[e].v[2] + h), vecd);
+                   _mm256_storeu_pd  (dest + e * lanes + h, vecd);
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_cross(vecsoa<float, 3> *dest,
+                                vecsoa<float, 3> *a,
+                                vecsoa<float, 3> *b,
+                                size_t           blocks) {
+    const size_t lanes = vecsoa<float, 3>::lanes;
+    __m256       ax, ay, az, bx, by, bz;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 8) {
+            ax = _mm256_loadu_ps     (a[e].v[0] + h);
+            ay = _mm256_loadu_ps     (a[e].v[1] + h);
+            az = _mm256_loadu_ps     (a[e].v[2] + h);
+            bx = _mm256_loadu_ps     (b[e].v[0] + h);
+            by = _mm256_loadu_ps     (b[e].v[1] + h);
+            bz = _mm256_loadu_ps     (b[e].v[2] + h);
+                 _mm256_storeu_ps    (dest[e].v[0] + h, _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by)));
+                 _mm256_storeu_ps    (dest[e].v[1] + h, _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz)));
+                 _mm256_storeu_ps    (dest[e].v[2] + h, _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx)));
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_cross(vecsoa<double, 3> *dest,
+                                vecsoa<double, 3> *a,
+                                vecsoa<double, 3> *b,
+                                size_t            blocks) {
+    const size_t lanes = vecsoa<double, 3>::lanes;
+    __m256d      ax, ay, az, bx, by, bz;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 4) {
+            ax = _mm256_loadu_pd     (a[e].v[0] + h);
+            ay = _mm256_loadu_pd     (a[e].v[1] + h);
+            az = _mm256_loadu_pd     (a[e].v[2] + h);
+            bx = _mm256_loadu_pd     (b[e].v[0] + h);
+            by = _mm256_loadu_pd     (b[e].v[1] + h);
+            bz = _mm256_loadu_pd     (b[e].v[2] + h);
+                 _mm256_storeu_pd    (dest[e].v[0] + h, _mm256_sub_pd(_mm256_mul_pd(ay, bz), _mm256_mul_pd(az, by)));
+                 _mm256_storeu_pd    (dest[e].v[1] + h, _mm256_sub_pd(_mm256_mul_pd(az, bx), _mm256_mul_pd(ax, bz)));
+                 _mm256_storeu_pd    (dest[e].v[2] + h, _mm256_sub_pd(_mm256_mul_pd(ax, by), _mm256_mul_pd(ay, bx)));
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_length(float *dest, vecsoa<float, 3> *a, size_t blocks) {
+    const size_t lanes = vecsoa<float, 3>::lanes;
+    __m256       vecx, vecy, vecz;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 8) {
+            vecx = _mm256_loadu_ps   (a[e].v[0] + h);
+            vecy = _mm256_loadu_ps   (a[e].v[1] + h);
+            vecz = _mm256_loadu_ps   (a[e].v[2] + h);
+            vecx = _mm256_fmadd_ps   (vecy, vecy, _mm256_mul_ps(vecx, vecx));
+            vecx = _mm256_fmadd_ps   (vecz, vecz, vecx);
+                   _mm256_storeu_ps  (dest + e * lanes + h, _mm256_sqrt_ps(vecx));
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_length(double *dest, vecsoa<double, 3> *a, size_t blocks) {
+    const size_t lanes = vecsoa<double, 3>::lanes;
+    __m256d      vecx, vecy, vecz;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 4) {
+            vecx = _mm256_loadu_pd   (a[e].v[0] + h);
+            vecy = _mm256_loadu_pd   (a[e].v[1] + h);
+            vecz = _mm256_loadu_pd   (a[e].v[2] + h);
+            vecx = _mm256_fmadd_pd   (vecy, vecy, _mm256_mul_pd(vecx, vecx));
+            vecx = _mm256_fmadd_pd   (vecz, vecz, vecx);
+                   _mm256_storeu_pd  (dest + e * lanes + h, _mm256_sqrt_pd(vecx));
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_normalize(vecsoa<float, 3> *dest,
+                                    vecsoa<float, 3> *a,
+                                    size_t           blocks,
+                                    bool             approx) {
+    const size_t lanes = vecsoa<float, 3>::lanes;
+    __m256       vecx, vecy, vecz, vecs, vecr, half, three;
+
+    half  = _mm256_set1_ps           (0.5f);
+    three = _mm256_set1_ps           (1.5f);
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 8) {
+            vecx = _mm256_loadu_ps   (a[e].v[0] + h);
+            vecy = _mm256_loadu_ps   (a[e].v[1] + h);
+            vecz = _mm256_loadu_ps   (a[e].v[2] + h);
+            vecs = _mm256_fmadd_ps   (vecy, vecy, _mm256_mul_ps(vecx, vecx));
+            vecs = _mm256_fmadd_ps   (vecz, vecz, vecs);
+
+            if (approx) {
+                vecr = _mm256_rsqrt_ps (vecs);              // Approximation
+                vecs = _mm256_mul_ps   (_mm256_mul_ps(vecs, half), _mm256_mul_ps(vecr, vecr));
+                vecr = _mm256_mul_ps   (vecr, _mm256_sub_ps(three, vecs));  // Newton-Raphson step
+            } else {
+                vecr = _mm256_div_ps   (_mm256_set1_ps(1.0f), _mm256_sqrt_ps(vecs));
+            }
+
+                   _mm256_storeu_ps  (dest[e].v[0] + h, _mm256_mul_ps(vecx, vecr));
+                   _mm256_storeu_ps  (dest[e].v[1] + h, _mm256_mul_ps(vecy, vecr));
+                   _mm256_storeu_ps  (dest[e].v[2] + h, _mm256_mul_ps(vecz, vecr));
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_normalize(vecsoa<double, 3> *dest,
+                                    vecsoa<double, 3> *a,
+                                    size_t            blocks,
+                                    bool              approx) {
+    const size_t lanes = vecsoa<double, 3>::lanes;
+    __m256d      vecx, vecy, vecz, vecs, vecr;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 4) {
+            vecx = _mm256_loadu_pd   (a[e].v[0] + h);
+            vecy = _mm256_loadu_pd   (a[e].v[1] + h);
+            vecz = _mm256_loadu_pd   (a[e].v[2] + h);
+            vecs = _mm256_fmadd_pd   (vecy, vecy, _mm256_mul_pd(vecx, vecx));
+            vecs = _mm256_fmadd_pd   (vecz, vecz, vecs);
+            vecr = _mm256_div_pd     (_mm256_set1_pd(1.0), _mm256_sqrt_pd(vecs));
+                   _mm256_storeu_pd  (dest[e].v[0] + h, _mm256_mul_pd(vecx, vecr));
+                   _mm256_storeu_pd  (dest[e].v[1] + h, _mm256_mul_pd(vecy, vecr));
+                   _mm256_storeu_pd  (dest[e].v[2] + h, _mm256_mul_pd(vecz, vecr));
+        }
+    }
+
+    return intrin;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Interpolation
+//
+// Float lerp processes 2 vectors per 256-bit register. nlerp and slerp find
+// the dot products of 8 float or 4 double quaternions together, as with
+// vecarr_dot, and broadcast the weights of each quaternion across its lane.
+// Keyframe sampling finds the keys of each channel, then interpolates
+// 2 float channels or 1 double channel per register.
+
+template <>
+inline specialized vecarr_lerp(vec<float, 4> *dest,
+                               vec<float, 4> *a,
+                               vec<float, 4> *b,
+                               float         t,
+                               size_t        n) {
+    __m256 veca, vecb, vect;
+    __m128 veca4, vecb4;
+    size_t e;
+
+    vect = _mm256_set1_ps            (t);
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        veca = _mm256_loadu_ps       (a[e].v);
+        vecb = _mm256_loadu_ps       (b[e].v);
+               _mm256_storeu_ps      (dest[e].v, _mm256_fmadd_ps(vect, _mm256_sub_ps(vecb, veca), veca));
+    }
+
+    if (e < n) {
+        veca4 = _mm_loadu_ps         (a[e].v);
+        vecb4 = _mm_loadu_ps         (b[e].v);
+                _mm_storeu_ps        (dest[e].v, _mm_fmadd_ps(_mm256_castps256_ps128(vect),
+                                                              _mm_sub_ps(vecb4, veca4), veca4));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_lerp(vec<double, 4> *dest,
+                               vec<double, 4> *a,
+                               vec<double, 4> *b,
+                               double         t,
+                               size_t         n) {
+    __m256d veca, vecb, vect;
+
+    vect = _mm256_set1_pd            (t);
+
+    for (size_t e = 0; e < n; ++e) {
+        veca = _mm256_loadu_pd       (a[e].v);
+        vecb = _mm256_loadu_pd       (b[e].v);
+               _mm256_storeu_pd      (dest[e].v, _mm256_fmadd_pd(vect, _mm256_sub_pd(vecb, veca), veca));
+    }
+
+    return intrin;
+}
+
+// Rows of 4x4 matrices are contiguous 4 element vectors
+template <>
+inline specialized matarr_lerp(mat<float, 4, 4> *dest,
+                               mat<float, 4, 4> *a,
+                               mat<float, 4, 4> *b,
+                               float            t,
+                               size_t           n) {
+    return vecarr_lerp((vec<float, 4> *) dest, (vec<float, 4> *) a, (vec<float, 4> *) b, t, n * 4);
+}
+
+template <>
+inline specialized matarr_lerp(mat<double, 4, 4> *dest,
+                               mat<double, 4, 4> *a,
+                               mat<double, 4, 4> *b,
+                               double            t,
+                               size_t            n) {
+    return vecarr_lerp((vec<double, 4> *) dest, (vec<double, 4> *) a, (vec<double, 4> *) b, t, n * 4);
+}
+
+template <>
+inline specialized quatarr_nlerp(quat<float> *dest,
+                                 quat<float> *a,
+                                 quat<float> *b,
+                                 float       t,
+                                 size_t      n) {
+    __m256 veca0, veca1, veca2, veca3, vecb0, vecb1, vecb2, vecb3;
+    __m256 vecd, vecs, vecw, vect, vecu, sign;
+    __m128 veca4, vecb4, vecd4;
+    size_t e;
+
+    vect = _mm256_set1_ps            (t);
+    vecu = _mm256_set1_ps            (1.0f - t);
+    sign = _mm256_set1_ps            (-0.0f);
+
+    for (e = 0; e + 8 <= n; e += 8) {
+        veca0 = _mm256_loadu_ps      (a[e + 0].v);
+        veca1 = _mm256_loadu_ps      (a[e + 2].v);
+        veca2 = _mm256_loadu_ps      (a[e + 4].v);
+        veca3 = _mm256_loadu_ps      (a[e + 6].v);
+        vecb0 = _mm256_loadu_ps      (b[e + 0].v);
+        vecb1 = _mm256_loadu_ps      (b[e + 2].v);
+        vecb2 = _mm256_loadu_ps      (b[e + 4].v);
+        vecb3 = _mm256_loadu_ps      (b[e + 6].v);
+        vecd  = _mm256_hadd_ps       (_mm256_mul_ps(veca0, vecb0), _mm256_mul_ps(veca1, vecb1));
+        vecs  = _mm256_hadd_ps       (_mm256_mul_ps(veca2, vecb2), _mm256_mul_ps(veca3, vecb3));
+        vecd  = _mm256_hadd_ps       (vecd, vecs);          // Even dot products, then odd
+        vecw  = _mm256_xor_ps        (vect, _mm256_and_ps(vecd, sign));    // t with sign of dot
+
+        veca0 = _mm256_fmadd_ps      (vecb0, _mm256_permute_ps(vecw, 0x00), _mm256_mul_ps(veca0, vecu));
+        veca1 = _mm256_fmadd_ps      (vecb1, _mm256_permute_ps(vecw, 0x55), _mm256_mul_ps(veca1, vecu));
+        veca2 = _mm256_fmadd_ps      (vecb2, _mm256_permute_ps(vecw, 0xaa), _mm256_mul_ps(veca2, vecu));
+        veca3 = _mm256_fmadd_ps      (vecb3, _mm256_permute_ps(vecw, 0xff), _mm256_mul_ps(veca3, vecu));
+
+        vecd  = _mm256_hadd_ps       (_mm256_mul_ps(veca0, veca0), _mm256_mul_ps(veca1, veca1));
+        vecs  = _mm256_hadd_ps       (_mm256_mul_ps(veca2, veca2), _mm256_mul_ps(veca3, veca3));
+        vecs  = _mm256_hadd_ps       (vecd, vecs);          // Squared lengths
+        vecs  = _mm256_div_ps        (_mm256_set1_ps(1.0f), _mm256_sqrt_ps(vecs));
+                _mm256_storeu_ps     (dest[e + 0].v, _mm256_mul_ps(veca0, _mm256_permute_ps(vecs, 0x00)));
+                _mm256_storeu_ps     (dest[e + 2].v, _mm256_mul_ps(veca1, _mm256_permute_ps(vecs, 0x55)));
+                _mm256_storeu_ps     (dest[e + 4].v, _mm256_mul_ps(veca2, _mm256_permute_ps(vecs, 0xaa)));
+                _mm256_storeu_ps     (dest[e + 6].v, _mm256_mul_ps(veca3, _mm256_permute_ps(vecs, 0xff)));
+    }
+
+    for (; e < n; ++e) {
+        veca4 = _mm_loadu_ps         (a[e].v);
+        vecb4 = _mm_loadu_ps         (b[e].v);
+        vecd4 = _mm_mul_ps           (veca4, vecb4);        // Dot product in every element
+        vecd4 = _mm_add_ps           (vecd4, _mm_permute_ps(vecd4, 0xb1));
+        vecd4 = _mm_add_ps           (vecd4, _mm_permute_ps(vecd4, 0x4e));
+        vecd4 = _mm_xor_ps           (_mm256_castps256_ps128(vect),
+                                      _mm_and_ps(vecd4, _mm256_castps256_ps128(sign)));
+        veca4 = _mm_fmadd_ps         (vecb4, vecd4, _mm_mul_ps(veca4, _mm256_castps256_ps128(vecu)));
+        vecd4 = _mm_mul_ps           (veca4, veca4);        // Squared length
+        vecd4 = _mm_add_ps           (vecd4, _mm_permute_ps(vecd4, 0xb1));
+        vecd4 = _mm_add_ps           (vecd4, _mm_permute_ps(vecd4, 0x4e));
+                _mm_storeu_ps        (dest[e].v, _mm_div_ps(veca4, _mm_sqrt_ps(vecd4)));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized quatarr_nlerp(quat<double> *dest,
+                                 quat<double> *a,
+                                 quat<double> *b,
+                                 double       t,
+                                 size_t       n) {
+    __m256d veca0, veca1, veca2, veca3, vecb0, vecb1, vecb2, vecb3;
+    __m256d vecd, vecs, vecw, vect, vecu, sign;
+    size_t  e;
+
+    vect = _mm256_set1_pd            (t);
+    vecu = _mm256_set1_pd            (1.0 - t);
+    sign = _mm256_set1_pd            (-0.0);
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        veca0 = _mm256_loadu_pd      (a[e + 0].v);
+        veca1 = _mm256_loadu_pd      (a[e + 1].v);
+        veca2 = _mm256_loadu_pd      (a[e + 2].v);
+        veca3 = _mm256_loadu_pd      (a[e + 3].v);
+        vecb0 = _mm256_loadu_pd      (b[e + 0].v);
+        vecb1 = _mm256_loadu_pd      (b[e + 1].v);
+        vecb2 = _mm256_loadu_pd      (b[e + 2].v);
+        vecb3 = _mm256_loadu_pd      (b[e + 3].v);
+        vecd  = _mm256_hadd_pd       (_mm256_mul_pd(veca0, vecb0), _mm256_mul_pd(veca1, vecb1));
+        vecs  = _mm256_hadd_pd       (_mm256_mul_pd(veca2, vecb2), _mm256_mul_pd(veca3, vecb3));
+        vecd  = _mm256_add_pd        (_mm256_permute2f128_pd(vecd, vecs, 0x20),
+                                      _mm256_permute2f128_pd(vecd, vecs, 0x31));   // Dot products
+        vecw  = _mm256_xor_pd        (vect, _mm256_and_pd(vecd, sign));    // t with sign of dot
+
+        veca0 = _mm256_fmadd_pd      (vecb0, _mm256_permute4x64_pd(vecw, 0x00), _mm256_mul_pd(veca0, vecu));
+        veca1 = _mm256_fmadd_pd      (vecb1, _mm256_permute4x64_pd(vecw, 0x55), _mm256_mul_pd(veca1, vecu));
+        veca2 = _mm256_fmadd_pd      (vecb2, _mm256_permute4x64_pd(vecw, 0xaa), _mm256_mul_pd(veca2, vecu));
+        veca3 = _mm256_fmadd_pd      (vecb3, _mm256_permute4x64_pd(vecw, 0xff), _mm256_mul_pd(veca3, vecu));
+
+        vecd  = _mm256_hadd_pd       (_mm256_mul_pd(veca0, veca0), _mm256_mul_pd(veca1, veca1));
+        vecs  = _mm256_hadd_pd       (_mm256_mul_pd(veca2, veca2), _mm256_mul_pd(veca3, veca3));
+        vecs  = _mm256_add_pd        (_mm256_permute2f128_pd(vecd, vecs, 0x20),
+                                      _mm256_permute2f128_pd(vecd, vecs, 0x31));   // Squared lengths
+        vecs  = _mm256_div_pd        (_mm256_set1_pd(1.0), _mm256_sqrt_pd(vecs));
+                _mm256_storeu_pd     (dest[e + 0].v, _mm256_mul_pd(veca0, _mm256_permute4x64_pd(vecs, 0x00)));
+                _mm256_storeu_pd     (dest[e + 1].v, _mm256_mul_pd(veca1, _mm256_permute4x64_pd(vecs, 0x55)));
+                _mm256_storeu_pd     (dest[e + 2].v, _mm256_mul_pd(veca2, _mm256_permute4x64_pd(vecs, 0xaa)));
+                _mm256_storeu_pd     (dest[e + 3].v, _mm256_mul_pd(veca3, _mm256_permute4x64_pd(vecs, 0xff)));
+    }
+
+    for (; e < n; ++e) {
+        veca0 = _mm256_loadu_pd      (a[e].v);
+        vecb0 = _mm256_loadu_pd      (b[e].v);
+        vecd  = _mm256_mul_pd        (veca0, vecb0);        // Dot product in every element
+        vecd  = _mm256_add_pd        (vecd, _mm256_permute_pd(vecd, 0x5));
+        vecd  = _mm256_add_pd        (vecd, _mm256_permute2f128_pd(vecd, vecd, 0x01));
+        vecw  = _mm256_xor_pd        (vect, _mm256_and_pd(vecd, sign));
+        veca0 = _mm256_fmadd_pd      (vecb0, vecw, _mm256_mul_pd(veca0, vecu));
+        vecs  = _mm256_mul_pd        (veca0, veca0);        // Squared length
+        vecs  = _mm256_add_pd        (vecs, _mm256_permute_pd(vecs, 0x5));
+        vecs  = _mm256_add_pd        (vecs, _mm256_permute2f128_pd(vecs, vecs, 0x01));
+                _mm256_storeu_pd     (dest[e].v, _mm256_div_pd(veca0, _mm256_sqrt_pd(vecs)));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized quatarr_slerp(quat<float> *dest,
+                                 quat<float> *a,
+                                 quat<float> *b,
+                                 float       t,
+                                 size_t      n) {
+    __m256 veca0, veca1, veca2, veca3, vecb0, vecb1, vecb2, vecb3;
+    __m256 vecd, vecs, vecx, veca, vecb, vect, vecu, sign, one;
+    __m256 ka[slerp_terms], kb[slerp_terms];
+    __m128 veca4, vecb4, vecd4;
+    float  ca[slerp_terms], cb[slerp_terms];
+    float  d, xm1;
+    size_t e;
+
+    slerp_coefficients(ca, 1.0f - t);
+    slerp_coefficients(cb, t);
+
+    for (int i = 0; i < slerp_terms; ++i) {
+        ka[i] = _mm256_set1_ps       (ca[i]);
+        kb[i] = _mm256_set1_ps       (cb[i]);
+    }
+
+    vect = _mm256_set1_ps            (t);
+    vecu = _mm256_set1_ps            (1.0f - t);
+    sign = _mm256_set1_ps            (-0.0f);
+    one  = _mm256_set1_ps            (1.0f);
+
+    for (e = 0; e + 8 <= n; e += 8) {
+        veca0 = _mm256_loadu_ps      (a[e + 0].v);
+        veca1 = _mm256_loadu_ps      (a[e + 2].v);
+        veca2 = _mm256_loadu_ps      (a[e + 4].v);
+        veca3 = _mm256_loadu_ps      (a[e + 6].v);
+        vecb0 = _mm256_loadu_ps      (b[e + 0].v);
+        vecb1 = _mm256_loadu_ps      (b[e + 2].v);
+        vecb2 = _mm256_loadu_ps      (b[e + 4].v);
+        vecb3 = _mm256_loadu_ps      (b[e + 6].v);
+        vecd  = _mm256_hadd_ps       (_mm256_mul_ps(veca0, vecb0), _mm256_mul_ps(veca1, vecb1));
+        vecs  = _mm256_hadd_ps       (_mm256_mul_ps(veca2, vecb2), _mm256_mul_ps(veca3, vecb3));
+        vecd  = _mm256_hadd_ps       (vecd, vecs);          // Even dot products, then odd
+        vecs  = _mm256_and_ps        (vecd, sign);          // Sign of dot products
+        vecx  = _mm256_sub_ps        (_mm256_andnot_ps(sign, vecd), one);  // |dot| - 1
+
+        veca  = one;
+        vecb  = one;
+        for (int i = slerp_terms - 1; i >= 0; --i) {
+            veca = _mm256_fmadd_ps   (_mm256_mul_ps(ka[i], vecx), veca, one);
+            vecb = _mm256_fmadd_ps   (_mm256_mul_ps(kb[i], vecx), vecb, one);
+        }
+        veca  = _mm256_mul_ps        (veca, vecu);          // Weights of a
+        vecb  = _mm256_xor_ps        (_mm256_mul_ps(vecb, vect), vecs);    // Weights of b
+
+                _mm256_storeu_ps     (dest[e + 0].v, _mm256_fmadd_ps(vecb0, _mm256_permute_ps(vecb, 0x00),
+                                                                     _mm256_mul_ps(veca0, _mm256_permute_ps(veca, 0x00))));
+                _mm256_storeu_ps     (dest[e + 2].v, _mm256_fmadd_ps(vecb1, _mm256_permute_ps(vecb, 0x55),
+                                                                     _mm256_mul_ps(veca1, _mm256_permute_ps(veca, 0x55))));
+                _mm256_storeu_ps     (dest[e + 4].v, _mm256_fmadd_ps(vecb2, _mm256_permute_ps(vecb, 0xaa),
+                                                                     _mm256_mul_ps(veca2, _mm256_permute_ps(veca, 0xaa))));
+                _mm256_storeu_ps     (dest[e + 6].v, _mm256_fmadd_ps(vecb3, _mm256_permute_ps(vecb, 0xff),
+                                                                     _mm256_mul_ps(veca3, _mm256_permute_ps(veca, 0xff))));
+    }
+
+    for (; e < n; ++e) {
+        veca4 = _mm_loadu_ps         (a[e].v);
+        vecb4 = _mm_loadu_ps         (b[e].v);
+        vecd4 = _mm_mul_ps           (veca4, vecb4);        // Dot product
+        vecd4 = _mm_add_ps           (vecd4, _mm_permute_ps(vecd4, 0xb1));
+        vecd4 = _mm_add_ps           (vecd4, _mm_permute_ps(vecd4, 0x4e));
+        d     = _mm_cvtss_f32        (vecd4);
+        xm1   = std::abs(d) - 1.0f;
+        veca4 = _mm_mul_ps           (veca4, _mm_set1_ps(slerp_weight(ca, 1.0f - t, xm1)));
+        vecb4 = _mm_mul_ps           (vecb4, _mm_set1_ps(slerp_weight(cb, t, xm1) * (d < 0 ? -1.0f : 1.0f)));
+                _mm_storeu_ps        (dest[e].v, _mm_add_ps(veca4, vecb4));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized quatarr_slerp(quat<double> *dest,
+                                 quat<double> *a,
+                                 quat<double> *b,
+                                 double       t,
+                                 size_t       n) {
+    __m256d veca0, veca1, veca2, veca3, vecb0, vecb1, vecb2, vecb3;
+    __m256d vecd, vecs, vecx, veca, vecb, vect, vecu, sign, one;
+    __m256d ka[slerp_terms], kb[slerp_terms];
+    double  ca[slerp_terms], cb[slerp_terms];
+    double  d, xm1;
+    size_t  e;
+
+    slerp_coefficients(ca, 1.0 - t);
+    slerp_coefficients(cb, t);
+
+    for (int i = 0; i < slerp_terms; ++i) {
+        ka[i] = _mm256_set1_pd       (ca[i]);
+        kb[i] = _mm256_set1_pd       (cb[i]);
+    }
+
+    vect = _mm256_set1_pd            (t);
+    vecu = _mm256_set1_pd            (1.0 - t);
+    sign = _mm256_set1_pd            (-0.0);
+    one  = _mm256_set1_pd            (1.0);
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        veca0 = _mm256_loadu_pd      (a[e + 0].v);
+        veca1 = _mm256_loadu_pd      (a[e + 1].v);
+        veca2 = _mm256_loadu_pd      (a[e + 2].v);
+        veca3 = _mm256_loadu_pd      (a[e + 3].v);
+        vecb0 = _mm256_loadu_pd      (b[e + 0].v);
+        vecb1 = _mm256_loadu_pd      (b[e + 1].v);
+        vecb2 = _mm256_loadu_pd      (b[e + 2].v);
+        vecb3 = _mm256_loadu_pd      (b[e + 3].v);
+        vecd  = _mm256_hadd_pd       (_mm256_mul_pd(veca0, vecb0), _mm256_mul_pd(veca1, vecb1));
+        vecs  = _mm256_hadd_pd       (_mm256_mul_pd(veca2, vecb2), _mm256_mul_pd(veca3, vecb3));
+        vecd  = _mm256_add_pd        (_mm256_permute2f128_pd(vecd, vecs, 0x20),
+                                      _mm256_permute2f128_pd(vecd, vecs, 0x31));   // Dot products
+        vecs  = _mm256_and_pd        (vecd, sign);          // Sign of dot products
+        vecx  = _mm256_sub_pd        (_mm256_andnot_pd(sign, vecd), one);  // |dot| - 1
+
+        veca  = one;
+        vecb  = one;
+        for (int i = slerp_terms - 1; i >= 0; --i) {
+            veca = _mm256_fmadd_pd   (_mm256_mul_pd(ka[i], vecx), veca, one);
+            vecb = _mm256_fmadd_pd   (_mm256_mul_pd(kb[i], vecx), vecb, one);
+        }
+        veca  = _mm256_mul_pd        (veca, vecu);          // Weights of a
+        vecb  = _mm256_xor_pd        (_mm256_mul_pd(vecb, vect), vecs);    // Weights of b
+
+                _mm256_storeu_pd     (dest[e + 0].v, _mm256_fmadd_pd(vecb0, _mm256_permute4x64_pd(vecb, 0x00),
+                                                                     _mm256_mul_pd(veca0, _mm256_permute4x64_pd(veca, 0x00))));
+                _mm256_storeu_pd     (dest[e + 1].v, _mm256_fmadd_pd(vecb1, _mm256_permute4x64_pd(vecb, 0x55),
+                                                                     _mm256_mul_pd(veca1, _mm256_permute4x64_pd(veca, 0x55))));
+                _mm256_storeu_pd     (dest[e + 2].v, _mm256_fmadd_pd(vecb2, _mm256_permute4x64_pd(vecb, 0xaa),
+                                                                     _mm256_mul_pd(veca2, _mm256_permute4x64_pd(veca, 0xaa))));
+                _mm256_storeu_pd     (dest[e + 3].v, _mm256_fmadd_pd(vecb3, _mm256_permute4x64_pd(vecb, 0xff),
+                                                                     _mm256_mul_pd(veca3, _mm256_permute4x64_pd(veca, 0xff))));
+    }
+
+    for (; e < n; ++e) {
+        veca0 = _mm256_loadu_pd      (a[e].v);
+        vecb0 = _mm256_loadu_pd      (b[e].v);
+        vecd  = _mm256_mul_pd        (veca0, vecb0);        // Dot product
+        vecd  = _mm256_add_pd        (vecd, _mm256_permute_pd(vecd, 0x5));
+        vecd  = _mm256_add_pd        (vecd, _mm256_permute2f128_pd(vecd, vecd, 0x01));
+        d     = _mm256_cvtsd_f64     (vecd);
+        xm1   = std::abs(d) - 1.0;
+        veca0 = _mm256_mul_pd        (veca0, _mm256_set1_pd(slerp_weight(ca, 1.0 - t, xm1)));
+        vecb0 = _mm256_mul_pd        (vecb0, _mm256_set1_pd(slerp_weight(cb, t, xm1) * (d < 0 ? -1.0 : 1.0)));
+                _mm256_storeu_pd     (dest[e].v, _mm256_add_pd(veca0, vecb0));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_sample(vec<float, 4> *dest,
+                                 vec<float, 4> *keys,
+                                 float         *times,
+                                 size_t        *first,
+                                 size_t        channels,
+                                 float         time,
+                                 size_t        *cursor) {
+    __m256 veca, vecb, vect;
+    __m128 veca4, vecb4;
+    size_t c, i0, j0, i1, j1;
+    float  t0, t1;
+
+    for (c = 0; c + 2 <= channels; c += 2) {
+        t0   = key_interval(i0, j0, cursor ? cursor + c     : nullptr, times, first[c],     first[c + 1], time);
+        t1   = key_interval(i1, j1, cursor ? cursor + c + 1 : nullptr, times, first[c + 1], first[c + 2], time);
+        veca = _mm256_loadu2_m128    (keys[i1].v, keys[i0].v);         // Keys of 2 channels
+        vecb = _mm256_loadu2_m128    (keys[j1].v, keys[j0].v);
+        vect = _mm256_set_m128       (_mm_set1_ps(t1), _mm_set1_ps(t0));
+               _mm256_storeu_ps      (dest[c].v, _mm256_fmadd_ps(vect, _mm256_sub_ps(vecb, veca), veca));
+    }
+
+    if (c < channels) {
+        t0   = key_interval(i0, j0, cursor ? cursor + c : nullptr, times, first[c], first[c + 1], time);
+        veca4 = _mm_loadu_ps         (keys[i0].v);
+        vecb4 = _mm_loadu_ps         (keys[j0].v);
+                _mm_storeu_ps        (dest[c].v, _mm_fmadd_ps(_mm_set1_ps(t0), _mm_sub_ps(vecb4, veca4), veca4));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_sample(vec<double, 4> *dest,
+                                 vec<double, 4> *keys,
+                                 double         *times,
+                                 size_t         *first,
+                                 size_t         channels,
+                                 double         time,
+                                 size_t         *cursor) {
+    __m256d veca, vecb;
+    size_t  i, j;
+    double  t;
+
+    for (size_t c = 0; c < channels; ++c) {
+        t    = key_interval(i, j, cursor ? cursor + c : nullptr, times, first[c], first[c + 1], time);
+        veca = _mm256_loadu_pd       (keys[i].v);
+        vecb = _mm256_loadu_pd       (keys[j].v);
+               _mm256_storeu_pd      (dest[c].v, _mm256_fmadd_pd(_mm256_set1_pd(t), _mm256_sub_pd(vecb, veca), veca));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized quatarr_sample(quat<float> *dest,
+                                  quat<float> *keys,
+                                  float       *times,
+                                  size_t      *first,
+                                  size_t      channels,
+                                  float       time,
+                                  size_t      *cursor) {
+    __m256 veca, vecb, vecd, vect, sign, one;
+    size_t c, i0, j0, i1, j1;
+    float  t0, t1;
+
+    sign = _mm256_set1_ps            (-0.0f);
+    one  = _mm256_set1_ps            (1.0f);
+
+    for (c = 0; c < channels; c += 2) {
+        t0   = key_interval(i0, j0, cursor ? cursor + c : nullptr, times, first[c], first[c + 1], time);
+
+        if (c + 1 < channels) {
+            t1 = key_interval(i1, j1, cursor ? cursor + c + 1 : nullptr, times, first[c + 1], first[c + 2], time);
+        } else {
+            i1 = i0;                                        // Odd channel count, repeat the last
+            j1 = j0;
+            t1 = t0;
+        }
+
+        veca = _mm256_loadu2_m128    (keys[i1].v, keys[i0].v);         // Keys of 2 channels
+        vecb = _mm256_loadu2_m128    (keys[j1].v, keys[j0].v);
+        vect = _mm256_set_m128       (_mm_set1_ps(t1), _mm_set1_ps(t0));
+        vecd = _mm256_mul_ps         (veca, vecb);          // Dot products in every element
+        vecd = _mm256_add_ps         (vecd, _mm256_permute_ps(vecd, 0xb1));
+        vecd = _mm256_add_ps         (vecd, _mm256_permute_ps(vecd, 0x4e));
+        veca = _mm256_mul_ps         (veca, _mm256_sub_ps(one, vect));
+        veca = _mm256_fmadd_ps       (vecb, _mm256_xor_ps(vect, _mm256_and_ps(vecd, sign)), veca);
+        vecd = _mm256_mul_ps         (veca, veca);          // Squared lengths
+        vecd = _mm256_add_ps         (vecd, _mm256_permute_ps(vecd, 0xb1));
+        vecd = _mm256_add_ps         (vecd, _mm256_permute_ps(vecd, 0x4e));
+        veca = _mm256_div_ps         (veca, _mm256_sqrt_ps(vecd));
+
+        if (c + 1 < channels) {
+               _mm256_storeu_ps      (dest[c].v, veca);
+        } else {
+               _mm_storeu_ps         (dest[c].v, _mm256_castps256_ps128(veca));
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized quatarr_sample(quat<double> *dest,
+                                  quat<double> *keys,
+                                  double       *times,
+                                  size_t       *first,
+                                  size_t       channels,
+                                  double       time,
+                                  size_t       *cursor) {
+    __m256d veca, vecb, vecd, vect, sign;
+    size_t  i, j;
+    double  t;
+
+    sign = _mm256_set1_pd            (-0.0);
+
+    for (size_t c = 0; c < channels; ++c) {
+        t    = key_interval(i, j, cursor ? cursor + c : nullptr, times, first[c], first[c + 1], time);
+        veca = _mm256_loadu_pd       (keys[i].v);
+        vecb = _mm256_loadu_pd       (keys[j].v);
+        vect = _mm256_set1_pd        (t);
+        vecd = _mm256_mul_pd         (veca, vecb);          // Dot product in every element
+        vecd = _mm256_add_pd         (vecd, _mm256_permute_pd(vecd, 0x5));
+        vecd = _mm256_add_pd         (vecd, _mm256_permute2f128_pd(vecd, vecd, 0x01));
+        veca = _mm256_mul_pd         (veca, _mm256_set1_pd(1.0 - t));
+        veca = _mm256_fmadd_pd       (vecb, _mm256_xor_pd(vect, _mm256_and_pd(vecd, sign)), veca);
+        vecd = _mm256_mul_pd         (veca, veca);          // Squared length
+        vecd = _mm256_add_pd         (vecd, _mm256_permute_pd(vecd, 0x5));
+        vecd = _mm256_add_pd         (vecd, _mm256_permute2f128_pd(vecd, vecd, 0x01));
+               _mm256_storeu_pd      (dest[c].v, _mm256_div_pd(veca, _mm256_sqrt_pd(vecd)));
+    }
+
+    return intrin;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// 3x3 and 2x2 matrices
+//
+// Rows of 3x3 matrices and 2 element rows of 2x2 matrices are padded with
+// zero to 4 elements in registers. 3 and 2 element vectors are padded to
+// 4 elements in memory, see vec, so they are loaded and stored as 4 element
+// vectors and their padding is written as zero. The rows of a 3x3 result
+// are stored in order, each 4 element store is overwritten by the next row,
+// the last writes zero to padding within the alignment of the matrix.
+// A 2x2 matrix fits in a single register.
+
+template <>
+constexpr specialized mat_x_mat(mat<float, 3, 3> &dest,
+                                mat<float, 3, 3> &a,
+                                mat<float, 3, 3> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    __m128 row0, row1, row2, vecd0, vecd1, vecd2;
+    float *pd = dest.m[0];
+    float *pa = a.m[0];
+    float *pb = b.m[0];
+
+    row0  = _mm_setr_ps    (pb[0], pb[1], pb[2], 0.0f);    // Rows padded with zero
+    row1  = _mm_setr_ps    (pb[3], pb[4], pb[5], 0.0f);
+    row2  = _mm_setr_ps    (pb[6], pb[7], pb[8], 0.0f);
+
+    vecd0 = _mm_mul_ps     (row0, _mm_set1_ps(pa[0]));      // Multiply and add the elements
+    vecd0 = _mm_fmadd_ps   (row1, _mm_set1_ps(pa[1]), vecd0);
+    vecd0 = _mm_fmadd_ps   (row2, _mm_set1_ps(pa[2]), vecd0);
+    vecd1 = _mm_mul_ps     (row0, _mm_set1_ps(pa[3]));
+    vecd1 = _mm_fmadd_ps   (row1, _mm_set1_ps(pa[4]), vecd1);
+    vecd1 = _mm_fmadd_ps   (row2, _mm_set1_ps(pa[5]), vecd1);
+    vecd2 = _mm_mul_ps     (row0, _mm_set1_ps(pa[6]));
+    vecd2 = _mm_fmadd_ps   (row1, _mm_set1_ps(pa[7]), vecd2);
+    vecd2 = _mm_fmadd_ps   (row2, _mm_set1_ps(pa[8]), vecd2);
+
+            _mm_storeu_ps  (pd + 0, vecd0);                 // Store rows in order
+            _mm_storeu_ps  (pd + 3, vecd1);
+            _mm_storeu_ps  (pd + 6, vecd2);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<double, 3, 3> &dest,
+                                mat<double, 3, 3> &a,
+                                mat<double, 3, 3> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    __m256d row0, row1, row2, vecd0, vecd1, vecd2;
+    double *pd = dest.m[0];
+    double *pa = a.m[0];
+    double *pb = b.m[0];
+
+    row0  = _mm256_setr_pd (pb[0], pb[1], pb[2], 0.0);     // Rows padded with zero
+    row1  = _mm256_setr_pd (pb[3], pb[4], pb[5], 0.0);
+    row2  = _mm256_setr_pd (pb[6], pb[7], pb[8], 0.0);
+
+    vecd0 = _mm256_mul_pd  (row0, _mm256_set1_pd(pa[0]));   // Multiply and add the elements
+    vecd0 = _mm256_fmadd_pd(row1, _mm256_set1_pd(pa[1]), vecd0);
+    vecd0 = _mm256_fmadd_pd(row2, _mm256_set1_pd(pa[2]), vecd0);
+    vecd1 = _mm256_mul_pd  (row0, _mm256_set1_pd(pa[3]));
+    vecd1 = _mm256_fmadd_pd(row1, _mm256_set1_pd(pa[4]), vecd1);
+    vecd1 = _mm256_fmadd_pd(row2, _mm256_set1_pd(pa[5]), vecd1);
+    vecd2 = _mm256_mul_pd  (row0, _mm256_set1_pd(pa[6]));
+    vecd2 = _mm256_fmadd_pd(row1, _mm256_set1_pd(pa[7]), vecd2);
+    vecd2 = _mm256_fmadd_pd(row2, _mm256_set1_pd(pa[8]), vecd2);
+
+            _mm256_storeu_pd(pd + 0, vecd0);                // Store rows in order
+            _mm256_storeu_pd(pd + 3, vecd1);
+            _mm256_storeu_pd(pd + 6, vecd2);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<float, 2, 2> &dest,
+                                mat<float, 2, 2> &a,
+                                mat<float, 2, 2> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    __m128 veca, vecb, vecd;
+
+    veca = _mm_loadu_ps    (a.m[0]);                        // [ a00 a01 a10 a11 ]
+    vecb = _mm_loadu_ps    (b.m[0]);                        // [ b00 b01 b10 b11 ]
+    vecd = _mm_mul_ps      (_mm_permute_ps(veca, 0xa0), _mm_movelh_ps(vecb, vecb));
+    vecd = _mm_fmadd_ps    (_mm_permute_ps(veca, 0xf5), _mm_movehl_ps(vecb, vecb), vecd);
+           _mm_storeu_ps   (dest.m[0], vecd);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<double, 2, 2> &dest,
+                                mat<double, 2, 2> &a,
+                                mat<double, 2, 2> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    __m256d veca, vecb, vecd;
+
+    veca = _mm256_loadu_pd (a.m[0]);                        // [ a00 a01 a10 a11 ]
+    vecb = _mm256_loadu_pd (b.m[0]);                        // [ b00 b01 b10 b11 ]
+    vecd = _mm256_mul_pd   (_mm256_permute4x64_pd(veca, 0xa0), _mm256_permute4x64_pd(vecb, 0x44));
+    vecd = _mm256_fmadd_pd (_mm256_permute4x64_pd(veca, 0xf5), _mm256_permute4x64_pd(vecb, 0xee), vecd);
+           _mm256_storeu_pd(dest.m[0], vecd);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized vec_x_mat(vec<float, 3>    &dest,
+                                vec<float, 3>    &v,
+                                mat<float, 3, 3> &m) {
+    if (std::is_constant_evaluated()) {
+        return looped_vec_x_mat(dest, v, m);
+    }
+
+    __m128 vecd;
+    float *pm = m.m[0];
+
+    vecd = _mm_mul_ps      (_mm_setr_ps(pm[0], pm[1], pm[2], 0.0f), _mm_set1_ps(v.v[0]));
+    vecd = _mm_fmadd_ps    (_mm_setr_ps(pm[3], pm[4], pm[5], 0.0f), _mm_set1_ps(v.v[1]), vecd);
+    vecd = _mm_fmadd_ps    (_mm_setr_ps(pm[6], pm[7], pm[8], 0.0f), _mm_set1_ps(v.v[2]), vecd);
+           _mm_storeu_ps   (dest.v, vecd);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized vec_x_mat(vec<double, 3>    &dest,
+                                vec<double, 3>    &v,
+                                mat<double, 3, 3> &m) {
+    if (std::is_constant_evaluated()) {
+        return looped_vec_x_mat(dest, v, m);
+    }
+
+    __m256d vecd;
+    double *pm = m.m[0];
+
+    vecd = _mm256_mul_pd   (_mm256_setr_pd(pm[0], pm[1], pm[2], 0.0), _mm256_set1_pd(v.v[0]));
+    vecd = _mm256_fmadd_pd (_mm256_setr_pd(pm[3], pm[4], pm[5], 0.0), _mm256_set1_pd(v.v[1]), vecd);
+    vecd = _mm256_fmadd_pd (_mm256_setr_pd(pm[6], pm[7], pm[8], 0.0), _mm256_set1_pd(v.v[2]), vecd);
+           _mm256_storeu_pd(dest.v, vecd);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized vec_x_mat(vec<float, 2>    &dest,
+                                vec<float, 2>    &v,
+                                mat<float, 2, 2> &m) {
+    if (std::is_constant_evaluated()) {
+        return looped_vec_x_mat(dest, v, m);
+    }
+
+    __m128 vecd;
+    float *pm = m.m[0];
+
+    vecd = _mm_mul_ps      (_mm_setr_ps(pm[0], pm[1], 0.0f, 0.0f), _mm_set1_ps(v.v[0]));
+    vecd = _mm_fmadd_ps    (_mm_setr_ps(pm[2], pm[3], 0.0f, 0.0f), _mm_set1_ps(v.v[1]), vecd);
+           _mm_storeu_ps   (dest.v, vecd);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized vec_x_mat(vec<double, 2>    &dest,
+                                vec<double, 2>    &v,
+                                mat<double, 2, 2> &m) {
+    if (std::is_constant_evaluated()) {
+        return looped_vec_x_mat(dest, v, m);
+    }
+
+    __m256d vecd;
+    double *pm = m.m[0];
+
+    vecd = _mm256_mul_pd   (_mm256_setr_pd(pm[0], pm[1], 0.0, 0.0), _mm256_set1_pd(v.v[0]));
+    vecd = _mm256_fmadd_pd (_mm256_setr_pd(pm[2], pm[3], 0.0, 0.0), _mm256_set1_pd(v.v[1]), vecd);
+           _mm256_storeu_pd(dest.v, vecd);
+
+    return intrin;
+}
+
+// Float vector arrays are processed 2 vectors at a time with INTRIN256,
+// the padded rows are duplicated in both halves of a 256-bit register
+
+template <>
+inline specialized vecarr_x_mat(vec <float, 3>    *dest,
+                                vec <float, 3>    *v,
+                                mat <float, 3, 3> &m,
+                                size_t            n) {
+    __m128 low0, low1, low2, vecv4, vecd4;
+    float  *pm = m.m[0];
+    size_t e   = 0;
+
+    low0 = _mm_setr_ps           (pm[0], pm[1], pm[2], 0.0f);
+    low1 = _mm_setr_ps           (pm[3], pm[4], pm[5], 0.0f);
+    low2 = _mm_setr_ps           (pm[6], pm[7], pm[8], 0.0f);
+
+#ifdef INTRIN256
+    __m256 row0, row1, row2, vecv, vecd;
+
+    row0 = _mm256_set_m128       (low0, low0);
+    row1 = _mm256_set_m128       (low1, low1);
+    row2 = _mm256_set_m128       (low2, low2);
+
+    for (; e + 2 <= n; e += 2) {
+        vecv = _mm256_loadu_ps   (v[e].v);                  // [ x0 y0 z0 - x1 y1 z1 - ]
+        vecd = _mm256_mul_ps     (row0, _mm256_permute_ps(vecv, 0x00));
+        vecd = _mm256_fmadd_ps   (row1, _mm256_permute_ps(vecv, 0x55), vecd);
+        vecd = _mm256_fmadd_ps   (row2, _mm256_permute_ps(vecv, 0xaa), vecd);
+               _mm256_storeu_ps  (dest[e].v, vecd);
+    }
+#endif  // INTRIN256
+
+    for (; e < n; ++e) {
+        vecv4 = _mm_loadu_ps     (v[e].v);                  // [ x y z - ]
+        vecd4 = _mm_mul_ps       (low0, _mm_permute_ps(vecv4, 0x00));
+        vecd4 = _mm_fmadd_ps     (low1, _mm_permute_ps(vecv4, 0x55), vecd4);
+        vecd4 = _mm_fmadd_ps     (low2, _mm_permute_ps(vecv4, 0xaa), vecd4);
+                _mm_storeu_ps    (dest[e].v, vecd4);
+    }
+
+#ifdef INTRIN256
+    return intrin256;
+#else
+    return intrin;
+#endif  // INTRIN256
+}
+
+template <>
+inline specialized vecarr_x_mat(vec <double, 3>    *dest,
+                                vec <double, 3>    *v,
+                                mat <double, 3, 3> &m,
+                                size_t             n) {
+    __m256d row0, row1, row2, vecd;
+    double  *pm = m.m[0];
+
+    row0 = _mm256_setr_pd        (pm[0], pm[1], pm[2], 0.0);
+    row1 = _mm256_setr_pd        (pm[3], pm[4], pm[5], 0.0);
+    row2 = _mm256_setr_pd        (pm[6], pm[7], pm[8], 0.0);
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pv = v[e].v;
+
+        vecd = _mm256_mul_pd     (row0, _mm256_broadcast_sd(pv + 0));
+        vecd = _mm256_fmadd_pd   (row1, _mm256_broadcast_sd(pv + 1), vecd);
+        vecd = _mm256_fmadd_pd   (row2, _mm256_broadcast_sd(pv + 2), vecd);
+               _mm256_storeu_pd  (dest[e].v, vecd);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_mat(vec <float, 2>    *dest,
+                                vec <float, 2>    *v,
+                                mat <float, 2, 2> &m,
+                                size_t            n) {
+    __m128 low0, low1, vecv4, vecd4;
+    float  *pm = m.m[0];
+    size_t e   = 0;
+
+    low0 = _mm_setr_ps           (pm[0], pm[1], 0.0f, 0.0f);
+    low1 = _mm_setr_ps           (pm[2], pm[3], 0.0f, 0.0f);
+
+#ifdef INTRIN256
+    __m256 row0, row1, vecv, vecd;
+
+    row0 = _mm256_set_m128       (low0, low0);
+    row1 = _mm256_set_m128       (low1, low1);
+
+    for (; e + 2 <= n; e += 2) {
+        vecv = _mm256_loadu_ps   (v[e].v);                  // [ x0 y0 - - x1 y1 - - ]
+        vecd = _mm256_mul_ps     (row0, _mm256_permute_ps(vecv, 0x00));
+        vecd = _mm256_fmadd_ps   (row1, _mm256_permute_ps(vecv, 0x55), vecd);
+               _mm256_storeu_ps  (dest[e].v, vecd);
+    }
+#endif  // INTRIN256
+
+    for (; e < n; ++e) {
+        vecv4 = _mm_loadu_ps     (v[e].v);                  // [ x y - - ]
+        vecd4 = _mm_mul_ps       (low0, _mm_permute_ps(vecv4, 0x00));
+        vecd4 = _mm_fmadd_ps     (low1, _mm_permute_ps(vecv4, 0x55), vecd4);
+                _mm_storeu_ps    (dest[e].v, vecd4);
+    }
+
+#ifdef INTRIN256
+    return intrin256;
+#else
+    return intrin;
+#endif  // INTRIN256
+}
+
+template <>
+inline specialized vecarr_x_mat(vec <double, 2>    *dest,
+                                vec <double, 2>    *v,
+                                mat <double, 2, 2> &m,
+                                size_t             n) {
+    __m256d row0, row1, vecd;
+    double  *pm = m.m[0];
+
+    row0 = _mm256_setr_pd        (pm[0], pm[1], 0.0, 0.0);
+    row1 = _mm256_setr_pd        (pm[2], pm[3], 0.0, 0.0);
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pv = v[e].v;
+
+        vecd = _mm256_mul_pd     (row0, _mm256_broadcast_sd(pv + 0));
+        vecd = _mm256_fmadd_pd   (row1, _mm256_broadcast_sd(pv + 1), vecd);
+               _mm256_storeu_pd  (dest[e].v, vecd);
+    }
+
+    return intrin;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Elementwise array operations
+//
+// Process 8 float or 4 double elements per 256-bit register, then the
+// remaining elements one at a time. abs clears the sign bits. min and max
+// take their operands in reverse order to return a on ties as std::min and
+// std::max do.
+
+template <>
+inline specialized arr_add(float *dest, float *a, float *b, size_t n) {
+    size_t e, full = n - n % 8;
+
+    for (e = 0; e < full; e += 8) {
+        _mm256_storeu_ps           (dest + e, _mm256_add_ps(_mm256_loadu_ps(a + e), _mm256_loadu_ps(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] + b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_sub(float *dest, float *a, float *b, size_t n) {
+    size_t e, full = n - n % 8;
+
+    for (e = 0; e < full; e += 8) {
+        _mm256_storeu_ps           (dest + e, _mm256_sub_ps(_mm256_loadu_ps(a + e), _mm256_loadu_ps(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] - b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_add_scalar(float *dest, float *a, float s, size_t n) {
+    __m256 vecs;
+    size_t e, full = n - n % 8;
+
+    vecs = _mm256_set1_ps            (s);
+
+    for (e = 0; e < full; e += 8) {
+        _mm256_storeu_ps           (dest + e, _mm256_add_ps(_mm256_loadu_ps(a + e), vecs));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] + s;
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_scale(float *dest, float *a, float s, size_t n) {
+    __m256 vecs;
+    size_t e, full = n - n % 8;
+
+    vecs = _mm256_set1_ps            (s);
+
+    for (e = 0; e < full; e += 8) {
+        _mm256_storeu_ps           (dest + e, _mm256_mul_ps(_mm256_loadu_ps(a + e), vecs));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] * s;
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_axpy(float *dest, float *x, float *y, float alpha, size_t n) {
+    __m256 veca;
+    size_t e, full = n - n % 8;
+
+    veca = _mm256_set1_ps            (alpha);
+
+    for (e = 0; e < full; e += 8) {
+        _mm256_storeu_ps           (dest + e, _mm256_fmadd_ps(veca, _mm256_loadu_ps(x + e), _mm256_loadu_ps(y + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = alpha * x[e] + y[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_blend(float *dest, float *a, float *b, float wa, float wb, size_t n) {
+    __m256 veca, vecb;
+    size_t e, full = n - n % 8;
+
+    veca = _mm256_set1_ps            (wa);
+    vecb = _mm256_set1_ps            (wb);
+
+    for (e = 0; e < full; e += 8) {
+        _mm256_storeu_ps           (dest + e, _mm256_fmadd_ps(veca, _mm256_loadu_ps(a + e), _mm256_mul_ps(vecb, _mm256_loadu_ps(b + e))));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = wa * a[e] + wb * b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_abs(float *dest, float *a, size_t n) {
+    __m256 vecm;
+    size_t e, full = n - n % 8;
+
+    vecm = _mm256_set1_ps            (-0.0f);
+
+    for (e = 0; e < full; e += 8) {
+        _mm256_storeu_ps           (dest + e, _mm256_andnot_ps(vecm, _mm256_loadu_ps(a + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::abs(a[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_min(float *dest, float *a, float *b, size_t n) {
+    size_t e, full = n - n % 8;
+
+    for (e = 0; e < full; e += 8) {
+        _mm256_storeu_ps           (dest + e, _mm256_min_ps(_mm256_loadu_ps(b + e), _mm256_loadu_ps(a + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::min(a[e], b[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_max(float *dest, float *a, float *b, size_t n) {
+    size_t e, full = n - n % 8;
+
+    for (e = 0; e < full; e += 8) {
+        _mm256_storeu_ps           (dest + e, _mm256_max_ps(_mm256_loadu_ps(b + e), _mm256_loadu_ps(a + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::max(a[e], b[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_add(double *dest, double *a, double *b, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        _mm256_storeu_pd           (dest + e, _mm256_add_pd(_mm256_loadu_pd(a + e), _mm256_loadu_pd(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] + b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_sub(double *dest, double *a, double *b, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        _mm256_storeu_pd           (dest + e, _mm256_sub_pd(_mm256_loadu_pd(a + e), _mm256_loadu_pd(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] - b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_add_scalar(double *dest, double *a, double s, size_t n) {
+    __m256d vecs;
+    size_t e, full = n - n % 4;
+
+    vecs = _mm256_set1_pd            (s);
+
+    for (e = 0; e < full; e += 4) {
+        _mm256_storeu_pd           (dest + e, _mm256_add_pd(_mm256_loadu_pd(a + e), vecs));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] + s;
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_scale(double *dest, double *a, double s, size_t n) {
+    __m256d vecs;
+    size_t e, full = n - n % 4;
+
+    vecs = _mm256_set1_pd            (s);
+
+    for (e = 0; e < full; e += 4) {
+        _mm256_storeu_pd           (dest + e, _mm256_mul_pd(_mm256_loadu_pd(a + e), vecs));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] * s;
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_axpy(double *dest, double *x, double *y, double alpha, size_t n) {
+    __m256d veca;
+    size_t e, full = n - n % 4;
+
+    veca = _mm256_set1_pd            (alpha);
+
+    for (e = 0; e < full; e += 4) {
+        _mm256_storeu_pd           (dest + e, _mm256_fmadd_pd(veca, _mm256_loadu_pd(x + e), _mm256_loadu_pd(y + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = alpha * x[e] + y[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_blend(double *dest, double *a, double *b, double wa, double wb, size_t n) {
+    __m256d veca, vecb;
+    size_t e, full = n - n % 4;
+
+    veca = _mm256_set1_pd            (wa);
+    vecb = _mm256_set1_pd            (wb);
+
+    for (e = 0; e < full; e += 4) {
+        _mm256_storeu_pd           (dest + e, _mm256_fmadd_pd(veca, _mm256_loadu_pd(a + e), _mm256_mul_pd(vecb, _mm256_loadu_pd(b + e))));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = wa * a[e] + wb * b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_abs(double *dest, double *a, size_t n) {
+    __m256d vecm;
+    size_t e, full = n - n % 4;
+
+    vecm = _mm256_set1_pd            (-0.0);
+
+    for (e = 0; e < full; e += 4) {
+        _mm256_storeu_pd           (dest + e, _mm256_andnot_pd(vecm, _mm256_loadu_pd(a + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::abs(a[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_min(double *dest, double *a, double *b, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        _mm256_storeu_pd           (dest + e, _mm256_min_pd(_mm256_loadu_pd(b + e), _mm256_loadu_pd(a + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::min(a[e], b[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_max(double *dest, double *a, double *b, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        _mm256_storeu_pd           (dest + e, _mm256_max_pd(_mm256_loadu_pd(b + e), _mm256_loadu_pd(a + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::max(a[e], b[e]);
+    }
+
+    return intrin;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix structure
+//
+// classify compares the matrix to the identity and packs the equal
+// elements into a mask with movemask. The affine product skips the last
+// column of a and the last row of b except for the translation. Vectors are
+// translated and scaled with a multiply and an FMA by the broadcast w.
+
+template <>
+inline specialized classify(structure &dest, mat<float, 4, 4> &a) {
+    __m256   vec0, vec1;
+    unsigned mask;
+
+    vec0 = _mm256_cmp_ps             (_mm256_loadu_ps(a.m[0]),                    // Rows 0 and 1
+                                      _mm256_setr_ps(1, 0, 0, 0, 0, 1, 0, 0), _CMP_EQ_OQ);
+    vec1 = _mm256_cmp_ps             (_mm256_loadu_ps(a.m[2]),                    // Rows 2 and 3
+                                      _mm256_setr_ps(0, 0, 1, 0, 0, 0, 0, 1), _CMP_EQ_OQ);
+    mask = _mm256_movemask_ps        (vec0) | _mm256_movemask_ps(vec1) << 8;
+    dest = mask_to_structure         (mask);
+
+    return intrin;
+}
+
+template <>
+inline specialized classify(structure &dest, mat<double, 4, 4> &a) {
+    __m256d  vec0, vec1, vec2, vec3;
+    unsigned mask;
+
+    vec0 = _mm256_cmp_pd             (_mm256_loadu_pd(a.m[0]), _mm256_setr_pd(1, 0, 0, 0), _CMP_EQ_OQ);
+    vec1 = _mm256_cmp_pd             (_mm256_loadu_pd(a.m[1]), _mm256_setr_pd(0, 1, 0, 0), _CMP_EQ_OQ);
+    vec2 = _mm256_cmp_pd             (_mm256_loadu_pd(a.m[2]), _mm256_setr_pd(0, 0, 1, 0), _CMP_EQ_OQ);
+    vec3 = _mm256_cmp_pd             (_mm256_loadu_pd(a.m[3]), _mm256_setr_pd(0, 0, 0, 1), _CMP_EQ_OQ);
+    mask = _mm256_movemask_pd        (vec0)      | _mm256_movemask_pd(vec1) << 4
+         | _mm256_movemask_pd        (vec2) << 8 | _mm256_movemask_pd(vec3) << 12;
+    dest = mask_to_structure         (mask);
+
+    return intrin;
+}
+
+template <>
+inline specialized affine_x_affine(mat<float, 4, 4> &dest,
+                                   mat<float, 4, 4> &a,
+                                   mat<float, 4, 4> &b) {
+    __m256 row0, row1, row2, row3, veca, vecd;
+
+    row0 = _mm256_broadcast_ps       ((__m128 *) b.m[0]);                         // Rows of b in
+    row1 = _mm256_broadcast_ps       ((__m128 *) b.m[1]);                         //   both halves
+    row2 = _mm256_broadcast_ps       ((__m128 *) b.m[2]);
+    row3 = _mm256_insertf128_ps      (_mm256_setzero_ps(), _mm_loadu_ps(b.m[3]), 1);  // Translation
+
+    veca = _mm256_loadu_ps           (a.m[0]);                                    // Rows 0 and 1
+    vecd = _mm256_mul_ps             (_mm256_permute_ps(veca, 0x00), row0);
+    vecd = _mm256_fmadd_ps           (_mm256_permute_ps(veca, 0x55), row1, vecd);
+    vecd = _mm256_fmadd_ps           (_mm256_permute_ps(veca, 0xaa), row2, vecd);
+           _mm256_storeu_ps          (dest.m[0], vecd);
+
+    veca = _mm256_loadu_ps           (a.m[2]);                                    // Rows 2 and 3
+    vecd = _mm256_fmadd_ps           (_mm256_permute_ps(veca, 0x00), row0, row3);
+    vecd = _mm256_fmadd_ps           (_mm256_permute_ps(veca, 0x55), row1, vecd);
+    vecd = _mm256_fmadd_ps           (_mm256_permute_ps(veca, 0xaa), row2, vecd);
+           _mm256_storeu_ps          (dest.m[2], vecd);
+
+    return intrin;
+}
+
+template <>
+inline specialized affine_x_affine(mat<double, 4, 4> &dest,
+                                   mat<double, 4, 4> &a,
+                                   mat<double, 4, 4> &b) {
+    __m256d row0, row1, row2, row3, vecd;
+
+    row0 = _mm256_loadu_pd           (b.m[0]);
+    row1 = _mm256_loadu_pd           (b.m[1]);
+    row2 = _mm256_loadu_pd           (b.m[2]);
+    row3 = _mm256_loadu_pd           (b.m[3]);
+
+    for (int i = 0; i < 4; ++i) {
+        vecd = (i == 3) ? row3 : _mm256_setzero_pd();                             // Translation
+        vecd = _mm256_fmadd_pd       (_mm256_broadcast_sd(&a.m[i][0]), row0, vecd);
+        vecd = _mm256_fmadd_pd       (_mm256_broadcast_sd(&a.m[i][1]), row1, vecd);
+        vecd = _mm256_fmadd_pd       (_mm256_broadcast_sd(&a.m[i][2]), row2, vecd);
+               _mm256_storeu_pd      (dest.m[i], vecd);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_translation(vec<float, 4>    *dest,
+                                        vec<float, 4>    *v,
+                                        mat<float, 4, 4> &m,
+                                        size_t           n) {
+    __m256 vect, vecv;
+    __m128 vecv4;
+    size_t e;
+
+    vect = _mm256_broadcast_ps       ((__m128 *) m.m[3]);                         // [ tx ty tz 0 ]
+    vect = _mm256_blend_ps           (vect, _mm256_setzero_ps(), 0x88);
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        vecv  = _mm256_loadu_ps      (v[e].v);
+                _mm256_storeu_ps     (dest[e].v, _mm256_fmadd_ps(_mm256_permute_ps(vecv, 0xff), vect, vecv));
+    }
+
+    if (e < n) {
+        vecv4 = _mm_loadu_ps         (v[e].v);
+                _mm_storeu_ps        (dest[e].v, _mm_fmadd_ps(_mm_permute_ps(vecv4, 0xff),
+                                                              _mm256_castps256_ps128(vect), vecv4));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_translation(vec<double, 4>    *dest,
+                                        vec<double, 4>    *v,
+                                        mat<double, 4, 4> &m,
+                                        size_t            n) {
+    __m256d vect, vecv;
+
+    vect = _mm256_loadu_pd           (m.m[3]);                                    // [ tx ty tz 0 ]
+    vect = _mm256_blend_pd           (vect, _mm256_setzero_pd(), 0x8);
+
+    for (size_t e = 0; e < n; ++e) {
+        vecv = _mm256_loadu_pd       (v[e].v);
+               _mm256_storeu_pd      (dest[e].v, _mm256_fmadd_pd(_mm256_permute4x64_pd(vecv, 0xff), vect, vecv));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_scale(vec<float, 4>    *dest,
+                                  vec<float, 4>    *v,
+                                  mat<float, 4, 4> &m,
+                                  size_t           n) {
+    __m256 vecs, vect, vecv;
+    __m128 vecv4;
+    size_t e;
+
+    vecs = _mm256_setr_ps            (m.m[0][0], m.m[1][1], m.m[2][2], 0,         // [ sx sy sz 0 ]
+                                      m.m[0][0], m.m[1][1], m.m[2][2], 0);
+    vect = _mm256_broadcast_ps       ((__m128 *) m.m[3]);                         // [ tx ty tz 1 ]
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        vecv  = _mm256_loadu_ps      (v[e].v);
+                _mm256_storeu_ps     (dest[e].v, _mm256_fmadd_ps(_mm256_permute_ps(vecv, 0xff), vect,
+                                                                 _mm256_mul_ps(vecv, vecs)));
+    }
+
+    if (e < n) {
+        vecv4 = _mm_loadu_ps         (v[e].v);
+                _mm_storeu_ps        (dest[e].v, _mm_fmadd_ps(_mm_permute_ps(vecv4, 0xff),
+                                                              _mm256_castps256_ps128(vect),
+                                                              _mm_mul_ps(vecv4, _mm256_castps256_ps128(vecs))));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_scale(vec<double, 4>    *dest,
+                                  vec<double, 4>    *v,
+                                  mat<double, 4, 4> &m,
+                                  size_t            n) {
+    __m256d vecs, vect, vecv;
+
+    vecs = _mm256_setr_pd            (m.m[0][0], m.m[1][1], m.m[2][2], 0);        // [ sx sy sz 0 ]
+    vect = _mm256_loadu_pd           (m.m[3]);                                    // [ tx ty tz 1 ]
+
+    for (size_t e = 0; e < n; ++e) {
+        vecv = _mm256_loadu_pd       (v[e].v);
+               _mm256_storeu_pd      (dest[e].v, _mm256_fmadd_pd(_mm256_permute4x64_pd(vecv, 0xff), vect,
+                                                                 _mm256_mul_pd(vecv, vecs)));
+    }
+
+    return intrin;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Register blocked 8x8 and 16x16 products
+//
+// A tile of R rows by C vectors of dest stays in registers for the whole
+// product. Each step loads the C vectors of a row of b once, broadcasts an
+// element of a for each row of the tile and accumulates with FMA. AVX2 has
+// 16 ymm registers, tiles use 8 for sums. AVX-512 has 32 zmm registers,
+// tiles use up to 16 for sums.
+//
+// dest(R,C*lanes) = a(R,K) * b(K,C*lanes), rows are LD elements apart
+
+template <int R, int C, int K, int LD>
+inline void block_f256(float *pd, float *pa, float *pb) {
+    __m256 sum[R][C], rowb[C], veca;
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            sum[i][j] = _mm256_setzero_ps();
+
+    for (int k = 0; k < K; ++k) {
+        for (int j = 0; j < C; ++j)
+            rowb[j] = _mm256_loadu_ps(pb + k * LD + j * 8);         // Row of b
+
+        for (int i = 0; i < R; ++i) {
+            veca = _mm256_broadcast_ss(pa + i * LD + k);            // Element of a
+            for (int j = 0; j < C; ++j)
+                sum[i][j] = _mm256_fmadd_ps(veca, rowb[j], sum[i][j]);
+        }
+    }
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            _mm256_storeu_ps(pd + i * LD + j * 8, sum[i][j]);
+}
+
+template <int R, int C, int K, int LD>
+inline void block_d256(double *pd, double *pa, double *pb) {
+    __m256d sum[R][C], rowb[C], veca;
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            sum[i][j] = _mm256_setzero_pd();
+
+    for (int k = 0; k < K; ++k) {
+        for (int j = 0; j < C; ++j)
+            rowb[j] = _mm256_loadu_pd(pb + k * LD + j * 4);
+
+        for (int i = 0; i < R; ++i) {
+            veca = _mm256_broadcast_sd(pa + i * LD + k);
+            for (int j = 0; j < C; ++j)
+                sum[i][j] = _mm256_fmadd_pd(veca, rowb[j], sum[i][j]);
+        }
+    }
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            _mm256_storeu_pd(pd + i * LD + j * 4, sum[i][j]);
+}
+
+#if defined(__AVX512F__)
+
+template <int R, int C, int K, int LD>
+inline void block_f512(float *pd, float *pa, float *pb) {
+    __m512 sum[R][C], rowb[C], veca;
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            sum[i][j] = _mm512_setzero_ps();
+
+    for (int k = 0; k < K; ++k) {
+        for (int j = 0; j < C; ++j)
+            rowb[j] = _mm512_loadu_ps(pb + k * LD + j * 16);
+
+        for (int i = 0; i < R; ++i) {
+            veca = _mm512_set1_ps(pa[i * LD + k]);
+            for (int j = 0; j < C; ++j)
+                sum[i][j] = _mm512_fmadd_ps(veca, rowb[j], sum[i][j]);
+        }
+    }
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            _mm512_storeu_ps(pd + i * LD + j * 16, sum[i][j]);
+}
+
+template <int R, int C, int K, int LD>
+inline void block_d512(double *pd, double *pa, double *pb) {
+    __m512d sum[R][C], rowb[C], veca;
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            sum[i][j] = _mm512_setzero_pd();
+
+    for (int k = 0; k < K; ++k) {
+        for (int j = 0; j < C; ++j)
+            rowb[j] = _mm512_loadu_pd(pb + k * LD + j * 8);
+
+        for (int i = 0; i < R; ++i) {
+            veca = _mm512_set1_pd(pa[i * LD + k]);
+            for (int j = 0; j < C; ++j)
+                sum[i][j] = _mm512_fmadd_pd(veca, rowb[j], sum[i][j]);
+        }
+    }
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            _mm512_storeu_pd(pd + i * LD + j * 8, sum[i][j]);
+}
+
+#endif  // __AVX512F__
+
+// A row of 8 floats fills half a zmm register, broadcasting elements of a
+// for two rows per register takes permutes that are slower than the 256-bit
+// kernel, so AVX-512 builds use it too
+template <>
+constexpr specialized mat_x_mat(mat<float, 8, 8> &dest,
+                                mat<float, 8, 8> &a,
+                                mat<float, 8, 8> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    block_f256<8, 1, 8, 8>(dest.m[0], a.m[0], b.m[0]);              // Whole 8x8 tile
+
+    return block256;
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<double, 8, 8> &dest,
+                                mat<double, 8, 8> &a,
+                                mat<double, 8, 8> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    double *pd = dest.m[0];
+    double *pa = a.m[0];
+    double *pb = b.m[0];
+
+#if defined(__AVX512F__)
+
+    block_d512<8, 1, 8, 8>(pd, pa, pb);                             // Whole 8x8 tile
+
+    return block512;
+
+#else
+
+    block_d256<4, 2, 8, 8>(pd,      pa,      pb);                   // 4x8 tiles
+    block_d256<4, 2, 8, 8>(pd + 32, pa + 32, pb);
+
+    return block256;
+
+#endif  // __AVX512F__
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<float, 16, 16> &dest,
+                                mat<float, 16, 16> &a,
+                                mat<float, 16, 16> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    float *pd = dest.m[0];
+    float *pa = a.m[0];
+    float *pb = b.m[0];
+
+#if defined(__AVX512F__)
+
+    block_f512<16, 1, 16, 16>(pd, pa, pb);                          // Whole 16x16 tile
+
+    return block512;
+
+#else
+
+    for (int i = 0; i < 16; i += 4) {
+        block_f256<4, 2, 16, 16>(pd + i * 16, pa + i * 16, pb);     // 4x16 tiles
+    }
+
+    return block256;
+
+#endif  // __AVX512F__
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<double, 16, 16> &dest,
+                                mat<double, 16, 16> &a,
+                                mat<double, 16, 16> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    double *pd = dest.m[0];
+    double *pa = a.m[0];
+    double *pb = b.m[0];
+
+#if defined(__AVX512F__)
+
+    block_d512<8, 2, 16, 16>(pd,       pa,       pb);               // 8x16 tiles
+    block_d512<8, 2, 16, 16>(pd + 128, pa + 128, pb);
+
+    return block512;
+
+#else
+
+    for (int i = 0; i < 16; i += 4) {
+        block_d256<4, 2, 16, 16>(pd + i * 16,     pa + i * 16, pb);     // 4x8 tiles
+        block_d256<4, 2, 16, 16>(pd + i * 16 + 8, pa + i * 16, pb + 8);
+    }
+
+    return block256;
+
+#endif  // __AVX512F__
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Blocked matrix multiplication
+//
+// Micro-kernels keep a tile of dest in registers, 12 sums of 16 ymm for
+// AVX2 and 24 sums of 32 zmm for AVX-512, leaving registers for the row of
+// b and the broadcast element of a. Each step loads a row of the b panel,
+// then broadcasts the elements of the a panel down the tile.
+
+#if defined(__AVX512F__)
+
+template <> struct gemm_shape<float> {
+    static const size_t mr = 12;
+    static const size_t nr = 32;
+    static const size_t mc = 120;
+    static const size_t kc = 256;
+    static const size_t nc = 4096;
+};
+
+template <> struct gemm_shape<double> {
+    static const size_t mr = 12;
+    static const size_t nr = 16;
+    static const size_t mc = 96;
+    static const size_t kc = 256;
+    static const size_t nc = 2048;
+};
+
+template <>
+inline specialized gemm_kernel(float *dest, size_t ld, float *pa, float *pb, size_t kc) {
+    __m512 sum[12][2], rowb0, rowb1, veca;
+
+    for (int i = 0; i < 12; ++i) {
+        sum[i][0] = _mm512_loadu_ps(dest + i * ld);
+        sum[i][1] = _mm512_loadu_ps(dest + i * ld + 16);
+    }
+
+    for (size_t p = 0; p < kc; ++p, pa += 12, pb += 32) {
+        rowb0 = _mm512_loadu_ps(pb);                                // Row of the b panel
+        rowb1 = _mm512_loadu_ps(pb + 16);
+
+        for (int i = 0; i < 12; ++i) {
+            veca      = _mm512_set1_ps (pa[i]);                     // Column of the a panel
+            sum[i][0] = _mm512_fmadd_ps(veca, rowb0, sum[i][0]);
+            sum[i][1] = _mm512_fmadd_ps(veca, rowb1, sum[i][1]);
+        }
+    }
+
+    for (int i = 0; i < 12; ++i) {
+        _mm512_storeu_ps(dest + i * ld,      sum[i][0]);
+        _mm512_storeu_ps(dest + i * ld + 16, sum[i][1]);
+    }
+
+    return intrin512;
+}
+
+template <>
+inline specialized gemm_kernel(double *dest, size_t ld, double *pa, double *pb, size_t kc) {
+    __m512d sum[12][2], rowb0, rowb1, veca;
+
+    for (int i = 0; i < 12; ++i) {
+        sum[i][0] = _mm512_loadu_pd(dest + i * ld);
+        sum[i][1] = _mm512_loadu_pd(dest + i * ld + 8);
+    }
+
+    for (size_t p = 0; p < kc; ++p, pa += 12, pb += 16) {
+        rowb0 = _mm512_loadu_pd(pb);
+        rowb1 = _mm512_loadu_pd(pb + 8);
+
+        for (int i = 0; i < 12; ++i) {
+            veca      = _mm512_set1_pd (pa[i]);
+            sum[i][0] = _mm512_fmadd_pd(veca, rowb0, sum[i][0]);
+            sum[i][1] = _mm512_fmadd_pd(veca, rowb1, sum[i][1]);
+        }
+    }
+
+    for (int i = 0; i < 12; ++i) {
+        _mm512_storeu_pd(dest + i * ld,     sum[i][0]);
+        _mm512_storeu_pd(dest + i * ld + 8, sum[i][1]);
+    }
+
+    return intrin512;
+}
+
+#else
+
+template <> struct gemm_shape<float> {
+    static const size_t mr = 6;
+    static const size_t nr = 16;
+    static const size_t mc = 120;
+    static const size_t kc = 256;
+    static const size_t nc = 4096;
+};
+
+template <> struct gemm_shape<double> {
+    static const size_t mr = 6;
+    static const size_t nr = 8;
+    static const size_t mc = 96;
+    static const size_t kc = 256;
+    static const size_t nc = 2048;
+};
+
+template <>
+inline specialized gemm_kernel(float *dest, size_t ld, float *pa, float *pb, size_t kc) {
+    __m256 sum[6][2], rowb0, rowb1, veca;
+
+    for (int i = 0; i < 6; ++i) {
+        sum[i][0] = _mm256_loadu_ps(dest + i * ld);
+        sum[i][1] = _mm256_loadu_ps(dest + i * ld + 8);
+    }
+
+    for (size_t p = 0; p < kc; ++p, pa += 6, pb += 16) {
+        rowb0 = _mm256_loadu_ps(pb);                                // Row of the b panel
+        rowb1 = _mm256_loadu_ps(pb + 8);
+
+        for (int i = 0; i < 6; ++i) {
+            veca      = _mm256_broadcast_ss(pa + i);                // Column of the a panel
+            sum[i][0] = _mm256_fmadd_ps    (veca, rowb0, sum[i][0]);
+            sum[i][1] = _mm256_fmadd_ps    (veca, rowb1, sum[i][1]);
+        }
+    }
+
+    for (int i = 0; i < 6; ++i) {
+        _mm256_storeu_ps(dest + i * ld,     sum[i][0]);
+        _mm256_storeu_ps(dest + i * ld + 8, sum[i][1]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized gemm_kernel(double *dest, size_t ld, double *pa, double *pb, size_t kc) {
+    __m256d sum[6][2], rowb0, rowb1, veca;
+
+    for (int i = 0; i < 6; ++i) {
+        sum[i][0] = _mm256_loadu_pd(dest + i * ld);
+        sum[i][1] = _mm256_loadu_pd(dest + i * ld + 4);
+    }
+
+    for (size_t p = 0; p < kc; ++p, pa += 6, pb += 8) {
+        rowb0 = _mm256_loadu_pd(pb);
+        rowb1 = _mm256_loadu_pd(pb + 4);
+
+        for (int i = 0; i < 6; ++i) {
+            veca      = _mm256_broadcast_sd(pa + i);
+            sum[i][0] = _mm256_fmadd_pd    (veca, rowb0, sum[i][0]);
+            sum[i][1] = _mm256_fmadd_pd    (veca, rowb1, sum[i][1]);
+        }
+    }
+
+    for (int i = 0; i < 6; ++i) {
+        _mm256_storeu_pd(dest + i * ld,     sum[i][0]);
+        _mm256_storeu_pd(dest + i * ld + 4, sum[i][1]);
+    }
+
+    return intrin;
+}
+
+#endif  // __AVX512F__
+
+
+
+#elif defined(__aarch64__) || defined(__arm__)  // 64- or 32-bit ARM
+
+
+
+template <>
+constexpr specialized mat_x_mat(mat<float, 4, 4> &dest,
+                                mat<float, 4, 4> &a,
+                                mat<float, 4, 4> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    float32x4_t row0, row1, row2, row3, vec0, vec1, vec2, vec3;
+    float *pd = dest.m[0];
+    float *pa = a.m[0];
+    float *pb = b.m[0];
+
+    row0 = vld1q_f32     (pb);              // Load all the matrix rows
+    row1 = vld1q_f32     (pb +  4);
+    row2 = vld1q_f32     (pb +  8);
+    row3 = vld1q_f32     (pb + 12);
+
+    vec0 = vld1q_dup_f32 (pa);              // Duplicate the 1st element
+    vec1 = vld1q_dup_f32 (pa + 1);          //   of each column
+    vec2 = vld1q_dup_f32 (pa + 2);
+    vec3 = vld1q_dup_f32 (pa + 3);
+    vec0 = vmulq_f32     (row0, vec0);      // Multiply the elements
+    vec1 = vmulq_f32     (row1, vec1);
+    vec2 = vmulq_f32     (row2, vec2);
+    vec3 = vmulq_f32     (row3, vec3);
+    vec0 = vaddq_f32     (vec0, vec1);      // Add the products
+    vec1 = vaddq_f32     (vec2, vec3);
+    vec0 = vaddq_f32     (vec0, vec1);
+           vst1q_f32     (pd, vec0);        // Store a vector
+
+    vec0 = vld1q_dup_f32 (pa + 4);          // 2nd element of each column
+    vec1 = vld1q_dup_f32 (pa + 5);
+    vec2 = vld1q_dup_f32 (pa + 6);
+    vec3 = vld1q_dup_f32 (pa + 7);
+    vec0 = vmulq_f32     (row0, vec0);
+    vec1 = vmulq_f32     (row1, vec1);
+    vec2 = vmulq_f32     (row2, vec2);
+    vec3 = vmulq_f32     (row3, vec3);
+    vec0 = vaddq_f32     (vec0, vec1);
+    vec1 = vaddq_f32     (vec2, vec3);
+    vec0 = vaddq_f32     (vec0, vec1);
+           vst1q_f32     (pd + 4, vec0);
+
+    vec0 = vld1q_dup_f32 (pa +  8);         // 3rd element of each column
+    vec1 = vld1q_dup_f32 (pa +  9);
+    vec2 = vld1q_dup_f32 (pa + 10);
+    vec3 = vld1q_dup_f32 (pa + 11);
+    vec0 = vmulq_f32     (row0, vec0);
+    vec1 = vmulq_f32     (row1, vec1);
+    vec2 = vmulq_f32     (row2, vec2);
+    vec3 = vmulq_f32     (row3, vec3);
+    vec0 = vaddq_f32     (vec0, vec1);
+    vec1 = vaddq_f32     (vec2, vec3);
+    vec0 = vaddq_f32     (vec0, vec1);
+           vst1q_f32     (pd + 8, vec0);
+
+    vec0 = vld1q_dup_f32 (pa + 12);         // 4th element of each column
+    vec1 = vld1q_dup_f32 (pa + 13);
+    vec2 = vld1q_dup_f32 (pa + 14);
+    vec3 = vld1q_dup_f32 (pa + 15);
+    vec0 = vmulq_f32     (row0, vec0);
+    vec1 = vmulq_f32     (row1, vec1);
+    vec2 = vmulq_f32     (row2, vec2);
+    vec3 = vmulq_f32     (row3, vec3);
+    vec0 = vaddq_f32     (vec0, vec1);
+    vec1 = vaddq_f32     (vec2, vec3);
+    vec0 = vaddq_f32     (vec0, vec1);
+           vst1q_f32     (pd + 12, vec0);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<double, 4, 4> &dest,
+                                mat<double, 4, 4> &a,
+                                mat<double, 4, 4> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    uint32x4_t vec0;
+    uint32_t   *pd = (uint32_t *) dest.m[0];
+
+    // Just zero out destination
+    vec0 = vmovq_n_u32 (0);
+           vst1q_u32   (pd,      vec0);
+           vst1q_u32   (pd + 4,  vec0);
+           vst1q_u32   (pd + 8,  vec0);
+           vst1q_u32   (pd + 12, vec0);
+           vst1q_u32   (pd + 16, vec0);
+           vst1q_u32   (pd + 20, vec0);
+           vst1q_u32   (pd + 24, vec0);
+           vst1q_u32   (pd + 28, vec0);
+
+    return zero;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix and vector array multiplication
+
+template <>
+inline specialized vecarr_x_mat(vec <float, 4>    *dest,
+                                vec <float, 4>    *v,
+                                mat <float, 4, 4> &m,
+                                size_t            n) {
+    float32x4_t   row0, row1, row2, row3, vec0, vec1, vec2, vec3, vecs;
+    float *pd = dest->v;
+    float *pv = v->v;
+    float *pm = m.m[0];
+
+    row0 = vld1q_f32(pm +  0);              // Load all the matrix rows
+    row1 = vld1q_f32(pm +  4);
+    row2 = vld1q_f32(pm +  8);
+    row3 = vld1q_f32(pm + 12);
+
+    for (int i = 0; i < n; ++i, pv += 4, pd += 4) {
+        vec0 = vld1q_dup_f32 (pv + 0);      // Duplicate the nth element
+        vec1 = vld1q_dup_f32 (pv + 1);      //   of each column in a vector
+        vec2 = vld1q_dup_f32 (pv + 2);
+        vec3 = vld1q_dup_f32 (pv + 3);
+        vec0 = vmulq_f32     (row0, vec0);  // Multiply the elements
+        vec1 = vmulq_f32     (row1, vec1);
+        vec2 = vmulq_f32     (row2, vec2);
+        vec3 = vmulq_f32     (row3, vec3);
+        vec0 = vaddq_f32     (vec0, vec1);  // Add the products
+        vec1 = vaddq_f32     (vec2, vec3);
+        vec0 = vaddq_f32     (vec0, vec1);
+               vst1q_f32     (pd, vec0);    // Store a vector
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_mat(vec <double, 4>    *dest,
+                                vec <double, 4>    *v,
+                                mat <double, 4, 4> &m,
+                                size_t             n) {
+    uint32x4_t vec0;
     uint32_t   *pd = (uint32_t *) dest->v;
 
-    // Just zero out destination
-    vec0 = vmovq_n_u32 (0);
-    for (int i = 0; i < n; ++i, pd += 8) {
-        vst1q_u32   (pd,     vec0);
-        vst1q_u32   (pd + 4, vec0);
+    // Just zero out destination
+    vec0 = vmovq_n_u32 (0);
+    for (int i = 0; i < n; ++i, pd += 8) {
+        vst1q_u32   (pd,     vec0);
+        vst1q_u32   (pd + 4, vec0);
+    }
+
+    return zero;
+}
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix array multiplication
+
+template <>
+inline specialized matarr_x_mat(mat<float, 4, 4> *dest,
+                                mat<float, 4, 4> *a,
+                                mat<float, 4, 4> &b,
+                                size_t           n) {
+    float32x4_t row0, row1, row2, row3, vec0, vec1, vec2, vec3;
+    float *pd = dest->m[0];
+    float *pa = a->m[0];
+    float *pb = b.m[0];
+
+    row0 = vld1q_f32(pb +  0);              // Load all the rows of b
+    row1 = vld1q_f32(pb +  4);              //   once for the whole array
+    row2 = vld1q_f32(pb +  8);
+    row3 = vld1q_f32(pb + 12);
+
+    // Every row of every matrix in the array is a vector times b
+    size_t rows = n * 4;
+
+    for (size_t i = 0; i < rows; ++i, pa += 4, pd += 4) {
+        vec0 = vld1q_dup_f32 (pa + 0);      // Duplicate the nth element
+        vec1 = vld1q_dup_f32 (pa + 1);      //   of each row of a
+        vec2 = vld1q_dup_f32 (pa + 2);
+        vec3 = vld1q_dup_f32 (pa + 3);
+        vec0 = vmulq_f32     (row0, vec0);  // Multiply the elements
+        vec1 = vmulq_f32     (row1, vec1);
+        vec2 = vmulq_f32     (row2, vec2);
+        vec3 = vmulq_f32     (row3, vec3);
+        vec0 = vaddq_f32     (vec0, vec1);  // Add the products
+        vec1 = vaddq_f32     (vec2, vec3);
+        vec0 = vaddq_f32     (vec0, vec1);
+               vst1q_f32     (pd, vec0);    // Store a row
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized mat_x_matarr(mat<float, 4, 4> *dest,
+                                mat<float, 4, 4> &a,
+                                mat<float, 4, 4> *b,
+                                size_t           n) {
+    float32x2_t lo0, hi0, lo1, hi1, lo2, hi2, lo3, hi3;
+    float32x4_t row0, row1, row2, row3, vecd;
+    float *pd = dest->m[0];
+    float *pa = a.m[0];
+    float *pb = b->m[0];
+
+    lo0 = vld1_f32(pa +  0);                // Load all the rows of a
+    hi0 = vld1_f32(pa +  2);                //   once for the whole array,
+    lo1 = vld1_f32(pa +  4);                //   as halves for lane access
+    hi1 = vld1_f32(pa +  6);
+    lo2 = vld1_f32(pa +  8);
+    hi2 = vld1_f32(pa + 10);
+    lo3 = vld1_f32(pa + 12);
+    hi3 = vld1_f32(pa + 14);
+
+    for (size_t i = 0; i < n; ++i, pb += 16, pd += 16) {
+        row0 = vld1q_f32      (pb +  0);            // Load all the rows of b
+        row1 = vld1q_f32      (pb +  4);
+        row2 = vld1q_f32      (pb +  8);
+        row3 = vld1q_f32      (pb + 12);
+
+        vecd = vmulq_lane_f32 (row0, lo0, 0);       // Multiply by each element
+        vecd = vmlaq_lane_f32 (vecd, row1, lo0, 1); //   of a row of a and add
+        vecd = vmlaq_lane_f32 (vecd, row2, hi0, 0);
+        vecd = vmlaq_lane_f32 (vecd, row3, hi0, 1);
+               vst1q_f32      (pd, vecd);           // Store a row
+
+        vecd = vmulq_lane_f32 (row0, lo1, 0);
+        vecd = vmlaq_lane_f32 (vecd, row1, lo1, 1);
+        vecd = vmlaq_lane_f32 (vecd, row2, hi1, 0);
+        vecd = vmlaq_lane_f32 (vecd, row3, hi1, 1);
+               vst1q_f32      (pd + 4, vecd);
+
+        vecd = vmulq_lane_f32 (row0, lo2, 0);
+        vecd = vmlaq_lane_f32 (vecd, row1, lo2, 1);
+        vecd = vmlaq_lane_f32 (vecd, row2, hi2, 0);
+        vecd = vmlaq_lane_f32 (vecd, row3, hi2, 1);
+               vst1q_f32      (pd + 8, vecd);
+
+        vecd = vmulq_lane_f32 (row0, lo3, 0);
+        vecd = vmlaq_lane_f32 (vecd, row1, lo3, 1);
+        vecd = vmlaq_lane_f32 (vecd, row2, hi3, 0);
+        vecd = vmlaq_lane_f32 (vecd, row3, hi3, 1);
+               vst1q_f32      (pd + 12, vecd);
+    }
+
+    return intrin;
+}
+
+// ARM64 has 2 lane double vectors, ARM32 uses the unrolled templates
+#if defined(__aarch64__)
+
+template <>
+inline specialized matarr_x_mat(mat<double, 4, 4> *dest,
+                                mat<double, 4, 4> *a,
+                                mat<double, 4, 4> &b,
+                                size_t            n) {
+    float64x2_t lo0, hi0, lo1, hi1, lo2, hi2, lo3, hi3, vec01, vec23, dstl, dsth;
+    double *pd = dest->m[0];
+    double *pa = a->m[0];
+    double *pb = b.m[0];
+
+    lo0 = vld1q_f64(pb +  0);               // Load all the rows of b
+    hi0 = vld1q_f64(pb +  2);               //   once for the whole array,
+    lo1 = vld1q_f64(pb +  4);               //   lower and upper halves
+    hi1 = vld1q_f64(pb +  6);
+    lo2 = vld1q_f64(pb +  8);
+    hi2 = vld1q_f64(pb + 10);
+    lo3 = vld1q_f64(pb + 12);
+    hi3 = vld1q_f64(pb + 14);
+
+    // Every row of every matrix in the array is a vector times b
+    size_t rows = n * 4;
+
+    for (size_t i = 0; i < rows; ++i, pa += 4, pd += 4) {
+        vec01 = vld1q_f64        (pa);                  // Load a row of a
+        vec23 = vld1q_f64        (pa + 2);
+
+        dstl  = vmulq_laneq_f64  (lo0, vec01, 0);       // Multiply by each element
+        dsth  = vmulq_laneq_f64  (hi0, vec01, 0);       //   of the row and add
+        dstl  = vfmaq_laneq_f64  (dstl, lo1, vec01, 1);
+        dsth  = vfmaq_laneq_f64  (dsth, hi1, vec01, 1);
+        dstl  = vfmaq_laneq_f64  (dstl, lo2, vec23, 0);
+        dsth  = vfmaq_laneq_f64  (dsth, hi2, vec23, 0);
+        dstl  = vfmaq_laneq_f64  (dstl, lo3, vec23, 1);
+        dsth  = vfmaq_laneq_f64  (dsth, hi3, vec23, 1);
+                vst1q_f64        (pd,     dstl);        // Store a row
+                vst1q_f64        (pd + 2, dsth);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized mat_x_matarr(mat<double, 4, 4> *dest,
+                                mat<double, 4, 4> &a,
+                                mat<double, 4, 4> *b,
+                                size_t            n) {
+    float64x2_t a01_0, a23_0, a01_1, a23_1, a01_2, a23_2, a01_3, a23_3,
+                lo0, hi0, lo1, hi1, lo2, hi2, lo3, hi3, dstl, dsth;
+    double *pd = dest->m[0];
+    double *pa = a.m[0];
+    double *pb = b->m[0];
+
+    a01_0 = vld1q_f64(pa +  0);             // Load all the rows of a
+    a23_0 = vld1q_f64(pa +  2);             //   once for the whole array
+    a01_1 = vld1q_f64(pa +  4);
+    a23_1 = vld1q_f64(pa +  6);
+    a01_2 = vld1q_f64(pa +  8);
+    a23_2 = vld1q_f64(pa + 10);
+    a01_3 = vld1q_f64(pa + 12);
+    a23_3 = vld1q_f64(pa + 14);
+
+    for (size_t i = 0; i < n; ++i, pb += 16, pd += 16) {
+        lo0  = vld1q_f64        (pb +  0);              // Load all the rows of b
+        hi0  = vld1q_f64        (pb +  2);
+        lo1  = vld1q_f64        (pb +  4);
+        hi1  = vld1q_f64        (pb +  6);
+        lo2  = vld1q_f64        (pb +  8);
+        hi2  = vld1q_f64        (pb + 10);
+        lo3  = vld1q_f64        (pb + 12);
+        hi3  = vld1q_f64        (pb + 14);
+
+        dstl = vmulq_laneq_f64  (lo0, a01_0, 0);        // Multiply by each element
+        dsth = vmulq_laneq_f64  (hi0, a01_0, 0);        //   of a row of a and add
+        dstl = vfmaq_laneq_f64  (dstl, lo1, a01_0, 1);
+        dsth = vfmaq_laneq_f64  (dsth, hi1, a01_0, 1);
+        dstl = vfmaq_laneq_f64  (dstl, lo2, a23_0, 0);
+        dsth = vfmaq_laneq_f64  (dsth, hi2, a23_0, 0);
+        dstl = vfmaq_laneq_f64  (dstl, lo3, a23_0, 1);
+        dsth = vfmaq_laneq_f64  (dsth, hi3, a23_0, 1);
+               vst1q_f64        (pd +  0, dstl);        // Store a row
+               vst1q_f64        (pd +  2, dsth);
+
+        dstl = vmulq_laneq_f64  (lo0, a01_1, 0);
+        dsth = vmulq_laneq_f64  (hi0, a01_1, 0);
+        dstl = vfmaq_laneq_f64  (dstl, lo1, a01_1, 1);
+        dsth = vfmaq_laneq_f64  (dsth, hi1, a01_1, 1);
+        dstl = vfmaq_laneq_f64  (dstl, lo2, a23_1, 0);
+        dsth = vfmaq_laneq_f64  (dsth, hi2, a23_1, 0);
+        dstl = vfmaq_laneq_f64  (dstl, lo3, a23_1, 1);
+        dsth = vfmaq_laneq_f64  (dsth, hi3, a23_1, 1);
+               vst1q_f64        (pd +  4, dstl);
+               vst1q_f64        (pd +  6, dsth);
+
+        dstl = vmulq_laneq_f64  (lo0, a01_2, 0);
+        dsth = vmulq_laneq_f64  (hi0, a01_2, 0);
+        dstl = vfmaq_laneq_f64  (dstl, lo1, a01_2, 1);
+        dsth = vfmaq_laneq_f64  (dsth, hi1, a01_2, 1);
+        dstl = vfmaq_laneq_f64  (dstl, lo2, a23_2, 0);
+        dsth = vfmaq_laneq_f64  (dsth, hi2, a23_2, 0);
+        dstl = vfmaq_laneq_f64  (dstl, lo3, a23_2, 1);
+        dsth = vfmaq_laneq_f64  (dsth, hi3, a23_2, 1);
+               vst1q_f64        (pd +  8, dstl);
+               vst1q_f64        (pd + 10, dsth);
+
+        dstl = vmulq_laneq_f64  (lo0, a01_3, 0);
+        dsth = vmulq_laneq_f64  (hi0, a01_3, 0);
+        dstl = vfmaq_laneq_f64  (dstl, lo1, a01_3, 1);
+        dsth = vfmaq_laneq_f64  (dsth, hi1, a01_3, 1);
+        dstl = vfmaq_laneq_f64  (dstl, lo2, a23_3, 0);
+        dsth = vfmaq_laneq_f64  (dsth, hi2, a23_3, 0);
+        dstl = vfmaq_laneq_f64  (dstl, lo3, a23_3, 1);
+        dsth = vfmaq_laneq_f64  (dsth, hi3, a23_3, 1);
+               vst1q_f64        (pd + 12, dstl);
+               vst1q_f64        (pd + 14, dsth);
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Pairwise matrix array multiplication
+
+// Element (i,j) of the lane interleaved blocks starts at (i * 4 + j) * lanes.
+// A row of a is held in registers while it multiplies each column of b.
+
+template <>
+inline specialized matsoa_x_matsoa(matsoa<float, 4, 4> *dest,
+                                   matsoa<float, 4, 4> *a,
+                                   matsoa<float, 4, 4> *b,
+                                   size_t              blocks) {
+    const size_t lanes = matsoa<float, 4, 4>::lanes;
+    float32x4_t  row0, row1, row2, row3, vecd;
+
+    // 4 matrices per register, quarters of a block
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t q = 0; q < lanes; q += 4) {
+            float *pd = dest[e].m[0][0] + q;
+            float *pa = a[e].m[0][0] + q;
+            float *pb = b[e].m[0][0] + q;
+
+            for (int i = 0; i < 4; ++i, pd += 4 * lanes, pa += 4 * lanes) {
+                row0 = vld1q_f32 (pa + 0 * lanes);              // Load a row of a
+                row1 = vld1q_f32 (pa + 1 * lanes);
+                row2 = vld1q_f32 (pa + 2 * lanes);
+                row3 = vld1q_f32 (pa + 3 * lanes);
+
+                for (int j = 0; j < 4; ++j) {                   // Each column of b
+                    vecd = vmulq_f32 (row0, vld1q_f32(pb + ( 0 + j) * lanes));
+                    vecd = vmlaq_f32 (vecd, row1, vld1q_f32(pb + ( 4 + j) * lanes));
+                    vecd = vmlaq_f32 (vecd, row2, vld1q_f32(pb + ( 8 + j) * lanes));
+                    vecd = vmlaq_f32 (vecd, row3, vld1q_f32(pb + (12 + j) * lanes));
+                           vst1q_f32 (pd + j * lanes, vecd);
+                }
+            }
+        }
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized matsoa_x_matsoa(matsoa<double, 4, 4> *dest,
+                                   matsoa<double, 4, 4> *a,
+                                   matsoa<double, 4, 4> *b,
+                                   size_t               blocks) {
+    const size_t lanes = matsoa<double, 4, 4>::lanes;
+    float64x2_t  row0, row1, row2, row3, vecd;
+
+    // 2 matrices per register, quarters of a block
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t q = 0; q < lanes; q += 2) {
+            double *pd = dest[e].m[0][0] + q;
+            double *pa = a[e].m[0][0] + q;
+            double *pb = b[e].m[0][0] + q;
+
+            for (int i = 0; i < 4; ++i, pd += 4 * lanes, pa += 4 * lanes) {
+                row0 = vld1q_f64 (pa + 0 * lanes);              // Load a row of a
+                row1 = vld1q_f64 (pa + 1 * lanes);
+                row2 = vld1q_f64 (pa + 2 * lanes);
+                row3 = vld1q_f64 (pa + 3 * lanes);
+
+                for (int j = 0; j < 4; ++j) {                   // Each column of b
+                    vecd = vmulq_f64 (row0, vld1q_f64(pb + ( 0 + j) * lanes));
+                    vecd = vfmaq_f64 (vecd, row1, vld1q_f64(pb + ( 4 + j) * lanes));
+                    vecd = vfmaq_f64 (vecd, row2, vld1q_f64(pb + ( 8 + j) * lanes));
+                    vecd = vfmaq_f64 (vecd, row3, vld1q_f64(pb + (12 + j) * lanes));
+                           vst1q_f64 (pd + j * lanes, vecd);
+                }
+            }
+        }
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix inverse and determinant
+
+// The columns of a are held in registers, and the columns with the upper
+// and lower pairs of rows swapped, rev = [ a1k, a0k, a3k, a2k ].
+// col(i) * rev(j) - rev(i) * col(j) then holds the 2x2 sub-determinants
+// of columns i and j as [ s, -s, c, -c ], s from rows 0 and 1, c from
+// rows 2 and 3. Swapping its halves gives the cofactor signs needed to
+// build each row of the adjugate from three of the rev columns.
+// The determinant is row 0 of the adjugate times column 0 of a.
+
+template <>
+inline specialized determinant(float &dest, mat<float, 4, 4> &a) {
+    float32x4x4_t cols;
+    float32x4_t   rev1, rev2, rev3, sub3, sub4, sub5, vecd;
+    float32x2_t   half;
+    float         *pa = a.m[0];
+
+    cols = vld4q_f32     (pa);                              // Load the columns
+    rev1 = vrev64q_f32   (cols.val[1]);                     // Swap pairs of rows
+    rev2 = vrev64q_f32   (cols.val[2]);
+    rev3 = vrev64q_f32   (cols.val[3]);
+
+    sub3 = vmlsq_f32     (vmulq_f32(cols.val[1], rev2), rev1, cols.val[2]); // Columns 1 2
+    sub4 = vmlsq_f32     (vmulq_f32(cols.val[1], rev3), rev1, cols.val[3]); // Columns 1 3
+    sub5 = vmlsq_f32     (vmulq_f32(cols.val[2], rev3), rev2, cols.val[3]); // Columns 2 3
+    sub3 = vextq_f32     (sub3, sub3, 2);                   // Swap halves
+    sub4 = vextq_f32     (sub4, sub4, 2);
+    sub5 = vextq_f32     (sub5, sub5, 2);
+
+    vecd = vmulq_f32     (rev1, sub5);                      // Row 0 of the adjugate
+    vecd = vmlsq_f32     (vecd, rev2, sub4);
+    vecd = vmlaq_f32     (vecd, rev3, sub3);
+    vecd = vmulq_f32     (vecd, cols.val[0]);               // Sum of the products
+    half = vadd_f32      (vget_low_f32(vecd), vget_high_f32(vecd));
+    half = vpadd_f32     (half, half);
+    dest = vget_lane_f32 (half, 0);
+
+    return intrin;
+}
+
+template <>
+inline specialized inverse(mat<float, 4, 4> &dest, mat<float, 4, 4> &a) {
+    float32x4x4_t cols;
+    float32x4_t   rev0, rev1, rev2, rev3, sub0, sub1, sub2, sub3, sub4, sub5,
+                  row0, row1, row2, row3, vecd;
+    float32x2_t   half;
+    float         *pd = dest.m[0];
+    float         *pa = a.m[0];
+
+    cols = vld4q_f32     (pa);                              // Load the columns
+    rev0 = vrev64q_f32   (cols.val[0]);                     // Swap pairs of rows
+    rev1 = vrev64q_f32   (cols.val[1]);
+    rev2 = vrev64q_f32   (cols.val[2]);
+    rev3 = vrev64q_f32   (cols.val[3]);
+
+    sub0 = vmlsq_f32     (vmulq_f32(cols.val[0], rev1), rev0, cols.val[1]); // Columns 0 1
+    sub1 = vmlsq_f32     (vmulq_f32(cols.val[0], rev2), rev0, cols.val[2]); // Columns 0 2
+    sub2 = vmlsq_f32     (vmulq_f32(cols.val[0], rev3), rev0, cols.val[3]); // Columns 0 3
+    sub3 = vmlsq_f32     (vmulq_f32(cols.val[1], rev2), rev1, cols.val[2]); // Columns 1 2
+    sub4 = vmlsq_f32     (vmulq_f32(cols.val[1], rev3), rev1, cols.val[3]); // Columns 1 3
+    sub5 = vmlsq_f32     (vmulq_f32(cols.val[2], rev3), rev2, cols.val[3]); // Columns 2 3
+    sub0 = vextq_f32     (sub0, sub0, 2);                   // Swap halves
+    sub1 = vextq_f32     (sub1, sub1, 2);
+    sub2 = vextq_f32     (sub2, sub2, 2);
+    sub3 = vextq_f32     (sub3, sub3, 2);
+    sub4 = vextq_f32     (sub4, sub4, 2);
+    sub5 = vextq_f32     (sub5, sub5, 2);
+
+    row0 = vmulq_f32     (rev1, sub5);                      // Rows of the adjugate
+    row0 = vmlsq_f32     (row0, rev2, sub4);
+    row0 = vmlaq_f32     (row0, rev3, sub3);
+    row1 = vmulq_f32     (rev2, sub2);
+    row1 = vmlsq_f32     (row1, rev0, sub5);
+    row1 = vmlsq_f32     (row1, rev3, sub1);
+    row2 = vmulq_f32     (rev0, sub4);
+    row2 = vmlsq_f32     (row2, rev1, sub2);
+    row2 = vmlaq_f32     (row2, rev3, sub0);
+    row3 = vmulq_f32     (rev1, sub1);
+    row3 = vmlsq_f32     (row3, rev0, sub3);
+    row3 = vmlsq_f32     (row3, rev2, sub0);
+
+    vecd = vmulq_f32     (row0, cols.val[0]);               // Determinant
+    half = vadd_f32      (vget_low_f32(vecd), vget_high_f32(vecd));
+    half = vpadd_f32     (half, half);
+    vecd = vdupq_n_f32   (1.0f / vget_lane_f32(half, 0));   // Reciprocal
+
+           vst1q_f32     (pd +  0, vmulq_f32(row0, vecd));
+           vst1q_f32     (pd +  4, vmulq_f32(row1, vecd));
+           vst1q_f32     (pd +  8, vmulq_f32(row2, vecd));
+           vst1q_f32     (pd + 12, vmulq_f32(row3, vecd));
+
+    return intrin;
+}
+
+// The 4th row of the columns is replaced with zero, leaving the rotation
+// transposed and the 4th column zero'd. The translation row is built from those.
+
+template <>
+inline specialized rigid_inverse(mat<float, 4, 4> &dest, mat<float, 4, 4> &a) {
+    float32x4x4_t cols;
+    float32x4_t   col0, col1, col2, vect, vecd;
+    float         *pd = dest.m[0];
+    float         *pa = a.m[0];
+
+    cols = vld4q_f32      (pa);                             // Load the columns
+    vect = vld1q_f32      (pa + 12);                        // Load the translation
+    col0 = vsetq_lane_f32 (0.0f, cols.val[0], 3);           // Transposed rotation
+    col1 = vsetq_lane_f32 (0.0f, cols.val[1], 3);
+    col2 = vsetq_lane_f32 (0.0f, cols.val[2], 3);
+
+    vecd = vsetq_lane_f32 (1.0f, vdupq_n_f32(0.0f), 3);     // -t * T(R), last element 1
+    vecd = vmlsq_lane_f32 (vecd, col0, vget_low_f32(vect),  0);
+    vecd = vmlsq_lane_f32 (vecd, col1, vget_low_f32(vect),  1);
+    vecd = vmlsq_lane_f32 (vecd, col2, vget_high_f32(vect), 0);
+
+           vst1q_f32      (pd +  0, col0);
+           vst1q_f32      (pd +  4, col1);
+           vst1q_f32      (pd +  8, col2);
+           vst1q_f32      (pd + 12, vecd);
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+// Double precision columns are split into rows 0 1 and rows 2 3,
+// swapping the halves of the sub-determinants is swapping registers.
+
+template <>
+inline specialized determinant(double &dest, mat<double, 4, 4> &a) {
+    float64x2_t rowl, rowh, rowl1, rowh1,
+                col0l, col1l, col2l, col3l, col0h, col1h, col2h, col3h,
+                rev1l, rev2l, rev3l, rev1h, rev2h, rev3h,
+                sub3l, sub4l, sub5l, sub3h, sub4h, sub5h, vecl, vech;
+    double      *pa = a.m[0];
+
+    rowl  = vld1q_f64   (pa +  0);                          // Load rows 0 and 1
+    rowh  = vld1q_f64   (pa +  2);
+    rowl1 = vld1q_f64   (pa +  4);
+    rowh1 = vld1q_f64   (pa +  6);
+    col0l = vzip1q_f64  (rowl, rowl1);                      // Columns, rows 0 and 1
+    col1l = vzip2q_f64  (rowl, rowl1);
+    col2l = vzip1q_f64  (rowh, rowh1);
+    col3l = vzip2q_f64  (rowh, rowh1);
+    rowl  = vld1q_f64   (pa +  8);                          // Load rows 2 and 3
+    rowh  = vld1q_f64   (pa + 10);
+    rowl1 = vld1q_f64   (pa + 12);
+    rowh1 = vld1q_f64   (pa + 14);
+    col0h = vzip1q_f64  (rowl, rowl1);                      // Columns, rows 2 and 3
+    col1h = vzip2q_f64  (rowl, rowl1);
+    col2h = vzip1q_f64  (rowh, rowh1);
+    col3h = vzip2q_f64  (rowh, rowh1);
+
+    rev1l = vextq_f64   (col1l, col1l, 1);                  // Swap pairs of rows
+    rev2l = vextq_f64   (col2l, col2l, 1);
+    rev3l = vextq_f64   (col3l, col3l, 1);
+    rev1h = vextq_f64   (col1h, col1h, 1);
+    rev2h = vextq_f64   (col2h, col2h, 1);
+    rev3h = vextq_f64   (col3h, col3h, 1);
+
+    sub3l = vfmsq_f64   (vmulq_f64(col1l, rev2l), rev1l, col2l);    // Columns 1 2
+    sub3h = vfmsq_f64   (vmulq_f64(col1h, rev2h), rev1h, col2h);
+    sub4l = vfmsq_f64   (vmulq_f64(col1l, rev3l), rev1l, col3l);    // Columns 1 3
+    sub4h = vfmsq_f64   (vmulq_f64(col1h, rev3h), rev1h, col3h);
+    sub5l = vfmsq_f64   (vmulq_f64(col2l, rev3l), rev2l, col3l);    // Columns 2 3
+    sub5h = vfmsq_f64   (vmulq_f64(col2h, rev3h), rev2h, col3h);
+
+    vecl  = vmulq_f64   (rev1l, sub5h);                     // Row 0 of the adjugate
+    vech  = vmulq_f64   (rev1h, sub5l);                     //   with halves swapped
+    vecl  = vfmsq_f64   (vecl, rev2l, sub4h);
+    vech  = vfmsq_f64   (vech, rev2h, sub4l);
+    vecl  = vfmaq_f64   (vecl, rev3l, sub3h);
+    vech  = vfmaq_f64   (vech, rev3h, sub3l);
+    vecl  = vmulq_f64   (vecl, col0l);                      // Sum of the products
+    vecl  = vfmaq_f64   (vecl, vech, col0h);
+    dest  = vaddvq_f64  (vecl);
+
+    return intrin;
+}
+
+template <>
+inline specialized inverse(mat<double, 4, 4> &dest, mat<double, 4, 4> &a) {
+    float64x2_t rowl, rowh, rowl1, rowh1,
+                col0l, col1l, col2l, col3l, col0h, col1h, col2h, col3h,
+                rev0l, rev1l, rev2l, rev3l, rev0h, rev1h, rev2h, rev3h,
+                sub0l, sub1l, sub2l, sub3l, sub4l, sub5l,
+                sub0h, sub1h, sub2h, sub3h, sub4h, sub5h,
+                row0l, row1l, row2l, row3l, row0h, row1h, row2h, row3h, vecd;
+    double      *pd = dest.m[0];
+    double      *pa = a.m[0];
+
+    rowl  = vld1q_f64   (pa +  0);                          // Load rows 0 and 1
+    rowh  = vld1q_f64   (pa +  2);
+    rowl1 = vld1q_f64   (pa +  4);
+    rowh1 = vld1q_f64   (pa +  6);
+    col0l = vzip1q_f64  (rowl, rowl1);                      // Columns, rows 0 and 1
+    col1l = vzip2q_f64  (rowl, rowl1);
+    col2l = vzip1q_f64  (rowh, rowh1);
+    col3l = vzip2q_f64  (rowh, rowh1);
+    rowl  = vld1q_f64   (pa +  8);                          // Load rows 2 and 3
+    rowh  = vld1q_f64   (pa + 10);
+    rowl1 = vld1q_f64   (pa + 12);
+    rowh1 = vld1q_f64   (pa + 14);
+    col0h = vzip1q_f64  (rowl, rowl1);                      // Columns, rows 2 and 3
+    col1h = vzip2q_f64  (rowl, rowl1);
+    col2h = vzip1q_f64  (rowh, rowh1);
+    col3h = vzip2q_f64  (rowh, rowh1);
+
+    rev0l = vextq_f64   (col0l, col0l, 1);                  // Swap pairs of rows
+    rev1l = vextq_f64   (col1l, col1l, 1);
+    rev2l = vextq_f64   (col2l, col2l, 1);
+    rev3l = vextq_f64   (col3l, col3l, 1);
+    rev0h = vextq_f64   (col0h, col0h, 1);
+    rev1h = vextq_f64   (col1h, col1h, 1);
+    rev2h = vextq_f64   (col2h, col2h, 1);
+    rev3h = vextq_f64   (col3h, col3h, 1);
+
+    // Halves are swapped by naming, subNl holds [ c, -c ] and subNh [ s, -s ]
+    sub0h = vfmsq_f64   (vmulq_f64(col0l, rev1l), rev0l, col1l);    // Columns 0 1
+    sub0l = vfmsq_f64   (vmulq_f64(col0h, rev1h), rev0h, col1h);
+    sub1h = vfmsq_f64   (vmulq_f64(col0l, rev2l), rev0l, col2l);    // Columns 0 2
+    sub1l = vfmsq_f64   (vmulq_f64(col0h, rev2h), rev0h, col2h);
+    sub2h = vfmsq_f64   (vmulq_f64(col0l, rev3l), rev0l, col3l);    // Columns 0 3
+    sub2l = vfmsq_f64   (vmulq_f64(col0h, rev3h), rev0h, col3h);
+    sub3h = vfmsq_f64   (vmulq_f64(col1l, rev2l), rev1l, col2l);    // Columns 1 2
+    sub3l = vfmsq_f64   (vmulq_f64(col1h, rev2h), rev1h, col2h);
+    sub4h = vfmsq_f64   (vmulq_f64(col1l, rev3l), rev1l, col3l);    // Columns 1 3
+    sub4l = vfmsq_f64   (vmulq_f64(col1h, rev3h), rev1h, col3h);
+    sub5h = vfmsq_f64   (vmulq_f64(col2l, rev3l), rev2l, col3l);    // Columns 2 3
+    sub5l = vfmsq_f64   (vmulq_f64(col2h, rev3h), rev2h, col3h);
+
+    row0l = vmulq_f64   (rev1l, sub5l);                     // Rows of the adjugate
+    row0h = vmulq_f64   (rev1h, sub5h);
+    row0l = vfmsq_f64   (row0l, rev2l, sub4l);
+    row0h = vfmsq_f64   (row0h, rev2h, sub4h);
+    row0l = vfmaq_f64   (row0l, rev3l, sub3l);
+    row0h = vfmaq_f64   (row0h, rev3h, sub3h);
+    row1l = vmulq_f64   (rev2l, sub2l);
+    row1h = vmulq_f64   (rev2h, sub2h);
+    row1l = vfmsq_f64   (row1l, rev0l, sub5l);
+    row1h = vfmsq_f64   (row1h, rev0h, sub5h);
+    row1l = vfmsq_f64   (row1l, rev3l, sub1l);
+    row1h = vfmsq_f64   (row1h, rev3h, sub1h);
+    row2l = vmulq_f64   (rev0l, sub4l);
+    row2h = vmulq_f64   (rev0h, sub4h);
+    row2l = vfmsq_f64   (row2l, rev1l, sub2l);
+    row2h = vfmsq_f64   (row2h, rev1h, sub2h);
+    row2l = vfmaq_f64   (row2l, rev3l, sub0l);
+    row2h = vfmaq_f64   (row2h, rev3h, sub0h);
+    row3l = vmulq_f64   (rev1l, sub1l);
+    row3h = vmulq_f64   (rev1h, sub1h);
+    row3l = vfmsq_f64   (row3l, rev0l, sub3l);
+    row3h = vfmsq_f64   (row3h, rev0h, sub3h);
+    row3l = vfmsq_f64   (row3l, rev2l, sub0l);
+    row3h = vfmsq_f64   (row3h, rev2h, sub0h);
+
+    vecd  = vmulq_f64   (row0l, col0l);                     // Determinant
+    vecd  = vfmaq_f64   (vecd, row0h, col0h);
+    vecd  = vdupq_n_f64 (1.0 / vaddvq_f64(vecd));           // Reciprocal
+
+            vst1q_f64   (pd +  0, vmulq_f64(row0l, vecd));
+            vst1q_f64   (pd +  2, vmulq_f64(row0h, vecd));
+            vst1q_f64   (pd +  4, vmulq_f64(row1l, vecd));
+            vst1q_f64   (pd +  6, vmulq_f64(row1h, vecd));
+            vst1q_f64   (pd +  8, vmulq_f64(row2l, vecd));
+            vst1q_f64   (pd + 10, vmulq_f64(row2h, vecd));
+            vst1q_f64   (pd + 12, vmulq_f64(row3l, vecd));
+            vst1q_f64   (pd + 14, vmulq_f64(row3h, vecd));
+
+    return intrin;
+}
+
+template <>
+inline specialized rigid_inverse(mat<double, 4, 4> &dest, mat<double, 4, 4> &a) {
+    float64x2_t rowl, rowh, rowl1, rowh1, zero,
+                col0l, col1l, col2l, col0h, col1h, col2h, vect, vecl, vech;
+    double      *pd = dest.m[0];
+    double      *pa = a.m[0];
+
+    zero  = vdupq_n_f64 (0.0);
+    rowl  = vld1q_f64   (pa +  0);                          // Load rows 0 and 1
+    rowh  = vld1q_f64   (pa +  2);
+    rowl1 = vld1q_f64   (pa +  4);
+    rowh1 = vld1q_f64   (pa +  6);
+    col0l = vzip1q_f64  (rowl, rowl1);                      // Transposed rotation
+    col1l = vzip2q_f64  (rowl, rowl1);
+    col2l = vzip1q_f64  (rowh, rowh1);
+    rowl  = vld1q_f64   (pa +  8);                          // Load row 2
+    rowh  = vld1q_f64   (pa + 10);
+    col0h = vzip1q_f64  (rowl, zero);                       //   and zero'd 4th column
+    col1h = vzip2q_f64  (rowl, zero);
+    col2h = vzip1q_f64  (rowh, zero);
+
+    vect  = vld1q_f64   (pa + 12);                          // -t * T(R), last element 1
+    vecl  = vfmsq_laneq_f64 (zero, col0l, vect, 0);
+    vech  = vfmsq_laneq_f64 (vsetq_lane_f64(1.0, zero, 1), col0h, vect, 0);
+    vecl  = vfmsq_laneq_f64 (vecl, col1l, vect, 1);
+    vech  = vfmsq_laneq_f64 (vech, col1h, vect, 1);
+    vect  = vld1q_f64   (pa + 14);
+    vecl  = vfmsq_laneq_f64 (vecl, col2l, vect, 0);
+    vech  = vfmsq_laneq_f64 (vech, col2h, vect, 0);
+
+            vst1q_f64   (pd +  0, col0l);
+            vst1q_f64   (pd +  2, col0h);
+            vst1q_f64   (pd +  4, col1l);
+            vst1q_f64   (pd +  6, col1h);
+            vst1q_f64   (pd +  8, col2l);
+            vst1q_f64   (pd + 10, col2h);
+            vst1q_f64   (pd + 12, vecl);
+            vst1q_f64   (pd + 14, vech);
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix transpose
+
+// Structure loads de-interleave every 4th element, which are the columns
+
+template <>
+constexpr specialized transpose(mat<float, 4, 4> &dest, mat<float, 4, 4> &a) {
+    if (std::is_constant_evaluated()) {
+        return looped_transpose(dest, a);
+    }
+
+    float         *pd = dest.m[0];
+    float         *pa = a.m[0];
+    float32x4x4_t cols;
+
+    cols = vld4q_f32 (pa);                                  // Load the columns
+           vst1q_f32 (pd +  0, cols.val[0]);                // Store them as rows
+           vst1q_f32 (pd +  4, cols.val[1]);
+           vst1q_f32 (pd +  8, cols.val[2]);
+           vst1q_f32 (pd + 12, cols.val[3]);
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+constexpr specialized transpose(mat<double, 4, 4> &dest, mat<double, 4, 4> &a) {
+    if (std::is_constant_evaluated()) {
+        return looped_transpose(dest, a);
+    }
+
+    double        *pd = dest.m[0];
+    double        *pa = a.m[0];
+    float64x2x4_t lo, hi;
+
+    lo = vld4q_f64 (pa + 0);                                // Columns of rows 0 and 1
+    hi = vld4q_f64 (pa + 8);                                // Columns of rows 2 and 3
+         vst1q_f64 (pd +  0, lo.val[0]);                    // Store them as rows
+         vst1q_f64 (pd +  2, hi.val[0]);
+         vst1q_f64 (pd +  4, lo.val[1]);
+         vst1q_f64 (pd +  6, hi.val[1]);
+         vst1q_f64 (pd +  8, lo.val[2]);
+         vst1q_f64 (pd + 10, hi.val[2]);
+         vst1q_f64 (pd + 12, lo.val[3]);
+         vst1q_f64 (pd + 14, hi.val[3]);
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Normal transformation
+
+// Rows of the normal matrix padded with zero, so the 4th element is zero'd.
+// Float normalization uses the reciprocal square root estimate refined
+// with one Newton-Raphson step, vrsqrts computes (3 - x * y * y) / 2.
+
+template <>
+inline specialized normarr_x_mat(vec<float, 4>    *dest,
+                                 vec<float, 4>    *v,
+                                 mat<float, 4, 4> &m,
+                                 size_t           n,
+                                 bool             normalize) {
+    mat<float, 3, 3> nm;
+    float32x4_t row0, row1, row2, vecd, vecs, vecy;
+    float32x2_t sum;
+
+    normal_matrix(nm, m);
+
+    float rows[3][4] = { { nm.m[0][0], nm.m[0][1], nm.m[0][2], 0.0f },
+                         { nm.m[1][0], nm.m[1][1], nm.m[1][2], 0.0f },
+                         { nm.m[2][0], nm.m[2][1], nm.m[2][2], 0.0f } };
+
+    row0 = vld1q_f32 (rows[0]);
+    row1 = vld1q_f32 (rows[1]);
+    row2 = vld1q_f32 (rows[2]);
+
+    for (size_t e = 0; e < n; ++e) {
+        float *pd = dest[e].v;
+        float *pv = v[e].v;
+
+        vecd = vmulq_n_f32      (row0, pv[0]);
+        vecd = vmlaq_n_f32      (vecd, row1, pv[1]);
+        vecd = vmlaq_n_f32      (vecd, row2, pv[2]);
+
+        if (normalize) {
+            vecs = vmulq_f32    (vecd, vecd);                   // Squared length
+            sum  = vadd_f32     (vget_low_f32(vecs), vget_high_f32(vecs));
+            sum  = vpadd_f32    (sum, sum);
+            vecs = vcombine_f32 (sum, sum);
+            vecy = vrsqrteq_f32 (vecs);                         // Estimate
+            vecy = vmulq_f32    (vecy, vrsqrtsq_f32(vmulq_f32(vecs, vecy), vecy));
+            vecd = vmulq_f32    (vecd, vecy);
+        }
+
+               vst1q_f32        (pd, vecd);
+    }
+
+    return intrin;
+}
+
+// 3 element vectors are padded to 4 elements, the memory layout is the same
+
+template <>
+inline specialized normarr_x_mat(vec<float, 3>    *dest,
+                                 vec<float, 3>    *v,
+                                 mat<float, 4, 4> &m,
+                                 size_t           n,
+                                 bool             normalize) {
+    return normarr_x_mat((vec<float, 4> *) dest, (vec<float, 4> *) v, m, n, normalize);
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized normarr_x_mat(vec<double, 4>    *dest,
+                                 vec<double, 4>    *v,
+                                 mat<double, 4, 4> &m,
+                                 size_t            n,
+                                 bool              normalize) {
+    mat<double, 3, 3> nm;
+    float64x2_t row0l, row1l, row2l, row0h, row1h, row2h, vecl, vech, vecs;
+
+    normal_matrix(nm, m);
+    row0l = vld1q_f64       (nm.m[0]);                      // Rows padded with zero
+    row1l = vld1q_f64       (nm.m[1]);
+    row2l = vld1q_f64       (nm.m[2]);
+    row0h = vsetq_lane_f64  (nm.m[0][2], vdupq_n_f64(0.0), 0);
+    row1h = vsetq_lane_f64  (nm.m[1][2], vdupq_n_f64(0.0), 0);
+    row2h = vsetq_lane_f64  (nm.m[2][2], vdupq_n_f64(0.0), 0);
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pd = dest[e].v;
+        double *pv = v[e].v;
+
+        vecl = vmulq_n_f64      (row0l, pv[0]);
+        vech = vmulq_n_f64      (row0h, pv[0]);
+        vecl = vfmaq_n_f64      (vecl, row1l, pv[1]);
+        vech = vfmaq_n_f64      (vech, row1h, pv[1]);
+        vecl = vfmaq_n_f64      (vecl, row2l, pv[2]);
+        vech = vfmaq_n_f64      (vech, row2h, pv[2]);
+
+        if (normalize) {
+            vecs = vmulq_f64    (vecl, vecl);                   // Length
+            vecs = vfmaq_f64    (vecs, vech, vech);
+            vecs = vsqrtq_f64   (vdupq_n_f64(vaddvq_f64(vecs)));
+            vecl = vdivq_f64    (vecl, vecs);
+            vech = vdivq_f64    (vech, vecs);
+        }
+
+               vst1q_f64        (pd + 0, vecl);
+               vst1q_f64        (pd + 2, vech);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized normarr_x_mat(vec<double, 3>    *dest,
+                                 vec<double, 3>    *v,
+                                 mat<double, 4, 4> &m,
+                                 size_t            n,
+                                 bool              normalize) {
+    return normarr_x_mat((vec<double, 4> *) dest, (vec<double, 4> *) v, m, n, normalize);
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Projection and perspective divide
+
+// Reciprocal estimates are refined with Newton-Raphson,
+// vrecps computes 2 - w * r. 32-bit ARM has no divide instruction,
+// so the exact float version uses a second refinement step.
+// The w element of each vector is replaced by 1/w before the viewport.
+
+template <>
+inline specialized projarr_x_mat(vec<float, 4>    *dest,
+                                 vec<float, 4>    *v,
+                                 mat<float, 4, 4> &m,
+                                 vec<float, 4>    &scale,
+                                 vec<float, 4>    &offset,
+                                 size_t           n,
+                                 bool             approx,
+                                 unsigned char    *clip) {
+    float       *pd = dest[0].v;
+    float       *pv = v[0].v;
+    float       *pm = m.m[0];
+    float32x4_t row0, row1, row2, row3, vecs, veco, vecv, vecd, vecw, vecr;
+
+    row0 = vld1q_f32 (pm +  0);                             // Load all the matrix rows
+    row1 = vld1q_f32 (pm +  4);
+    row2 = vld1q_f32 (pm +  8);
+    row3 = vld1q_f32 (pm + 12);
+    vecs = vld1q_f32 (scale.v);
+    veco = vld1q_f32 (offset.v);
+
+    for (size_t e = 0; e < n; ++e, pd += 4, pv += 4) {
+        vecv = vld1q_f32        (pv);
+        vecd = vmulq_lane_f32   (row0, vget_low_f32(vecv),  0);
+        vecd = vmlaq_lane_f32   (vecd, row1, vget_low_f32(vecv),  1);
+        vecd = vmlaq_lane_f32   (vecd, row2, vget_high_f32(vecv), 0);
+        vecd = vmlaq_lane_f32   (vecd, row3, vget_high_f32(vecv), 1);
+        vecw = vdupq_lane_f32   (vget_high_f32(vecd), 1);   // Duplicate w
+
+        vecr = vrecpeq_f32      (vecw);                     // Estimate
+        vecr = vmulq_f32        (vecr, vrecpsq_f32(vecw, vecr));
+
+        if (!approx) {
+#if defined(__aarch64__)
+            vecr = vdivq_f32    (vdupq_n_f32(1.0f), vecw);
+#else
+            vecr = vmulq_f32    (vecr, vrecpsq_f32(vecw, vecr));
+#endif
+        }
+
+        vecd = vmulq_f32        (vecd, vecr);
+        vecd = vsetq_lane_f32   (vgetq_lane_f32(vecr, 3), vecd, 3);
+        vecd = vmlaq_f32        (veco, vecd, vecs);         // Viewport
+               vst1q_f32        (pd, vecd);
+
+        if (clip != nullptr) {
+            clip[e] = vgetq_lane_f32(vecw, 0) <= 0.0f;
+        }
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized projarr_x_mat(vec<double, 4>    *dest,
+                                 vec<double, 4>    *v,
+                                 mat<double, 4, 4> &m,
+                                 vec<double, 4>    &scale,
+                                 vec<double, 4>    &offset,
+                                 size_t            n,
+                                 bool              approx,
+                                 unsigned char     *clip) {
+    double      *pd = dest[0].v;
+    double      *pv = v[0].v;
+    double      *pm = m.m[0];
+    float64x2_t row0l, row1l, row2l, row3l, row0h, row1h, row2h, row3h,
+                vecsl, vecsh, vecol, vecoh, vecvl, vecvh, vecl, vech, vecw, vecr;
+
+    row0l = vld1q_f64 (pm +  0);                            // Load all the matrix rows
+    row0h = vld1q_f64 (pm +  2);
+    row1l = vld1q_f64 (pm +  4);
+    row1h = vld1q_f64 (pm +  6);
+    row2l = vld1q_f64 (pm +  8);
+    row2h = vld1q_f64 (pm + 10);
+    row3l = vld1q_f64 (pm + 12);
+    row3h = vld1q_f64 (pm + 14);
+    vecsl = vld1q_f64 (scale.v + 0);
+    vecsh = vld1q_f64 (scale.v + 2);
+    vecol = vld1q_f64 (offset.v + 0);
+    vecoh = vld1q_f64 (offset.v + 2);
+
+    for (size_t e = 0; e < n; ++e, pd += 4, pv += 4) {
+        vecvl = vld1q_f64       (pv + 0);
+        vecvh = vld1q_f64       (pv + 2);
+        vecl  = vmulq_laneq_f64 (row0l, vecvl, 0);
+        vech  = vmulq_laneq_f64 (row0h, vecvl, 0);
+        vecl  = vfmaq_laneq_f64 (vecl, row1l, vecvl, 1);
+        vech  = vfmaq_laneq_f64 (vech, row1h, vecvl, 1);
+        vecl  = vfmaq_laneq_f64 (vecl, row2l, vecvh, 0);
+        vech  = vfmaq_laneq_f64 (vech, row2h, vecvh, 0);
+        vecl  = vfmaq_laneq_f64 (vecl, row3l, vecvh, 1);
+        vech  = vfmaq_laneq_f64 (vech, row3h, vecvh, 1);
+        vecw  = vdupq_laneq_f64 (vech, 1);                  // Duplicate w
+
+        if (approx) {                                       // 8 bits, three steps to 64
+            vecr = vrecpeq_f64  (vecw);
+            vecr = vmulq_f64    (vecr, vrecpsq_f64(vecw, vecr));
+            vecr = vmulq_f64    (vecr, vrecpsq_f64(vecw, vecr));
+            vecr = vmulq_f64    (vecr, vrecpsq_f64(vecw, vecr));
+        } else {
+            vecr = vdivq_f64    (vdupq_n_f64(1.0), vecw);
+        }
+
+        vecl  = vmulq_f64       (vecl, vecr);
+        vech  = vmulq_f64       (vech, vecr);
+        vech  = vsetq_lane_f64  (vgetq_lane_f64(vecr, 1), vech, 1);
+        vecl  = vfmaq_f64       (vecol, vecl, vecsl);       // Viewport
+        vech  = vfmaq_f64       (vecoh, vech, vecsh);
+                vst1q_f64       (pd + 0, vecl);
+                vst1q_f64       (pd + 2, vech);
+
+        if (clip != nullptr) {
+            clip[e] = vgetq_lane_f64(vecw, 0) <= 0.0;
+        }
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Quaternions
+
+// vld4 de-interleaves quaternions and vectors into x, y, z and w registers,
+// the matrix rows are stored one lane at a time with vst4 lane stores.
+
+template <>
+inline specialized quatarr_to_matarr(mat<float, 4, 4> *dest, quat<float> *q, size_t n) {
+    float32x4x4_t quat, row0, row1, row2;
+    float32x4_t   x2, y2, z2, xx, yy, zz, xy, xz, yz, xw, yw, zw, one, zero, last;
+    size_t        e;
+
+    float rlast[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    one  = vdupq_n_f32 (1.0f);
+    zero = vdupq_n_f32 (0.0f);
+    last = vld1q_f32   (rlast);
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        float *pd = dest[e].m[0];
+        float *pq = q[e].v;
+
+        quat = vld4q_f32        (pq);                       // De-interleave x, y, z, w
+
+        x2 = vaddq_f32          (quat.val[0], quat.val[0]);
+        y2 = vaddq_f32          (quat.val[1], quat.val[1]);
+        z2 = vaddq_f32          (quat.val[2], quat.val[2]);
+        xx = vmulq_f32          (quat.val[0], x2);
+        yy = vmulq_f32          (quat.val[1], y2);
+        zz = vmulq_f32          (quat.val[2], z2);
+        xy = vmulq_f32          (quat.val[0], y2);
+        xz = vmulq_f32          (quat.val[0], z2);
+        yz = vmulq_f32          (quat.val[1], z2);
+        xw = vmulq_f32          (quat.val[3], x2);
+        yw = vmulq_f32          (quat.val[3], y2);
+        zw = vmulq_f32          (quat.val[3], z2);
+
+        row0.val[0] = vsubq_f32 (one, vaddq_f32(yy, zz));
+        row0.val[1] = vaddq_f32 (xy, zw);
+        row0.val[2] = vsubq_f32 (xz, yw);
+        row0.val[3] = zero;
+        row1.val[0] = vsubq_f32 (xy, zw);
+        row1.val[1] = vsubq_f32 (one, vaddq_f32(xx, zz));
+        row1.val[2] = vaddq_f32 (yz, xw);
+        row1.val[3] = zero;
+        row2.val[0] = vaddq_f32 (xz, yw);
+        row2.val[1] = vsubq_f32 (yz, xw);
+        row2.val[2] = vsubq_f32 (one, vaddq_f32(xx, yy));
+        row2.val[3] = zero;
+
+        vst4q_lane_f32          (pd +  0, row0, 0);         // Interleave back to rows
+        vst4q_lane_f32          (pd +  4, row1, 0);
+        vst4q_lane_f32          (pd +  8, row2, 0);
+        vst1q_f32               (pd + 12, last);
+        vst4q_lane_f32          (pd + 16, row0, 1);
+        vst4q_lane_f32          (pd + 20, row1, 1);
+        vst4q_lane_f32          (pd + 24, row2, 1);
+        vst1q_f32               (pd + 28, last);
+        vst4q_lane_f32          (pd + 32, row0, 2);
+        vst4q_lane_f32          (pd + 36, row1, 2);
+        vst4q_lane_f32          (pd + 40, row2, 2);
+        vst1q_f32               (pd + 44, last);
+        vst4q_lane_f32          (pd + 48, row0, 3);
+        vst4q_lane_f32          (pd + 52, row1, 3);
+        vst4q_lane_f32          (pd + 56, row2, 3);
+        vst1q_f32               (pd + 60, last);
+    }
+
+    for (; e < n; ++e) {
+        quat_to_mat(dest[e], q[e]);
+    }
+
+    return intrin;
+}
+
+// 4 vectors at a time, the 4th element is passed through unchanged
+
+template <>
+inline specialized vecarr_x_quat(vec<float, 4> *dest,
+                                 vec<float, 4> *v,
+                                 quat<float>   &q,
+                                 size_t        n) {
+    float32x4x4_t vecv;
+    float32x4_t   tx, ty, tz;
+    float         x = q.v[0], y = q.v[1], z = q.v[2], w = q.v[3];
+    float         x2 = x + x, y2 = y + y, z2 = z + z;
+    size_t        e;
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        vecv = vld4q_f32            (v[e].v);               // De-interleave x, y, z, w
+
+        tx   = vmlsq_n_f32          (vmulq_n_f32(vecv.val[2], y2), vecv.val[1], z2);
+        ty   = vmlsq_n_f32          (vmulq_n_f32(vecv.val[0], z2), vecv.val[2], x2);
+        tz   = vmlsq_n_f32          (vmulq_n_f32(vecv.val[1], x2), vecv.val[0], y2);
+
+        vecv.val[0] = vmlaq_n_f32   (vecv.val[0], tx, w);
+        vecv.val[0] = vmlaq_n_f32   (vecv.val[0], tz, y);
+        vecv.val[0] = vmlsq_n_f32   (vecv.val[0], ty, z);
+        vecv.val[1] = vmlaq_n_f32   (vecv.val[1], ty, w);
+        vecv.val[1] = vmlaq_n_f32   (vecv.val[1], tx, z);
+        vecv.val[1] = vmlsq_n_f32   (vecv.val[1], tz, x);
+        vecv.val[2] = vmlaq_n_f32   (vecv.val[2], tz, w);
+        vecv.val[2] = vmlaq_n_f32   (vecv.val[2], ty, x);
+        vecv.val[2] = vmlsq_n_f32   (vecv.val[2], tx, y);
+
+                      vst4q_f32     (dest[e].v, vecv);
+    }
+
+    for (; e < n; ++e) {
+        float vx = v[e].v[0], vy = v[e].v[1], vz = v[e].v[2];
+        float sx = y2 * vz - z2 * vy;
+        float sy = z2 * vx - x2 * vz;
+        float sz = x2 * vy - y2 * vx;
+
+        dest[e].v[0] = vx + w * sx + (y * sz - z * sy);
+        dest[e].v[1] = vy + w * sy + (z * sx - x * sz);
+        dest[e].v[2] = vz + w * sz + (x * sy - y * sx);
+        dest[e].v[3] = v[e].v[3];
+    }
+
+    return intrin;
+}
+
+// 3 element vectors are padded to 4 elements, the memory layout is the same
+
+template <>
+inline specialized vecarr_x_quat(vec<float, 3> *dest,
+                                 vec<float, 3> *v,
+                                 quat<float>   &q,
+                                 size_t        n) {
+    return vecarr_x_quat((vec<float, 4> *) dest, (vec<float, 4> *) v, q, n);
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized quatarr_to_matarr(mat<double, 4, 4> *dest, quat<double> *q, size_t n) {
+    float64x2x4_t quat, row0, row1, row2;
+    float64x2_t   x2, y2, z2, xx, yy, zz, xy, xz, yz, xw, yw, zw, one, zero;
+    size_t        e;
+
+    one  = vdupq_n_f64 (1.0);
+    zero = vdupq_n_f64 (0.0);
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        double *pd = dest[e].m[0];
+        double *pq = q[e].v;
+
+        quat = vld4q_f64        (pq);                       // De-interleave x, y, z, w
+
+        x2 = vaddq_f64          (quat.val[0], quat.val[0]);
+        y2 = vaddq_f64          (quat.val[1], quat.val[1]);
+        z2 = vaddq_f64          (quat.val[2], quat.val[2]);
+        xx = vmulq_f64          (quat.val[0], x2);
+        yy = vmulq_f64          (quat.val[1], y2);
+        zz = vmulq_f64          (quat.val[2], z2);
+        xy = vmulq_f64          (quat.val[0], y2);
+        xz = vmulq_f64          (quat.val[0], z2);
+        yz = vmulq_f64          (quat.val[1], z2);
+        xw = vmulq_f64          (quat.val[3], x2);
+        yw = vmulq_f64          (quat.val[3], y2);
+        zw = vmulq_f64          (quat.val[3], z2);
+
+        row0.val[0] = vsubq_f64 (one, vaddq_f64(yy, zz));
+        row0.val[1] = vaddq_f64 (xy, zw);
+        row0.val[2] = vsubq_f64 (xz, yw);
+        row0.val[3] = zero;
+        row1.val[0] = vsubq_f64 (xy, zw);
+        row1.val[1] = vsubq_f64 (one, vaddq_f64(xx, zz));
+        row1.val[2] = vaddq_f64 (yz, xw);
+        row1.val[3] = zero;
+        row2.val[0] = vaddq_f64 (xz, yw);
+        row2.val[1] = vsubq_f64 (yz, xw);
+        row2.val[2] = vsubq_f64 (one, vaddq_f64(xx, yy));
+        row2.val[3] = zero;
+
+        vst4q_lane_f64          (pd +  0, row0, 0);         // Interleave back to rows
+        vst4q_lane_f64          (pd +  4, row1, 0);
+        vst4q_lane_f64          (pd +  8, row2, 0);
+        vst1q_f64               (pd + 12, zero);
+        vst1q_f64               (pd + 14, vsetq_lane_f64(1.0, zero, 1));
+        vst4q_lane_f64          (pd + 16, row0, 1);
+        vst4q_lane_f64          (pd + 20, row1, 1);
+        vst4q_lane_f64          (pd + 24, row2, 1);
+        vst1q_f64               (pd + 28, zero);
+        vst1q_f64               (pd + 30, vsetq_lane_f64(1.0, zero, 1));
+    }
+
+    for (; e < n; ++e) {
+        quat_to_mat(dest[e], q[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_quat(vec<double, 4> *dest,
+                                 vec<double, 4> *v,
+                                 quat<double>   &q,
+                                 size_t         n) {
+    float64x2x4_t vecv;
+    float64x2_t   tx, ty, tz;
+    double        x = q.v[0], y = q.v[1], z = q.v[2], w = q.v[3];
+    double        x2 = x + x, y2 = y + y, z2 = z + z;
+    size_t        e;
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        vecv = vld4q_f64            (v[e].v);               // De-interleave x, y, z, w
+
+        tx   = vfmsq_n_f64          (vmulq_n_f64(vecv.val[2], y2), vecv.val[1], z2);
+        ty   = vfmsq_n_f64          (vmulq_n_f64(vecv.val[0], z2), vecv.val[2], x2);
+        tz   = vfmsq_n_f64          (vmulq_n_f64(vecv.val[1], x2), vecv.val[0], y2);
+
+        vecv.val[0] = vfmaq_n_f64   (vecv.val[0], tx, w);
+        vecv.val[0] = vfmaq_n_f64   (vecv.val[0], tz, y);
+        vecv.val[0] = vfmsq_n_f64   (vecv.val[0], ty, z);
+        vecv.val[1] = vfmaq_n_f64   (vecv.val[1], ty, w);
+        vecv.val[1] = vfmaq_n_f64   (vecv.val[1], tx, z);
+        vecv.val[1] = vfmsq_n_f64   (vecv.val[1], tz, x);
+        vecv.val[2] = vfmaq_n_f64   (vecv.val[2], tz, w);
+        vecv.val[2] = vfmaq_n_f64   (vecv.val[2], ty, x);
+        vecv.val[2] = vfmsq_n_f64   (vecv.val[2], tx, y);
+
+                      vst4q_f64     (dest[e].v, vecv);
+    }
+
+    for (; e < n; ++e) {
+        double vx = v[e].v[0], vy = v[e].v[1], vz = v[e].v[2];
+        double sx = y2 * vz - z2 * vy;
+        double sy = z2 * vx - x2 * vz;
+        double sz = x2 * vy - y2 * vx;
+
+        dest[e].v[0] = vx + w * sx + (y * sz - z * sy);
+        dest[e].v[1] = vy + w * sy + (z * sx - x * sz);
+        dest[e].v[2] = vz + w * sz + (x * sy - y * sx);
+        dest[e].v[3] = v[e].v[3];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_quat(vec<double, 3> *dest,
+                                 vec<double, 3> *v,
+                                 quat<double>   &q,
+                                 size_t         n) {
+    return vecarr_x_quat((vec<double, 4> *) dest, (vec<double, 4> *) v, q, n);
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Translation, rotation and scale
+
+// vld4 de-interleaves quaternions, scales and translations, matrix rows are
+// loaded and stored one lane at a time with vld4 and vst4 lane operations.
+
+template <>
+inline specialized trsarr_to_matarr(mat<float, 4, 4> *dest,
+                                    vec<float, 4>    *t,
+                                    quat<float>      *r,
+                                    vec<float, 4>    *s,
+                                    size_t           n) {
+    float32x4x4_t rot,  scl, trs, row0, row1, row2;
+    float32x4_t   x2, y2, z2, xx, yy, zz, xy, xz, yz, xw, yw, zw, one, zero;
+    size_t        e;
+
+    one  = vdupq_n_f32 (1.0f);
+    zero = vdupq_n_f32 (0.0f);
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        float *pd = dest[e].m[0];
+
+        rot  = vld4q_f32        (r[e].v);                   // De-interleave x, y, z, w
+        scl  = vld4q_f32        (s[e].v);
+        trs  = vld4q_f32        (t[e].v);
+
+        x2 = vaddq_f32          (rot.val[0], rot.val[0]);
+        y2 = vaddq_f32          (rot.val[1], rot.val[1]);
+        z2 = vaddq_f32          (rot.val[2], rot.val[2]);
+        xx = vmulq_f32          (rot.val[0], x2);
+        yy = vmulq_f32          (rot.val[1], y2);
+        zz = vmulq_f32          (rot.val[2], z2);
+        xy = vmulq_f32          (rot.val[0], y2);
+        xz = vmulq_f32          (rot.val[0], z2);
+        yz = vmulq_f32          (rot.val[1], z2);
+        xw = vmulq_f32          (rot.val[3], x2);
+        yw = vmulq_f32          (rot.val[3], y2);
+        zw = vmulq_f32          (rot.val[3], z2);
+
+        row0.val[0] = vmulq_f32 (vsubq_f32(one, vaddq_f32(yy, zz)), scl.val[0]);
+        row0.val[1] = vmulq_f32 (vaddq_f32(xy, zw), scl.val[0]);
+        row0.val[2] = vmulq_f32 (vsubq_f32(xz, yw), scl.val[0]);
+        row0.val[3] = zero;
+        row1.val[0] = vmulq_f32 (vsubq_f32(xy, zw), scl.val[1]);
+        row1.val[1] = vmulq_f32 (vsubq_f32(one, vaddq_f32(xx, zz)), scl.val[1]);
+        row1.val[2] = vmulq_f32 (vaddq_f32(yz, xw), scl.val[1]);
+        row1.val[3] = zero;
+        row2.val[0] = vmulq_f32 (vaddq_f32(xz, yw), scl.val[2]);
+        row2.val[1] = vmulq_f32 (vsubq_f32(yz, xw), scl.val[2]);
+        row2.val[2] = vmulq_f32 (vsubq_f32(one, vaddq_f32(xx, yy)), scl.val[2]);
+        row2.val[3] = zero;
+        trs.val[3]  = one;
+
+        vst4q_lane_f32          (pd +  0, row0, 0);         // Interleave back to rows
+        vst4q_lane_f32          (pd +  4, row1, 0);
+        vst4q_lane_f32          (pd +  8, row2, 0);
+        vst4q_lane_f32          (pd + 12, trs,  0);
+        vst4q_lane_f32          (pd + 16, row0, 1);
+        vst4q_lane_f32          (pd + 20, row1, 1);
+        vst4q_lane_f32          (pd + 24, row2, 1);
+        vst4q_lane_f32          (pd + 28, trs,  1);
+        vst4q_lane_f32          (pd + 32, row0, 2);
+        vst4q_lane_f32          (pd + 36, row1, 2);
+        vst4q_lane_f32          (pd + 40, row2, 2);
+        vst4q_lane_f32          (pd + 44, trs,  2);
+        vst4q_lane_f32          (pd + 48, row0, 3);
+        vst4q_lane_f32          (pd + 52, row1, 3);
+        vst4q_lane_f32          (pd + 56, row2, 3);
+        vst4q_lane_f32          (pd + 60, trs,  3);
+    }
+
+    for (; e < n; ++e) {
+        quat_to_mat(dest[e], r[e]);
+
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                dest[e].m[i][j] *= s[e].v[i];
+            }
+
+            dest[e].m[3][i] = t[e].v[i];
+        }
+    }
+
+    return intrin;
+}
+
+// The quaternion candidates are selected with compares and bit selects,
+// a later candidate replaces the current one only when it is larger.
+// 32-bit ARM has no square root or divide, the reciprocal square root
+// estimate is refined with two Newton-Raphson steps.
+
+template <>
+inline specialized matarr_to_trsarr(vec<float, 4>    *t,
+                                    quat<float>      *r,
+                                    vec<float, 4>    *s,
+                                    mat<float, 4, 4> *m,
+                                    size_t           n) {
+    float32x4x4_t row[3], rot, scl;
+    float32x4_t   sum, inv, a, b, c, d, f, g, tw, tx, ty, tz, best, one, zero;
+    float32x4_t   rm[3][3];
+    uint32x4_t    mask;
+    size_t        e;
+
+    one  = vdupq_n_f32 (1.0f);
+    zero = vdupq_n_f32 (0.0f);
+
+    for (int i = 0; i < 3; ++i) {
+        row[i].val[0] = row[i].val[1] = row[i].val[2] = row[i].val[3] = zero;
+    }
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        float *pt = t[e].v;
+        float *pm = m[e].m[0];
+
+        for (int i = 0; i < 3; ++i) {
+            row[i] = vld4q_lane_f32 (pm + 4 * i +  0, row[i], 0);   // Transpose the row
+            row[i] = vld4q_lane_f32 (pm + 4 * i + 16, row[i], 1);
+            row[i] = vld4q_lane_f32 (pm + 4 * i + 32, row[i], 2);
+            row[i] = vld4q_lane_f32 (pm + 4 * i + 48, row[i], 3);
+
+            sum = vmulq_f32         (row[i].val[0], row[i].val[0]); // Scale is the row length
+            sum = vmlaq_f32         (sum, row[i].val[1], row[i].val[1]);
+            sum = vmlaq_f32         (sum, row[i].val[2], row[i].val[2]);
+#if defined(__aarch64__)
+            scl.val[i] = vsqrtq_f32 (sum);
+            inv = vdivq_f32         (one, scl.val[i]);
+#else
+            inv = vrsqrteq_f32      (sum);
+            inv = vmulq_f32         (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+            inv = vmulq_f32         (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+            scl.val[i] = vmulq_f32  (sum, inv);
+#endif
+            rm[i][0] = vmulq_f32    (row[i].val[0], inv);
+            rm[i][1] = vmulq_f32    (row[i].val[1], inv);
+            rm[i][2] = vmulq_f32    (row[i].val[2], inv);
+        }
+
+        a  = vsubq_f32          (rm[1][2], rm[2][1]);       // 4xw
+        b  = vsubq_f32          (rm[2][0], rm[0][2]);       // 4yw
+        c  = vsubq_f32          (rm[0][1], rm[1][0]);       // 4zw
+        d  = vaddq_f32          (rm[0][1], rm[1][0]);       // 4xy
+        f  = vaddq_f32          (rm[2][0], rm[0][2]);       // 4xz
+        g  = vaddq_f32          (rm[1][2], rm[2][1]);       // 4yz
+
+        tw = vaddq_f32          (vaddq_f32(vaddq_f32(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        tx = vsubq_f32          (vsubq_f32(vaddq_f32(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        ty = vsubq_f32          (vaddq_f32(vsubq_f32(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        tz = vaddq_f32          (vsubq_f32(vsubq_f32(one, rm[0][0]), rm[1][1]), rm[2][2]);
+
+        best         = tw;
+        rot.val[0]   = a;
+        rot.val[1]   = b;
+        rot.val[2]   = c;
+        rot.val[3]   = tw;
+
+        mask         = vcgtq_f32 (tx, best);                // x candidate
+        best         = vbslq_f32 (mask, tx, best);
+        rot.val[0]   = vbslq_f32 (mask, tx, rot.val[0]);
+        rot.val[1]   = vbslq_f32 (mask, d,  rot.val[1]);
+        rot.val[2]   = vbslq_f32 (mask, f,  rot.val[2]);
+        rot.val[3]   = vbslq_f32 (mask, a,  rot.val[3]);
+
+        mask         = vcgtq_f32 (ty, best);                // y candidate
+        best         = vbslq_f32 (mask, ty, best);
+        rot.val[0]   = vbslq_f32 (mask, d,  rot.val[0]);
+        rot.val[1]   = vbslq_f32 (mask, ty, rot.val[1]);
+        rot.val[2]   = vbslq_f32 (mask, g,  rot.val[2]);
+        rot.val[3]   = vbslq_f32 (mask, b,  rot.val[3]);
+
+        mask         = vcgtq_f32 (tz, best);                // z candidate
+        best         = vbslq_f32 (mask, tz, best);
+        rot.val[0]   = vbslq_f32 (mask, f,  rot.val[0]);
+        rot.val[1]   = vbslq_f32 (mask, g,  rot.val[1]);
+        rot.val[2]   = vbslq_f32 (mask, tz, rot.val[2]);
+        rot.val[3]   = vbslq_f32 (mask, c,  rot.val[3]);
+
+#if defined(__aarch64__)
+        best = vdivq_f32        (vdupq_n_f32(0.5f), vsqrtq_f32(best));
+#else
+        inv  = vrsqrteq_f32     (best);
+        inv  = vmulq_f32        (inv, vrsqrtsq_f32(vmulq_f32(best, inv), inv));
+        inv  = vmulq_f32        (inv, vrsqrtsq_f32(vmulq_f32(best, inv), inv));
+        best = vmulq_n_f32      (inv, 0.5f);
+#endif
+        rot.val[0]  = vmulq_f32 (rot.val[0], best);
+        rot.val[1]  = vmulq_f32 (rot.val[1], best);
+        rot.val[2]  = vmulq_f32 (rot.val[2], best);
+        rot.val[3]  = vmulq_f32 (rot.val[3], best);
+        scl.val[3]  = one;
+
+        vst4q_f32               (r[e].v, rot);              // Interleave back
+        vst4q_f32               (s[e].v, scl);
+
+        for (int k = 0; k < 4; ++k) {
+            vst1q_f32(pt + 4 * k, vsetq_lane_f32(1.0f, vld1q_f32(pm + 16 * k + 12), 3));
+        }
+    }
+
+    // The remaining matrices are padded with identity matrices
+    if (e < n) {
+        mat<float, 4, 4> tm[4];
+        vec<float, 4>    tt[4], ts[4];
+        quat<float>      tr[4];
+
+        for (size_t k = 0; k < 4; ++k) {
+            diagonal(tm[k], 1.0f);
+
+            if (e + k < n) {
+                tm[k] = m[e + k];
+            }
+        }
+
+        matarr_to_trsarr(tt, tr, ts, tm, 4);
+
+        for (size_t k = 0; e + k < n; ++k) {
+            t[e + k] = tt[k];
+            r[e + k] = tr[k];
+            s[e + k] = ts[k];
+        }
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized trsarr_to_matarr(mat<double, 4, 4> *dest,
+                                    vec<double, 4>    *t,
+                                    quat<double>      *r,
+                                    vec<double, 4>    *s,
+                                    size_t            n) {
+    float64x2x4_t rot,  scl, trs, row0, row1, row2;
+    float64x2_t   x2, y2, z2, xx, yy, zz, xy, xz, yz, xw, yw, zw, one, zero;
+    size_t        e;
+
+    one  = vdupq_n_f64 (1.0);
+    zero = vdupq_n_f64 (0.0);
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        double *pd = dest[e].m[0];
+
+        rot  = vld4q_f64        (r[e].v);                   // De-interleave x, y, z, w
+        scl  = vld4q_f64        (s[e].v);
+        trs  = vld4q_f64        (t[e].v);
+
+        x2 = vaddq_f64          (rot.val[0], rot.val[0]);
+        y2 = vaddq_f64          (rot.val[1], rot.val[1]);
+        z2 = vaddq_f64          (rot.val[2], rot.val[2]);
+        xx = vmulq_f64          (rot.val[0], x2);
+        yy = vmulq_f64          (rot.val[1], y2);
+        zz = vmulq_f64          (rot.val[2], z2);
+        xy = vmulq_f64          (rot.val[0], y2);
+        xz = vmulq_f64          (rot.val[0], z2);
+        yz = vmulq_f64          (rot.val[1], z2);
+        xw = vmulq_f64          (rot.val[3], x2);
+        yw = vmulq_f64          (rot.val[3], y2);
+        zw = vmulq_f64          (rot.val[3], z2);
+
+        row0.val[0] = vmulq_f64 (vsubq_f64(one, vaddq_f64(yy, zz)), scl.val[0]);
+        row0.val[1] = vmulq_f64 (vaddq_f64(xy, zw), scl.val[0]);
+        row0.val[2] = vmulq_f64 (vsubq_f64(xz, yw), scl.val[0]);
+        row0.val[3] = zero;
+        row1.val[0] = vmulq_f64 (vsubq_f64(xy, zw), scl.val[1]);
+        row1.val[1] = vmulq_f64 (vsubq_f64(one, vaddq_f64(xx, zz)), scl.val[1]);
+        row1.val[2] = vmulq_f64 (vaddq_f64(yz, xw), scl.val[1]);
+        row1.val[3] = zero;
+        row2.val[0] = vmulq_f64 (vaddq_f64(xz, yw), scl.val[2]);
+        row2.val[1] = vmulq_f64 (vsubq_f64(yz, xw), scl.val[2]);
+        row2.val[2] = vmulq_f64 (vsubq_f64(one, vaddq_f64(xx, yy)), scl.val[2]);
+        row2.val[3] = zero;
+        trs.val[3]  = one;
+
+        vst4q_lane_f64          (pd +  0, row0, 0);         // Interleave back to rows
+        vst4q_lane_f64          (pd +  4, row1, 0);
+        vst4q_lane_f64          (pd +  8, row2, 0);
+        vst4q_lane_f64          (pd + 12, trs,  0);
+        vst4q_lane_f64          (pd + 16, row0, 1);
+        vst4q_lane_f64          (pd + 20, row1, 1);
+        vst4q_lane_f64          (pd + 24, row2, 1);
+        vst4q_lane_f64          (pd + 28, trs,  1);
+    }
+
+    for (; e < n; ++e) {
+        quat_to_mat(dest[e], r[e]);
+
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                dest[e].m[i][j] *= s[e].v[i];
+            }
+
+            dest[e].m[3][i] = t[e].v[i];
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized matarr_to_trsarr(vec<double, 4>    *t,
+                                    quat<double>      *r,
+                                    vec<double, 4>    *s,
+                                    mat<double, 4, 4> *m,
+                                    size_t            n) {
+    float64x2x4_t row[3], rot, scl;
+    float64x2_t   sum, inv, a, b, c, d, f, g, tw, tx, ty, tz, best, one, zero;
+    float64x2_t   rm[3][3];
+    uint64x2_t    mask;
+    size_t        e;
+
+    one  = vdupq_n_f64 (1.0);
+    zero = vdupq_n_f64 (0.0);
+
+    for (int i = 0; i < 3; ++i) {
+        row[i].val[0] = row[i].val[1] = row[i].val[2] = row[i].val[3] = zero;
+    }
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        double *pt = t[e].v;
+        double *pm = m[e].m[0];
+
+        for (int i = 0; i < 3; ++i) {
+            row[i] = vld4q_lane_f64 (pm + 4 * i +  0, row[i], 0);   // Transpose the row
+            row[i] = vld4q_lane_f64 (pm + 4 * i + 16, row[i], 1);
+
+            sum = vmulq_f64         (row[i].val[0], row[i].val[0]); // Scale is the row length
+            sum = vfmaq_f64         (sum, row[i].val[1], row[i].val[1]);
+            sum = vfmaq_f64         (sum, row[i].val[2], row[i].val[2]);
+            scl.val[i] = vsqrtq_f64 (sum);
+            inv = vdivq_f64         (one, scl.val[i]);
+            rm[i][0] = vmulq_f64    (row[i].val[0], inv);
+            rm[i][1] = vmulq_f64    (row[i].val[1], inv);
+            rm[i][2] = vmulq_f64    (row[i].val[2], inv);
+        }
+
+        a  = vsubq_f64          (rm[1][2], rm[2][1]);       // 4xw
+        b  = vsubq_f64          (rm[2][0], rm[0][2]);       // 4yw
+        c  = vsubq_f64          (rm[0][1], rm[1][0]);       // 4zw
+        d  = vaddq_f64          (rm[0][1], rm[1][0]);       // 4xy
+        f  = vaddq_f64          (rm[2][0], rm[0][2]);       // 4xz
+        g  = vaddq_f64          (rm[1][2], rm[2][1]);       // 4yz
+
+        tw = vaddq_f64          (vaddq_f64(vaddq_f64(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        tx = vsubq_f64          (vsubq_f64(vaddq_f64(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        ty = vsubq_f64          (vaddq_f64(vsubq_f64(one, rm[0][0]), rm[1][1]), rm[2][2]);
+        tz = vaddq_f64          (vsubq_f64(vsubq_f64(one, rm[0][0]), rm[1][1]), rm[2][2]);
+
+        best         = tw;
+        rot.val[0]   = a;
+        rot.val[1]   = b;
+        rot.val[2]   = c;
+        rot.val[3]   = tw;
+
+        mask         = vcgtq_f64 (tx, best);                // x candidate
+        best         = vbslq_f64 (mask, tx, best);
+        rot.val[0]   = vbslq_f64 (mask, tx, rot.val[0]);
+        rot.val[1]   = vbslq_f64 (mask, d,  rot.val[1]);
+        rot.val[2]   = vbslq_f64 (mask, f,  rot.val[2]);
+        rot.val[3]   = vbslq_f64 (mask, a,  rot.val[3]);
+
+        mask         = vcgtq_f64 (ty, best);                // y candidate
+        best         = vbslq_f64 (mask, ty, best);
+        rot.val[0]   = vbslq_f64 (mask, d,  rot.val[0]);
+        rot.val[1]   = vbslq_f64 (mask, ty, rot.val[1]);
+        rot.val[2]   = vbslq_f64 (mask, g,  rot.val[2]);
+        rot.val[3]   = vbslq_f64 (mask, b,  rot.val[3]);
+
+        mask         = vcgtq_f64 (tz, best);                // z candidate
+        best         = vbslq_f64 (mask, tz, best);
+        rot.val[0]   = vbslq_f64 (mask, f,  rot.val[0]);
+        rot.val[1]   = vbslq_f64 (mask, g,  rot.val[1]);
+        rot.val[2]   = vbslq_f64 (mask, tz, rot.val[2]);
+        rot.val[3]   = vbslq_f64 (mask, c,  rot.val[3]);
+
+        best = vdivq_f64        (vdupq_n_f64(0.5), vsqrtq_f64(best));
+        rot.val[0]  = vmulq_f64 (rot.val[0], best);
+        rot.val[1]  = vmulq_f64 (rot.val[1], best);
+        rot.val[2]  = vmulq_f64 (rot.val[2], best);
+        rot.val[3]  = vmulq_f64 (rot.val[3], best);
+        scl.val[3]  = one;
+
+        vst4q_f64               (r[e].v, rot);              // Interleave back
+        vst4q_f64               (s[e].v, scl);
+
+        for (int k = 0; k < 2; ++k) {
+            vst1q_f64(pt + 4 * k + 0, vld1q_f64(pm + 16 * k + 12));
+            vst1q_f64(pt + 4 * k + 2, vsetq_lane_f64(1.0, vld1q_f64(pm + 16 * k + 14), 1));
+        }
+    }
+
+    // The remaining matrix is padded with an identity matrix
+    if (e < n) {
+        mat<double, 4, 4> tm[2];
+        vec<double, 4>    tt[2], ts[2];
+        quat<double>      tr[2];
+
+        diagonal(tm[1], 1.0);
+        tm[0] = m[e];
+
+        matarr_to_trsarr(tt, tr, ts, tm, 2);
+
+        t[e] = tt[0];
+        r[e] = tr[0];
+        s[e] = ts[0];
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Hierarchies
+
+// Indexed products gather their operands, so the matrix of a later
+// element of b is prefetched while the current product is computed.
+
+template <>
+inline specialized matarr_x_matarr_indexed(mat<float, 4, 4> *dest,
+                                           mat<float, 4, 4> *a,
+                                           mat<float, 4, 4> *b,
+                                           const size_t     *index,
+                                           const size_t     *bindex,
+                                           size_t           n) {
+    const size_t ahead = 4;
+    float32x4_t  row0, row1, row2, row3, veca, vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        float *pd = dest[index[e]].m[0];
+        float *pa = a[index[e]].m[0];
+        float *pb = b[bindex[e]].m[0];
+
+        if (e + ahead < n) {
+            __builtin_prefetch(b[bindex[e + ahead]].m[0]);
+            __builtin_prefetch(b[bindex[e + ahead]].m[0] + 15);
+        }
+
+        row0 = vld1q_f32        (pb +  0);                  // Load all the matrix rows
+        row1 = vld1q_f32        (pb +  4);
+        row2 = vld1q_f32        (pb +  8);
+        row3 = vld1q_f32        (pb + 12);
+
+        for (int i = 0; i < 16; i += 4) {
+            veca = vld1q_f32        (pa + i);
+            vecd = vmulq_lane_f32   (row0, vget_low_f32(veca),  0);
+            vecd = vmlaq_lane_f32   (vecd, row1, vget_low_f32(veca),  1);
+            vecd = vmlaq_lane_f32   (vecd, row2, vget_high_f32(veca), 0);
+            vecd = vmlaq_lane_f32   (vecd, row3, vget_high_f32(veca), 1);
+                   vst1q_f32        (pd + i, vecd);
+        }
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized matarr_x_matarr_indexed(mat<double, 4, 4> *dest,
+                                           mat<double, 4, 4> *a,
+                                           mat<double, 4, 4> *b,
+                                           const size_t      *index,
+                                           const size_t      *bindex,
+                                           size_t            n) {
+    const size_t ahead = 4;
+    float64x2_t  row0l, row1l, row2l, row3l, row0h, row1h, row2h, row3h,
+                 vecal, vecah, vecl, vech;
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pd = dest[index[e]].m[0];
+        double *pa = a[index[e]].m[0];
+        double *pb = b[bindex[e]].m[0];
+
+        if (e + ahead < n) {
+            __builtin_prefetch(b[bindex[e + ahead]].m[0]);
+            __builtin_prefetch(b[bindex[e + ahead]].m[0] + 8);
+            __builtin_prefetch(b[bindex[e + ahead]].m[0] + 15);
+        }
+
+        row0l = vld1q_f64       (pb +  0);                  // Load all the matrix rows
+        row0h = vld1q_f64       (pb +  2);
+        row1l = vld1q_f64       (pb +  4);
+        row1h = vld1q_f64       (pb +  6);
+        row2l = vld1q_f64       (pb +  8);
+        row2h = vld1q_f64       (pb + 10);
+        row3l = vld1q_f64       (pb + 12);
+        row3h = vld1q_f64       (pb + 14);
+
+        for (int i = 0; i < 16; i += 4) {
+            vecal = vld1q_f64       (pa + i + 0);
+            vecah = vld1q_f64       (pa + i + 2);
+            vecl  = vmulq_laneq_f64 (row0l, vecal, 0);
+            vech  = vmulq_laneq_f64 (row0h, vecal, 0);
+            vecl  = vfmaq_laneq_f64 (vecl, row1l, vecal, 1);
+            vech  = vfmaq_laneq_f64 (vech, row1h, vecal, 1);
+            vecl  = vfmaq_laneq_f64 (vecl, row2l, vecah, 0);
+            vech  = vfmaq_laneq_f64 (vech, row2h, vecah, 0);
+            vecl  = vfmaq_laneq_f64 (vecl, row3l, vecah, 1);
+            vech  = vfmaq_laneq_f64 (vech, row3h, vecah, 1);
+                    vst1q_f64       (pd + i + 0, vecl);
+                    vst1q_f64       (pd + i + 2, vech);
+        }
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Skinning
+
+// The rows of the blended matrix stay in registers,
+// normals are transformed without the 4th row.
+
+template <>
+inline specialized skinarr_x_matarr(vec<float, 4>    *dest,
+                                    vec<float, 4>    *v,
+                                    mat<float, 4, 4> *palette,
+                                    vec<unsigned, 4> *bone,
+                                    vec<float, 4>    *weight,
+                                    size_t           n,
+                                    vec<float, 4>    *ndest,
+                                    vec<float, 4>    *nv) {
+    float32x4_t row0, row1, row2, row3, vecv, vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        unsigned *pb = bone[e].v;
+        float    *pw = weight[e].v;
+        float    *pm = palette[pb[0]].m[0];
+
+        row0 = vmulq_n_f32          (vld1q_f32(pm +  0), pw[0]);    // Blend the rows
+        row1 = vmulq_n_f32          (vld1q_f32(pm +  4), pw[0]);
+        row2 = vmulq_n_f32          (vld1q_f32(pm +  8), pw[0]);
+        row3 = vmulq_n_f32          (vld1q_f32(pm + 12), pw[0]);
+
+        for (int k = 1; k < 4; ++k) {
+            pm   = palette[pb[k]].m[0];
+            row0 = vmlaq_n_f32      (row0, vld1q_f32(pm +  0), pw[k]);
+            row1 = vmlaq_n_f32      (row1, vld1q_f32(pm +  4), pw[k]);
+            row2 = vmlaq_n_f32      (row2, vld1q_f32(pm +  8), pw[k]);
+            row3 = vmlaq_n_f32      (row3, vld1q_f32(pm + 12), pw[k]);
+        }
+
+        vecv = vld1q_f32            (v[e].v);
+        vecd = vmulq_lane_f32       (row0, vget_low_f32(vecv),  0);
+        vecd = vmlaq_lane_f32       (vecd, row1, vget_low_f32(vecv),  1);
+        vecd = vmlaq_lane_f32       (vecd, row2, vget_high_f32(vecv), 0);
+        vecd = vmlaq_lane_f32       (vecd, row3, vget_high_f32(vecv), 1);
+               vst1q_f32            (dest[e].v, vecd);
+
+        if (ndest != nullptr) {
+            vecv = vld1q_f32        (nv[e].v);
+            vecd = vmulq_lane_f32   (row0, vget_low_f32(vecv),  0);
+            vecd = vmlaq_lane_f32   (vecd, row1, vget_low_f32(vecv),  1);
+            vecd = vmlaq_lane_f32   (vecd, row2, vget_high_f32(vecv), 0);
+                   vst1q_f32        (ndest[e].v, vsetq_lane_f32(0.0f, vecd, 3));
+        }
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized skinarr_x_matarr(vec<double, 4>    *dest,
+                                    vec<double, 4>    *v,
+                                    mat<double, 4, 4> *palette,
+                                    vec<unsigned, 4>  *bone,
+                                    vec<double, 4>    *weight,
+                                    size_t            n,
+                                    vec<double, 4>    *ndest,
+                                    vec<double, 4>    *nv) {
+    float64x2_t row[8], vecvl, vecvh, vecl, vech;
+
+    for (size_t e = 0; e < n; ++e) {
+        unsigned *pb = bone[e].v;
+        double   *pw = weight[e].v;
+        double   *pm = palette[pb[0]].m[0];
+
+        for (int i = 0; i < 8; ++i) {                       // Blend the rows, in halves
+            row[i] = vmulq_n_f64    (vld1q_f64(pm + 2 * i), pw[0]);
+        }
+
+        for (int k = 1; k < 4; ++k) {
+            pm = palette[pb[k]].m[0];
+
+            for (int i = 0; i < 8; ++i) {
+                row[i] = vfmaq_n_f64 (row[i], vld1q_f64(pm + 2 * i), pw[k]);
+            }
+        }
+
+        vecvl = vld1q_f64           (v[e].v + 0);
+        vecvh = vld1q_f64           (v[e].v + 2);
+        vecl  = vmulq_laneq_f64     (row[0], vecvl, 0);
+        vech  = vmulq_laneq_f64     (row[1], vecvl, 0);
+        vecl  = vfmaq_laneq_f64     (vecl, row[2], vecvl, 1);
+        vech  = vfmaq_laneq_f64     (vech, row[3], vecvl, 1);
+        vecl  = vfmaq_laneq_f64     (vecl, row[4], vecvh, 0);
+        vech  = vfmaq_laneq_f64     (vech, row[5], vecvh, 0);
+        vecl  = vfmaq_laneq_f64     (vecl, row[6], vecvh, 1);
+        vech  = vfmaq_laneq_f64     (vech, row[7], vecvh, 1);
+                vst1q_f64           (dest[e].v + 0, vecl);
+                vst1q_f64           (dest[e].v + 2, vech);
+
+        if (ndest != nullptr) {
+            vecvl = vld1q_f64       (nv[e].v + 0);
+            vecvh = vld1q_f64       (nv[e].v + 2);
+            vecl  = vmulq_laneq_f64 (row[0], vecvl, 0);
+            vech  = vmulq_laneq_f64 (row[1], vecvl, 0);
+            vecl  = vfmaq_laneq_f64 (vecl, row[2], vecvl, 1);
+            vech  = vfmaq_laneq_f64 (vech, row[3], vecvl, 1);
+            vecl  = vfmaq_laneq_f64 (vecl, row[4], vecvh, 0);
+            vech  = vfmaq_laneq_f64 (vech, row[5], vecvh, 0);
+                    vst1q_f64       (ndest[e].v + 0, vecl);
+                    vst1q_f64       (ndest[e].v + 2, vsetq_lane_f64(0.0, vech, 1));
+        }
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Indexed vector array multiplication
+
+// Every vector loads its own matrix, the matrix of a later vector is prefetched
+
+template <>
+inline specialized vecarr_x_matarr_indexed(vec<float, 4>    *dest,
+                                           vec<float, 4>    *v,
+                                           mat<float, 4, 4> *palette,
+                                           const unsigned   *index,
+                                           size_t           n) {
+    const size_t ahead = 8;
+    float32x4_t  vecv, vecd;
+
+    for (size_t e = 0; e < n; ++e) {
+        float *pm = palette[index[e]].m[0];
+
+        if (e + ahead < n) {
+            __builtin_prefetch(palette[index[e + ahead]].m[0]);
+            __builtin_prefetch(palette[index[e + ahead]].m[0] + 15);
+        }
+
+        vecv = vld1q_f32            (v[e].v);
+        vecd = vmulq_lane_f32       (vld1q_f32(pm +  0), vget_low_f32(vecv),  0);
+        vecd = vmlaq_lane_f32       (vecd, vld1q_f32(pm +  4), vget_low_f32(vecv),  1);
+        vecd = vmlaq_lane_f32       (vecd, vld1q_f32(pm +  8), vget_high_f32(vecv), 0);
+        vecd = vmlaq_lane_f32       (vecd, vld1q_f32(pm + 12), vget_high_f32(vecv), 1);
+               vst1q_f32            (dest[e].v, vecd);
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized vecarr_x_matarr_indexed(vec<double, 4>    *dest,
+                                           vec<double, 4>    *v,
+                                           mat<double, 4, 4> *palette,
+                                           const unsigned    *index,
+                                           size_t            n) {
+    const size_t ahead = 8;
+    float64x2_t  vecvl, vecvh, vecl, vech;
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pm = palette[index[e]].m[0];
+
+        if (e + ahead < n) {
+            __builtin_prefetch(palette[index[e + ahead]].m[0]);
+            __builtin_prefetch(palette[index[e + ahead]].m[0] + 8);
+            __builtin_prefetch(palette[index[e + ahead]].m[0] + 15);
+        }
+
+        vecvl = vld1q_f64           (v[e].v + 0);
+        vecvh = vld1q_f64           (v[e].v + 2);
+        vecl  = vmulq_laneq_f64     (vld1q_f64(pm +  0), vecvl, 0);
+        vech  = vmulq_laneq_f64     (vld1q_f64(pm +  2), vecvl, 0);
+        vecl  = vfmaq_laneq_f64     (vecl, vld1q_f64(pm +  4), vecvl, 1);
+        vech  = vfmaq_laneq_f64     (vech, vld1q_f64(pm +  6), vecvl, 1);
+        vecl  = vfmaq_laneq_f64     (vecl, vld1q_f64(pm +  8), vecvh, 0);
+        vech  = vfmaq_laneq_f64     (vech, vld1q_f64(pm + 10), vecvh, 0);
+        vecl  = vfmaq_laneq_f64     (vecl, vld1q_f64(pm + 12), vecvh, 1);
+        vech  = vfmaq_laneq_f64     (vech, vld1q_f64(pm + 14), vecvh, 1);
+                vst1q_f64           (dest[e].v + 0, vecl);
+                vst1q_f64           (dest[e].v + 2, vech);
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Bounding box transform and frustum culling
+
+// Each lane works on its own box, the matrix and plane elements are
+// broadcast. Lanes that pass all the planes are weighted by their bit
+// and summed pairwise into a bit mask.
+
+template <>
+inline specialized aabbsoa_x_mat(aabbsoa<float>   *dest,
+                                 unsigned         *visible,
+                                 aabbsoa<float>   *src,
+                                 mat<float, 4, 4> &m,
+                                 vec<float, 4>    *planes,
+                                 size_t           nplanes,
+                                 size_t           n) {
+    const size_t lanes  = aabbsoa<float>::lanes;
+    size_t       blocks = aabb_blocks<float>(n);
+    float        *pm    = m.m[0];
+    const uint32_t weight[4] = { 1, 2, 4, 8 };
+    float        vm[12], va[9];
+    float32x4_t  cx, cy, cz, ex, ey, ez, vecd;
+    uint32x4_t   in, vecw = vld1q_u32(weight);
+    uint32x2_t   sum;
+    unsigned     bits;
+
+    for (int i = 0; i < 12; ++i) {                          // Rows without 4th column
+        vm[i] = pm[i / 3 * 4 + i % 3];
+    }
+    for (int i = 0; i < 9; ++i) {
+        va[i] = std::abs(vm[i]);
+    }
+
+    for (size_t e = 0; e < blocks; ++e) {
+        size_t rest = n - e * lanes;
+
+        bits = 0;
+        for (size_t h = 0; h < lanes; h += 4) {             // 4 boxes per register
+            cx = vld1q_f32          (src[e].c[0] + h);      // Transform centers
+            cy = vld1q_f32          (src[e].c[1] + h);
+            cz = vld1q_f32          (src[e].c[2] + h);
+            ex = vmlaq_n_f32        (vdupq_n_f32(vm[ 9]), cx, vm[0]);
+            ey = vmlaq_n_f32        (vdupq_n_f32(vm[10]), cx, vm[1]);
+            ez = vmlaq_n_f32        (vdupq_n_f32(vm[11]), cx, vm[2]);
+            ex = vmlaq_n_f32        (ex, cy, vm[3]);
+            ey = vmlaq_n_f32        (ey, cy, vm[4]);
+            ez = vmlaq_n_f32        (ez, cy, vm[5]);
+            cx = vmlaq_n_f32        (ex, cz, vm[6]);
+            cy = vmlaq_n_f32        (ey, cz, vm[7]);
+            cz = vmlaq_n_f32        (ez, cz, vm[8]);
+
+            vecd = vld1q_f32        (src[e].e[0] + h);      // Transform extents
+            ex   = vmulq_n_f32      (vecd, va[0]);
+            ey   = vmulq_n_f32      (vecd, va[1]);
+            ez   = vmulq_n_f32      (vecd, va[2]);
+            vecd = vld1q_f32        (src[e].e[1] + h);
+            ex   = vmlaq_n_f32      (ex, vecd, va[3]);
+            ey   = vmlaq_n_f32      (ey, vecd, va[4]);
+            ez   = vmlaq_n_f32      (ez, vecd, va[5]);
+            vecd = vld1q_f32        (src[e].e[2] + h);
+            ex   = vmlaq_n_f32      (ex, vecd, va[6]);
+            ey   = vmlaq_n_f32      (ey, vecd, va[7]);
+            ez   = vmlaq_n_f32      (ez, vecd, va[8]);
+
+            in = vdupq_n_u32        (0xffffffff);
+
+            for (size_t p = 0; p < nplanes; ++p) {
+                float *pp = planes[p].v;
+
+                vecd = vmlaq_n_f32  (vdupq_n_f32(pp[3]), cx, pp[0]);
+                vecd = vmlaq_n_f32  (vecd, cy, pp[1]);
+                vecd = vmlaq_n_f32  (vecd, cz, pp[2]);
+                vecd = vmlaq_n_f32  (vecd, ex, std::abs(pp[0]));
+                vecd = vmlaq_n_f32  (vecd, ey, std::abs(pp[1]));
+                vecd = vmlaq_n_f32  (vecd, ez, std::abs(pp[2]));
+                in   = vandq_u32    (in, vcgeq_f32(vecd, vdupq_n_f32(0)));
+            }
+
+            if (dest != nullptr) {
+                vst1q_f32           (dest[e].c[0] + h, cx);
+                vst1q_f32           (dest[e].c[1] + h, cy);
+                vst1q_f32           (dest[e].c[2] + h, cz);
+                vst1q_f32           (dest[e].e[0] + h, ex);
+                vst1q_f32           (dest[e].e[1] + h, ey);
+                vst1q_f32           (dest[e].e[2] + h, ez);
+            }
+
+            in   = vandq_u32        (in, vecw);             // Lane bits summed
+            sum  = vpadd_u32        (vget_low_u32(in), vget_high_u32(in));
+            sum  = vpadd_u32        (sum, sum);
+            bits |= vget_lane_u32   (sum, 0) << h;
+        }
+
+        if (visible != nullptr) {
+            visible[e] = (rest < lanes) ? bits & ((1u << rest) - 1) : bits;
+        }
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized aabbsoa_x_mat(aabbsoa<double>   *dest,
+                                 unsigned          *visible,
+                                 aabbsoa<double>   *src,
+                                 mat<double, 4, 4> &m,
+                                 vec<double, 4>    *planes,
+                                 size_t            nplanes,
+                                 size_t            n) {
+    const size_t lanes  = aabbsoa<double>::lanes;
+    size_t       blocks = aabb_blocks<double>(n);
+    double       *pm    = m.m[0];
+    const uint64_t weight[2] = { 1, 2 };
+    double       vm[12], va[9];
+    float64x2_t  cx, cy, cz, ex, ey, ez, vecd;
+    uint64x2_t   in, vecw = vld1q_u64(weight);
+    unsigned     bits;
+
+    for (int i = 0; i < 12; ++i) {                          // Rows without 4th column
+        vm[i] = pm[i / 3 * 4 + i % 3];
+    }
+    for (int i = 0; i < 9; ++i) {
+        va[i] = std::abs(vm[i]);
+    }
+
+    for (size_t e = 0; e < blocks; ++e) {
+        size_t rest = n - e * lanes;
+
+        bits = 0;
+        for (size_t h = 0; h < lanes; h += 2) {             // 2 boxes per register
+            cx = vld1q_f64          (src[e].c[0] + h);      // Transform centers
+            cy = vld1q_f64          (src[e].c[1] + h);
+            cz = vld1q_f64          (src[e].c[2] + h);
+            ex = vfmaq_n_f64        (vdupq_n_f64(vm[ 9]), cx, vm[0]);
+            ey = vfmaq_n_f64        (vdupq_n_f64(vm[10]), cx, vm[1]);
+            ez = vfmaq_n_f64        (vdupq_n_f64(vm[11]), cx, vm[2]);
+            ex = vfmaq_n_f64        (ex, cy, vm[3]);
+            ey = vfmaq_n_f64        (ey, cy, vm[4]);
+            ez = vfmaq_n_f64        (ez, cy, vm[5]);
+            cx = vfmaq_n_f64        (ex, cz, vm[6]);
+            cy = vfmaq_n_f64        (ey, cz, vm[7]);
+            cz = vfmaq_n_f64        (ez, cz, vm[8]);
+
+            vecd = vld1q_f64        (src[e].e[0] + h);      // Transform extents
+            ex   = vmulq_n_f64      (vecd, va[0]);
+            ey   = vmulq_n_f64      (vecd, va[1]);
+            ez   = vmulq_n_f64      (vecd, va[2]);
+            vecd = vld1q_f64        (src[e].e[1] + h);
+            ex   = vfmaq_n_f64      (ex, vecd, va[3]);
+            ey   = vfmaq_n_f64      (ey, vecd, va[4]);
+            ez   = vfmaq_n_f64      (ez, vecd, va[5]);
+            vecd = vld1q_f64        (src[e].e[2] + h);
+            ex   = vfmaq_n_f64      (ex, vecd, va[6]);
+            ey   = vfmaq_n_f64      (ey, vecd, va[7]);
+            ez   = vfmaq_n_f64      (ez, vecd, va[8]);
+
+            in = vdupq_n_u64        (~uint64_t(0));
+
+            for (size_t p = 0; p < nplanes; ++p) {
+                double *pp = planes[p].v;
+
+                vecd = vfmaq_n_f64  (vdupq_n_f64(pp[3]), cx, pp[0]);
+                vecd = vfmaq_n_f64  (vecd, cy, pp[1]);
+                vecd = vfmaq_n_f64  (vecd, cz, pp[2]);
+                vecd = vfmaq_n_f64  (vecd, ex, std::abs(pp[0]));
+                vecd = vfmaq_n_f64  (vecd, ey, std::abs(pp[1]));
+                vecd = vfmaq_n_f64  (vecd, ez, std::abs(pp[2]));
+                in   = vandq_u64    (in, vcgeq_f64(vecd, vdupq_n_f64(0)));
+            }
+
+            if (dest != nullptr) {
+                vst1q_f64           (dest[e].c[0] + h, cx);
+                vst1q_f64           (dest[e].c[1] + h, cy);
+                vst1q_f64           (dest[e].c[2] + h, cz);
+                vst1q_f64           (dest[e].e[0] + h, ex);
+                vst1q_f64           (dest[e].e[1] + h, ey);
+                vst1q_f64           (dest[e].e[2] + h, ez);
+            }
+
+            bits |= unsigned(vaddvq_u64(vandq_u64(in, vecw))) << h;
+        }
+
+        if (visible != nullptr) {
+            visible[e] = (rest < lanes) ? bits & ((1u << rest) - 1) : bits;
+        }
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Transform with bounds
+
+// Minimum, maximum and sum stay in registers while the results are written
+
+template <>
+inline specialized vecarr_x_mat_bounds(vec<float, 4>    *dest,
+                                       vec<float, 4>    &lo,
+                                       vec<float, 4>    &hi,
+                                       vec<float, 4>    *v,
+                                       mat<float, 4, 4> &m,
+                                       size_t           n,
+                                       vec<float, 4>    *sum) {
+    float       *pm = m.m[0];
+    float32x4_t row0, row1, row2, row3, vecv, vecd, veclo, vechi, vecs;
+
+    row0  = vld1q_f32               (pm +  0);
+    row1  = vld1q_f32               (pm +  4);
+    row2  = vld1q_f32               (pm +  8);
+    row3  = vld1q_f32               (pm + 12);
+    veclo = vdupq_n_f32             (std::numeric_limits<float>::max());
+    vechi = vdupq_n_f32             (std::numeric_limits<float>::lowest());
+    vecs  = vdupq_n_f32             (0);
+
+    for (size_t e = 0; e < n; ++e) {
+        vecv  = vld1q_f32           (v[e].v);
+        vecd  = vmulq_lane_f32      (row0, vget_low_f32(vecv),  0);
+        vecd  = vmlaq_lane_f32      (vecd, row1, vget_low_f32(vecv),  1);
+        vecd  = vmlaq_lane_f32      (vecd, row2, vget_high_f32(vecv), 0);
+        vecd  = vmlaq_lane_f32      (vecd, row3, vget_high_f32(vecv), 1);
+
+        if (dest != nullptr) {
+            vst1q_f32               (dest[e].v, vecd);
+        }
+
+        veclo = vminq_f32           (veclo, vecd);
+        vechi = vmaxq_f32           (vechi, vecd);
+        vecs  = vaddq_f32           (vecs,  vecd);
+    }
+
+            vst1q_f32               (lo.v, veclo);
+            vst1q_f32               (hi.v, vechi);
+
+    if (sum != nullptr) {
+            vst1q_f32               (sum->v, vecs);
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized vecarr_x_mat_bounds(vec<double, 4>    *dest,
+                                       vec<double, 4>    &lo,
+                                       vec<double, 4>    &hi,
+                                       vec<double, 4>    *v,
+                                       mat<double, 4, 4> &m,
+                                       size_t            n,
+                                       vec<double, 4>    *sum) {
+    double      *pm = m.m[0];
+    float64x2_t vecvl, vecvh, vecl, vech;
+    float64x2_t lol, loh, hil, hih, suml, sumh;
+
+    lol  = loh = vdupq_n_f64        (std::numeric_limits<double>::max());
+    hil  = hih = vdupq_n_f64        (std::numeric_limits<double>::lowest());
+    suml = sumh = vdupq_n_f64       (0);
+
+    for (size_t e = 0; e < n; ++e) {
+        vecvl = vld1q_f64           (v[e].v + 0);
+        vecvh = vld1q_f64           (v[e].v + 2);
+        vecl  = vmulq_laneq_f64     (vld1q_f64(pm +  0), vecvl, 0);
+        vech  = vmulq_laneq_f64     (vld1q_f64(pm +  2), vecvl, 0);
+        vecl  = vfmaq_laneq_f64     (vecl, vld1q_f64(pm +  4), vecvl, 1);
+        vech  = vfmaq_laneq_f64     (vech, vld1q_f64(pm +  6), vecvl, 1);
+        vecl  = vfmaq_laneq_f64     (vecl, vld1q_f64(pm +  8), vecvh, 0);
+        vech  = vfmaq_laneq_f64     (vech, vld1q_f64(pm + 10), vecvh, 0);
+        vecl  = vfmaq_laneq_f64     (vecl, vld1q_f64(pm + 12), vecvh, 1);
+        vech  = vfmaq_laneq_f64     (vech, vld1q_f64(pm + 14), vecvh, 1);
+
+        if (dest != nullptr) {
+            vst1q_f64               (dest[e].v + 0, vecl);
+            vst1q_f64               (dest[e].v + 2, vech);
+        }
+
+        lol   = vminq_f64           (lol,  vecl);
+        loh   = vminq_f64           (loh,  vech);
+        hil   = vmaxq_f64           (hil,  vecl);
+        hih   = vmaxq_f64           (hih,  vech);
+        suml  = vaddq_f64           (suml, vecl);
+        sumh  = vaddq_f64           (sumh, vech);
+    }
+
+            vst1q_f64               (lo.v + 0, lol);
+            vst1q_f64               (lo.v + 2, loh);
+            vst1q_f64               (hi.v + 0, hil);
+            vst1q_f64               (hi.v + 2, hih);
+
+    if (sum != nullptr) {
+            vst1q_f64               (sum->v + 0, suml);
+            vst1q_f64               (sum->v + 2, sumh);
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Transform with compaction
+
+// One vector per register, its lanes are reduced to a single pass value.
+// Every result is stored at the count and the count only advances when
+// the vector passes, so there are no branches on the data.
+
+template <>
+inline specialized vecarr_x_mat_compact(vec<float, 4>    *dest,
+                                        size_t           &count,
+                                        vec<float, 4>    *v,
+                                        mat<float, 4, 4> &m,
+                                        size_t           n,
+                                        condition        test,
+                                        vec<float, 4>    &lo,
+                                        vec<float, 4>    &hi) {
+    float       *pm = m.m[0];
+    const uint32_t wlane[4] = { 0, 0, 0, 0xffffffff };
+    float32x4_t row0, row1, row2, row3, vecv, vecd, veclo, vechi, vect;
+    float32x2_t dot;
+    uint32x4_t  in, vecw = vld1q_u32(wlane);
+    uint32x2_t  all;
+
+    row0  = vld1q_f32               (pm +  0);
+    row1  = vld1q_f32               (pm +  4);
+    row2  = vld1q_f32               (pm +  8);
+    row3  = vld1q_f32               (pm + 12);
+    veclo = vld1q_f32               (lo.v);
+    vechi = vld1q_f32               (hi.v);
+
+    count = 0;
+
+    for (size_t e = 0; e < n; ++e) {
+        vecv = vld1q_f32            (v[e].v);
+        vecd = vmulq_lane_f32       (row0, vget_low_f32(vecv),  0);
+        vecd = vmlaq_lane_f32       (vecd, row1, vget_low_f32(vecv),  1);
+        vecd = vmlaq_lane_f32       (vecd, row2, vget_high_f32(vecv), 0);
+        vecd = vmlaq_lane_f32       (vecd, row3, vget_high_f32(vecv), 1);
+
+        switch (test) {
+            case inside_box:                                // w lane always passes
+                in  = vandq_u32     (vcleq_f32(veclo, vecd), vcleq_f32(vecd, vechi));
+                in  = vorrq_u32     (in, vecw);
+                break;
+            case above_plane:                               // Pairwise sums of products
+                vect = vmulq_f32    (vecd, veclo);
+                dot  = vpadd_f32    (vget_low_f32(vect), vget_high_f32(vect));
+                dot  = vpadd_f32    (dot, dot);
+                in   = vcgeq_f32    (vcombine_f32(dot, dot), vdupq_n_f32(0));
+                break;
+            default:
+                vect = vdupq_lane_f32 (vget_high_f32(vecd), 1);
+                in   = vorrq_u32    (vcleq_f32(vabsq_f32(vecd), vect), vecw);
+                break;
+        }
+
+        all = vpmin_u32             (vget_low_u32(in), vget_high_u32(in));
+        all = vpmin_u32             (all, all);
+              vst1q_f32             (dest[count].v, vecd);  // Kept when counted
+        count += vget_lane_u32(all, 0) != 0;
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized vecarr_x_mat_compact(vec<double, 4>    *dest,
+                                        size_t            &count,
+                                        vec<double, 4>    *v,
+                                        mat<double, 4, 4> &m,
+                                        size_t            n,
+                                        condition         test,
+                                        vec<double, 4>    &lo,
+                                        vec<double, 4>    &hi) {
+    double      *pm = m.m[0];
+    const uint64_t wlane[2] = { 0, ~uint64_t(0) };
+    float64x2_t vecvl, vecvh, vecl, vech, lol, loh, hil, hih;
+    uint64x2_t  inl, inh, vecw = vld1q_u64(wlane);
+    double      dot;
+
+    lol = vld1q_f64                 (lo.v + 0);
+    loh = vld1q_f64                 (lo.v + 2);
+    hil = vld1q_f64                 (hi.v + 0);
+    hih = vld1q_f64                 (hi.v + 2);
+
+    count = 0;
+
+    for (size_t e = 0; e < n; ++e) {
+        vecvl = vld1q_f64           (v[e].v + 0);
+        vecvh = vld1q_f64           (v[e].v + 2);
+        vecl  = vmulq_laneq_f64     (vld1q_f64(pm +  0), vecvl, 0);
+        vech  = vmulq_laneq_f64     (vld1q_f64(pm +  2), vecvl, 0);
+        vecl  = vfmaq_laneq_f64     (vecl, vld1q_f64(pm +  4), vecvl, 1);
+        vech  = vfmaq_laneq_f64     (vech, vld1q_f64(pm +  6), vecvl, 1);
+        vecl  = vfmaq_laneq_f64     (vecl, vld1q_f64(pm +  8), vecvh, 0);
+        vech  = vfmaq_laneq_f64     (vech, vld1q_f64(pm + 10), vecvh, 0);
+        vecl  = vfmaq_laneq_f64     (vecl, vld1q_f64(pm + 12), vecvh, 1);
+        vech  = vfmaq_laneq_f64     (vech, vld1q_f64(pm + 14), vecvh, 1);
+
+        switch (test) {
+            case inside_box:                                // w lane always passes
+                inl = vandq_u64     (vcleq_f64(lol, vecl), vcleq_f64(vecl, hil));
+                inh = vandq_u64     (vcleq_f64(loh, vech), vcleq_f64(vech, hih));
+                inh = vorrq_u64     (inh, vecw);
+                break;
+            case above_plane:
+                dot = vaddvq_f64    (vaddq_f64(vmulq_f64(vecl, lol), vmulq_f64(vech, loh)));
+                inl = inh = vdupq_n_u64 (dot >= 0 ? ~uint64_t(0) : 0);
+                break;
+            default:
+                inl = vcleq_f64     (vabsq_f64(vecl), vdupq_laneq_f64(vech, 1));
+                inh = vorrq_u64     (vcleq_f64(vabsq_f64(vech), vdupq_laneq_f64(vech, 1)), vecw);
+                break;
+        }
+
+              vst1q_f64             (dest[count].v + 0, vecl);  // Kept when counted
+              vst1q_f64             (dest[count].v + 2, vech);
+        count += (vgetq_lane_u64(inl, 0) & vgetq_lane_u64(inl, 1)
+                & vgetq_lane_u64(inh, 0) & vgetq_lane_u64(inh, 1)) != 0;
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Vector array operations
+
+// Interleaved loads transpose 4 float or 2 double vectors into element
+// registers, so vector arrays are computed like lane interleaved blocks and
+// the remaining vectors one element at a time. Float normalization may use
+// the reciprocal square root estimate refined with one Newton-Raphson step.
+// ARM32 has no vector divide or square root and always uses the estimate,
+// refined with two steps.
+
+template <>
+inline specialized vecarr_dot(float *dest, vec<float, 4> *a, vec<float, 4> *b, size_t n) {
+    float32x4x4_t veca, vecb;
+    float32x4_t   vecd;
+    size_t        e;
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        veca = vld4q_f32            (a[e].v);
+        vecb = vld4q_f32            (b[e].v);
+        vecd = vmulq_f32            (veca.val[0], vecb.val[0]);
+        vecd = vmlaq_f32            (vecd, veca.val[1], vecb.val[1]);
+        vecd = vmlaq_f32            (vecd, veca.val[2], vecb.val[2]);
+        vecd = vmlaq_f32            (vecd, veca.val[3], vecb.val[3]);
+               vst1q_f32            (dest + e, vecd);
+    }
+
+    for (; e < n; ++e) {
+        float *pa = a[e].v;
+        float *pb = b[e].v;
+
+        dest[e] = pa[0] * pb[0] + pa[1] * pb[1] + pa[2] * pb[2] + pa[3] * pb[3];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_cross(vec<float, 4> *dest, vec<float, 4> *a, vec<float, 4> *b, size_t n) {
+    float32x4x4_t veca, vecb, vecd;
+    size_t        e;
+
+    vecd.val[3] = vdupq_n_f32       (0);
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        veca = vld4q_f32            (a[e].v);
+        vecb = vld4q_f32            (b[e].v);
+        vecd.val[0] = vmlsq_f32     (vmulq_f32(veca.val[1], vecb.val[2]), veca.val[2], vecb.val[1]);
+        vecd.val[1] = vmlsq_f32     (vmulq_f32(veca.val[2], vecb.val[0]), veca.val[0], vecb.val[2]);
+        vecd.val[2] = vmlsq_f32     (vmulq_f32(veca.val[0], vecb.val[1]), veca.val[1], vecb.val[0]);
+                      vst4q_f32     (dest[e].v, vecd);
+    }
+
+    for (; e < n; ++e) {
+        float *pa = a[e].v;
+        float *pb = b[e].v;
+
+        dest[e].v[0] = pa[1] * pb[2] - pa[2] * pb[1];
+        dest[e].v[1] = pa[2] * pb[0] - pa[0] * pb[2];
+        dest[e].v[2] = pa[0] * pb[1] - pa[1] * pb[0];
+        dest[e].v[3] = 0;
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_length(float *dest, vec<float, 4> *a, size_t n) {
+    float32x4x4_t veca;
+    float32x4_t   sum, inv;
+    size_t        e;
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        veca = vld4q_f32            (a[e].v);
+        sum  = vmulq_f32            (veca.val[0], veca.val[0]);
+        sum  = vmlaq_f32            (sum, veca.val[1], veca.val[1]);
+        sum  = vmlaq_f32            (sum, veca.val[2], veca.val[2]);
+        sum  = vmlaq_f32            (sum, veca.val[3], veca.val[3]);
+#if defined(__aarch64__)
+        sum  = vsqrtq_f32           (sum);
+#else
+        inv  = vrsqrteq_f32         (sum);
+        inv  = vmulq_f32            (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+        inv  = vmulq_f32            (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+        sum  = vbslq_f32            (vceqq_f32(sum, vdupq_n_f32(0)), sum, vmulq_f32(sum, inv));
+#endif
+               vst1q_f32            (dest + e, sum);
+    }
+
+    for (; e < n; ++e) {
+        float *pa = a[e].v;
+
+        dest[e] = std::sqrt(pa[0] * pa[0] + pa[1] * pa[1] + pa[2] * pa[2] + pa[3] * pa[3]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_normalize(vec<float, 4> *dest,
+                                    vec<float, 4> *a,
+                                    size_t        n,
+                                    bool          approx) {
+    float32x4x4_t veca;
+    float32x4_t   sum, inv;
+    size_t        e;
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        veca = vld4q_f32            (a[e].v);
+        sum  = vmulq_f32            (veca.val[0], veca.val[0]);
+        sum  = vmlaq_f32            (sum, veca.val[1], veca.val[1]);
+        sum  = vmlaq_f32            (sum, veca.val[2], veca.val[2]);
+        sum  = vmlaq_f32            (sum, veca.val[3], veca.val[3]);
+#if defined(__aarch64__)
+        if (approx) {
+            inv = vrsqrteq_f32      (sum);                  // Estimate
+            inv = vmulq_f32         (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+        } else {
+            inv = vdivq_f32         (vdupq_n_f32(1.0f), vsqrtq_f32(sum));
+        }
+#else
+        inv  = vrsqrteq_f32         (sum);
+        inv  = vmulq_f32            (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+        inv  = vmulq_f32            (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+#endif
+        veca.val[0] = vmulq_f32     (veca.val[0], inv);
+        veca.val[1] = vmulq_f32     (veca.val[1], inv);
+        veca.val[2] = vmulq_f32     (veca.val[2], inv);
+        veca.val[3] = vmulq_f32     (veca.val[3], inv);
+                      vst4q_f32     (dest[e].v, veca);
+    }
+
+    for (; e < n; ++e) {
+        float *pa = a[e].v;
+        float r   = 1.0f / std::sqrt(pa[0] * pa[0] + pa[1] * pa[1] + pa[2] * pa[2] + pa[3] * pa[3]);
+
+        for (int i = 0; i < 4; ++i) {
+            dest[e].v[i] = pa[i] * r;
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_dot(float           *dest,
+                              vecsoa<float, 3> *a,
+                              vecsoa<float, 3> *b,
+                              size_t           blocks) {
+    const size_t lanes = vecsoa<float, 3>::lanes;
+    float32x4_t  vecd;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 4) {
+            vecd = vmulq_f32        (vld1q_f32(a[e].v[0] + h), vld1q_f32(b[e].v[0] + h));
+            vecd = vmlaq_f32        (vecd, vld1q_f32(a[e].v[1] + h), vld1q_f32(b[e].v[1] + h));
+            vecd = vmlaq_f32        (vecd, vld1q_f32(a[e].v[2] + h), vld1q_f32(b[e].v[2] + h));
+                   vst1q_f32        (dest + e * lanes + h, vecd);
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_cross(vecsoa<float, 3> *dest,
+                                vecsoa<float, 3> *a,
+                                vecsoa<float, 3> *b,
+                                size_t           blocks) {
+    const size_t lanes = vecsoa<float, 3>::lanes;
+    float32x4_t  ax, ay, az, bx, by, bz;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 4) {
+            ax = vld1q_f32          (a[e].v[0] + h);
+            ay = vld1q_f32          (a[e].v[1] + h);
+            az = vld1q_f32          (a[e].v[2] + h);
+            bx = vld1q_f32          (b[e].v[0] + h);
+            by = vld1q_f32          (b[e].v[1] + h);
+            bz = vld1q_f32          (b[e].v[2] + h);
+                 vst1q_f32          (dest[e].v[0] + h, vmlsq_f32(vmulq_f32(ay, bz), az, by));
+                 vst1q_f32          (dest[e].v[1] + h, vmlsq_f32(vmulq_f32(az, bx), ax, bz));
+                 vst1q_f32          (dest[e].v[2] + h, vmlsq_f32(vmulq_f32(ax, by), ay, bx));
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_length(float *dest, vecsoa<float, 3> *a, size_t blocks) {
+    const size_t lanes = vecsoa<float, 3>::lanes;
+    float32x4_t  vecx, vecy, vecz, sum, inv;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 4) {
+            vecx = vld1q_f32        (a[e].v[0] + h);
+            vecy = vld1q_f32        (a[e].v[1] + h);
+            vecz = vld1q_f32        (a[e].v[2] + h);
+            sum  = vmulq_f32        (vecx, vecx);
+            sum  = vmlaq_f32        (sum, vecy, vecy);
+            sum  = vmlaq_f32        (sum, vecz, vecz);
+#if defined(__aarch64__)
+            sum  = vsqrtq_f32       (sum);
+#else
+            inv  = vrsqrteq_f32     (sum);
+            inv  = vmulq_f32        (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+            inv  = vmulq_f32        (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+            sum  = vbslq_f32        (vceqq_f32(sum, vdupq_n_f32(0)), sum, vmulq_f32(sum, inv));
+#endif
+                   vst1q_f32        (dest + e * lanes + h, sum);
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_normalize(vecsoa<float, 3> *dest,
+                                    vecsoa<float, 3> *a,
+                                    size_t           blocks,
+                                    bool             approx) {
+    const size_t lanes = vecsoa<float, 3>::lanes;
+    float32x4_t  vecx, vecy, vecz, sum, inv;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 4) {
+            vecx = vld1q_f32        (a[e].v[0] + h);
+            vecy = vld1q_f32        (a[e].v[1] + h);
+            vecz = vld1q_f32        (a[e].v[2] + h);
+            sum  = vmulq_f32        (vecx, vecx);
+            sum  = vmlaq_f32        (sum, vecy, vecy);
+            sum  = vmlaq_f32        (sum, vecz, vecz);
+#if defined(__aarch64__)
+            if (approx) {
+                inv = vrsqrteq_f32  (sum);                  // Estimate
+                inv = vmulq_f32     (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+            } else {
+                inv = vdivq_f32     (vdupq_n_f32(1.0f), vsqrtq_f32(sum));
+            }
+#else
+            inv  = vrsqrteq_f32     (sum);
+            inv  = vmulq_f32        (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+            inv  = vmulq_f32        (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+#endif
+                   vst1q_f32        (dest[e].v[0] + h, vmulq_f32(vecx, inv));
+                   vst1q_f32        (dest[e].v[1] + h, vmulq_f32(vecy, inv));
+                   vst1q_f32        (dest[e].v[2] + h, vmulq_f32(vecz, inv));
+        }
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized vecarr_dot(double *dest, vec<double, 4> *a, vec<double, 4> *b, size_t n) {
+    float64x2x4_t veca, vecb;
+    float64x2_t   vecd;
+    size_t        e;
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        veca = vld4q_f64            (a[e].v);
+        vecb = vld4q_f64            (b[e].v);
+        vecd = vmulq_f64            (veca.val[0], vecb.val[0]);
+        vecd = vfmaq_f64            (vecd, veca.val[1], vecb.val[1]);
+        vecd = vfmaq_f64            (vecd, veca.val[2], vecb.val[2]);
+        vecd = vfmaq_f64            (vecd, veca.val[3], vecb.val[3]);
+               vst1q_f64            (dest + e, vecd);
+    }
+
+    if (e < n) {
+        double *pa = a[e].v;
+        double *pb = b[e].v;
+
+        dest[e] = pa[0] * pb[0] + pa[1] * pb[1] + pa[2] * pb[2] + pa[3] * pb[3];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_cross(vec<double, 4> *dest, vec<double, 4> *a, vec<double, 4> *b, size_t n) {
+    float64x2x4_t veca, vecb, vecd;
+    size_t        e;
+
+    vecd.val[3] = vdupq_n_f64       (0);
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        veca = vld4q_f64            (a[e].v);
+        vecb = vld4q_f64            (b[e].v);
+        vecd.val[0] = vsubq_f64     (vmulq_f64(veca.val[1], vecb.val[2]), vmulq_f64(veca.val[2], vecb.val[1]));
+        vecd.val[1] = vsubq_f64     (vmulq_f64(veca.val[2], vecb.val[0]), vmulq_f64(veca.val[0], vecb.val[2]));
+        vecd.val[2] = vsubq_f64     (vmulq_f64(veca.val[0], vecb.val[1]), vmulq_f64(veca.val[1], vecb.val[0]));
+                      vst4q_f64     (dest[e].v, vecd);
+    }
+
+    if (e < n) {
+        double *pa = a[e].v;
+        double *pb = b[e].v;
+
+        dest[e].v[0] = pa[1] * pb[2] - pa[2] * pb[1];
+        dest[e].v[1] = pa[2] * pb[0] - pa[0] * pb[2];
+        dest[e].v[2] = pa[0] * pb[1] - pa[1] * pb[0];
+        dest[e].v[3] = 0;
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_length(double *dest, vec<double, 4> *a, size_t n) {
+    float64x2x4_t veca;
+    float64x2_t   sum;
+    size_t        e;
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        veca = vld4q_f64            (a[e].v);
+        sum  = vmulq_f64            (veca.val[0], veca.val[0]);
+        sum  = vfmaq_f64            (sum, veca.val[1], veca.val[1]);
+        sum  = vfmaq_f64            (sum, veca.val[2], veca.val[2]);
+        sum  = vfmaq_f64            (sum, veca.val[3], veca.val[3]);
+               vst1q_f64            (dest + e, vsqrtq_f64(sum));
+    }
+
+    if (e < n) {
+        double *pa = a[e].v;
+
+        dest[e] = std::sqrt(pa[0] * pa[0] + pa[1] * pa[1] + pa[2] * pa[2] + pa[3] * pa[3]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_normalize(vec<double, 4> *dest,
+                                    vec<double, 4> *a,
+                                    size_t         n,
+                                    bool           approx) {
+    float64x2x4_t veca;
+    float64x2_t   sum, inv;
+    size_t        e;
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        veca = vld4q_f64            (a[e].v);
+        sum  = vmulq_f64            (veca.val[0], veca.val[0]);
+        sum  = vfmaq_f64            (sum, veca.val[1], veca.val[1]);
+        sum  = vfmaq_f64            (sum, veca.val[2], veca.val[2]);
+        sum  = vfmaq_f64            (sum, veca.val[3], veca.val[3]);
+        inv  = vdivq_f64            (vdupq_n_f64(1.0), vsqrtq_f64(sum));
+        veca.val[0] = vmulq_f64     (veca.val[0], inv);
+        veca.val[1] = vmulq_f64     (veca.val[1], inv);
+        veca.val[2] = vmulq_f64     (veca.val[2], inv);
+        veca.val[3] = vmulq_f64     (veca.val[3], inv);
+                      vst4q_f64     (dest[e].v, veca);
+    }
+
+    if (e < n) {
+        double *pa = a[e].v;
+        double r   = 1.0 / std::sqrt(pa[0] * pa[0] + pa[1] * pa[1] + pa[2] * pa[2] + pa[3] * pa[3]);
+
+        for (int i = 0; i < 4; ++i) {
+            dest[e].v[i] = pa[i] * r;
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_dot(double           *dest,
+                              vecsoa<double, 3> *a,
+                              vecsoa<double, 3> *b,
+                              size_t            blocks) {
+    const size_t lanes = vecsoa<double, 3>::lanes;
+    float64x2_t  vecd;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 2) {
+            vecd = vmulq_f64        (vld1q_f64(a[e].v[0] + h), vld1q_f64(b[e].v[0] + h));
+            vecd = vfmaq_f64        (vecd, vld1q_f64(a[e].v[1] + h), vld1q_f64(b[e].v[1] + h));
+            vecd = vfmaq_f64        (vecd, vld1q_f64(a[e].v[2] + h), vld1q_f64(b[e].v[2] + h));
+                   vst1q_f64        (dest + e * lanes + h, vecd);
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_cross(vecsoa<double, 3> *dest,
+                                vecsoa<double, 3> *a,
+                                vecsoa<double, 3> *b,
+                                size_t            blocks) {
+    const size_t lanes = vecsoa<double, 3>::lanes;
+    float64x2_t  ax, ay, az, bx, by, bz;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 2) {
+            ax = vld1q_f64          (a[e].v[0] + h);
+            ay = vld1q_f64          (a[e].v[1] + h);
+            az = vld1q_f64          (a[e].v[2] + h);
+            bx = vld1q_f64          (b[e].v[0] + h);
+            by = vld1q_f64          (b[e].v[1] + h);
+            bz = vld1q_f64          (b[e].v[2] + h);
+                 vst1q_f64          (dest[e].v[0] + h, vsubq_f64(vmulq_f64(ay, bz), vmulq_f64(az, by)));
+                 vst1q_f64          (dest[e].v[1] + h, vsubq_f64(vmulq_f64(az, bx), vmulq_f64(ax, bz)));
+                 vst1q_f64          (dest[e].v[2] + h, vsubq_f64(vmulq_f64(ax, by), vmulq_f64(ay, bx)));
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_length(double *dest, vecsoa<double, 3> *a, size_t blocks) {
+    const size_t lanes = vecsoa<double, 3>::lanes;
+    float64x2_t  vecx, vecy, vecz, sum;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 2) {
+            vecx = vld1q_f64        (a[e].v[0] + h);
+            vecy = vld1q_f64        (a[e].v[1] + h);
+            vecz = vld1q_f64        (a[e].v[2] + h);
+            sum  = vmulq_f64        (vecx, vecx);
+            sum  = vfmaq_f64        (sum, vecy, vecy);
+            sum  = vfmaq_f64        (sum, vecz, vecz);
+                   vst1q_f64        (dest + e * lanes + h, vsqrtq_f64(sum));
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecsoa_normalize(vecsoa<double, 3> *dest,
+                                    vecsoa<double, 3> *a,
+                                    size_t            blocks,
+                                    bool              approx) {
+    const size_t lanes = vecsoa<double, 3>::lanes;
+    float64x2_t  vecx, vecy, vecz, sum, inv;
+
+    for (size_t e = 0; e < blocks; ++e) {
+        for (size_t h = 0; h < lanes; h += 2) {
+            vecx = vld1q_f64        (a[e].v[0] + h);
+            vecy = vld1q_f64        (a[e].v[1] + h);
+            vecz = vld1q_f64        (a[e].v[2] + h);
+            sum  = vmulq_f64        (vecx, vecx);
+            sum  = vfmaq_f64        (sum, vecy, vecy);
+            sum  = vfmaq_f64        (sum, vecz, vecz);
+            inv  = vdivq_f64        (vdupq_n_f64(1.0), vsqrtq_f64(sum));
+                   vst1q_f64        (dest[e].v[0] + h, vmulq_f64(vecx, inv));
+                   vst1q_f64        (dest[e].v[1] + h, vmulq_f64(vecy, inv));
+                   vst1q_f64        (dest[e].v[2] + h, vmulq_f64(vecz, inv));
+        }
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Interpolation
+//
+// nlerp and slerp load 4 float or 2 double quaternions with their elements
+// deinterleaved, so each dot product and weight is in its own lane.
+// Keyframe sampling interpolates a channel at a time.
+
+template <>
+inline specialized vecarr_lerp(vec<float, 4> *dest,
+                               vec<float, 4> *a,
+                               vec<float, 4> *b,
+                               float         t,
+                               size_t        n) {
+    float32x4_t veca, vecb;
+
+    for (size_t e = 0; e < n; ++e) {
+        veca = vld1q_f32            (a[e].v);
+        vecb = vld1q_f32            (b[e].v);
+               vst1q_f32            (dest[e].v, vmlaq_n_f32(veca, vsubq_f32(vecb, veca), t));
+    }
+
+    return intrin;
+}
+
+// Rows of 4x4 matrices are contiguous 4 element vectors
+template <>
+inline specialized matarr_lerp(mat<float, 4, 4> *dest,
+                               mat<float, 4, 4> *a,
+                               mat<float, 4, 4> *b,
+                               float            t,
+                               size_t           n) {
+    return vecarr_lerp((vec<float, 4> *) dest, (vec<float, 4> *) a, (vec<float, 4> *) b, t, n * 4);
+}
+
+template <>
+inline specialized quatarr_nlerp(quat<float> *dest,
+                                 quat<float> *a,
+                                 quat<float> *b,
+                                 float       t,
+                                 size_t      n) {
+    float32x4x4_t veca, vecb;
+    float32x4_t   vecd, vecw, sum, inv;
+    uint32x4_t    sign;
+    size_t        e;
+
+    sign = vdupq_n_u32              (0x80000000);
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        veca = vld4q_f32            (a[e].v);
+        vecb = vld4q_f32            (b[e].v);
+        vecd = vmulq_f32            (veca.val[0], vecb.val[0]);
+        vecd = vmlaq_f32            (vecd, veca.val[1], vecb.val[1]);
+        vecd = vmlaq_f32            (vecd, veca.val[2], vecb.val[2]);
+        vecd = vmlaq_f32            (vecd, veca.val[3], vecb.val[3]);
+        vecw = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vdupq_n_f32(t)),
+                                               vandq_u32(vreinterpretq_u32_f32(vecd), sign)));
+        veca.val[0] = vmlaq_f32     (vmulq_n_f32(veca.val[0], 1.0f - t), vecb.val[0], vecw);
+        veca.val[1] = vmlaq_f32     (vmulq_n_f32(veca.val[1], 1.0f - t), vecb.val[1], vecw);
+        veca.val[2] = vmlaq_f32     (vmulq_n_f32(veca.val[2], 1.0f - t), vecb.val[2], vecw);
+        veca.val[3] = vmlaq_f32     (vmulq_n_f32(veca.val[3], 1.0f - t), vecb.val[3], vecw);
+        sum  = vmulq_f32            (veca.val[0], veca.val[0]);
+        sum  = vmlaq_f32            (sum, veca.val[1], veca.val[1]);
+        sum  = vmlaq_f32            (sum, veca.val[2], veca.val[2]);
+        sum  = vmlaq_f32            (sum, veca.val[3], veca.val[3]);
+#if defined(__aarch64__)
+        inv  = vdivq_f32            (vdupq_n_f32(1.0f), vsqrtq_f32(sum));
+#else
+        inv  = vrsqrteq_f32         (sum);
+        inv  = vmulq_f32            (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+        inv  = vmulq_f32            (inv, vrsqrtsq_f32(vmulq_f32(sum, inv), inv));
+#endif
+        veca.val[0] = vmulq_f32     (veca.val[0], inv);
+        veca.val[1] = vmulq_f32     (veca.val[1], inv);
+        veca.val[2] = vmulq_f32     (veca.val[2], inv);
+        veca.val[3] = vmulq_f32     (veca.val[3], inv);
+                      vst4q_f32     (dest[e].v, veca);
+    }
+
+    for (; e < n; ++e) {
+        float *pa = a[e].v;
+        float *pb = b[e].v;
+        float d   = pa[0] * pb[0] + pa[1] * pb[1] + pa[2] * pb[2] + pa[3] * pb[3];
+        float wb  = (d < 0) ? -t : t;
+        float r[4];
+
+        for (int i = 0; i < 4; ++i) {
+            r[i] = pa[i] * (1.0f - t) + pb[i] * wb;
+        }
+
+        float s = 1.0f / std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+
+        for (int i = 0; i < 4; ++i) {
+            dest[e].v[i] = r[i] * s;
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized quatarr_slerp(quat<float> *dest,
+                                 quat<float> *a,
+                                 quat<float> *b,
+                                 float       t,
+                                 size_t      n) {
+    float32x4x4_t veca, vecb;
+    float32x4_t   vecd, vecx, wa, wb, one;
+    uint32x4_t    sign;
+    float         ca[slerp_terms], cb[slerp_terms];
+    size_t        e;
+
+    slerp_coefficients(ca, 1.0f - t);
+    slerp_coefficients(cb, t);
+
+    sign = vdupq_n_u32              (0x80000000);
+    one  = vdupq_n_f32              (1.0f);
+
+    for (e = 0; e + 4 <= n; e += 4) {
+        veca = vld4q_f32            (a[e].v);
+        vecb = vld4q_f32            (b[e].v);
+        vecd = vmulq_f32            (veca.val[0], vecb.val[0]);
+        vecd = vmlaq_f32            (vecd, veca.val[1], vecb.val[1]);
+        vecd = vmlaq_f32            (vecd, veca.val[2], vecb.val[2]);
+        vecd = vmlaq_f32            (vecd, veca.val[3], vecb.val[3]);
+        vecx = vsubq_f32            (vabsq_f32(vecd), one); // |dot| - 1
+
+        wa   = one;
+        wb   = one;
+        for (int i = slerp_terms - 1; i >= 0; --i) {
+            wa = vmlaq_f32          (one, vmulq_n_f32(vecx, ca[i]), wa);
+            wb = vmlaq_f32          (one, vmulq_n_f32(vecx, cb[i]), wb);
+        }
+        wa   = vmulq_n_f32          (wa, 1.0f - t);         // Weights of a
+        wb   = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vmulq_n_f32(wb, t)),
+                                               vandq_u32(vreinterpretq_u32_f32(vecd), sign)));
+
+        veca.val[0] = vmlaq_f32     (vmulq_f32(veca.val[0], wa), vecb.val[0], wb);
+        veca.val[1] = vmlaq_f32     (vmulq_f32(veca.val[1], wa), vecb.val[1], wb);
+        veca.val[2] = vmlaq_f32     (vmulq_f32(veca.val[2], wa), vecb.val[2], wb);
+        veca.val[3] = vmlaq_f32     (vmulq_f32(veca.val[3], wa), vecb.val[3], wb);
+                      vst4q_f32     (dest[e].v, veca);
+    }
+
+    for (; e < n; ++e) {
+        float *pa  = a[e].v;
+        float *pb  = b[e].v;
+        float d    = pa[0] * pb[0] + pa[1] * pb[1] + pa[2] * pb[2] + pa[3] * pb[3];
+        float xm1  = std::abs(d) - 1.0f;
+        float wa1  = slerp_weight(ca, 1.0f - t, xm1);
+        float wb1  = slerp_weight(cb, t, xm1) * (d < 0 ? -1.0f : 1.0f);
+
+                      vst1q_f32     (dest[e].v, vmlaq_n_f32(vmulq_n_f32(vld1q_f32(pa), wa1), vld1q_f32(pb), wb1));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_sample(vec<float, 4> *dest,
+                                 vec<float, 4> *keys,
+                                 float         *times,
+                                 size_t        *first,
+                                 size_t        channels,
+                                 float         time,
+                                 size_t        *cursor) {
+    float32x4_t veca, vecb;
+    size_t      i, j;
+    float       t;
+
+    for (size_t c = 0; c < channels; ++c) {
+        t    = key_interval(i, j, cursor ? cursor + c : nullptr, times, first[c], first[c + 1], time);
+        veca = vld1q_f32            (keys[i].v);
+        vecb = vld1q_f32            (keys[j].v);
+               vst1q_f32            (dest[c].v, vmlaq_n_f32(veca, vsubq_f32(vecb, veca), t));
+    }
+
+    return intrin;
+}
+
+// Sum of the elements of a float vector
+inline float sum_lanes(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+#endif
+}
+
+template <>
+inline specialized quatarr_sample(quat<float> *dest,
+                                  quat<float> *keys,
+                                  float       *times,
+                                  size_t      *first,
+                                  size_t      channels,
+                                  float       time,
+                                  size_t      *cursor) {
+    float32x4_t veca, vecb;
+    size_t      i, j;
+    float       t, d;
+
+    for (size_t c = 0; c < channels; ++c) {
+        t    = key_interval(i, j, cursor ? cursor + c : nullptr, times, first[c], first[c + 1], time);
+        veca = vld1q_f32            (keys[i].v);
+        vecb = vld1q_f32            (keys[j].v);
+        d    = sum_lanes            (vmulq_f32(veca, vecb));
+        veca = vmlaq_n_f32          (vmulq_n_f32(veca, 1.0f - t), vecb, (d < 0) ? -t : t);
+               vst1q_f32            (dest[c].v, vmulq_n_f32(veca, 1.0f / std::sqrt(sum_lanes(vmulq_f32(veca, veca)))));
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized vecarr_lerp(vec<double, 4> *dest,
+                               vec<double, 4> *a,
+                               vec<double, 4> *b,
+                               double         t,
+                               size_t         n) {
+    float64x2_t vecal, vecah, vecbl, vecbh;
+
+    for (size_t e = 0; e < n; ++e) {
+        vecal = vld1q_f64           (a[e].v + 0);
+        vecah = vld1q_f64           (a[e].v + 2);
+        vecbl = vld1q_f64           (b[e].v + 0);
+        vecbh = vld1q_f64           (b[e].v + 2);
+                vst1q_f64           (dest[e].v + 0, vfmaq_n_f64(vecal, vsubq_f64(vecbl, vecal), t));
+                vst1q_f64           (dest[e].v + 2, vfmaq_n_f64(vecah, vsubq_f64(vecbh, vecah), t));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized matarr_lerp(mat<double, 4, 4> *dest,
+                               mat<double, 4, 4> *a,
+                               mat<double, 4, 4> *b,
+                               double            t,
+                               size_t            n) {
+    return vecarr_lerp((vec<double, 4> *) dest, (vec<double, 4> *) a, (vec<double, 4> *) b, t, n * 4);
+}
+
+template <>
+inline specialized quatarr_nlerp(quat<double> *dest,
+                                 quat<double> *a,
+                                 quat<double> *b,
+                                 double       t,
+                                 size_t       n) {
+    float64x2x4_t veca, vecb;
+    float64x2_t   vecd, vecw, sum, inv;
+    uint64x2_t    sign;
+    size_t        e;
+
+    sign = vdupq_n_u64              (0x8000000000000000);
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        veca = vld4q_f64            (a[e].v);
+        vecb = vld4q_f64            (b[e].v);
+        vecd = vmulq_f64            (veca.val[0], vecb.val[0]);
+        vecd = vfmaq_f64            (vecd, veca.val[1], vecb.val[1]);
+        vecd = vfmaq_f64            (vecd, veca.val[2], vecb.val[2]);
+        vecd = vfmaq_f64            (vecd, veca.val[3], vecb.val[3]);
+        vecw = vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(vdupq_n_f64(t)),
+                                               vandq_u64(vreinterpretq_u64_f64(vecd), sign)));
+        veca.val[0] = vfmaq_f64     (vmulq_n_f64(veca.val[0], 1.0 - t), vecb.val[0], vecw);
+        veca.val[1] = vfmaq_f64     (vmulq_n_f64(veca.val[1], 1.0 - t), vecb.val[1], vecw);
+        veca.val[2] = vfmaq_f64     (vmulq_n_f64(veca.val[2], 1.0 - t), vecb.val[2], vecw);
+        veca.val[3] = vfmaq_f64     (vmulq_n_f64(veca.val[3], 1.0 - t), vecb.val[3], vecw);
+        sum  = vmulq_f64            (veca.val[0], veca.val[0]);
+        sum  = vfmaq_f64            (sum, veca.val[1], veca.val[1]);
+        sum  = vfmaq_f64            (sum, veca.val[2], veca.val[2]);
+        sum  = vfmaq_f64            (sum, veca.val[3], veca.val[3]);
+        inv  = vdivq_f64            (vdupq_n_f64(1.0), vsqrtq_f64(sum));
+        veca.val[0] = vmulq_f64     (veca.val[0], inv);
+        veca.val[1] = vmulq_f64     (veca.val[1], inv);
+        veca.val[2] = vmulq_f64     (veca.val[2], inv);
+        veca.val[3] = vmulq_f64     (veca.val[3], inv);
+                      vst4q_f64     (dest[e].v, veca);
+    }
+
+    if (e < n) {
+        double *pa = a[e].v;
+        double *pb = b[e].v;
+        double d   = pa[0] * pb[0] + pa[1] * pb[1] + pa[2] * pb[2] + pa[3] * pb[3];
+        double wb  = (d < 0) ? -t : t;
+        double r[4];
+
+        for (int i = 0; i < 4; ++i) {
+            r[i] = pa[i] * (1.0 - t) + pb[i] * wb;
+        }
+
+        double s = 1.0 / std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+
+        for (int i = 0; i < 4; ++i) {
+            dest[e].v[i] = r[i] * s;
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized quatarr_slerp(quat<double> *dest,
+                                 quat<double> *a,
+                                 quat<double> *b,
+                                 double       t,
+                                 size_t       n) {
+    float64x2x4_t veca, vecb;
+    float64x2_t   vecd, vecx, wa, wb, one;
+    uint64x2_t    sign;
+    double        ca[slerp_terms], cb[slerp_terms];
+    size_t        e;
+
+    slerp_coefficients(ca, 1.0 - t);
+    slerp_coefficients(cb, t);
+
+    sign = vdupq_n_u64              (0x8000000000000000);
+    one  = vdupq_n_f64              (1.0);
+
+    for (e = 0; e + 2 <= n; e += 2) {
+        veca = vld4q_f64            (a[e].v);
+        vecb = vld4q_f64            (b[e].v);
+        vecd = vmulq_f64            (veca.val[0], vecb.val[0]);
+        vecd = vfmaq_f64            (vecd, veca.val[1], vecb.val[1]);
+        vecd = vfmaq_f64            (vecd, veca.val[2], vecb.val[2]);
+        vecd = vfmaq_f64            (vecd, veca.val[3], vecb.val[3]);
+        vecx = vsubq_f64            (vabsq_f64(vecd), one); // |dot| - 1
+
+        wa   = one;
+        wb   = one;
+        for (int i = slerp_terms - 1; i >= 0; --i) {
+            wa = vfmaq_f64          (one, vmulq_n_f64(vecx, ca[i]), wa);
+            wb = vfmaq_f64          (one, vmulq_n_f64(vecx, cb[i]), wb);
+        }
+        wa   = vmulq_n_f64          (wa, 1.0 - t);          // Weights of a
+        wb   = vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(vmulq_n_f64(wb, t)),
+                                               vandq_u64(vreinterpretq_u64_f64(vecd), sign)));
+
+        veca.val[0] = vfmaq_f64     (vmulq_f64(veca.val[0], wa), vecb.val[0], wb);
+        veca.val[1] = vfmaq_f64     (vmulq_f64(veca.val[1], wa), vecb.val[1], wb);
+        veca.val[2] = vfmaq_f64     (vmulq_f64(veca.val[2], wa), vecb.val[2], wb);
+        veca.val[3] = vfmaq_f64     (vmulq_f64(veca.val[3], wa), vecb.val[3], wb);
+                      vst4q_f64     (dest[e].v, veca);
+    }
+
+    if (e < n) {
+        double *pa = a[e].v;
+        double *pb = b[e].v;
+        double d   = pa[0] * pb[0] + pa[1] * pb[1] + pa[2] * pb[2] + pa[3] * pb[3];
+        double xm1 = std::abs(d) - 1.0;
+        double wa1 = slerp_weight(ca, 1.0 - t, xm1);
+        double wb1 = slerp_weight(cb, t, xm1) * (d < 0 ? -1.0 : 1.0);
+
+        for (int i = 0; i < 4; ++i) {
+            dest[e].v[i] = pa[i] * wa1 + pb[i] * wb1;
+        }
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_sample(vec<double, 4> *dest,
+                                 vec<double, 4> *keys,
+                                 double         *times,
+                                 size_t         *first,
+                                 size_t         channels,
+                                 double         time,
+                                 size_t         *cursor) {
+    float64x2_t vecal, vecah, vecbl, vecbh;
+    size_t      i, j;
+    double      t;
+
+    for (size_t c = 0; c < channels; ++c) {
+        t     = key_interval(i, j, cursor ? cursor + c : nullptr, times, first[c], first[c + 1], time);
+        vecal = vld1q_f64           (keys[i].v + 0);
+        vecah = vld1q_f64           (keys[i].v + 2);
+        vecbl = vld1q_f64           (keys[j].v + 0);
+        vecbh = vld1q_f64           (keys[j].v + 2);
+                vst1q_f64           (dest[c].v + 0, vfmaq_n_f64(vecal, vsubq_f64(vecbl, vecal), t));
+                vst1q_f64           (dest[c].v + 2, vfmaq_n_f64(vecah, vsubq_f64(vecbh, vecah), t));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized quatarr_sample(quat<double> *dest,
+                                  quat<double> *keys,
+                                  double       *times,
+                                  size_t       *first,
+                                  size_t       channels,
+                                  double       time,
+                                  size_t       *cursor) {
+    float64x2_t vecal, vecah, vecbl, vecbh;
+    size_t      i, j;
+    double      t, d, s, wb;
+
+    for (size_t c = 0; c < channels; ++c) {
+        t     = key_interval(i, j, cursor ? cursor + c : nullptr, times, first[c], first[c + 1], time);
+        vecal = vld1q_f64           (keys[i].v + 0);
+        vecah = vld1q_f64           (keys[i].v + 2);
+        vecbl = vld1q_f64           (keys[j].v + 0);
+        vecbh = vld1q_f64           (keys[j].v + 2);
+        d     = vaddvq_f64          (vfmaq_f64(vmulq_f64(vecal, vecbl), vecah, vecbh));
+        wb    = (d < 0) ? -t : t;
+        vecal = vfmaq_n_f64         (vmulq_n_f64(vecal, 1.0 - t), vecbl, wb);
+        vecah = vfmaq_n_f64         (vmulq_n_f64(vecah, 1.0 - t), vecbh, wb);
+        s     = 1.0 / std::sqrt     (vaddvq_f64(vfmaq_f64(vmulq_f64(vecal, vecal), vecah, vecah)));
+                vst1q_f64           (dest[c].v + 0, vmulq_n_f64(vecal, s));
+                vst1q_f64           (dest[c].v + 2, vmulq_n_f64(vecah, s));
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// 3x3 and 2x2 matrices
+//
+// Rows of 3x3 matrices and 2 element rows of 2x2 matrices are padded with
+// zero to 4 elements in registers. 3 and 2 element vectors are padded to
+// 4 elements in memory, see vec, so they are loaded and stored as 4 element
+// vectors and their padding is written as zero. The rows of a 3x3 result
+// are stored in order, each 4 element store is overwritten by the next row,
+// the last writes zero to padding within the alignment of the matrix.
+
+template <>
+constexpr specialized mat_x_mat(mat<float, 3, 3> &dest,
+                                mat<float, 3, 3> &a,
+                                mat<float, 3, 3> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    float32x4_t row0, row1, row2, vecd0, vecd1, vecd2;
+    float *pd = dest.m[0];
+    float *pa = a.m[0];
+    float *pb = b.m[0];
+
+    row0  = vsetq_lane_f32      (0.0f, vld1q_f32(pb + 0), 3);   // Rows padded with zero
+    row1  = vsetq_lane_f32      (0.0f, vld1q_f32(pb + 3), 3);
+    row2  = vsetq_lane_f32      (0.0f, vld1q_f32(pb + 6), 3);
+
+    vecd0 = vmulq_n_f32         (row0, pa[0]);              // Multiply and add the elements
+    vecd0 = vmlaq_n_f32         (vecd0, row1, pa[1]);
+    vecd0 = vmlaq_n_f32         (vecd0, row2, pa[2]);
+    vecd1 = vmulq_n_f32         (row0, pa[3]);
+    vecd1 = vmlaq_n_f32         (vecd1, row1, pa[4]);
+    vecd1 = vmlaq_n_f32         (vecd1, row2, pa[5]);
+    vecd2 = vmulq_n_f32         (row0, pa[6]);
+    vecd2 = vmlaq_n_f32         (vecd2, row1, pa[7]);
+    vecd2 = vmlaq_n_f32         (vecd2, row2, pa[8]);
+
+            vst1q_f32           (pd + 0, vecd0);            // Store rows in order
+            vst1q_f32           (pd + 3, vecd1);
+            vst1q_f32           (pd + 6, vecd2);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<float, 2, 2> &dest,
+                                mat<float, 2, 2> &a,
+                                mat<float, 2, 2> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    float32x4x2_t veca;
+    float32x4_t   vecb, vecd;
+
+    veca = vtrnq_f32            (vld1q_f32(a.m[0]), vld1q_f32(a.m[0]));
+    vecb = vld1q_f32            (b.m[0]);                   // [ b00 b01 b10 b11 ]
+    vecd = vmulq_f32            (veca.val[0], vcombine_f32(vget_low_f32(vecb), vget_low_f32(vecb)));
+    vecd = vmlaq_f32            (vecd, veca.val[1], vcombine_f32(vget_high_f32(vecb), vget_high_f32(vecb)));
+           vst1q_f32            (dest.m[0], vecd);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized vec_x_mat(vec<float, 3>    &dest,
+                                vec<float, 3>    &v,
+                                mat<float, 3, 3> &m) {
+    if (std::is_constant_evaluated()) {
+        return looped_vec_x_mat(dest, v, m);
+    }
+
+    float32x4_t vecd;
+    float *pm = m.m[0];
+
+    vecd = vmulq_n_f32          (vsetq_lane_f32(0.0f, vld1q_f32(pm + 0), 3), v.v[0]);
+    vecd = vmlaq_n_f32          (vecd, vsetq_lane_f32(0.0f, vld1q_f32(pm + 3), 3), v.v[1]);
+    vecd = vmlaq_n_f32          (vecd, vsetq_lane_f32(0.0f, vld1q_f32(pm + 6), 3), v.v[2]);
+           vst1q_f32            (dest.v, vecd);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized vec_x_mat(vec<float, 2>    &dest,
+                                vec<float, 2>    &v,
+                                mat<float, 2, 2> &m) {
+    if (std::is_constant_evaluated()) {
+        return looped_vec_x_mat(dest, v, m);
+    }
+
+    float32x2_t vecd;
+
+    vecd = vmul_n_f32           (vld1_f32(m.m[0]), v.v[0]);
+    vecd = vmla_n_f32           (vecd, vld1_f32(m.m[1]), v.v[1]);
+           vst1q_f32            (dest.v, vcombine_f32(vecd, vdup_n_f32(0.0f)));
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_mat(vec <float, 3>    *dest,
+                                vec <float, 3>    *v,
+                                mat <float, 3, 3> &m,
+                                size_t            n) {
+    float32x4_t row0, row1, row2, vecv, vecd;
+    float *pm = m.m[0];
+
+    row0 = vsetq_lane_f32       (0.0f, vld1q_f32(pm + 0), 3);   // Rows padded with zero
+    row1 = vsetq_lane_f32       (0.0f, vld1q_f32(pm + 3), 3);
+    row2 = vsetq_lane_f32       (0.0f, vld1q_f32(pm + 6), 3);
+
+    for (size_t e = 0; e < n; ++e) {
+        vecv = vld1q_f32        (v[e].v);
+        vecd = vmulq_lane_f32   (row0, vget_low_f32(vecv), 0);
+        vecd = vmlaq_lane_f32   (vecd, row1, vget_low_f32(vecv), 1);
+        vecd = vmlaq_lane_f32   (vecd, row2, vget_high_f32(vecv), 0);
+               vst1q_f32        (dest[e].v, vecd);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_mat(vec <float, 2>    *dest,
+                                vec <float, 2>    *v,
+                                mat <float, 2, 2> &m,
+                                size_t            n) {
+    float32x2_t row0, row1, vecd, zero;
+
+    row0 = vld1_f32             (m.m[0]);
+    row1 = vld1_f32             (m.m[1]);
+    zero = vdup_n_f32           (0.0f);
+
+    for (size_t e = 0; e < n; ++e) {
+        vecd = vmul_n_f32       (row0, v[e].v[0]);
+        vecd = vmla_n_f32       (vecd, row1, v[e].v[1]);
+               vst1q_f32        (dest[e].v, vcombine_f32(vecd, zero));   // Zero padding
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+constexpr specialized mat_x_mat(mat<double, 3, 3> &dest,
+                                mat<double, 3, 3> &a,
+                                mat<double, 3, 3> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    float64x2_t row0l, row0h, row1l, row1h, row2l, row2h;
+    float64x2_t vecd0l, vecd0h, vecd1l, vecd1h, vecd2l, vecd2h;
+    double *pd = dest.m[0];
+    double *pa = a.m[0];
+    double *pb = b.m[0];
+
+    row0l = vld1q_f64           (pb + 0);                   // Rows padded with zero
+    row0h = vsetq_lane_f64      (0.0, vld1q_f64(pb + 2), 1);
+    row1l = vld1q_f64           (pb + 3);
+    row1h = vsetq_lane_f64      (0.0, vld1q_f64(pb + 5), 1);
+    row2l = vld1q_f64           (pb + 6);
+    row2h = vsetq_lane_f64      (0.0, vld1q_f64(pb + 8), 1);
+
+    vecd0l = vmulq_n_f64        (row0l, pa[0]);             // Multiply and add the elements
+    vecd0h = vmulq_n_f64        (row0h, pa[0]);
+    vecd0l = vfmaq_n_f64        (vecd0l, row1l, pa[1]);
+    vecd0h = vfmaq_n_f64        (vecd0h, row1h, pa[1]);
+    vecd0l = vfmaq_n_f64        (vecd0l, row2l, pa[2]);
+    vecd0h = vfmaq_n_f64        (vecd0h, row2h, pa[2]);
+    vecd1l = vmulq_n_f64        (row0l, pa[3]);
+    vecd1h = vmulq_n_f64        (row0h, pa[3]);
+    vecd1l = vfmaq_n_f64        (vecd1l, row1l, pa[4]);
+    vecd1h = vfmaq_n_f64        (vecd1h, row1h, pa[4]);
+    vecd1l = vfmaq_n_f64        (vecd1l, row2l, pa[5]);
+    vecd1h = vfmaq_n_f64        (vecd1h, row2h, pa[5]);
+    vecd2l = vmulq_n_f64        (row0l, pa[6]);
+    vecd2h = vmulq_n_f64        (row0h, pa[6]);
+    vecd2l = vfmaq_n_f64        (vecd2l, row1l, pa[7]);
+    vecd2h = vfmaq_n_f64        (vecd2h, row1h, pa[7]);
+    vecd2l = vfmaq_n_f64        (vecd2l, row2l, pa[8]);
+    vecd2h = vfmaq_n_f64        (vecd2h, row2h, pa[8]);
+
+             vst1q_f64          (pd + 0, vecd0l);           // Store rows in order
+             vst1q_f64          (pd + 2, vecd0h);
+             vst1q_f64          (pd + 3, vecd1l);
+             vst1q_f64          (pd + 5, vecd1h);
+             vst1q_f64          (pd + 6, vecd2l);
+             vst1q_f64          (pd + 8, vecd2h);
+
+    return intrin;
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<double, 2, 2> &dest,
+                                mat<double, 2, 2> &a,
+                                mat<double, 2, 2> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    float64x2_t row0, row1, vecd0, vecd1;
+    double *pa = a.m[0];
+
+    row0  = vld1q_f64           (b.m[0]);
+    row1  = vld1q_f64           (b.m[1]);
+    vecd0 = vmulq_n_f64         (row0, pa[0]);
+    vecd0 = vfmaq_n_f64         (vecd0, row1, pa[1]);
+    vecd1 = vmulq_n_f64         (row0, pa[2]);
+    vecd1 = vfmaq_n_f64         (vecd1, row1, pa[3]);
+            vst1q_f64           (dest.m[0], vecd0);
+            vst1q_f64           (dest.m[1], vecd1);
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_mat(vec <double, 3>    *dest,
+                                vec <double, 3>    *v,
+                                mat <double, 3, 3> &m,
+                                size_t             n) {
+    float64x2_t row0l, row0h, row1l, row1h, row2l, row2h, vecdl, vecdh;
+    double *pm = m.m[0];
+
+    row0l = vld1q_f64           (pm + 0);                   // Rows padded with zero
+    row0h = vsetq_lane_f64      (0.0, vld1q_f64(pm + 2), 1);
+    row1l = vld1q_f64           (pm + 3);
+    row1h = vsetq_lane_f64      (0.0, vld1q_f64(pm + 5), 1);
+    row2l = vld1q_f64           (pm + 6);
+    row2h = vsetq_lane_f64      (0.0, vld1q_f64(pm + 8), 1);
+
+    for (size_t e = 0; e < n; ++e) {
+        double *pv = v[e].v;
+
+        vecdl = vmulq_n_f64     (row0l, pv[0]);
+        vecdh = vmulq_n_f64     (row0h, pv[0]);
+        vecdl = vfmaq_n_f64     (vecdl, row1l, pv[1]);
+        vecdh = vfmaq_n_f64     (vecdh, row1h, pv[1]);
+        vecdl = vfmaq_n_f64     (vecdl, row2l, pv[2]);
+        vecdh = vfmaq_n_f64     (vecdh, row2h, pv[2]);
+                vst1q_f64       (dest[e].v + 0, vecdl);
+                vst1q_f64       (dest[e].v + 2, vecdh);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_mat(vec <double, 2>    *dest,
+                                vec <double, 2>    *v,
+                                mat <double, 2, 2> &m,
+                                size_t             n) {
+    float64x2_t row0, row1, vecd, zero;
+
+    row0 = vld1q_f64            (m.m[0]);
+    row1 = vld1q_f64            (m.m[1]);
+    zero = vdupq_n_f64          (0.0);
+
+    for (size_t e = 0; e < n; ++e) {
+        vecd = vmulq_n_f64      (row0, v[e].v[0]);
+        vecd = vfmaq_n_f64      (vecd, row1, v[e].v[1]);
+               vst1q_f64        (dest[e].v + 0, vecd);
+               vst1q_f64        (dest[e].v + 2, zero);      // Padding
+    }
+
+    return intrin;
+}
+
+template <>
+constexpr specialized vec_x_mat(vec<double, 3>    &dest,
+                                vec<double, 3>    &v,
+                                mat<double, 3, 3> &m) {
+    if (std::is_constant_evaluated()) {
+        return looped_vec_x_mat(dest, v, m);
+    }
+
+    return vecarr_x_mat(&dest, &v, m, 1);
+}
+
+template <>
+constexpr specialized vec_x_mat(vec<double, 2>    &dest,
+                                vec<double, 2>    &v,
+                                mat<double, 2, 2> &m) {
+    if (std::is_constant_evaluated()) {
+        return looped_vec_x_mat(dest, v, m);
+    }
+
+    return vecarr_x_mat(&dest, &v, m, 1);
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Elementwise array operations
+//
+// Process 4 float or 2 double elements per 128-bit register, then the
+// remaining elements one at a time.
+
+template <>
+inline specialized arr_add(float *dest, float *a, float *b, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        vst1q_f32                    (dest + e, vaddq_f32(vld1q_f32(a + e), vld1q_f32(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] + b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_sub(float *dest, float *a, float *b, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        vst1q_f32                    (dest + e, vsubq_f32(vld1q_f32(a + e), vld1q_f32(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] - b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_add_scalar(float *dest, float *a, float s, size_t n) {
+    float32x4_t vecs;
+    size_t e, full = n - n % 4;
+
+    vecs = vdupq_n_f32               (s);
+
+    for (e = 0; e < full; e += 4) {
+        vst1q_f32                    (dest + e, vaddq_f32(vld1q_f32(a + e), vecs));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] + s;
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_scale(float *dest, float *a, float s, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        vst1q_f32                    (dest + e, vmulq_n_f32(vld1q_f32(a + e), s));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] * s;
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_axpy(float *dest, float *x, float *y, float alpha, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        vst1q_f32                    (dest + e, vmlaq_n_f32(vld1q_f32(y + e), vld1q_f32(x + e), alpha));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = alpha * x[e] + y[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_blend(float *dest, float *a, float *b, float wa, float wb, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        vst1q_f32                    (dest + e, vmlaq_n_f32(vmulq_n_f32(vld1q_f32(b + e), wb), vld1q_f32(a + e), wa));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = wa * a[e] + wb * b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_abs(float *dest, float *a, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        vst1q_f32                    (dest + e, vabsq_f32(vld1q_f32(a + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::abs(a[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_min(float *dest, float *a, float *b, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        vst1q_f32                    (dest + e, vminq_f32(vld1q_f32(a + e), vld1q_f32(b + e)));
     }
 
-    return zero;
+    for (; e < n; ++e) {
+        dest[e] = std::min(a[e], b[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_max(float *dest, float *a, float *b, size_t n) {
+    size_t e, full = n - n % 4;
+
+    for (e = 0; e < full; e += 4) {
+        vst1q_f32                    (dest + e, vmaxq_f32(vld1q_f32(a + e), vld1q_f32(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::max(a[e], b[e]);
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized arr_add(double *dest, double *a, double *b, size_t n) {
+    size_t e, full = n - n % 2;
+
+    for (e = 0; e < full; e += 2) {
+        vst1q_f64                    (dest + e, vaddq_f64(vld1q_f64(a + e), vld1q_f64(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] + b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_sub(double *dest, double *a, double *b, size_t n) {
+    size_t e, full = n - n % 2;
+
+    for (e = 0; e < full; e += 2) {
+        vst1q_f64                    (dest + e, vsubq_f64(vld1q_f64(a + e), vld1q_f64(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] - b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_add_scalar(double *dest, double *a, double s, size_t n) {
+    float64x2_t vecs;
+    size_t e, full = n - n % 2;
+
+    vecs = vdupq_n_f64               (s);
+
+    for (e = 0; e < full; e += 2) {
+        vst1q_f64                    (dest + e, vaddq_f64(vld1q_f64(a + e), vecs));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] + s;
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_scale(double *dest, double *a, double s, size_t n) {
+    size_t e, full = n - n % 2;
+
+    for (e = 0; e < full; e += 2) {
+        vst1q_f64                    (dest + e, vmulq_n_f64(vld1q_f64(a + e), s));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = a[e] * s;
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_axpy(double *dest, double *x, double *y, double alpha, size_t n) {
+    size_t e, full = n - n % 2;
+
+    for (e = 0; e < full; e += 2) {
+        vst1q_f64                    (dest + e, vfmaq_n_f64(vld1q_f64(y + e), vld1q_f64(x + e), alpha));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = alpha * x[e] + y[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_blend(double *dest, double *a, double *b, double wa, double wb, size_t n) {
+    size_t e, full = n - n % 2;
+
+    for (e = 0; e < full; e += 2) {
+        vst1q_f64                    (dest + e, vfmaq_n_f64(vmulq_n_f64(vld1q_f64(b + e), wb), vld1q_f64(a + e), wa));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = wa * a[e] + wb * b[e];
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_abs(double *dest, double *a, size_t n) {
+    size_t e, full = n - n % 2;
+
+    for (e = 0; e < full; e += 2) {
+        vst1q_f64                    (dest + e, vabsq_f64(vld1q_f64(a + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::abs(a[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_min(double *dest, double *a, double *b, size_t n) {
+    size_t e, full = n - n % 2;
+
+    for (e = 0; e < full; e += 2) {
+        vst1q_f64                    (dest + e, vminq_f64(vld1q_f64(a + e), vld1q_f64(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::min(a[e], b[e]);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized arr_max(double *dest, double *a, double *b, size_t n) {
+    size_t e, full = n - n % 2;
+
+    for (e = 0; e < full; e += 2) {
+        vst1q_f64                    (dest + e, vmaxq_f64(vld1q_f64(a + e), vld1q_f64(b + e)));
+    }
+
+    for (; e < n; ++e) {
+        dest[e] = std::max(a[e], b[e]);
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Matrix structure
+//
+// classify compares the matrix to the identity, keeps a bit for each equal
+// element and combines the bits of all the rows into a mask.
+
+template <>
+inline specialized classify(structure &dest, mat<float, 4, 4> &a) {
+    const float    ident[16] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 };
+    const uint32_t bits[4]   = { 1, 2, 4, 8 };
+    uint32x4_t     vecb, vecm;
+    uint32x2_t     vech;
+
+    vecb = vld1q_u32                 (bits);
+    vecm =           vandq_u32(vceqq_f32(vld1q_f32(a.m[0]), vld1q_f32(ident +  0)), vecb);
+    vecm = vorrq_u32 (vecm, vshlq_n_u32(vandq_u32(vceqq_f32(vld1q_f32(a.m[1]), vld1q_f32(ident +  4)), vecb),  4));
+    vecm = vorrq_u32 (vecm, vshlq_n_u32(vandq_u32(vceqq_f32(vld1q_f32(a.m[2]), vld1q_f32(ident +  8)), vecb),  8));
+    vecm = vorrq_u32 (vecm, vshlq_n_u32(vandq_u32(vceqq_f32(vld1q_f32(a.m[3]), vld1q_f32(ident + 12)), vecb), 12));
+    vech = vorr_u32  (vget_low_u32(vecm), vget_high_u32(vecm));
+    dest = mask_to_structure(vget_lane_u32(vech, 0) | vget_lane_u32(vech, 1));
+
+    return intrin;
+}
+
+template <>
+inline specialized affine_x_affine(mat<float, 4, 4> &dest,
+                                   mat<float, 4, 4> &a,
+                                   mat<float, 4, 4> &b) {
+    float32x4_t row0, row1, row2, row3, vecd;
+
+    row0 = vld1q_f32                 (b.m[0]);
+    row1 = vld1q_f32                 (b.m[1]);
+    row2 = vld1q_f32                 (b.m[2]);
+    row3 = vld1q_f32                 (b.m[3]);
+
+    for (int i = 0; i < 4; ++i) {
+        vecd = (i == 3) ? row3 : vdupq_n_f32(0);                                 // Translation
+        vecd = vmlaq_n_f32           (vecd, row0, a.m[i][0]);
+        vecd = vmlaq_n_f32           (vecd, row1, a.m[i][1]);
+        vecd = vmlaq_n_f32           (vecd, row2, a.m[i][2]);
+               vst1q_f32             (dest.m[i], vecd);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_translation(vec<float, 4>    *dest,
+                                        vec<float, 4>    *v,
+                                        mat<float, 4, 4> &m,
+                                        size_t           n) {
+    float32x4_t vect;
+
+    vect = vsetq_lane_f32            (0, vld1q_f32(m.m[3]), 3);                  // [ tx ty tz 0 ]
+
+    for (size_t e = 0; e < n; ++e) {
+               vst1q_f32             (dest[e].v, vmlaq_n_f32(vld1q_f32(v[e].v), vect, v[e].v[3]));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_scale(vec<float, 4>    *dest,
+                                  vec<float, 4>    *v,
+                                  mat<float, 4, 4> &m,
+                                  size_t           n) {
+    const float diag[4] = { m.m[0][0], m.m[1][1], m.m[2][2], 0 };
+    float32x4_t vecs, vect;
+
+    vecs = vld1q_f32                 (diag);                                      // [ sx sy sz 0 ]
+    vect = vld1q_f32                 (m.m[3]);                                    // [ tx ty tz 1 ]
+
+    for (size_t e = 0; e < n; ++e) {
+               vst1q_f32             (dest[e].v, vmlaq_n_f32(vmulq_f32(vld1q_f32(v[e].v), vecs), vect, v[e].v[3]));
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <>
+inline specialized classify(structure &dest, mat<double, 4, 4> &a) {
+    const double   ident[16] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 };
+    const uint64_t bits[4]   = { 1, 2, 4, 8 };
+    uint64x2_t     vecl, vech, vecm;
+
+    vecl = vld1q_u64                 (bits);
+    vech = vld1q_u64                 (bits + 2);
+    vecm = vorrq_u64 (vandq_u64(vceqq_f64(vld1q_f64(a.m[0]),     vld1q_f64(ident +  0)), vecl),
+                      vandq_u64(vceqq_f64(vld1q_f64(a.m[0] + 2), vld1q_f64(ident +  2)), vech));
+    vecm = vorrq_u64 (vecm, vshlq_n_u64(vorrq_u64(vandq_u64(vceqq_f64(vld1q_f64(a.m[1]),     vld1q_f64(ident +  4)), vecl),
+                                                  vandq_u64(vceqq_f64(vld1q_f64(a.m[1] + 2), vld1q_f64(ident +  6)), vech)),  4));
+    vecm = vorrq_u64 (vecm, vshlq_n_u64(vorrq_u64(vandq_u64(vceqq_f64(vld1q_f64(a.m[2]),     vld1q_f64(ident +  8)), vecl),
+                                                  vandq_u64(vceqq_f64(vld1q_f64(a.m[2] + 2), vld1q_f64(ident + 10)), vech)),  8));
+    vecm = vorrq_u64 (vecm, vshlq_n_u64(vorrq_u64(vandq_u64(vceqq_f64(vld1q_f64(a.m[3]),     vld1q_f64(ident + 12)), vecl),
+                                                  vandq_u64(vceqq_f64(vld1q_f64(a.m[3] + 2), vld1q_f64(ident + 14)), vech)), 12));
+    dest = mask_to_structure(unsigned(vgetq_lane_u64(vecm, 0) | vgetq_lane_u64(vecm, 1)));
+
+    return intrin;
+}
+
+template <>
+inline specialized affine_x_affine(mat<double, 4, 4> &dest,
+                                   mat<double, 4, 4> &a,
+                                   mat<double, 4, 4> &b) {
+    float64x2_t row0l, row0h, row1l, row1h, row2l, row2h, vecl, vech;
+
+    row0l = vld1q_f64                (b.m[0]);
+    row0h = vld1q_f64                (b.m[0] + 2);
+    row1l = vld1q_f64                (b.m[1]);
+    row1h = vld1q_f64                (b.m[1] + 2);
+    row2l = vld1q_f64                (b.m[2]);
+    row2h = vld1q_f64                (b.m[2] + 2);
+
+    for (int i = 0; i < 4; ++i) {
+        vecl = (i == 3) ? vld1q_f64(b.m[3])     : vdupq_n_f64(0);                 // Translation
+        vech = (i == 3) ? vld1q_f64(b.m[3] + 2) : vdupq_n_f64(0);
+        vecl = vfmaq_n_f64           (vecl, row0l, a.m[i][0]);
+        vech = vfmaq_n_f64           (vech, row0h, a.m[i][0]);
+        vecl = vfmaq_n_f64           (vecl, row1l, a.m[i][1]);
+        vech = vfmaq_n_f64           (vech, row1h, a.m[i][1]);
+        vecl = vfmaq_n_f64           (vecl, row2l, a.m[i][2]);
+        vech = vfmaq_n_f64           (vech, row2h, a.m[i][2]);
+               vst1q_f64             (dest.m[i],     vecl);
+               vst1q_f64             (dest.m[i] + 2, vech);
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_translation(vec<double, 4>    *dest,
+                                        vec<double, 4>    *v,
+                                        mat<double, 4, 4> &m,
+                                        size_t            n) {
+    float64x2_t vectl, vecth;
+    double      w;
+
+    vectl = vld1q_f64                (m.m[3]);                                    // [ tx ty tz 0 ]
+    vecth = vsetq_lane_f64           (0, vld1q_f64(m.m[3] + 2), 1);
+
+    for (size_t e = 0; e < n; ++e) {
+        w     = v[e].v[3];
+                vst1q_f64            (dest[e].v,     vfmaq_n_f64(vld1q_f64(v[e].v),     vectl, w));
+                vst1q_f64            (dest[e].v + 2, vfmaq_n_f64(vld1q_f64(v[e].v + 2), vecth, w));
+    }
+
+    return intrin;
+}
+
+template <>
+inline specialized vecarr_x_scale(vec<double, 4>    *dest,
+                                  vec<double, 4>    *v,
+                                  mat<double, 4, 4> &m,
+                                  size_t            n) {
+    const double diag[4] = { m.m[0][0], m.m[1][1], m.m[2][2], 0 };
+    float64x2_t  vecsl, vecsh, vectl, vecth;
+    double       w;
+
+    vecsl = vld1q_f64                (diag);                                      // [ sx sy sz 0 ]
+    vecsh = vld1q_f64                (diag + 2);
+    vectl = vld1q_f64                (m.m[3]);                                    // [ tx ty tz 1 ]
+    vecth = vld1q_f64                (m.m[3] + 2);
+
+    for (size_t e = 0; e < n; ++e) {
+        w     = v[e].v[3];
+                vst1q_f64            (dest[e].v,     vfmaq_n_f64(vmulq_f64(vld1q_f64(v[e].v),     vecsl), vectl, w));
+                vst1q_f64            (dest[e].v + 2, vfmaq_n_f64(vmulq_f64(vld1q_f64(v[e].v + 2), vecsh), vecth, w));
+    }
+
+    return intrin;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Register blocked 8x8 and 16x16 products
+//
+// A tile of R rows by C vectors of dest stays in registers for the whole
+// product, 16 of the 32 q registers hold sums. Each step loads the C
+// vectors of a row of b once and multiplies them by an element of a for
+// each row of the tile.
+//
+// dest(R,C*lanes) = a(R,K) * b(K,C*lanes), rows are LD elements apart
+
+template <int R, int C, int K, int LD>
+inline void block_f128(float *pd, float *pa, float *pb) {
+    float32x4_t sum[R][C], rowb[C];
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            sum[i][j] = vdupq_n_f32(0);
+
+    for (int k = 0; k < K; ++k) {
+        for (int j = 0; j < C; ++j)
+            rowb[j] = vld1q_f32(pb + k * LD + j * 4);               // Row of b
+
+        for (int i = 0; i < R; ++i)
+            for (int j = 0; j < C; ++j)
+                sum[i][j] = vmlaq_n_f32(sum[i][j], rowb[j], pa[i * LD + k]);
+    }
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            vst1q_f32(pd + i * LD + j * 4, sum[i][j]);
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<float, 8, 8> &dest,
+                                mat<float, 8, 8> &a,
+                                mat<float, 8, 8> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    block_f128<8, 2, 8, 8>(dest.m[0], a.m[0], b.m[0]);              // Whole 8x8 tile
+
+    return blockneon;
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<float, 16, 16> &dest,
+                                mat<float, 16, 16> &a,
+                                mat<float, 16, 16> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    for (int i = 0; i < 16; i += 4) {
+        block_f128<4, 4, 16, 16>(dest.m[i], a.m[i], b.m[0]);        // 4x16 tiles
+    }
+
+    return blockneon;
+}
+
+#if defined(__aarch64__)
+
+template <int R, int C, int K, int LD>
+inline void block_d128(double *pd, double *pa, double *pb) {
+    float64x2_t sum[R][C], rowb[C];
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            sum[i][j] = vdupq_n_f64(0);
+
+    for (int k = 0; k < K; ++k) {
+        for (int j = 0; j < C; ++j)
+            rowb[j] = vld1q_f64(pb + k * LD + j * 2);
+
+        for (int i = 0; i < R; ++i)
+            for (int j = 0; j < C; ++j)
+                sum[i][j] = vfmaq_n_f64(sum[i][j], rowb[j], pa[i * LD + k]);
+    }
+
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j)
+            vst1q_f64(pd + i * LD + j * 2, sum[i][j]);
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<double, 8, 8> &dest,
+                                mat<double, 8, 8> &a,
+                                mat<double, 8, 8> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    block_d128<4, 4, 8, 8>(dest.m[0], a.m[0], b.m[0]);              // 4x8 tiles
+    block_d128<4, 4, 8, 8>(dest.m[4], a.m[4], b.m[0]);
+
+    return blockneon;
+}
+
+template <>
+constexpr specialized mat_x_mat(mat<double, 16, 16> &dest,
+                                mat<double, 16, 16> &a,
+                                mat<double, 16, 16> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
+    for (int i = 0; i < 16; i += 4) {
+        block_d128<4, 4, 16, 16>(dest.m[i],     a.m[i], b.m[0]);    // 4x8 tiles
+        block_d128<4, 4, 16, 16>(dest.m[i] + 8, a.m[i], b.m[0] + 8);
+    }
+
+    return blockneon;
+}
+
+#endif  // __aarch64__
+
+
+
+// -----------------------------------------------------------------------------
+// Blocked matrix multiplication
+//
+// Micro-kernels keep an 8x8 float or 8x4 double tile of dest in 16 of the
+// 32 q registers. Each step loads a row of the b panel, then multiplies it
+// by the elements of the a panel down the tile.
+
+template <> struct gemm_shape<float> {
+    static const size_t mr = 8;
+    static const size_t nr = 8;
+    static const size_t mc = 128;
+    static const size_t kc = 256;
+    static const size_t nc = 4096;
+};
+
+template <>
+inline specialized gemm_kernel(float *dest, size_t ld, float *pa, float *pb, size_t kc) {
+    float32x4_t sum[8][2], rowb0, rowb1;
+
+    for (int i = 0; i < 8; ++i) {
+        sum[i][0] = vld1q_f32(dest + i * ld);
+        sum[i][1] = vld1q_f32(dest + i * ld + 4);
+    }
+
+    for (size_t p = 0; p < kc; ++p, pa += 8, pb += 8) {
+        rowb0 = vld1q_f32(pb);                                      // Row of the b panel
+        rowb1 = vld1q_f32(pb + 4);
+
+        for (int i = 0; i < 8; ++i) {
+            sum[i][0] = vmlaq_n_f32(sum[i][0], rowb0, pa[i]);       // Column of the a panel
+            sum[i][1] = vmlaq_n_f32(sum[i][1], rowb1, pa[i]);
+        }
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        vst1q_f32(dest + i * ld,     sum[i][0]);
+        vst1q_f32(dest + i * ld + 4, sum[i][1]);
+    }
+
+    return intrin;
+}
+
+#if defined(__aarch64__)
+
+template <> struct gemm_shape<double> {
+    static const size_t mr = 8;
+    static const size_t nr = 4;
+    static const size_t mc = 64;
+    static const size_t kc = 256;
+    static const size_t nc = 2048;
+};
+
+template <>
+inline specialized gemm_kernel(double *dest, size_t ld, double *pa, double *pb, size_t kc) {
+    float64x2_t sum[8][2], rowb0, rowb1;
+
+    for (int i = 0; i < 8; ++i) {
+        sum[i][0] = vld1q_f64(dest + i * ld);
+        sum[i][1] = vld1q_f64(dest + i * ld + 2);
+    }
+
+    for (size_t p = 0; p < kc; ++p, pa += 8, pb += 4) {
+        rowb0 = vld1q_f64(pb);
+        rowb1 = vld1q_f64(pb + 2);
+
+        for (int i = 0; i < 8; ++i) {
+            sum[i][0] = vfmaq_n_f64(sum[i][0], rowb0, pa[i]);
+            sum[i][1] = vfmaq_n_f64(sum[i][1], rowb1, pa[i]);
+        }
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        vst1q_f64(dest + i * ld,     sum[i][0]);
+        vst1q_f64(dest + i * ld + 2, sum[i][1]);
+    }
+
+    return intrin;
 }
 
+#endif  // __aarch64__
+
 
 
 #endif  // __x86_64__ _M_X64 __aarch64__ __arm__
@@ -656,16 +10654,24 @@ inline specialized vecarr_x_mat(vec <double, 4>    *dest,
 
 
 template <>
-inline specialized mat_x_mat(mat<float, 4, 4> &dest,
-                             mat<float, 4, 4> &a,
-                             mat<float, 4, 4> &b) {
+constexpr specialized mat_x_mat(mat<float, 4, 4> &dest,
+                                mat<float, 4, 4> &a,
+                                mat<float, 4, 4> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
     return mat_x_mat_f(dest.m[0], a.m[0], b.m[0]);
 }
 
 template <>
-inline specialized mat_x_mat(mat<double, 4, 4> &dest,
-                             mat<double, 4, 4> &a,
-                             mat<double, 4, 4> &b) {
+constexpr specialized mat_x_mat(mat<double, 4, 4> &dest,
+                                mat<double, 4, 4> &a,
+                                mat<double, 4, 4> &b) {
+    if (std::is_constant_evaluated()) {
+        return looped_mat_x_mat(dest, a, b);
+    }
+
     return mat_x_mat_d(dest.m[0], a.m[0], b.m[0]);
 }
 